@@ -47,10 +47,17 @@
 #include <interfaces/isession.h>
 #include <interfaces/iproject.h>
 #include <interfaces/iprojectcontroller.h>
+#include <project/abstractfilemanagerplugin.h>
 
 #include <debug.h>
 
 #include "parsejob.h"
+#include "parsescheduler.h"
+#include "../duchain/duchain.h"
+#include "../duchain/duchainlock.h"
+
+#include <algorithm>
+#include <iterator>
 
 using namespace KDevelop;
 
@@ -58,6 +65,9 @@ namespace {
 
 const bool separateThreadForHighPriority = true;
 
+// Count of documents whose dependency information is collected before creating a parse job
+const int schedulingBatchSize = 100;
+
 /**
  * Elides string in @p path, e.g. "VEEERY/LONG/PATH" -> ".../LONG/PATH"
  * - probably much faster than QFontMetrics::elidedText()
@@ -242,7 +252,19 @@ public:
                 break; //The additional parsing thread is reserved for higher priority parsing
             }
 
-            for (const auto& url : it1.value()) {
+            // Within a priority, the scheduler decides the order based on the include graph
+            const auto& documents = it1.value();
+            OrderedDocuments& ordered = orderedDocuments(priority);
+            // Skip the documents that have been taken already
+            while (ordered.first < ordered.urls.size() && !documents.contains(ordered.urls[ordered.first])) {
+                ++ordered.first;
+            }
+            for (int i = ordered.first; i < ordered.urls.size(); ++i) {
+                const auto& url = ordered.urls[i];
+                if (!documents.contains(url)) {
+                    continue;
+                }
+
                 // When a document is scheduled for parsing while it is being parsed, it will be parsed
                 // again once the job finished, but not now.
                 if (m_parseJobs.contains(url)) {
@@ -265,6 +287,38 @@ public:
         return {};
     }
 
+    struct OrderedDocuments
+    {
+        QVector<IndexedString> urls;
+        // The documents before this position are not queued any more
+        int first = 0;
+    };
+
+    /// @returns the documents queued with @p priority, in the order of the scheduler. Also contains documents
+    ///          that have been removed from m_documentsForPriority since, they must be skipped.
+    OrderedDocuments& orderedDocuments(int priority) const
+    {
+        if (m_orderedGeneration != m_scheduler.generation()) {
+            m_orderedDocuments.clear();
+            m_orderedGeneration = m_scheduler.generation();
+        }
+        auto it = m_orderedDocuments.find(priority);
+        if (it == m_orderedDocuments.end()) {
+            it = m_orderedDocuments.insert(priority, OrderedDocuments());
+            const auto documents = m_documentsForPriority.value(priority);
+            it->urls.reserve(documents.size());
+            std::copy(documents.begin(), documents.end(), std::back_inserter(it->urls));
+            m_scheduler.sort(it->urls);
+        }
+        return *it;
+    }
+
+    void insertDocument(int priority, const IndexedString& url)
+    {
+        m_documentsForPriority[priority].insert(url);
+        m_orderedDocuments.remove(priority);
+    }
+
     /**
      * Create a single delayed parse job
      *
@@ -325,6 +379,9 @@ public:
                     specialParseJob = decorator; //This parse-job is allocated into the reserved thread
 
                 m_parseJobs.insert(url, decorator);
+                m_scheduler.jobQueued(url);
+                QObject::connect(decorator, &ThreadWeaver::QObjectDecorator::started,
+                                 m_parser, [this, url]() { m_scheduler.jobStarted(url); }, Qt::DirectConnection);
                 m_weaver.enqueue(ThreadWeaver::JobPointer(decorator));
             } else {
                 --m_maxParseJobs;
@@ -480,6 +537,10 @@ config.readEntry(entry, oldConfig.readEntry(entry, default))
     QHash<IndexedString, DocumentParsePlan > m_documents;
     // The documents ordered by priority
     QMap<int, QSet<IndexedString> > m_documentsForPriority;
+    // Cache of the order of the documents in m_documentsForPriority, filled lazily and dropped
+    // when documents are inserted or the scheduler changes its mind
+    mutable QHash<int, OrderedDocuments> m_orderedDocuments;
+    mutable uint m_orderedGeneration = 0;
     // Currently running parse jobs
     QHash<IndexedString, ThreadWeaver::QObjectDecorator*> m_parseJobs;
     // The url for each managed document. Those may temporarily differ from the real url.
@@ -489,6 +550,9 @@ config.readEntry(entry, oldConfig.readEntry(entry, default))
 
     ThreadWeaver::Queue m_weaver;
 
+    // Orders the documents of one priority, and records the timing of the parse jobs
+    ParseScheduler m_scheduler;
+
     // generic high-level mutex
     QMutex m_mutex;
 
@@ -578,7 +642,7 @@ void BackgroundParser::revertAllRequests(QObject* notifyWhenReady)
             continue;
         }
 
-        d->m_documentsForPriority[it.value().priority()].insert(it.key());
+        d->insertDocument(it.value().priority(), it.key());
         ++it;
     }
 }
@@ -603,11 +667,12 @@ void BackgroundParser::addDocument(const IndexedString& url, TopDUContext::Featu
 
             d->m_documentsForPriority[it.value().priority()].remove(url);
             it.value().targets << target;
-            d->m_documentsForPriority[it.value().priority()].insert(url);
+            d->insertDocument(it.value().priority(), url);
         }else{
 //             qCDebug(LANGUAGE) << "BackgroundParser::addDocument: queuing" << cleanedUrl;
             d->m_documents[url].targets << target;
-            d->m_documentsForPriority[d->m_documents[url].priority()].insert(url);
+            d->insertDocument(d->m_documents[url].priority(), url);
+            d->m_scheduler.addDocument(url);
             ++d->m_maxParseJobs; //So the progress-bar waits for this document
         }
 
@@ -639,7 +704,7 @@ void BackgroundParser::removeDocument(const IndexedString& url, QObject* notifyW
             --d->m_maxParseJobs;
         }else{
             //Insert with an eventually different priority
-            d->m_documentsForPriority[d->m_documents[url].priority()].insert(url);
+            d->insertDocument(d->m_documents[url].priority(), url);
         }
     }
 }
@@ -650,6 +715,9 @@ void BackgroundParser::parseDocuments()
         startTimer(d->m_delay);
         return;
     }
+    // Locks the DUChain, so it must happen before locking our mutex
+    d->m_scheduler.updateDependencyInfo(schedulingBatchSize);
+
     QMutexLocker lock(&d->m_mutex);
 
     d->parseDocumentsInternal();
@@ -667,9 +735,14 @@ void BackgroundParser::parseComplete(const ThreadWeaver::JobPointer& job)
         QMutexLocker lock(&d->m_mutex);
 
         d->m_parseJobs.remove(parseJob->document());
+        d->m_scheduler.jobFinished(parseJob->document());
 
         d->m_jobProgress.remove(parseJob);
 
+        if (d->m_parseJobs.isEmpty() && d->m_documents.isEmpty()) {
+            d->m_scheduler.finishRun();
+        }
+
         ++d->m_doneParseJobs;
         updateProgressData();
     }
@@ -834,6 +907,11 @@ bool BackgroundParser::waitForIdle() const
     return false;
 }
 
+void BackgroundParser::dumpParseTimings(QTextStream& out) const
+{
+    d->m_scheduler.dumpTimings(out);
+}
+
 DocumentChangeTracker* BackgroundParser::trackerForUrl(const KDevelop::IndexedString& url) const
 {
     if (url.isEmpty()) {
@@ -926,6 +1004,32 @@ void BackgroundParser::projectAboutToBeOpened(IProject* project)
 void BackgroundParser::projectOpened(IProject* project)
 {
     d->m_loadingProjects.remove(project);
+
+    // files changed on disk, e.g. by a VCS, are parsed again in one go
+    if (auto manager = qobject_cast<AbstractFileManagerPlugin*>(project->managerPlugin())) {
+        connect(manager, &AbstractFileManagerPlugin::filesChanged,
+                this, &BackgroundParser::projectFilesChanged, Qt::UniqueConnection);
+    }
+}
+
+void BackgroundParser::projectFilesChanged(IProject* project, const QList<IndexedString>& files)
+{
+    if (d->m_shuttingDown || !ICore::self()->projectController()->projects().contains(project)) {
+        return;
+    }
+
+    QList<IndexedString> changed = files;
+    if (!ICore::self()->projectController()->parseAllProjectSources()) {
+        // only update what was parsed before, e.g. as an include of an opened document
+        DUChainReadLocker lock;
+        changed.erase(std::remove_if(changed.begin(), changed.end(), [] (const IndexedString& file) {
+            return DUChain::self()->allEnvironmentFiles(file).isEmpty();
+        }), changed.end());
+    }
+    for (const IndexedString& file : qAsConst(changed)) {
+        addDocument(file, TopDUContext::VisibleDeclarationsAndContexts, InitialParsePriority);
+    }
+    qCDebug(LANGUAGE) << "queued" << changed.size() << "of" << files.size() << "changed files of project" << project->name();
 }
 
 void BackgroundParser::projectOpeningAborted(IProject* project)
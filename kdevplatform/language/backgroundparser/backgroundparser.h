@@ -30,6 +30,8 @@
 #include <language/interfaces/ilanguagesupport.h>
 #include "parsejob.h"
 
+class QTextStream;
+
 namespace ThreadWeaver
 {
 class Job;
@@ -112,6 +114,12 @@ public:
 
     bool waitForIdle() const;
 
+    /**
+     * Writes the timing of all parse jobs since the background parser was last idle to @p out,
+     * together with the critical path through the imports of the parsed documents.
+     */
+    void dumpParseTimings(QTextStream& out) const;
+
 Q_SIGNALS:
     /**
      * Emitted whenever a document parse-job has finished.
@@ -234,6 +242,8 @@ private Q_SLOTS:
     /// Tracking of projects in state of loading.
     void projectAboutToBeOpened(KDevelop::IProject* project);
     void projectOpened(KDevelop::IProject* project);
+    /// Queues the files of @p project that changed on disk, as reported by its file manager.
+    void projectFilesChanged(KDevelop::IProject* project, const QList<KDevelop::IndexedString>& files);
     void projectOpeningAborted(KDevelop::IProject* project);
 };
 
@@ -234,7 +234,7 @@ KDevelop::ProblemPointer ParseJob::readContents()
     QString localFile(document().toUrl().toLocalFile());
     QFileInfo fileInfo( localFile );
 
-    QDateTime lastModified = fileInfo.lastModified();
+    const QDateTime diskModificationTime = fileInfo.lastModified();
 
     d->tracker = ICore::self()->languageController()->backgroundParser()->trackerForUrl(document());
 
@@ -249,6 +249,9 @@ KDevelop::ProblemPointer ParseJob::readContents()
     bool hadTracker = false;
     if(d->tracker)
     {
+        // Must match ModificationRevision::revisionForFile(), so the parsed file is not considered outdated right away
+        const QDateTime lastModified = ModificationRevision::contentModificationTime(document(), diskModificationTime);
+
         ForegroundLock lock;
         if(DocumentChangeTracker* t = d->tracker.data())
         {
@@ -312,6 +315,11 @@ KDevelop::ProblemPointer ParseJob::readContents()
 
         d->contents.contents = file.readAll(); ///@todo Convert from local encoding to utf-8 if they don't match
 
+        // Records the hash of the content as it is on disk, so touching the file later without changing it,
+        // for example by a checkout, does not make the parsed file outdated
+        const QDateTime lastModified = ModificationRevision::contentModificationTime(document(), diskModificationTime,
+                                                                                     &d->contents.contents);
+
         // This is consistent with KTextEditor::Document::text() as used for already-open files.
         normalizeLineEndings(d->contents.contents);
         d->contents.modification = KDevelop::ModificationRevision(lastModified);
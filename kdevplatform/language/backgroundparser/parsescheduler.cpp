@@ -0,0 +1,370 @@
+/*
+ * This file is part of KDevelop
+ *
+ * Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "parsescheduler.h"
+
+#include "qtcompat_p.h"
+#include <QTextStream>
+
+#include <language/duchain/duchain.h>
+#include <language/duchain/duchainlock.h>
+
+#include <debug.h>
+
+#include <algorithm>
+#include <functional>
+
+using namespace KDevelop;
+
+namespace {
+
+// Include chains are rarely deeper, and this bounds the recursion in include cycles
+const int maxLevel = 64;
+
+// Don't block the foreground thread for long if a parse job holds the DUChain
+const unsigned int lockTimeout = 10;
+
+// Count of the longest parse jobs listed by dumpTimings()
+const int listedJobs = 10;
+
+}
+
+ParseScheduler::ParseScheduler()
+{
+    m_clock.start();
+}
+
+ParseScheduler::~ParseScheduler() = default;
+
+void ParseScheduler::addDocument(const IndexedString& url)
+{
+    QMutexLocker lock(&m_mutex);
+    if (!m_info.contains(url)) {
+        m_pending.insert(url);
+    }
+}
+
+void ParseScheduler::updateDependencyInfo(int maxDocuments)
+{
+    QVector<IndexedString> urls;
+    {
+        QMutexLocker lock(&m_mutex);
+        for (auto it = m_pending.begin(); it != m_pending.end() && urls.size() < maxDocuments; ) {
+            urls << *it;
+            it = m_pending.erase(it);
+        }
+    }
+    if (urls.isEmpty()) {
+        return;
+    }
+
+    DUChainReadLocker duchainLock(DUChain::lock(), lockTimeout);
+    QMutexLocker lock(&m_mutex);
+    if (!duchainLock.locked()) {
+        for (const auto& url : qAsConst(urls)) {
+            m_pending.insert(url);
+        }
+        return;
+    }
+
+    for (const auto& url : qAsConst(urls)) {
+        DocumentInfo info;
+        int groupImporters = 0;
+        const auto files = DUChain::self()->allEnvironmentFiles(url);
+        for (const auto& file : files) {
+            info.level = qMax(info.level, computeLevel(file, 0));
+            const auto imports = file->imports();
+            for (const auto& import : imports) {
+                const IndexedString importUrl = import->url();
+                if (info.imports.contains(importUrl)) {
+                    continue;
+                }
+                info.imports << importUrl;
+                const int importers = importerCount(import);
+                if (importers > groupImporters) {
+                    groupImporters = importers;
+                    info.group = importUrl;
+                }
+            }
+        }
+        m_info.insert(url, info);
+    }
+    ++m_generation;
+}
+
+int ParseScheduler::computeLevel(const ParsingEnvironmentFilePointer& file, int depth)
+{
+    const IndexedString url = file->url();
+    const auto it = m_levels.constFind(url);
+    if (it != m_levels.constEnd()) {
+        return *it;
+    }
+    if (depth >= maxLevel) {
+        return 0;
+    }
+
+    // Breaks include cycles
+    m_levels.insert(url, 0);
+
+    int level = 0;
+    const auto importers = file->importers();
+    for (const auto& importer : importers) {
+        level = qMax(level, computeLevel(importer, depth + 1) + 1);
+    }
+    m_importerCounts.insert(url, importers.size());
+    m_levels.insert(url, level);
+    return level;
+}
+
+int ParseScheduler::importerCount(const ParsingEnvironmentFilePointer& file)
+{
+    const IndexedString url = file->url();
+    auto it = m_importerCounts.constFind(url);
+    if (it == m_importerCounts.constEnd()) {
+        it = m_importerCounts.insert(url, file->importers().size());
+    }
+    return *it;
+}
+
+void ParseScheduler::sort(QVector<IndexedString>& urls) const
+{
+    struct Entry
+    {
+        bool known;
+        int level;
+        uint group;
+        IndexedString url;
+    };
+
+    QVector<Entry> entries;
+    entries.reserve(urls.size());
+    {
+        QMutexLocker lock(&m_mutex);
+        for (const auto& url : qAsConst(urls)) {
+            const auto it = m_info.constFind(url);
+            if (it == m_info.constEnd()) {
+                entries.append({false, 0, 0, url});
+            } else {
+                entries.append({true, it->level, it->group.index(), url});
+            }
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+        // Known documents first, they are the ones we can order
+        if (lhs.known != rhs.known) {
+            return lhs.known;
+        }
+        // Critical path first, which also puts imports before their importers
+        if (lhs.level != rhs.level) {
+            return lhs.level > rhs.level;
+        }
+        // Documents sharing the same heavy import one after another
+        if (lhs.group != rhs.group) {
+            return lhs.group < rhs.group;
+        }
+        return lhs.url.index() < rhs.url.index();
+    });
+
+    for (int a = 0; a < entries.size(); ++a) {
+        urls[a] = entries[a].url;
+    }
+}
+
+uint ParseScheduler::generation() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_generation;
+}
+
+int ParseScheduler::level(const IndexedString& url) const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_info.value(url).level;
+}
+
+IndexedString ParseScheduler::group(const IndexedString& url) const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_info.value(url).group;
+}
+
+void ParseScheduler::jobQueued(const IndexedString& url)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_runFinished) {
+        m_runFinished = false;
+        m_timings.clear();
+        m_clock.restart();
+    }
+
+    const DocumentInfo info = m_info.value(url);
+    JobTiming& timing = m_timings[url];
+    timing.queued = m_clock.elapsed();
+    timing.started = timing.finished = -1;
+    timing.imports = info.imports;
+}
+
+void ParseScheduler::jobStarted(const IndexedString& url)
+{
+    QMutexLocker lock(&m_mutex);
+    const auto it = m_timings.find(url);
+    if (it != m_timings.end()) {
+        it->started = m_clock.elapsed();
+    }
+}
+
+void ParseScheduler::jobFinished(const IndexedString& url)
+{
+    QMutexLocker lock(&m_mutex);
+    const auto it = m_timings.find(url);
+    if (it != m_timings.end()) {
+        it->finished = m_clock.elapsed();
+        if (it->started == -1) {
+            // Aborted before it was started
+            it->started = it->finished;
+        }
+    }
+}
+
+void ParseScheduler::finishRun()
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_runFinished) {
+        return;
+    }
+    m_runFinished = true;
+
+    if (!m_timings.isEmpty()) {
+        qCDebug(LANGUAGE).noquote() << summary();
+    }
+
+    // The include graph changes while parsing, so it's collected again for the next run
+    m_info.clear();
+    m_pending.clear();
+    m_levels.clear();
+    m_importerCounts.clear();
+    ++m_generation;
+}
+
+QVector<IndexedString> ParseScheduler::criticalPath(qint64* length) const
+{
+    // The longest chain of parse times through the imports, in the order of the imports
+    QHash<IndexedString, qint64> pathLength;
+    QHash<IndexedString, IndexedString> predecessor;
+
+    std::function<qint64(const IndexedString&, int)> visit = [&](const IndexedString& url, int depth) -> qint64 {
+        const auto it = pathLength.constFind(url);
+        if (it != pathLength.constEnd()) {
+            return *it;
+        }
+        const JobTiming timing = m_timings.value(url);
+        if (timing.finished == -1) {
+            return 0;
+        }
+
+        // Breaks include cycles
+        pathLength.insert(url, 0);
+        qint64 longestImport = 0;
+        if (depth < maxLevel) {
+            for (const auto& import : timing.imports) {
+                const qint64 importLength = visit(import, depth + 1);
+                if (importLength > longestImport) {
+                    longestImport = importLength;
+                    predecessor.insert(url, import);
+                }
+            }
+        }
+        const qint64 ret = longestImport + timing.finished - timing.started;
+        pathLength.insert(url, ret);
+        return ret;
+    };
+
+    IndexedString last;
+    *length = 0;
+    for (auto it = m_timings.constBegin(); it != m_timings.constEnd(); ++it) {
+        const qint64 itLength = visit(it.key(), 0);
+        if (itLength > *length || last.isEmpty()) {
+            *length = itLength;
+            last = it.key();
+        }
+    }
+
+    QVector<IndexedString> ret;
+    for (IndexedString url = last; !url.isEmpty() && ret.size() <= maxLevel; url = predecessor.value(url)) {
+        ret.prepend(url);
+    }
+    return ret;
+}
+
+QString ParseScheduler::summary() const
+{
+    qint64 first = -1, last = 0, total = 0;
+    int finished = 0;
+    for (const auto& timing : m_timings) {
+        if (timing.finished == -1) {
+            continue;
+        }
+        ++finished;
+        first = first == -1 ? timing.queued : qMin(first, timing.queued);
+        last = qMax(last, timing.finished);
+        total += timing.finished - timing.started;
+    }
+
+    qint64 criticalPathLength = 0;
+    const int criticalPathSize = criticalPath(&criticalPathLength).size();
+    return QStringLiteral("parsed %1 documents in %2 ms, %3 ms spent in parse jobs, critical path of %4 documents takes %5 ms")
+        .arg(finished).arg(first == -1 ? 0 : last - first).arg(total).arg(criticalPathSize).arg(criticalPathLength);
+}
+
+void ParseScheduler::dumpTimings(QTextStream& out) const
+{
+    QMutexLocker lock(&m_mutex);
+
+    out << summary() << endl;
+
+    QVector<QPair<qint64, IndexedString>> durations;
+    for (auto it = m_timings.constBegin(); it != m_timings.constEnd(); ++it) {
+        if (it->finished != -1) {
+            durations.append({it->finished - it->started, it.key()});
+        }
+    }
+    std::sort(durations.begin(), durations.end(), [](const QPair<qint64, IndexedString>& lhs, const QPair<qint64, IndexedString>& rhs) {
+        return lhs.first > rhs.first;
+    });
+    if (durations.size() > listedJobs) {
+        durations.resize(listedJobs);
+    }
+
+    out << "longest parse jobs (waiting, parsing):" << endl;
+    for (const auto& duration : qAsConst(durations)) {
+        const JobTiming timing = m_timings.value(duration.second);
+        out << "  " << duration.second.str() << ": " << timing.started - timing.queued << " ms, " << duration.first << " ms" << endl;
+    }
+
+    qint64 criticalPathLength = 0;
+    const auto path = criticalPath(&criticalPathLength);
+    out << "critical path (started, parsing):" << endl;
+    for (const auto& url : path) {
+        const JobTiming timing = m_timings.value(url);
+        out << "  " << url.str() << ": " << timing.started << " ms, " << timing.finished - timing.started << " ms" << endl;
+    }
+}
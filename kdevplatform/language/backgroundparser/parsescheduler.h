@@ -0,0 +1,129 @@
+/*
+ * This file is part of KDevelop
+ *
+ * Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KDEVPLATFORM_PARSESCHEDULER_H
+#define KDEVPLATFORM_PARSESCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QVector>
+
+#include <language/languageexport.h>
+#include <language/duchain/parsingenvironment.h>
+#include <serialization/indexedstring.h>
+
+class QTextStream;
+
+namespace KDevelop {
+
+/**
+ * Decides the order in which the background parser parses documents of the same priority,
+ * and records the timing of the parse jobs.
+ *
+ * The include graph known from previous parses is used:
+ * - Documents are parsed before the documents that import them, and documents with longer chains of
+ *   importers first, as those are on the critical path.
+ * - Documents on the same level that share their most widely imported direct import are parsed one after
+ *   another, so the contexts of the shared headers are reused while they are still loaded.
+ * Documents that have not been parsed yet are parsed in an arbitrary order after the known ones.
+ *
+ * All functions are thread-safe. Only updateDependencyInfo() locks the DUChain, so it must not be
+ * called while holding a lock that is also acquired while the DUChain is locked.
+ */
+class KDEVPLATFORMLANGUAGE_EXPORT ParseScheduler
+{
+public:
+    ParseScheduler();
+    ~ParseScheduler();
+
+    /// Registers a queued document, its dependency information is collected by the next updateDependencyInfo().
+    void addDocument(const IndexedString& url);
+
+    /// Collects the dependency information of up to @p maxDocuments queued documents from the DUChain.
+    /// Gives up if the DUChain cannot be read-locked within a short time, the documents are retried on the next call.
+    void updateDependencyInfo(int maxDocuments);
+
+    /// Sorts @p urls into the order in which they should be parsed
+    void sort(QVector<IndexedString>& urls) const;
+
+    /// @returns a counter that changes whenever the order computed by sort() may have changed
+    uint generation() const;
+
+    /// @returns the length of the longest known chain of importers of @p url
+    int level(const IndexedString& url) const;
+
+    /// @returns the group of documents that @p url is parsed together with, that is its most widely imported direct import
+    IndexedString group(const IndexedString& url) const;
+
+    /// Called when a parse job for @p url has been enqueued
+    void jobQueued(const IndexedString& url);
+    /// Called from the parse thread when the parse job for @p url starts running
+    void jobStarted(const IndexedString& url);
+    /// Called when the parse job for @p url has finished
+    void jobFinished(const IndexedString& url);
+
+    /// Called when all queued documents have been parsed. Logs a summary of the timings, and drops the
+    /// cached dependency information. The timings are kept until the next job is queued.
+    void finishRun();
+
+    /// Writes the timing of all parse jobs since the background parser was last idle to @p out,
+    /// together with the critical path through the imports of the parsed documents.
+    void dumpTimings(QTextStream& out) const;
+
+private:
+    struct DocumentInfo
+    {
+        int level = 0;
+        IndexedString group;
+        QVector<IndexedString> imports;
+    };
+
+    struct JobTiming
+    {
+        qint64 queued = -1;
+        qint64 started = -1;
+        qint64 finished = -1;
+        QVector<IndexedString> imports;
+    };
+
+    int computeLevel(const ParsingEnvironmentFilePointer& file, int depth);
+    int importerCount(const ParsingEnvironmentFilePointer& file);
+    QVector<IndexedString> criticalPath(qint64* length) const;
+    QString summary() const;
+
+    mutable QMutex m_mutex;
+    QHash<IndexedString, DocumentInfo> m_info;
+    QSet<IndexedString> m_pending;
+    // Caches for the include graph, valid until finishRun()
+    QHash<IndexedString, int> m_levels;
+    QHash<IndexedString, int> m_importerCounts;
+    uint m_generation = 0;
+
+    QElapsedTimer m_clock;
+    QHash<IndexedString, JobTiming> m_timings;
+    bool m_runFinished = true;
+};
+
+}
+
+#endif // KDEVPLATFORM_PARSESCHEDULER_H
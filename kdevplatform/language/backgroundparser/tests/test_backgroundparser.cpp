@@ -27,6 +27,7 @@
 #include <QTemporaryFile>
 #include <QApplication>
 #include <QSemaphore>
+#include <QTextStream>
 
 #include <KTextEditor/Editor>
 #include <KTextEditor/View>
@@ -37,6 +38,7 @@
 
 #include <language/duchain/duchain.h>
 #include <language/duchain/duchainlock.h>
+#include <language/duchain/parsingenvironment.h>
 #include <language/backgroundparser/backgroundparser.h>
 
 #include <interfaces/ilanguagecontroller.h>
@@ -245,6 +247,52 @@ void TestBackgroundparser::testParseOrdering_noSequentialProcessing()
     QVERIFY(m_jobPlan.runJobs(1000));
 }
 
+void TestBackgroundparser::testParseOrdering_dependencies()
+{
+    m_jobPlan.clear();
+
+    // base.txt is imported by mid.txt, which is imported by a.txt and b.txt
+    const auto baseUrl = QUrl::fromLocalFile(QStringLiteral("/test_dep_base.txt"));
+    const auto midUrl = QUrl::fromLocalFile(QStringLiteral("/test_dep_mid.txt"));
+    QList<QUrl> urls = {QUrl::fromLocalFile(QStringLiteral("/test_dep_a.txt")),
+                        QUrl::fromLocalFile(QStringLiteral("/test_dep_b.txt")), midUrl, baseUrl};
+    QList<TopDUContext*> contexts;
+    {
+        DUChainWriteLocker lock;
+        for (const auto& url : urls) {
+            const IndexedString indexedUrl(url);
+            auto top = new TopDUContext(indexedUrl, RangeInRevision(), new ParsingEnvironmentFile(indexedUrl));
+            DUChain::self()->addDocumentChain(top);
+            contexts << top;
+        }
+        contexts[0]->addImportedParentContext(contexts[2]);
+        contexts[1]->addImportedParentContext(contexts[2]);
+        contexts[2]->addImportedParentContext(contexts[3]);
+    }
+
+    // never parsed before, so nothing is known about it
+    urls << QUrl::fromLocalFile(QStringLiteral("/test_dep_unknown.txt"));
+    foreach (const auto& url, urls) {
+        m_jobPlan.addJob(JobPrototype(url, BackgroundParser::InitialParsePriority, ParseJob::IgnoresSequentialProcessing, 10));
+    }
+    QVERIFY(m_jobPlan.runJobs(1000));
+
+    QCOMPARE(m_jobPlan.m_createdJobs.size(), urls.size());
+    QCOMPARE(m_jobPlan.m_createdJobs[0], IndexedString(baseUrl));
+    QCOMPARE(m_jobPlan.m_createdJobs[1], IndexedString(midUrl));
+    QCOMPARE(m_jobPlan.m_createdJobs.last(), IndexedString(urls.last()));
+
+    QString timings;
+    QTextStream stream(&timings);
+    ICore::self()->languageController()->backgroundParser()->dumpParseTimings(stream);
+    QVERIFY(timings.contains(QLatin1String("critical path")));
+
+    DUChainWriteLocker lock;
+    foreach (auto top, contexts) {
+        DUChain::self()->removeDocumentChain(top);
+    }
+}
+
 void TestBackgroundparser::testParseOrdering_lockup()
 {
     m_jobPlan.clear();
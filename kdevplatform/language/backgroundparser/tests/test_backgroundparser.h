@@ -101,6 +101,7 @@ private Q_SLOTS:
     void testParseOrdering_lockup();
     void testParseOrdering_foregroundThread();
     void testParseOrdering_noSequentialProcessing();
+    void testParseOrdering_dependencies();
 
     void testNoDeadlockInJobCreation();
 
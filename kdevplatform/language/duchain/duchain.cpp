@@ -43,6 +43,7 @@
 #include "topducontext.h"
 #include "topducontextdata.h"
 #include "topducontextdynamicdata.h"
+#include "topducontextstore.h"
 #include "parsingenvironment.h"
 #include "declaration.h"
 #include "definitions.h"
@@ -855,7 +856,11 @@ public:
         writeLock.unlock();
 
       //This must be the last step, due to the on-disk reference counting
+      //The repositories are stored through their journals, and recovered after a crash while storing them,
+      //so the write-lock that discards the whole repository is only held for the data written around them.
+      globalItemRepositoryRegistry().unlockForWriting();
       globalItemRepositoryRegistry().store(); //Stores all repositories
+      globalItemRepositoryRegistry().lockForWriting();
 
       {
         //Store the static parsing-environment file data
@@ -880,6 +885,13 @@ public:
         f.write((char*)m_availableTopContextIndices.data(), m_availableTopContextIndices.size() * sizeof(uint));
       }
 
+      //Move the top-contexts out of mostly unused segments, and write the index of the top-context store
+      {
+        const auto store = TopDUContextStore::self();
+        store->compact();
+        store->flush();
+      }
+
 
       if(retries) {
         doMoreCleanup(retries-1, NoLock);
@@ -1126,6 +1138,7 @@ DUChain* DUChain::self()
 }
 
 extern void initModificationRevisionSetRepository();
+extern void initModificationRevisionRepository();
 extern void initDeclarationRepositories();
 extern void initIdentifierRepository();
 extern void initTypeRepository();
@@ -1151,6 +1164,7 @@ void DUChain::initialize()
   initDeclarationRepositories();
 
   initModificationRevisionSetRepository();
+  initModificationRevisionRepository();
   initIdentifierRepository();
   initTypeRepository();
   initInstantiationInformationRepository();
@@ -1604,6 +1618,7 @@ void DUChain::shutdown()
     //Crashes here may happen in an inconsistent state, thus this makes sense, to protect the user from more crashes
     globalItemRepositoryRegistry().lockForWriting();
     finalCleanup();
+    TopDUContextStore::closeSelf();
     globalItemRepositoryRegistry().unlockForWriting();
   }
 
@@ -22,20 +22,79 @@
 #include "duchainlock.h"
 #include "duchain.h"
 
+#include <util/foregroundlock.h>
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QTextStream>
 #include <QThread>
 #include <QThreadStorage>
-#include <QElapsedTimer>
+#include <QWaitCondition>
 
+#include <climits>
 
-///@todo Always prefer exactly that lock that is requested by the thread that has the foreground mutex,
-///           to reduce the amount of UI blocking.
-
-//Microseconds to sleep when waiting for a lock
-const uint uSleepTime = 500;
+//Milliseconds during which other threads step back for a thread that waits for a lock while holding the foreground lock.
+//This is limited, so that a thread waiting for another thread that needs a new read-lock cannot deadlock.
+const uint foregroundPreferenceTime = 100;
 
 namespace KDevelop
 {
 
+namespace {
+
+///Histogram of durations, with buckets for powers of two microseconds
+class LockHistogram
+{
+public:
+  enum {
+    BucketCount = 24
+  };
+
+  void add(qint64 nsecs)
+  {
+    qint64 usecs = nsecs / 1000;
+    int bucket = 0;
+    while (usecs > 1 && bucket < BucketCount - 1) {
+      usecs >>= 1;
+      ++bucket;
+    }
+    m_buckets[bucket].ref();
+  }
+
+  void reset()
+  {
+    for (auto& bucket : m_buckets) {
+      bucket.store(0);
+    }
+  }
+
+  void dump(QTextStream& out, const QString& name) const
+  {
+    int total = 0;
+    for (const auto& bucket : m_buckets) {
+      total += bucket.load();
+    }
+    out << name << ": " << total << " samples\n";
+    for (int a = 0; a < BucketCount; ++a) {
+      if (const int count = m_buckets[a].load()) {
+        out << "  < " << (1ll << (a + 1)) << " us: " << count << '\n';
+      }
+    }
+  }
+
+private:
+  QAtomicInt m_buckets[BucketCount];
+};
+
+struct ThreadLockState
+{
+  int readerRecursion = 0;
+  ///When the outermost read-lock of this thread was acquired
+  qint64 readStart = 0;
+};
+
+}
+
 class DUChainLockPrivate
 {
 public:
@@ -43,30 +102,105 @@ public:
     : m_writer(nullptr)
     , m_writerRecursion(0)
     , m_totalReaderRecursion(0)
-  { }
+    , m_waiters(0)
+    , m_waitingForegroundReaders(0)
+    , m_waitingForegroundWriters(0)
+    , m_writeStart(0)
+  {
+    m_clock.start();
+  }
 
-  int ownReaderRecursion() const
+  qint64 now() const
   {
-    return m_readerRecursion.localData();
+    return m_clock.nsecsElapsed();
   }
 
-  void changeOwnReaderRecursion(int difference)
+  void increaseOwnReaderRecursion(ThreadLockState& state)
   {
-    m_readerRecursion.localData() += difference;
-    Q_ASSERT(m_readerRecursion.localData() >= 0);
-    m_totalReaderRecursion.fetchAndAddOrdered(difference);
+    if (!state.readerRecursion++) {
+      state.readStart = now();
+    }
+    m_totalReaderRecursion.ref();
   }
 
-  ///Holds the writer that currently has the write-lock, or zero. Is protected by m_writerRecursion.
-  QAtomicPointer<QThread> m_writer;
+  ///Drops one read-lock from m_totalReaderRecursion, and wakes the waiting writers if it was the last one
+  void decreaseTotalReaderRecursion()
+  {
+    if (!m_totalReaderRecursion.deref() && m_waitingWriters.loadAcquire()) {
+      //Locking the mutex makes sure that no writer can miss the wakeup between checking the reader count and waiting
+      QMutexLocker lock(&m_mutex);
+      wakeWaiters();
+    }
+  }
 
-  ///How often is the chain write-locked by the writer? This value protects m_writer,
-  ///m_writer may only be changed by the thread that successfully increases this value from 0 to 1
-  QAtomicInt m_writerRecursion;
-  ///How often is the chain read-locked recursively by all readers? Should be sum of all m_readerRecursion values
-  QAtomicInt m_totalReaderRecursion;
+  ///Waits until @p canAcquire returns true for the time waited so far in milliseconds, or @p timeout is reached.
+  ///m_mutex must be locked.
+  template<typename CanAcquire>
+  bool waitUntil(CanAcquire canAcquire, uint timeout)
+  {
+    QElapsedTimer t;
+    t.start();
+    while (!canAcquire(t.elapsed())) {
+      unsigned long waitTime = ULONG_MAX;
+      if (timeout) {
+        const qint64 remaining = timeout - t.elapsed();
+        if (remaining <= 0) {
+          return false;
+        }
+        waitTime = remaining;
+      }
+      if (t.elapsed() < foregroundPreferenceTime) {
+        //Wake up once we stop stepping back for the foreground thread, as nobody else will wake us then
+        waitTime = qMin<unsigned long>(waitTime, foregroundPreferenceTime - t.elapsed() + 1);
+      }
+      ++m_waiters;
+      m_condition.wait(&m_mutex, waitTime);
+      --m_waiters;
+    }
+    return true;
+  }
 
-  QThreadStorage<int> m_readerRecursion;
+  void wakeWaiters()
+  {
+    if (m_waiters) {
+      m_condition.wakeAll();
+    }
+  }
+
+  ///Protects the members below, except for the atomics that are documented otherwise
+  QMutex m_mutex;
+  QWaitCondition m_condition;
+
+  ///Holds the writer that currently has the write-lock, or zero. Is only changed with m_mutex locked,
+  ///but may be read without it to check whether the own thread holds the write-lock.
+  QAtomicPointer<QThread> m_writer;
+  ///How often is the chain write-locked by the writer? Is only accessed by the writer.
+  int m_writerRecursion;
+  ///How often is the chain read-locked recursively by all readers? Should be sum of all own reader recursions.
+  ///Readers increase it without m_mutex while m_waitingWriters is zero, and check m_waitingWriters again
+  ///afterwards, so a writer that saw no readers is never overtaken, see DUChainLock::lockForRead().
+  QAtomicInt m_totalReaderRecursion;
+  ///Count of threads waiting for the write-lock, is only changed with m_mutex locked
+  QAtomicInt m_waitingWriters;
+
+  ///Count of threads waiting in m_condition
+  int m_waiters;
+  ///Count of threads waiting for a lock while holding the foreground lock
+  int m_waitingForegroundReaders;
+  int m_waitingForegroundWriters;
+
+  QThreadStorage<ThreadLockState> m_threadState;
+
+  QElapsedTimer m_clock;
+  ///When the outermost write-lock was acquired, is only accessed by the writer
+  qint64 m_writeStart;
+  LockHistogram m_readWaitTimes;
+  LockHistogram m_writeWaitTimes;
+  LockHistogram m_readHoldTimes;
+  LockHistogram m_writeHoldTimes;
+  ///Acquisitions by threads that already held the lock, the others are counted by the histograms
+  QAtomicInt m_recursiveReadLocks;
+  QAtomicInt m_recursiveWriteLocks;
 };
 
 DUChainLock::DUChainLock()
@@ -78,100 +212,140 @@ DUChainLock::~DUChainLock() = default;
 
 bool DUChainLock::lockForRead(unsigned int timeout)
 {
-  ///Step 1: Increase the own reader-recursion. This will make sure no further write-locks will succeed
-  d->changeOwnReaderRecursion(1);
+  ThreadLockState& state = d->m_threadState.localData();
+  QThread* const self = QThread::currentThread();
 
-  QThread* w = d->m_writer.loadAcquire();
-  if (w == nullptr || w == QThread::currentThread()) {
-    //Successful lock: Either there is no writer, or we hold the write-lock by ourselves
-  } else {
-    ///Step 2: Start spinning until there is no writer any more
+  if (state.readerRecursion || d->m_writer.loadAcquire() == self) {
+    //Recursive locks never wait, there can be no writer other than ourselves
+    d->increaseOwnReaderRecursion(state);
+    d->m_recursiveReadLocks.ref();
+    return true;
+  }
 
-    QElapsedTimer t;
-    if (timeout) {
-      t.start();
+  const qint64 waitStart = d->now();
+
+  //Without a writer, and without threads waiting for one, the lock is taken without locking the mutex.
+  //A writer announces itself in m_waitingWriters before it checks the readers, so when it started
+  //waiting after the first check, the second one sees it and the read-lock is dropped again.
+  if (!d->m_waitingWriters.loadAcquire() && !d->m_writer.loadAcquire()) {
+    d->m_totalReaderRecursion.ref();
+    if (!d->m_waitingWriters.loadAcquire() && !d->m_writer.loadAcquire()) {
+      state.readerRecursion = 1;
+      state.readStart = d->now();
+      d->m_readWaitTimes.add(state.readStart - waitStart);
+      return true;
     }
+    d->decreaseTotalReaderRecursion();
+  }
 
-    while (d->m_writer.loadAcquire()) {
-      if (!timeout || t.elapsed() < timeout) {
-        QThread::usleep(uSleepTime);
-      } else {
-        //Fail!
-        d->changeOwnReaderRecursion(-1);
-        return false;
-      }
+  {
+    QMutexLocker lock(&d->m_mutex);
+    const bool foreground = ForegroundLock::isLockedForThread();
+    if (foreground) {
+      ++d->m_waitingForegroundReaders;
+    }
+
+    const bool acquired = d->waitUntil([&] (qint64 waited) {
+      return !d->m_writer.load()
+          && (foreground || !d->m_waitingForegroundWriters || waited >= foregroundPreferenceTime);
+    }, timeout);
+
+    if (foreground) {
+      --d->m_waitingForegroundReaders;
+    }
+    if (!acquired) {
+      //Background writers may have stepped back for us
+      d->wakeWaiters();
+      return false;
     }
+    d->increaseOwnReaderRecursion(state);
   }
+  d->m_readWaitTimes.add(d->now() - waitStart);
 
   return true;
 }
 
 void DUChainLock::releaseReadLock()
 {
-  d->changeOwnReaderRecursion(-1);
+  ThreadLockState& state = d->m_threadState.localData();
+  Q_ASSERT(state.readerRecursion > 0);
+
+  if (!--state.readerRecursion) {
+    d->m_readHoldTimes.add(d->now() - state.readStart);
+  }
+
+  d->decreaseTotalReaderRecursion();
 }
 
 bool DUChainLock::currentThreadHasReadLock()
 {
-  return (bool)d->ownReaderRecursion();
+  return (bool)d->m_threadState.localData().readerRecursion;
 }
 
 bool DUChainLock::lockForWrite(uint timeout)
 {
   //It is not allowed to acquire a write-lock while holding read-lock
 
-  Q_ASSERT(d->ownReaderRecursion() == 0);
+  Q_ASSERT(d->m_threadState.localData().readerRecursion == 0);
 
-  if (d->m_writer.load() == QThread::currentThread()) {
+  QThread* const self = QThread::currentThread();
+  if (d->m_writer.load() == self) {
     //We already hold the write lock, just increase the recursion count and return
-    d->m_writerRecursion.fetchAndAddRelaxed(1);
+    ++d->m_writerRecursion;
+    d->m_recursiveWriteLocks.ref();
     return true;
   }
 
-  QElapsedTimer t;
-  if (timeout) {
-    t.start();
-  }
-
-  while (1) {
-    //Try acquiring the write-lcok
-    if (d->m_totalReaderRecursion.load() == 0 && d->m_writerRecursion.testAndSetOrdered(0, 1)) {
-      //Now we can be sure that there is no other writer, as we have increased m_writerRecursion from 0 to 1
-      d->m_writer = QThread::currentThread();
-      if (d->m_totalReaderRecursion.load() == 0) {
-        //There is still no readers, we have successfully acquired a write-lock
-        return true;
-      } else {
-        //There may be readers.. we have to continue spinning
-        d->m_writer = nullptr;
-        d->m_writerRecursion = 0;
-      }
+  const qint64 waitStart = d->now();
+  {
+    QMutexLocker lock(&d->m_mutex);
+    const bool foreground = ForegroundLock::isLockedForThread();
+    if (foreground) {
+      ++d->m_waitingForegroundWriters;
     }
-
-    if (!timeout || t.elapsed() < timeout) {
-      QThread::usleep(uSleepTime);
-    } else {
-      //Fail!
+    //Announced before the readers are checked, so new readers don't take the fast path anymore
+    d->m_waitingWriters.ref();
+
+    const bool acquired = d->waitUntil([&] (qint64 waited) {
+      return !d->m_writer.load() && d->m_totalReaderRecursion.loadAcquire() == 0
+          && (foreground || !(d->m_waitingForegroundReaders + d->m_waitingForegroundWriters)
+              || waited >= foregroundPreferenceTime);
+    }, timeout);
+
+    //The writer is set before we stop waiting, so readers of the fast path see either of them
+    if (acquired) {
+      d->m_writer.storeRelease(self);
+      d->m_writerRecursion = 1;
+    }
+    d->m_waitingWriters.deref();
+    if (foreground) {
+      --d->m_waitingForegroundWriters;
+    }
+    if (!acquired) {
+      //Readers may have stepped back for us
+      d->wakeWaiters();
       return false;
     }
   }
+  d->m_writeStart = d->now();
+  d->m_writeWaitTimes.add(d->m_writeStart - waitStart);
 
-  return false;
+  return true;
 }
 
 void DUChainLock::releaseWriteLock()
 {
   Q_ASSERT(currentThreadHasWriteLock());
 
-  //The order is important here, m_writerRecursion protects m_writer
-
-  //TODO: could testAndSet here
-  if (d->m_writerRecursion.load() == 1) {
-    d->m_writer = nullptr;
-    d->m_writerRecursion = 0;
-  } else {
-    d->m_writerRecursion.fetchAndAddOrdered(-1);
+  if (--d->m_writerRecursion) {
+    return;
   }
+
+  d->m_writeHoldTimes.add(d->now() - d->m_writeStart);
+
+  QMutexLocker lock(&d->m_mutex);
+  d->m_writer.storeRelease(nullptr);
+  d->wakeWaiters();
 }
 
 bool DUChainLock::currentThreadHasWriteLock()
@@ -179,6 +353,26 @@ bool DUChainLock::currentThreadHasWriteLock()
   return d->m_writer.load() == QThread::currentThread();
 }
 
+void DUChainLock::dumpStatistics(QTextStream& out) const
+{
+  out << "recursive read-locks: " << d->m_recursiveReadLocks.load() << '\n';
+  out << "recursive write-locks: " << d->m_recursiveWriteLocks.load() << '\n';
+  d->m_readWaitTimes.dump(out, QStringLiteral("read-lock wait times"));
+  d->m_readHoldTimes.dump(out, QStringLiteral("read-lock hold times"));
+  d->m_writeWaitTimes.dump(out, QStringLiteral("write-lock wait times"));
+  d->m_writeHoldTimes.dump(out, QStringLiteral("write-lock hold times"));
+}
+
+void DUChainLock::resetStatistics()
+{
+  d->m_readWaitTimes.reset();
+  d->m_readHoldTimes.reset();
+  d->m_writeWaitTimes.reset();
+  d->m_writeHoldTimes.reset();
+  d->m_recursiveReadLocks.store(0);
+  d->m_recursiveWriteLocks.store(0);
+}
+
 DUChainReadLocker::DUChainReadLocker(DUChainLock* duChainLock, uint timeout)
   : m_lock(duChainLock ? duChainLock : DUChain::lock())
   , m_locked(false)
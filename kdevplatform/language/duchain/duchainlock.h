@@ -22,6 +22,8 @@
 #include <language/languageexport.h>
 #include <QScopedPointer>
 
+class QTextStream;
+
 namespace KDevelop
 {
 
@@ -46,6 +48,10 @@ namespace KDevelop
 
 /**
  * Customized read/write locker for the definition-use chain.
+ *
+ * Threads that cannot get the lock sleep until it is released. While the thread holding the
+ * ForegroundLock waits for the lock, other threads step back for a short time, so the UI
+ * is not starved by the background parser threads.
  */
 class KDEVPLATFORMLANGUAGE_EXPORT DUChainLock
 {
@@ -100,6 +106,19 @@ public:
    */
   bool currentThreadHasWriteLock();
 
+  /**
+   * Writes histograms of the times threads waited for and held read- and write-locks to @p out,
+   * and how often the locks were acquired recursively by threads that already held them.
+   *
+   * The statistics are collected since the lock was created, or since the last call to resetStatistics().
+   */
+  void dumpStatistics(QTextStream& out) const;
+
+  /**
+   * Clears the statistics written by dumpStatistics().
+   */
+  void resetStatistics();
+
 private:
   const QScopedPointer<class DUChainLockPrivate> d;
 };
@@ -40,6 +40,8 @@
 #include <language/duchain/duchainregister.h>
 #include <language/duchain/problem.h>
 #include <language/duchain/parsingenvironment.h>
+#include <language/duchain/topducontextstore.h>
+#include <language/editor/modificationrevision.h>
 
 #include <language/codegen/coderepresentation.h>
 
@@ -49,8 +51,14 @@
 // #include <typeinfo>
 #include <set>
 #include <algorithm>
+#include <numeric>
 #include <iterator> // needed for std::insert_iterator on windows
 #include <QThread>
+#include <QTextStream>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
 
 //Extremely slow
 // #define TEST_NORMAL_IMPORTS
@@ -710,6 +718,240 @@ void TestDUChain::testLockForReadWrite()
   QVERIFY(threads.join(1000));
 }
 
+void TestDUChain::testLockTimeout()
+{
+  class ReadLockThread : public QThread
+  {
+  public:
+    void run() override
+    {
+      DUChainReadLocker lock(nullptr, 50);
+      locked = lock.locked();
+    }
+    bool locked = true;
+  };
+
+  ReadLockThread thread;
+  {
+    DUChainWriteLocker lock;
+    thread.start();
+    QVERIFY(thread.wait(1000));
+  }
+  QVERIFY(!thread.locked);
+
+  // the write lock has been released, so the read lock must succeed now
+  thread.start();
+  QVERIFY(thread.wait(1000));
+  QVERIFY(thread.locked);
+}
+
+void TestDUChain::testLockStatistics()
+{
+  DUChain::lock()->resetStatistics();
+  {
+    DUChainWriteLocker lock;
+    {
+      DUChainWriteLocker nestedLock;
+    }
+    DUChainReadLocker readLock;
+  }
+  {
+    DUChainReadLocker lock;
+  }
+
+  QString statistics;
+  QTextStream stream(&statistics);
+  DUChain::lock()->dumpStatistics(stream);
+  stream.flush();
+  // the read lock within the write lock is recursive, and does not need to wait
+  QVERIFY(statistics.contains(QLatin1String("read-lock wait times: 1 samples")));
+  QVERIFY(statistics.contains(QLatin1String("read-lock hold times: 2 samples")));
+  QVERIFY(statistics.contains(QLatin1String("write-lock wait times: 1 samples")));
+  QVERIFY(statistics.contains(QLatin1String("write-lock hold times: 1 samples")));
+  QVERIFY(statistics.contains(QLatin1String("recursive read-locks: 1\n")));
+  QVERIFY(statistics.contains(QLatin1String("recursive write-locks: 1\n")));
+}
+
+void TestDUChain::testTopContextStore()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  const QByteArray first(1000, 'a');
+  const QByteArray second(100, 'b');
+  {
+    QSharedPointer<TopDUContextStore> store(new TopDUContextStore(dir.path()));
+    QVERIFY(!store->contains(1));
+    QVERIFY(!store->map(1).isValid());
+
+    QVERIFY(store->write(1, first));
+    QVERIFY(store->write(2, first));
+    QVERIFY(store->contains(1));
+    {
+      const auto mapping = store->map(1);
+      QVERIFY(mapping.isValid());
+      QCOMPARE(QByteArray(mapping.data(), mapping.size()), first);
+
+      // the mapping must stay valid while the record is replaced
+      QVERIFY(store->write(1, second));
+      QCOMPARE(QByteArray(mapping.data(), mapping.size()), first);
+    }
+    const auto mapping = store->map(1);
+    QCOMPARE(QByteArray(mapping.data(), mapping.size()), second);
+
+    store->remove(2);
+    QVERIFY(!store->contains(2));
+    store->flush();
+
+    // not contained in the flushed index, must be recovered from the segment
+    QVERIFY(store->write(3, second));
+  }
+
+  QSharedPointer<TopDUContextStore> store(new TopDUContextStore(dir.path()));
+  QVERIFY(store->contains(1));
+  QVERIFY(!store->contains(2));
+  QVERIFY(store->contains(3));
+  const auto mapping = store->map(3);
+  QCOMPARE(QByteArray(mapping.data(), mapping.size()), second);
+}
+
+void TestDUChain::testCompressedTopContextStore()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  const QByteArray header(64, 'h');
+  const QByteArray data = header + QByteArray(1000, 'd');
+  {
+    QSharedPointer<TopDUContextStore> store(new TopDUContextStore(dir.path()));
+    store->setCompressionEnabled(true);
+    QVERIFY(store->write(1, data, header.size()));
+    QVERIFY(store->diskSize() < data.size());
+
+    const auto headerMapping = store->mapHeader(1);
+    QCOMPARE(QByteArray(headerMapping.data(), headerMapping.size()), header);
+    const auto mapping = store->map(1);
+    QCOMPARE(QByteArray(mapping.data(), mapping.size()), data);
+  }
+
+  // compressed records are read correctly with compression disabled
+  QSharedPointer<TopDUContextStore> store(new TopDUContextStore(dir.path()));
+  store->setCompressionEnabled(false);
+  const auto mapping = store->map(1);
+  QCOMPARE(QByteArray(mapping.data(), mapping.size()), data);
+}
+
+void TestDUChain::testContentModificationTime()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const QString path = dir.path() + QLatin1String("/file.cpp");
+  const IndexedString url(path);
+
+  auto writeFile = [](const QString& path, const QByteArray& contents) {
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(contents);
+  };
+  // like a parse job, the main thread only hashes in the background
+  auto contentModificationTime = [](const IndexedString& url, const QDateTime& time) {
+    return QtConcurrent::run([&] () {
+      return ModificationRevision::contentModificationTime(url, time);
+    }).result();
+  };
+
+  const QDateTime first = QDateTime::fromTime_t(1000000);
+  writeFile(path, "int foo;");
+  QCOMPARE(contentModificationTime(url, first), first);
+
+  // the content was not hashed yet, so the first change of the on-disk time is reported
+  const QDateTime touched = first.addSecs(10);
+  QCOMPARE(contentModificationTime(url, touched), touched);
+  QCOMPARE(contentModificationTime(url, touched), touched);
+
+  // touched again, but the content is identical
+  QCOMPARE(contentModificationTime(url, touched.addSecs(5)), touched);
+  QCOMPARE(contentModificationTime(url, touched.addSecs(10)), touched);
+
+  const QDateTime second = first.addSecs(30);
+  writeFile(path, "int bar;");
+  QCOMPARE(contentModificationTime(url, second), second);
+  QCOMPARE(contentModificationTime(url, second.addSecs(10)), second);
+
+  // the same content as before the last change is still a change
+  writeFile(path, "int foo;");
+  QCOMPARE(contentModificationTime(url, second.addSecs(20)), second.addSecs(20));
+
+  // the content read for parsing is hashed right away, so already the first touch is no change
+  const QString parsedPath = dir.path() + QLatin1String("/parsed.cpp");
+  const IndexedString parsedUrl(parsedPath);
+  const QByteArray parsedContents("int parsed;");
+  writeFile(parsedPath, parsedContents);
+  QCOMPARE(ModificationRevision::contentModificationTime(parsedUrl, first, &parsedContents), first);
+  QCOMPARE(contentModificationTime(parsedUrl, touched), first);
+
+  // on the main thread, the on-disk time is reported until the content has been hashed in the background
+  const QDateTime touchedAgain = touched.addSecs(10);
+  QCOMPARE(ModificationRevision::contentModificationTime(parsedUrl, touchedAgain), touchedAgain);
+  QTRY_COMPARE(ModificationRevision::contentModificationTime(parsedUrl, touchedAgain), first);
+}
+
+void TestDUChain::testConcurrentLoading()
+{
+  DUChain::self()->disablePersistentStorage(false);
+
+  const int contextCount = 64;
+  const int declarationCount = 50;
+  QVector<IndexedString> urls;
+  {
+    DUChainWriteLocker lock;
+    for (int i = 0; i < contextCount; ++i) {
+      const IndexedString url(QStringLiteral("/concurrent/loading/%1.cpp").arg(i));
+      auto top = new TopDUContext(url, {0, 0, INT_MAX, INT_MAX}, new ParsingEnvironmentFile(url));
+      DUChain::self()->addDocumentChain(top);
+      for (int j = 0; j < declarationCount; ++j) {
+        auto dec = new Declaration({j, 0, j, 1}, top);
+        dec->setIdentifier(Identifier(QStringLiteral("decl_%1_%2").arg(i).arg(j)));
+      }
+      urls << url;
+    }
+  }
+
+  // unloads all the contexts, as they are not referenced
+  DUChain::self()->storeToDisk();
+
+  // every thread loads its own contexts, so the declarations of independent contexts are loaded in parallel
+  QVector<int> contexts(contextCount);
+  std::iota(contexts.begin(), contexts.end(), 0);
+  QAtomicInt failures;
+  QtConcurrent::blockingMap(contexts, [&] (int i) {
+    DUChainReadLocker lock;
+    auto top = DUChain::self()->chainForDocument(urls[i]);
+    if (!top || top->localDeclarations().size() != declarationCount) {
+      failures.ref();
+      return;
+    }
+    int j = 0;
+    foreach (Declaration* dec, top->localDeclarations()) {
+      if (dec->identifier().toString() != QStringLiteral("decl_%1_%2").arg(i).arg(j++)) {
+        failures.ref();
+      }
+    }
+  });
+  QCOMPARE(failures.load(), 0);
+
+  {
+    DUChainWriteLocker lock;
+    foreach (const IndexedString& url, urls) {
+      auto top = DUChain::self()->chainForDocument(url);
+      QVERIFY(top);
+      DUChain::self()->removeDocumentChain(top);
+    }
+  }
+
+  DUChain::self()->disablePersistentStorage(true);
+}
+
 void TestDUChain::testProblemSerialization()
 {
   DUChain::self()->disablePersistentStorage(false);
@@ -44,6 +44,12 @@ private Q_SLOTS:
     void testLockForWrite();
     void testLockForRead();
     void testLockForReadWrite();
+    void testLockTimeout();
+    void testLockStatistics();
+    void testTopContextStore();
+    void testCompressedTopContextStore();
+    void testContentModificationTime();
+    void testConcurrentLoading();
     void testProblemSerialization();
     void testIdentifiers();
     ///NOTE: these are not "automated"!
@@ -20,8 +20,9 @@
 
 #include "topducontextdynamicdata.h"
 
+#include <cstring>
 #include <typeinfo>
-#include <QFile>
+#include <QBuffer>
 #include <QByteArray>
 
 #include "declaration.h"
@@ -34,6 +35,7 @@
 #include "duchainregister.h"
 #include "serialization/itemrepository.h"
 #include "problem.h"
+#include "topducontextstore.h"
 #include <debug.h>
 
 //#define DEBUG_DATA_INFO
@@ -149,16 +151,6 @@ void verifyDataInfo(const TopDUContextDynamicData::ItemDataInfo& info, const QVe
 #endif
 }
 
-QString basePath()
-{
-  return globalItemRepositoryRegistry().path() + QLatin1String("/topcontexts/");
-}
-
-QString pathForTopContext(const uint topContextIndex)
-{
-  return basePath() + QString::number(topContextIndex);
-}
-
 enum LoadType {
   PartialLoad, ///< Only load the direct member data
   FullLoad     ///< Load everything, including appended lists
@@ -166,16 +158,18 @@ enum LoadType {
 template<typename F>
 void loadTopDUContextData(const uint topContextIndex, LoadType loadType, F callback)
 {
-  QFile file(pathForTopContext(topContextIndex));
-  if (!file.open(QIODevice::ReadOnly)) {
+  // The top-context data is the header of the record, so compressed item data is not decompressed
+  const auto mapping = TopDUContextStore::self()->mapHeader(topContextIndex);
+  if (!mapping.isValid() || mapping.size() < sizeof(uint)) {
     return;
   }
 
   uint readValue;
-  file.read((char*)&readValue, sizeof(uint));
+  memcpy(&readValue, mapping.data(), sizeof(uint));
   // now readValue is filled with the top-context data size
-  Q_ASSERT(readValue >= sizeof(TopDUContextData));
-  const QByteArray data = file.read(loadType == FullLoad ? readValue : sizeof(TopDUContextData));
+  Q_ASSERT(readValue >= sizeof(TopDUContextData) && readValue <= mapping.size() - sizeof(uint));
+  // copy the data, so it is properly aligned
+  const QByteArray data(mapping.data() + sizeof(uint), loadType == FullLoad ? readValue : sizeof(TopDUContextData));
   const TopDUContextData* topData = reinterpret_cast<const TopDUContextData*>(data.constData());
   callback(topData);
 }
@@ -246,7 +240,7 @@ void TopDUContextDynamicData::DUChainItemStorage<ProblemPointer>::clearItems()
 template<class Item>
 void TopDUContextDynamicData::DUChainItemStorage<Item>::clearItemIndex(const Item& item, const uint index)
 {
-  if(!data->m_dataLoaded)
+  if(!data->isDataLoaded())
     data->loadData();
 
   if (index < (0x0fffffff/2)) {
@@ -326,7 +320,7 @@ bool TopDUContextDynamicData::DUChainItemStorage<Item>::itemsHaveChanged() const
 template<class Item>
 uint TopDUContextDynamicData::DUChainItemStorage<Item>::allocateItemIndex(const Item& item, const bool temporary)
 {
-  if (!data->m_dataLoaded) {
+  if (!data->isDataLoaded()) {
     data->loadData();
   }
   if (!temporary) {
@@ -341,7 +335,7 @@ uint TopDUContextDynamicData::DUChainItemStorage<Item>::allocateItemIndex(const
 template<class Item>
 bool TopDUContextDynamicData::DUChainItemStorage<Item>::isItemForIndexLoaded(uint index) const
 {
-  if (!data->m_dataLoaded) {
+  if (!data->isDataLoaded()) {
     return false;
   }
   if (index < (0x0fffffff/2)) {
@@ -424,7 +418,7 @@ void TopDUContextDynamicData::DUChainItemStorage<Item>::deleteOnDisk()
 }
 
 template<class Item>
-void TopDUContextDynamicData::DUChainItemStorage<Item>::loadData(QFile* file) const
+void TopDUContextDynamicData::DUChainItemStorage<Item>::loadData(QIODevice* file) const
 {
   Q_ASSERT(offsets.isEmpty());
   Q_ASSERT(items.isEmpty());
@@ -440,7 +434,7 @@ void TopDUContextDynamicData::DUChainItemStorage<Item>::loadData(QFile* file) co
 }
 
 template<class Item>
-void TopDUContextDynamicData::DUChainItemStorage<Item>::writeData(QFile* file)
+void TopDUContextDynamicData::DUChainItemStorage<Item>::writeData(QIODevice* file)
 {
   uint writeValue = offsets.size();
   file->write((char*)&writeValue, sizeof(uint));
@@ -466,11 +460,11 @@ TopDUContextDynamicData::TopDUContextDynamicData(TopDUContext* topContext)
   , m_declarations(this)
   , m_problems(this)
   , m_onDisk(false)
-  , m_dataLoaded(true)
-  , m_mappedFile(nullptr)
+  , m_dataLoaded(1)
   , m_mappedData(nullptr)
   , m_mappedDataSize(0)
   , m_itemRetrievalForbidden(false)
+  , m_store(TopDUContextStore::self())
 {
 }
 
@@ -487,15 +481,14 @@ TopDUContextDynamicData::~TopDUContextDynamicData()
 }
 
 void KDevelop::TopDUContextDynamicData::unmap() {
-  delete m_mappedFile;
-  m_mappedFile = nullptr;
+  m_mapping.reset();
   m_mappedData = nullptr;
   m_mappedDataSize = 0;
 }
 
 bool TopDUContextDynamicData::fileExists(uint topContextIndex)
 {
-  return QFile::exists(pathForTopContext(topContextIndex));
+  return TopDUContextStore::self()->contains(topContextIndex);
 }
 
 QList<IndexedDUContext> TopDUContextDynamicData::loadImporters(uint topContextIndex) {
@@ -528,79 +521,74 @@ IndexedString TopDUContextDynamicData::loadUrl(uint topContextIndex) {
 }
 
 void TopDUContextDynamicData::loadData() const {
-  //This function has to be protected by an additional mutex, since it can be triggered from multiple threads at the same time
-  static QMutex mutex;
-  QMutexLocker lock(&mutex);
-  if(m_dataLoaded)
+  //This function can be triggered from multiple threads at the same time, but only one of them may load the data.
+  //The mutex is per top-context, so unrelated top-contexts are loaded in parallel.
+  QMutexLocker lock(&m_loadMutex);
+  if(isDataLoaded())
     return;
 
-  Q_ASSERT(!m_dataLoaded);
   Q_ASSERT(m_data.isEmpty());
 
-  QFile* file = new QFile(pathForTopContext(m_topContext->ownIndex()));
-  bool open = file->open(QIODevice::ReadOnly);
-  Q_UNUSED(open);
-  Q_ASSERT(open);
-  Q_ASSERT(file->size());
+  auto mapping = m_store->map(m_topContext->ownIndex());
+  Q_ASSERT(mapping.isValid());
+  Q_ASSERT(mapping.size());
+
+  QBuffer buffer;
+  buffer.setData(QByteArray::fromRawData(mapping.data(), mapping.size()));
+  buffer.open(QIODevice::ReadOnly);
 
   //Skip the offsets, we're already read them
   //Skip top-context data
   uint readValue;
-  file->read((char*)&readValue, sizeof(uint));
-  file->seek(readValue + file->pos());
+  buffer.read((char*)&readValue, sizeof(uint));
+  buffer.seek(readValue + buffer.pos());
 
-  m_contexts.loadData(file);
-  m_declarations.loadData(file);
-  m_problems.loadData(file);
+  m_contexts.loadData(&buffer);
+  m_declarations.loadData(&buffer);
+  m_problems.loadData(&buffer);
 
 #ifdef USE_MMAP
 
-  m_mappedData = file->map(file->pos(), file->size() - file->pos());
-  if(m_mappedData) {
-    m_mappedFile = file;
-    m_mappedDataSize = file->size() - file->pos();
-    file->close(); //Close the file, so there is less open file descriptors(May be problematic)
-  }else{
-    qCDebug(LANGUAGE) << "Failed to map" << file->fileName();
-  }
+  //Keep the data mapped, the items are created from it on demand
+  m_mappedData = reinterpret_cast<uchar*>(const_cast<char*>(mapping.data())) + buffer.pos();
+  m_mappedDataSize = mapping.size() - buffer.pos();
+  m_mapping = std::move(mapping);
 
-#endif
+#else
 
-  if(!m_mappedFile) {
-    QByteArray data = file->readAll();
-    m_data.append({data, (uint)data.size()});
-    delete file;
-  }
+  QByteArray data = buffer.readAll();
+  m_data.append({data, (uint)data.size()});
 
-  m_dataLoaded = true;
+#endif
+
+  m_dataLoaded.storeRelease(1);
 }
 
 TopDUContext* TopDUContextDynamicData::load(uint topContextIndex) {
-  QFile file(pathForTopContext(topContextIndex));
-  if(file.open(QIODevice::ReadOnly)) {
-    if(file.size() == 0) {
-      qCWarning(LANGUAGE) << "Top-context file is empty" << file.fileName();
+  //The item data is only needed by loadData()
+  const auto mapping = TopDUContextStore::self()->mapHeader(topContextIndex);
+  if(mapping.isValid()) {
+    if(mapping.size() < sizeof(uint)) {
+      qCWarning(LANGUAGE) << "Top-context data is empty" << topContextIndex;
       return nullptr;
     }
-    QVector<ItemDataInfo> contextDataOffsets;
-    QVector<ItemDataInfo> declarationDataOffsets;
 
     uint readValue;
-    file.read((char*)&readValue, sizeof(uint));
+    memcpy(&readValue, mapping.data(), sizeof(uint));
     //now readValue is filled with the top-context data size
-    QByteArray topContextData = file.read(readValue);
+    QByteArray topContextData(mapping.data() + sizeof(uint), readValue);
 
     DUChainBaseData* topData = reinterpret_cast<DUChainBaseData*>(topContextData.data());
     TopDUContext* ret = dynamic_cast<TopDUContext*>(DUChainItemSystem::self().create(topData));
     if(!ret) {
-      qCWarning(LANGUAGE) << "Cannot load a top-context from file" << file.fileName() << "- the required language-support for handling ID" << topData->classId << "is probably not loaded";
+      qCWarning(LANGUAGE) << "Cannot load the top-context" << topContextIndex << "- the required language-support for handling ID" << topData->classId << "is probably not loaded";
       return nullptr;
     }
 
     TopDUContextDynamicData& target(*ret->m_dynamicData);
 
     target.m_data.clear();
-    target.m_dataLoaded = false;
+    target.m_dataLoaded.storeRelease(0);
     target.m_onDisk = true;
     ret->rebuildDynamicData(nullptr, topContextIndex);
     target.m_topContextData.append({topContextData, (uint)0});
@@ -619,7 +607,7 @@ void TopDUContextDynamicData::deleteOnDisk() {
     return;
   qCDebug(LANGUAGE) << "deleting" << m_topContext->ownIndex() << m_topContext->url().str();
 
-  if(!m_dataLoaded)
+  if(!isDataLoaded())
     loadData();
 
   m_contexts.deleteOnDisk();
@@ -630,16 +618,10 @@ void TopDUContextDynamicData::deleteOnDisk() {
 
   m_onDisk = false;
 
-  bool successfullyRemoved = QFile::remove(filePath());
-  Q_UNUSED(successfullyRemoved);
-  Q_ASSERT(successfullyRemoved);
+  m_store->remove(m_topContext->ownIndex());
   qCDebug(LANGUAGE) << "deletion ready";
 }
 
-QString KDevelop::TopDUContextDynamicData::filePath() const {
-  return pathForTopContext(m_topContext->ownIndex());
-}
-
 bool TopDUContextDynamicData::hasChanged() const
 {
   return !m_onDisk || m_topContext->d_func()->m_dynamic
@@ -659,7 +641,7 @@ void TopDUContextDynamicData::store() {
   ///@todo Save the meta-data into a repository, and only the actual content data into a file.
   ///      This will make saving+loading more efficient, and will reduce the disk-usage.
   ///      Then we also won't need to load the data if only the meta-data changed.
-  if(!m_dataLoaded)
+  if(!isDataLoaded())
     loadData();
 
   ///If the data is mapped, and we re-write the file, we must make sure that the data is copied out of the map,
@@ -711,32 +693,25 @@ void TopDUContextDynamicData::store() {
 
     unmap();
 
-    QDir().mkpath(basePath());
-
-    QFile file(filePath());
-    if(file.open(QIODevice::WriteOnly)) {
-
-      file.resize(0);
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
 
-      file.write((char*)&topContextDataSize, sizeof(uint));
-      foreach(const ArrayWithPosition& pos, m_topContextData)
-        file.write(pos.array.constData(), pos.position);
+    buffer.write((char*)&topContextDataSize, sizeof(uint));
+    foreach(const ArrayWithPosition& pos, m_topContextData)
+      buffer.write(pos.array.constData(), pos.position);
 
-      m_contexts.writeData(&file);
-      m_declarations.writeData(&file);
-      m_problems.writeData(&file);
+    m_contexts.writeData(&buffer);
+    m_declarations.writeData(&buffer);
+    m_problems.writeData(&buffer);
 
-      foreach(const ArrayWithPosition& pos, m_data)
-        file.write(pos.array.constData(), pos.position);
+    foreach(const ArrayWithPosition& pos, m_data)
+      buffer.write(pos.array.constData(), pos.position);
 
+    //The size and the top-context data form the header, which is read without the item data
+    if(m_store->write(m_topContext->ownIndex(), buffer.data(), sizeof(uint) + topContextDataSize)) {
       m_onDisk = true;
-
-      if (file.size() == 0) {
-        qCWarning(LANGUAGE) << "Saving zero size top ducontext data";
-      }
-      file.close();
     } else {
-      qCWarning(LANGUAGE) << "Cannot open top-context for writing";
+      qCWarning(LANGUAGE) << "Cannot write top-context" << m_topContext->ownIndex();
     }
 //   qCDebug(LANGUAGE) << "stored" << m_topContext->url().str() << m_topContext->ownIndex() << "import-count:" << m_topContext->importedParentContexts().size();
 }
@@ -799,7 +774,7 @@ bool TopDUContextDynamicData::isTemporaryDeclarationIndex(uint index) const {
 
 DUContext* TopDUContextDynamicData::getContextForIndex(uint index) const
 {
-  if(!m_dataLoaded)
+  if(!isDataLoaded())
     loadData();
 
   if (index == 0) {
@@ -811,7 +786,7 @@ DUContext* TopDUContextDynamicData::getContextForIndex(uint index) const
 
 Declaration* TopDUContextDynamicData::getDeclarationForIndex(uint index) const
 {
-  if(!m_dataLoaded)
+  if(!isDataLoaded())
     loadData();
 
   return m_declarations.getItemForIndex(index);
@@ -819,7 +794,7 @@ Declaration* TopDUContextDynamicData::getDeclarationForIndex(uint index) const
 
 ProblemPointer TopDUContextDynamicData::getProblemForIndex(uint index) const
 {
-  if(!m_dataLoaded)
+  if(!isDataLoaded())
     loadData();
 
   return m_problems.getItemForIndex(index);
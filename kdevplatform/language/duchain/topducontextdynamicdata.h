@@ -19,11 +19,14 @@
 #ifndef KDEVPLATFORM_TOPDUCONTEXTDYNAMICDATA_H
 #define KDEVPLATFORM_TOPDUCONTEXTDYNAMICDATA_H
 
-#include <QVector>
+#include <QAtomicInt>
 #include <QByteArray>
+#include <QMutex>
+#include <QVector>
 #include "problem.h"
+#include "topducontextstore.h"
 
-class QFile;
+class QIODevice;
 
 namespace KDevelop {
 
@@ -123,11 +126,14 @@ class TopDUContextDynamicData {
 
     void unmap();
     //Converts away from an mmap opened file to a data array
-    
-    QString filePath() const;
 
     void loadData() const;
 
+    bool isDataLoaded() const
+    {
+      return m_dataLoaded.loadAcquire();
+    }
+
     const char* pointerInData(uint offset) const;
 
     ItemDataInfo writeDataInfo(const ItemDataInfo& info, const DUChainBaseData* data, uint& totalDataOffset);
@@ -153,8 +159,8 @@ class TopDUContextDynamicData {
       void deleteOnDisk();
       bool isItemForIndexLoaded(uint index) const;
 
-      void loadData(QFile* file) const;
-      void writeData(QFile* file);
+      void loadData(QIODevice* file) const;
+      void writeData(QIODevice* file);
 
       //May contain zero items if they were deleted
       mutable QVector<Item> items;
@@ -172,12 +178,17 @@ class TopDUContextDynamicData {
     mutable QVector<ArrayWithPosition> m_data;
     mutable QVector<ArrayWithPosition> m_topContextData;
     bool m_onDisk;
-    mutable bool m_dataLoaded;
+    ///Whether the item offsets have been loaded and the data has been mapped, see loadData()
+    mutable QAtomicInt m_dataLoaded;
+    ///Serializes loadData() for this top-context
+    mutable QMutex m_loadMutex;
 
-    mutable QFile* m_mappedFile;
+    mutable TopDUContextStore::Mapping m_mapping;
     mutable uchar* m_mappedData;
     mutable size_t m_mappedDataSize;
     mutable bool m_itemRetrievalForbidden;
+    ///The store the data is written to, resolved once for this top-context
+    const QSharedPointer<TopDUContextStore> m_store;
 };
 }
 
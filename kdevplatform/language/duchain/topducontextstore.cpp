@@ -0,0 +1,571 @@
+/* This file is part of KDevelop
+
+   Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "topducontextstore.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+
+#include <serialization/abstractitemrepository.h>
+#include <serialization/itemrepositoryregistry.h>
+
+#include <debug.h>
+
+#include <cstring>
+#include <utility>
+
+using namespace KDevelop;
+
+namespace {
+
+enum : quint32 {
+  RecordMagic = 0x54435253, // "TCRS"
+  IndexMagic = 0x54435349, // "TCSI"
+  IndexVersion = 2
+};
+
+enum RecordFlags : quint32 {
+  DataRecord = 0,
+  RemovedRecord = 1,
+  // The data was compressed with qCompress()
+  CompressedRecord = 2,
+  // The size of the header and the header are followed by the remaining data compressed with qCompress()
+  CompressedBodyRecord = 4
+};
+
+struct RecordHeader
+{
+  quint32 magic;
+  quint32 topContextIndex;
+  quint32 size;
+  quint32 flags;
+};
+
+// Records start at aligned positions, so the mapped data is as aligned as it was in the separate files
+const qint64 recordAlignment = 16;
+static_assert(sizeof(RecordHeader) % recordAlignment == 0, "the data of a record must be aligned");
+
+// Once the active segment reaches this size, a new segment is started
+const qint64 maxSegmentSize = 64 * 1024 * 1024;
+
+qint64 alignedRecordSize(uint dataSize)
+{
+  const qint64 size = sizeof(RecordHeader) + dataSize;
+  return (size + recordAlignment - 1) / recordAlignment * recordAlignment;
+}
+
+QSharedPointer<TopDUContextStore>& globalStore()
+{
+  // Intentionally leaked like the registry, the store is released by closeSelf() on shutdown
+  static auto* store = new QSharedPointer<TopDUContextStore>(
+    new TopDUContextStore(globalItemRepositoryRegistry().path() + QLatin1String("/topcontexts")));
+  return *store;
+}
+
+}
+
+TopDUContextStore::Mapping::Mapping()
+  : m_segment(-1)
+  , m_data(nullptr)
+  , m_size(0)
+{
+}
+
+TopDUContextStore::Mapping::Mapping(Mapping&& rhs)
+  : m_store(std::move(rhs.m_store))
+  , m_segment(rhs.m_segment)
+  , m_data(rhs.m_data)
+  , m_size(rhs.m_size)
+  , m_copy(std::move(rhs.m_copy))
+{
+  rhs.m_store.reset();
+  rhs.m_segment = -1;
+  rhs.m_data = nullptr;
+  rhs.m_size = 0;
+}
+
+TopDUContextStore::Mapping& TopDUContextStore::Mapping::operator=(Mapping&& rhs)
+{
+  if (this != &rhs) {
+    reset();
+    m_store.swap(rhs.m_store);
+    std::swap(m_segment, rhs.m_segment);
+    std::swap(m_data, rhs.m_data);
+    std::swap(m_size, rhs.m_size);
+    m_copy.swap(rhs.m_copy);
+  }
+  return *this;
+}
+
+TopDUContextStore::Mapping::~Mapping()
+{
+  reset();
+}
+
+void TopDUContextStore::Mapping::reset()
+{
+  if (m_store) {
+    m_store->release(*this);
+  }
+  m_store.reset();
+  m_segment = -1;
+  m_data = nullptr;
+  m_size = 0;
+  m_copy.clear();
+}
+
+TopDUContextStore::TopDUContextStore(const QString& path)
+  : m_path(path)
+  , m_compressionEnabled(itemRepositoryCompressionEnabled())
+{
+  load();
+}
+
+TopDUContextStore::~TopDUContextStore()
+{
+  flush();
+  for (auto& segment : m_segments) {
+    delete segment.file;
+  }
+}
+
+QSharedPointer<TopDUContextStore> TopDUContextStore::self()
+{
+  return globalStore();
+}
+
+void TopDUContextStore::closeSelf()
+{
+  if (globalStore()) {
+    globalStore()->flush();
+  }
+  globalStore().reset();
+}
+
+QString TopDUContextStore::segmentPath(int segment) const
+{
+  return m_path + QLatin1String("/segment_") + QString::number(segment);
+}
+
+QString TopDUContextStore::indexPath() const
+{
+  return m_path + QLatin1String("/index");
+}
+
+void TopDUContextStore::load()
+{
+  QDir dir(m_path);
+  dir.mkpath(m_path);
+
+  // Find the segments that exist on disk
+  int segmentCount = 0;
+  const auto segmentFiles = dir.entryList({QStringLiteral("segment_*")}, QDir::Files);
+  for (const auto& fileName : segmentFiles) {
+    bool ok = false;
+    const int segment = fileName.midRef(8).toInt(&ok);
+    if (ok) {
+      segmentCount = qMax(segmentCount, segment + 1);
+    }
+  }
+  m_segments.resize(segmentCount);
+
+  // Read the index, which stays valid for the segments that still exist
+  QFile indexFile(indexPath());
+  if (indexFile.open(QIODevice::ReadOnly)) {
+    QDataStream stream(&indexFile);
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+    if (magic == IndexMagic && version == IndexVersion) {
+      qint32 indexedSegments = 0;
+      stream >> indexedSegments;
+      for (int a = 0; a < indexedSegments && a < m_segments.size(); ++a) {
+        stream >> m_segments[a].garbage >> m_segments[a].indexedEnd;
+      }
+      quint32 entries = 0;
+      stream >> entries;
+      for (quint32 a = 0; a < entries && stream.status() == QDataStream::Ok; ++a) {
+        quint32 topContextIndex = 0, size = 0, flags = 0;
+        qint32 segment = 0;
+        qint64 offset = 0;
+        stream >> topContextIndex >> segment >> offset >> size >> flags;
+        if (segment >= 0 && segment < m_segments.size() && QFile::exists(segmentPath(segment))) {
+          m_index.insert(topContextIndex, {segment, offset, size, flags});
+        }
+      }
+      if (stream.status() != QDataStream::Ok) {
+        qCWarning(LANGUAGE) << "top-context index is corrupted, scanning all segments";
+        m_index.clear();
+        for (auto& segment : m_segments) {
+          segment.garbage = segment.indexedEnd = 0;
+        }
+      }
+    }
+  }
+
+  // Open the segments, and recover the records that were appended after the index was written
+  for (int a = 0; a < m_segments.size(); ++a) {
+    if (!QFile::exists(segmentPath(a))) {
+      m_segments[a].retired = true;
+      continue;
+    }
+    m_segments[a].file = new QFile(segmentPath(a));
+    if (!m_segments[a].file->open(QIODevice::ReadWrite)) {
+      qCWarning(LANGUAGE) << "cannot open top-context segment" << segmentPath(a);
+      delete m_segments[a].file;
+      m_segments[a].file = nullptr;
+      m_segments[a].retired = true;
+      continue;
+    }
+    scan(a);
+  }
+}
+
+void TopDUContextStore::scan(int segment)
+{
+  Segment& seg = m_segments[segment];
+  qint64 pos = seg.indexedEnd;
+  const qint64 fileSize = seg.file->size();
+
+  while (pos + qint64(sizeof(RecordHeader)) <= fileSize) {
+    RecordHeader header;
+    seg.file->seek(pos);
+    if (seg.file->read(reinterpret_cast<char*>(&header), sizeof(RecordHeader)) != sizeof(RecordHeader)
+        || header.magic != RecordMagic || pos + alignedRecordSize(header.size) > fileSize) {
+      break;
+    }
+
+    const auto it = m_index.constFind(header.topContextIndex);
+    if (it != m_index.constEnd()) {
+      m_segments[it->segment].garbage += alignedRecordSize(it->size);
+    }
+    if (header.flags == RemovedRecord) {
+      m_index.remove(header.topContextIndex);
+      seg.garbage += alignedRecordSize(0);
+    } else {
+      m_index.insert(header.topContextIndex, {segment, pos + qint64(sizeof(RecordHeader)), header.size, header.flags});
+    }
+    pos += alignedRecordSize(header.size);
+  }
+
+  if (pos < fileSize) {
+    // The application crashed while appending a record
+    qCWarning(LANGUAGE) << "dropping incomplete top-context record in" << seg.file->fileName();
+    seg.file->resize(pos);
+  }
+  seg.indexedEnd = pos;
+}
+
+TopDUContextStore::Segment& TopDUContextStore::activeSegment()
+{
+  if (!m_segments.isEmpty()) {
+    Segment& last = m_segments.last();
+    if (!last.retired && last.file && last.file->size() < maxSegmentSize) {
+      return last;
+    }
+  }
+
+  Segment segment;
+  segment.file = new QFile(segmentPath(m_segments.size()));
+  if (!segment.file->open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+    qCWarning(LANGUAGE) << "cannot create top-context segment" << segment.file->fileName();
+  }
+  m_segments.append(segment);
+  return m_segments.last();
+}
+
+bool TopDUContextStore::append(uint topContextIndex, const char* data, uint size, uint flags)
+{
+  const int segment = &activeSegment() - m_segments.data();
+  QFile* file = m_segments[segment].file;
+  if (!file->isOpen()) {
+    return false;
+  }
+
+  const qint64 pos = file->size();
+  const qint64 recordSize = alignedRecordSize(size);
+  const RecordHeader header = {RecordMagic, topContextIndex, size, flags};
+  const QByteArray padding(recordSize - sizeof(RecordHeader) - size, 0);
+
+  file->seek(pos);
+  if (file->write(reinterpret_cast<const char*>(&header), sizeof(RecordHeader)) != sizeof(RecordHeader)
+      || (size && file->write(data, size) != size) || file->write(padding) != padding.size() || !file->flush()) {
+    qCWarning(LANGUAGE) << "failed to write top-context" << topContextIndex << "to" << file->fileName();
+    file->resize(pos);
+    return false;
+  }
+
+  const auto it = m_index.constFind(topContextIndex);
+  if (it != m_index.constEnd()) {
+    m_segments[it->segment].garbage += alignedRecordSize(it->size);
+  }
+  if (flags == RemovedRecord) {
+    m_index.remove(topContextIndex);
+    m_segments[segment].garbage += recordSize;
+  } else {
+    m_index.insert(topContextIndex, {segment, pos + qint64(sizeof(RecordHeader)), size, flags});
+  }
+  return true;
+}
+
+bool TopDUContextStore::contains(uint topContextIndex) const
+{
+  QMutexLocker lock(&m_mutex);
+  return m_index.contains(topContextIndex);
+}
+
+TopDUContextStore::Mapping TopDUContextStore::map(uint topContextIndex)
+{
+  return mapRecord(topContextIndex, false);
+}
+
+TopDUContextStore::Mapping TopDUContextStore::mapHeader(uint topContextIndex)
+{
+  return mapRecord(topContextIndex, true);
+}
+
+TopDUContextStore::Mapping TopDUContextStore::mapRecord(uint topContextIndex, bool headerOnly)
+{
+  Mapping ret;
+  QByteArray stored;
+  uint flags = 0;
+  QString fileName;
+
+  {
+    QMutexLocker lock(&m_mutex);
+
+    const auto it = m_index.constFind(topContextIndex);
+    if (it == m_index.constEnd()) {
+      return ret;
+    }
+
+    Segment& segment = m_segments[it->segment];
+    if (it->flags & (CompressedRecord | CompressedBodyRecord)) {
+      // Only the stored data is read under the lock, it is decompressed afterwards
+      segment.file->seek(it->offset);
+      if (headerOnly && (it->flags & CompressedBodyRecord)) {
+        quint32 headerSize = 0;
+        segment.file->read(reinterpret_cast<char*>(&headerSize), sizeof(quint32));
+        stored = segment.file->read(qMin<quint32>(headerSize, it->size - sizeof(quint32)));
+        if (stored.size() != int(headerSize)) {
+          qCWarning(LANGUAGE) << "failed to read header of top-context" << topContextIndex << "from" << segment.file->fileName();
+          return Mapping();
+        }
+        ret.m_copy = stored;
+        ret.m_data = ret.m_copy.constData();
+        ret.m_size = ret.m_copy.size();
+        return ret;
+      }
+      stored = segment.file->read(it->size);
+      if (stored.size() != int(it->size)) {
+        qCWarning(LANGUAGE) << "failed to read top-context" << topContextIndex << "from" << segment.file->fileName();
+        return Mapping();
+      }
+      flags = it->flags;
+      fileName = segment.file->fileName();
+    } else {
+      ret.m_size = it->size;
+      if (uchar* data = segment.file->map(it->offset, it->size)) {
+        ret.m_store = sharedFromThis();
+        Q_ASSERT(ret.m_store);
+        ret.m_segment = it->segment;
+        ret.m_data = reinterpret_cast<const char*>(data);
+        ++segment.mappings;
+      } else {
+        qCDebug(LANGUAGE) << "Failed to map top-context" << topContextIndex << "in" << segment.file->fileName();
+        segment.file->seek(it->offset);
+        ret.m_copy = segment.file->read(it->size);
+        if (ret.m_copy.size() != int(it->size)) {
+          qCWarning(LANGUAGE) << "failed to read top-context" << topContextIndex << "from" << segment.file->fileName();
+          return Mapping();
+        }
+        ret.m_data = ret.m_copy.constData();
+      }
+      return ret;
+    }
+  }
+
+  // Decompressed into memory, which stays valid as long as the top-context uses it
+  if (flags & CompressedBodyRecord) {
+    quint32 headerSize = 0;
+    if (stored.size() >= int(sizeof(quint32))) {
+      memcpy(&headerSize, stored.constData(), sizeof(quint32));
+    }
+    const int bodyOffset = sizeof(quint32) + headerSize;
+    if (bodyOffset <= stored.size()) {
+      ret.m_copy = stored.mid(sizeof(quint32), headerSize)
+                 + qUncompress(reinterpret_cast<const uchar*>(stored.constData()) + bodyOffset, stored.size() - bodyOffset);
+    }
+    if (ret.m_copy.size() <= int(headerSize)) {
+      ret.m_copy.clear();
+    }
+  } else {
+    ret.m_copy = qUncompress(stored);
+  }
+  if (ret.m_copy.isEmpty()) {
+    qCWarning(LANGUAGE) << "failed to decompress top-context" << topContextIndex << "from" << fileName;
+    return Mapping();
+  }
+  ret.m_data = ret.m_copy.constData();
+  ret.m_size = ret.m_copy.size();
+  return ret;
+}
+
+void TopDUContextStore::release(Mapping& mapping)
+{
+  QMutexLocker lock(&m_mutex);
+
+  Segment& segment = m_segments[mapping.m_segment];
+  segment.file->unmap(reinterpret_cast<uchar*>(const_cast<char*>(mapping.m_data)));
+  if (!--segment.mappings && segment.retired) {
+    retire(mapping.m_segment);
+  }
+}
+
+bool TopDUContextStore::write(uint topContextIndex, const QByteArray& data, uint headerSize)
+{
+  Q_ASSERT(headerSize <= uint(data.size()));
+
+  bool compressionEnabled = false;
+  {
+    QMutexLocker lock(&m_mutex);
+    compressionEnabled = m_compressionEnabled;
+  }
+
+  if (compressionEnabled) {
+    // Fast compression, decompressing is what matters when loading. Done outside of the lock, and the header
+    // is kept as it is, so reading it doesn't need to decompress the whole record.
+    const quint32 size = headerSize;
+    const QByteArray compressed = QByteArray(reinterpret_cast<const char*>(&size), sizeof(quint32))
+                                + data.left(headerSize)
+                                + qCompress(reinterpret_cast<const uchar*>(data.constData()) + headerSize, data.size() - headerSize, 1);
+    if (compressed.size() < data.size()) {
+      QMutexLocker lock(&m_mutex);
+      return append(topContextIndex, compressed.constData(), compressed.size(), CompressedBodyRecord);
+    }
+  }
+
+  QMutexLocker lock(&m_mutex);
+  return append(topContextIndex, data.constData(), data.size(), DataRecord);
+}
+
+void TopDUContextStore::remove(uint topContextIndex)
+{
+  QMutexLocker lock(&m_mutex);
+  if (m_index.contains(topContextIndex)) {
+    append(topContextIndex, nullptr, 0, RemovedRecord);
+  }
+}
+
+void TopDUContextStore::retire(int segment)
+{
+  Segment& seg = m_segments[segment];
+  seg.retired = true;
+  if (seg.mappings || !seg.file) {
+    // Deleted once the last mapping is released
+    return;
+  }
+
+  seg.file->close();
+  seg.file->remove();
+  delete seg.file;
+  seg.file = nullptr;
+}
+
+void TopDUContextStore::compact()
+{
+  QMutexLocker lock(&m_mutex);
+
+  for (int a = 0; a < m_segments.size() - 1; ++a) {
+    Segment& segment = m_segments[a];
+    if (segment.retired || !segment.file || segment.garbage * 2 < segment.file->size()) {
+      continue;
+    }
+
+    // Move the remaining records into the active segment
+    QVector<uint> topContexts;
+    for (auto it = m_index.constBegin(); it != m_index.constEnd(); ++it) {
+      if (it->segment == a) {
+        topContexts << it.key();
+      }
+    }
+
+    bool moved = true;
+    for (uint topContextIndex : topContexts) {
+      const Location location = m_index.value(topContextIndex);
+      m_segments[a].file->seek(location.offset);
+      const QByteArray data = m_segments[a].file->read(location.size);
+      if (data.size() != int(location.size) || !append(topContextIndex, data.constData(), data.size(), location.flags)) {
+        moved = false;
+        break;
+      }
+    }
+
+    if (moved) {
+      qCDebug(LANGUAGE) << "compacted top-context segment" << a << "with" << topContexts.size() << "remaining records";
+      retire(a);
+    }
+  }
+}
+
+void TopDUContextStore::flush()
+{
+  QMutexLocker lock(&m_mutex);
+
+  QSaveFile indexFile(indexPath());
+  if (!indexFile.open(QIODevice::WriteOnly)) {
+    qCWarning(LANGUAGE) << "cannot write top-context index" << indexFile.fileName();
+    return;
+  }
+
+  QDataStream stream(&indexFile);
+  stream << quint32(IndexMagic) << quint32(IndexVersion);
+
+  stream << qint32(m_segments.size());
+  for (auto& segment : m_segments) {
+    segment.indexedEnd = segment.file ? segment.file->size() : 0;
+    stream << segment.garbage << segment.indexedEnd;
+  }
+
+  stream << quint32(m_index.size());
+  for (auto it = m_index.constBegin(); it != m_index.constEnd(); ++it) {
+    stream << quint32(it.key()) << qint32(it->segment) << it->offset << quint32(it->size) << quint32(it->flags);
+  }
+
+  indexFile.commit();
+}
+
+void TopDUContextStore::setCompressionEnabled(bool enabled)
+{
+  QMutexLocker lock(&m_mutex);
+  m_compressionEnabled = enabled;
+}
+
+qint64 TopDUContextStore::diskSize() const
+{
+  QMutexLocker lock(&m_mutex);
+  qint64 ret = 0;
+  for (const auto& segment : m_segments) {
+    if (segment.file) {
+      ret += segment.file->size();
+    }
+  }
+  return ret;
+}
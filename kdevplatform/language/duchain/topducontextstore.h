@@ -0,0 +1,185 @@
+/* This file is part of KDevelop
+
+   Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KDEVPLATFORM_TOPDUCONTEXTSTORE_H
+#define KDEVPLATFORM_TOPDUCONTEXTSTORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include <language/languageexport.h>
+
+class QFile;
+
+namespace KDevelop {
+
+/**
+ * Packed on-disk storage for the data of all top-contexts.
+ *
+ * Instead of using one file per top-context, the data is appended as records to a few large segment files,
+ * and an in-memory index maps each top-context index to its record. Loading a top-context is one hash lookup
+ * and one mmap, and no file system lookups are needed to check whether a top-context is stored.
+ *
+ * Replaced or removed records leave garbage in their segment. compact() moves the remaining records out of
+ * segments that mostly contain garbage, and deletes those segments once they are not mapped any more.
+ *
+ * The index is written to disk by flush(). Records appended afterwards are recovered when the store is
+ * opened again by scanning the segments behind the indexed positions.
+ *
+ * When compression is enabled, records are compressed before they are written, except for a header that is
+ * kept uncompressed so mapHeader() can read it cheaply. Compressed records cannot be mapped, map() decompresses
+ * them into memory owned by the Mapping instead.
+ *
+ * All functions are thread-safe. The store must be owned by a QSharedPointer, since every Mapping keeps it alive.
+ */
+class KDEVPLATFORMLANGUAGE_EXPORT TopDUContextStore : public QEnableSharedFromThis<TopDUContextStore>
+{
+public:
+  /**
+   * Read-only view of the data of one top-context. Keeps the data mapped as long as it exists.
+   */
+  class KDEVPLATFORMLANGUAGE_EXPORT Mapping
+  {
+  public:
+    Mapping();
+    Mapping(Mapping&& rhs);
+    Mapping& operator=(Mapping&& rhs);
+    ~Mapping();
+
+    bool isValid() const
+    {
+      return m_data;
+    }
+
+    const char* data() const
+    {
+      return m_data;
+    }
+
+    uint size() const
+    {
+      return m_size;
+    }
+
+    /// Unmaps the data, and makes this mapping invalid.
+    void reset();
+
+  private:
+    friend class TopDUContextStore;
+
+    QSharedPointer<TopDUContextStore> m_store;
+    int m_segment;
+    const char* m_data;
+    uint m_size;
+    ///Holds the data if mapping the segment failed
+    QByteArray m_copy;
+
+    Q_DISABLE_COPY(Mapping)
+  };
+
+  /// Opens the store in the directory @p path, creating it if needed.
+  explicit TopDUContextStore(const QString& path);
+  ~TopDUContextStore();
+
+  /// @returns the store in the directory of the global item-repository registry.
+  /// It is opened on first use, and lives as long as the registry, which never changes its directory.
+  static QSharedPointer<TopDUContextStore> self();
+
+  /// Flushes the store returned by self() and releases it, it is closed once the last Mapping is gone.
+  /// Only called on shutdown, when no other thread uses the store any more.
+  static void closeSelf();
+
+  /// @returns whether data is stored for the top-context with the given index
+  bool contains(uint topContextIndex) const;
+
+  /// Maps the data of the given top-context. The mapping is invalid if nothing is stored for it.
+  Mapping map(uint topContextIndex);
+
+  /// Like map(), but only the header given to write() needs to be contained in the mapping,
+  /// so the remainder of a compressed record is not decompressed.
+  Mapping mapHeader(uint topContextIndex);
+
+  /// Stores @p data for the given top-context, replacing the previous data.
+  /// The first @p headerSize bytes of @p data are never compressed, see mapHeader().
+  bool write(uint topContextIndex, const QByteArray& data, uint headerSize = 0);
+
+  /// Removes the data of the given top-context.
+  void remove(uint topContextIndex);
+
+  /// Moves the records out of segments that mostly contain garbage.
+  void compact();
+
+  /// Writes the index to disk, so the segments don't need to be scanned the next time the store is opened.
+  void flush();
+
+  /// Enables or disables compressing the records written from now on, the default is itemRepositoryCompressionEnabled().
+  /// Records that are already stored are read correctly in both modes.
+  void setCompressionEnabled(bool enabled);
+
+  /// @returns the count of bytes used by the segments on disk
+  qint64 diskSize() const;
+
+private:
+  struct Location
+  {
+    int segment;
+    qint64 offset;
+    uint size;
+    uint flags;
+  };
+
+  struct Segment
+  {
+    QFile* file = nullptr;
+    ///Size of the data of replaced and removed records in this segment
+    qint64 garbage = 0;
+    ///Position up to which the records are contained in the stored index
+    qint64 indexedEnd = 0;
+    ///Count of Mappings into this segment
+    int mappings = 0;
+    ///Whether all records have been moved out of this segment, it is deleted once it's not mapped any more
+    bool retired = false;
+  };
+
+  void load();
+  void scan(int segment);
+  bool append(uint topContextIndex, const char* data, uint size, uint flags);
+  Mapping mapRecord(uint topContextIndex, bool headerOnly);
+  void release(Mapping& mapping);
+  void retire(int segment);
+  QString segmentPath(int segment) const;
+  QString indexPath() const;
+  Segment& activeSegment();
+
+  QString m_path;
+  mutable QMutex m_mutex;
+  QHash<uint, Location> m_index;
+  QVector<Segment> m_segments;
+  bool m_compressionEnabled;
+
+  Q_DISABLE_COPY(TopDUContextStore)
+};
+
+}
+
+#endif // KDEVPLATFORM_TOPDUCONTEXTSTORE_H
@@ -19,11 +19,20 @@
 #include "modificationrevision.h"
 
 #include <QString>
+#include <QCoreApplication>
+#include <QFile>
 #include <QFileInfo>
+#include <QCryptographicHash>
+#include <QSet>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrentRun>
 
 #include <ktexteditor/document.h>
 
 #include <serialization/indexedstring.h>
+#include <serialization/itemrepository.h>
+#include <serialization/itemrepositoryregistry.h>
 #include "modificationrevisionset.h"
 
 /// @todo Listen to filesystem changes (together with the project manager)
@@ -57,21 +66,272 @@ OpenDocumentRevisionsMap& openDocumentsRevisionMap()
   return map;
 }
 
+///Files that were not checked for this long are removed from the file content repository
+const uint fileContentExpirySeconds = 30 * 24 * 60 * 60;
+///The time a file was last checked is only updated with this resolution, so the repository isn't changed on every check
+const uint fileContentCheckResolution = 24 * 60 * 60;
+
+///Remembers the content of a file at the time its modification-time was recorded
+struct FileContentItem {
+  KDevelop::IndexedString file;
+  ///The on-disk modification-time that was last seen
+  uint diskModificationTime;
+  ///The modification-time reported for the file, kept as long as the content doesn't change
+  uint modificationTime;
+  ///When the file was last checked, see fileContentCheckResolution
+  uint lastCheckTime;
+  ///Zero until the content was read for parsing, or the on-disk modification-time changed
+  quint64 contentHash;
+
+  FileContentItem(const KDevelop::IndexedString& _file) : file(_file), diskModificationTime(0), modificationTime(0), lastCheckTime(0), contentHash(0) {
+  }
+
+  unsigned int hash() const {
+    return file.hash();
+  }
+
+  unsigned short int itemSize() const {
+    return sizeof(FileContentItem);
+  }
+};
+
+struct FileContentItemRequest {
+
+  FileContentItemRequest(const KDevelop::IndexedString& file) : m_file(file) {
+  }
+
+  const KDevelop::IndexedString& m_file;
+
+  enum {
+    AverageSize = sizeof(FileContentItem)
+  };
+
+  unsigned int hash() const {
+    return m_file.hash();
+  }
+
+  uint itemSize() const {
+    return sizeof(FileContentItem);
+  }
+
+  void createItem(FileContentItem* item) const {
+    new (item) FileContentItem(m_file);
+  }
+
+  bool equals(const FileContentItem* item) const {
+    return item->file == m_file;
+  }
+
+  static void destroy(FileContentItem* item, KDevelop::AbstractItemRepository&) {
+    item->~FileContentItem();
+  }
+
+  static bool persistent(const FileContentItem* /*item*/) {
+    return true;
+  }
+};
+
+typedef KDevelop::ItemRepository<FileContentItem, FileContentItemRequest, true, false> FileContentRepository;
+
+///Only set once the item-repository registry exists, before that the on-disk modification-times are used as they are
+static QAtomicPointer<FileContentRepository> fileContentRepository;
+
+struct ExpiredFileContentVisitor {
+  explicit ExpiredFileContentVisitor(uint _now) : now(_now) {
+  }
+
+  bool operator()(const FileContentItem* item) {
+    if (now - item->lastCheckTime > fileContentExpirySeconds) {
+      expired << item->file;
+    }
+    return true;
+  }
+
+  uint now;
+  QVector<KDevelop::IndexedString> expired;
+};
+
+///Removes the files that were not checked for a while, once a day, so the repository doesn't grow without bound
+static void removeExpiredFileContents(FileContentRepository* repository)
+{
+  const uint now = QDateTime::currentDateTime().toTime_t();
+  QAtomicInt& lastRemoval = globalItemRepositoryRegistry().getCustomCounter(QStringLiteral("File Content Expiry"), 0);
+  if (now - static_cast<uint>(lastRemoval.load()) < fileContentCheckResolution) {
+    return;
+  }
+  lastRemoval.store(static_cast<int>(now));
+
+  ExpiredFileContentVisitor visitor(now);
+  repository->visitAllItems(visitor);
+  foreach (const IndexedString& file, visitor.expired) {
+    if (const uint index = repository->findIndex(FileContentItemRequest(file))) {
+      repository->deleteItem(index);
+    }
+  }
+}
+
+void initModificationRevisionRepository() {
+  static FileContentRepository rep(QStringLiteral("file content repository"), &globalItemRepositoryRegistry(), 2);
+  removeExpiredFileContents(&rep);
+  fileContentRepository.storeRelease(&rep);
+}
+
+static quint64 hashContent(const QByteArray& content)
+{
+  quint64 hash;
+  const QByteArray md5 = QCryptographicHash::hash(content, QCryptographicHash::Md5);
+  memcpy(&hash, md5.constData(), sizeof(quint64));
+  return hash;
+}
+
+static bool hashFileContent(const IndexedString& fileName, quint64* hash)
+{
+  QFile file(fileName.str());
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QCryptographicHash md5(QCryptographicHash::Md5);
+  if (!md5.addData(&file)) {
+    return false;
+  }
+  memcpy(hash, md5.result().constData(), sizeof(quint64));
+  return true;
+}
+
+///Records the content hash of the file with the given on-disk modification-time, and returns the time to report for it
+static uint recordContentHash(FileContentRepository* repository, const IndexedString& fileName, uint diskTime, quint64 contentHash)
+{
+  QMutexLocker lock(repository->mutex());
+  FileContentItem* item = repository->dynamicItemFromIndexSimple(repository->index(FileContentItemRequest(fileName)));
+  item->lastCheckTime = QDateTime::currentDateTime().toTime_t();
+  // A content that was never hashed counts as changed
+  if (item->contentHash != contentHash || !item->modificationTime) {
+    item->modificationTime = diskTime;
+    item->contentHash = contentHash;
+  }
+  item->diskModificationTime = diskTime;
+  return item->modificationTime;
+}
+
+///The files whose content is hashed in the background, see checkContentModificationTime()
+static QSet<IndexedString>& pendingContentHashes()
+{
+  static QSet<IndexedString> files;
+  return files;
+}
+
+///Hashes the content outside of the calling thread, and makes the result visible to revisionForFile() once it's done
+static void hashFileContentInBackground(FileContentRepository* repository, const IndexedString& fileName, uint diskTime)
+{
+  {
+    QMutexLocker lock(&fileModificationTimeCacheMutex);
+    if (pendingContentHashes().contains(fileName)) {
+      return;
+    }
+    pendingContentHashes().insert(fileName);
+  }
+
+  QtConcurrent::run([repository, fileName, diskTime] () {
+    quint64 contentHash;
+    if (hashFileContent(fileName, &contentHash)) {
+      recordContentHash(repository, fileName, diskTime, contentHash);
+    }
+    {
+      QMutexLocker lock(&fileModificationTimeCacheMutex);
+      pendingContentHashes().remove(fileName);
+    }
+    ModificationRevision::clearModificationCache(fileName);
+  });
+}
+
+static bool isGuiThread()
+{
+  return QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread();
+}
+
+///@param hashPending Set to true if the returned time is the on-disk one, because the content is still being hashed
+static QDateTime checkContentModificationTime(const IndexedString& fileName, const QDateTime& diskModificationTime,
+                                              const QByteArray* content, bool* hashPending)
+{
+  FileContentRepository* repository = fileContentRepository.loadAcquire();
+  if (!repository || !diskModificationTime.isValid()) {
+    return diskModificationTime;
+  }
+
+  const uint diskTime = diskModificationTime.toTime_t();
+  if (content) {
+    // The content has been read anyway, so hashing it is cheap
+    return QDateTime::fromTime_t(recordContentHash(repository, fileName, diskTime, hashContent(*content)));
+  }
+
+  const uint now = QDateTime::currentDateTime().toTime_t();
+  const FileContentItemRequest request(fileName);
+  {
+    QMutexLocker lock(repository->mutex());
+    const uint index = repository->findIndex(request);
+    if (!index) {
+      // The content is hashed once the file is read for parsing, or once the on-disk time changes
+      FileContentItem* item = repository->dynamicItemFromIndexSimple(repository->index(request));
+      item->diskModificationTime = diskTime;
+      item->modificationTime = diskTime;
+      item->lastCheckTime = now;
+      return QDateTime::fromTime_t(diskTime);
+    }
+    const FileContentItem* item = repository->itemFromIndex(index);
+    if (item->diskModificationTime == diskTime) {
+      if (now - item->lastCheckTime > fileContentCheckResolution) {
+        repository->dynamicItemFromIndexSimple(index)->lastCheckTime = now;
+      }
+      return QDateTime::fromTime_t(item->modificationTime);
+    }
+  }
+
+  if (isGuiThread()) {
+    // Reading the whole file would block the UI, the on-disk time is reported until the hash is known
+    hashFileContentInBackground(repository, fileName, diskTime);
+    if (hashPending) {
+      *hashPending = true;
+    }
+    return diskModificationTime;
+  }
+
+  // Not locked while hashing, so other files can be checked meanwhile
+  quint64 contentHash;
+  if (!hashFileContent(fileName, &contentHash)) {
+    return diskModificationTime;
+  }
+  return QDateTime::fromTime_t(recordContentHash(repository, fileName, diskTime, contentHash));
+}
+
+QDateTime ModificationRevision::contentModificationTime(const IndexedString& fileName, const QDateTime& diskModificationTime,
+                                                        const QByteArray* content)
+{
+  return checkContentModificationTime(fileName, diskModificationTime, content, nullptr);
+}
+
 QDateTime fileModificationTimeCached( const IndexedString& fileName )
 {
   const auto currentTime = QDateTime::currentDateTime();
 
-  auto it = fileModificationCache().constFind( fileName );
-  if ( it != fileModificationCache().constEnd() ) {
-    ///Use the cache for X seconds
-    if (it.value().m_readTime.secsTo(currentTime) < cacheModificationTimesForSeconds ) {
-      return it.value().m_modificationTime;
+  {
+    QMutexLocker lock(&fileModificationTimeCacheMutex);
+    auto it = fileModificationCache().constFind( fileName );
+    if ( it != fileModificationCache().constEnd() ) {
+      ///Use the cache for X seconds
+      if (it.value().m_readTime.secsTo(currentTime) < cacheModificationTimesForSeconds ) {
+        return it.value().m_modificationTime;
+      }
     }
   }
 
   QFileInfo fileInfo( fileName.str() );
-  FileModificationCache data = {currentTime, fileInfo.lastModified()};
-  fileModificationCache().insert(fileName, data);
+  bool hashPending = false;
+  FileModificationCache data = {currentTime, checkContentModificationTime(fileName, fileInfo.lastModified(), nullptr, &hashPending)};
+
+  if (!hashPending) {
+    QMutexLocker lock(&fileModificationTimeCacheMutex);
+    fileModificationCache().insert(fileName, data);
+  }
   return data.m_modificationTime;
 }
 
@@ -87,10 +347,10 @@ void ModificationRevision::clearModificationCache(const IndexedString& fileName)
 
 ModificationRevision ModificationRevision::revisionForFile(const IndexedString& url)
 {
-  QMutexLocker lock(&fileModificationTimeCacheMutex);
-
   ModificationRevision ret(fileModificationTimeCached(url));
 
+  QMutexLocker lock(&fileModificationTimeCacheMutex);
+
   OpenDocumentRevisionsMap::const_iterator it = openDocumentsRevisionMap().constFind(url);
   if(it != openDocumentsRevisionMap().constEnd()) {
     ret.revision = it.value();
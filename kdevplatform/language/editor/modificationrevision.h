@@ -23,6 +23,7 @@
 #include <language/languageexport.h>
 #include "../backgroundparser/documentchangetracker.h"
 
+class QByteArray;
 class QString;
 
 namespace KDevelop {
@@ -54,6 +55,17 @@ class KDEVPLATFORMLANGUAGE_EXPORT ModificationRevision
     ///Otherwise, the on-disk modification-times are re-used for a specific amount of time
 	static void clearModificationCache(const IndexedString& fileName);
 
+	///Returns the modification-time that is used for the file with the given on-disk modification-time.
+	///While the content of the file is byte-identical to the content it had when the modification-time was last recorded,
+	///the recorded modification-time is returned, so touching a file (for example by switching branches back and forth)
+	///doesn't make the results that were computed from it outdated.
+	///Pass the @p content that was just read from disk when parsing, its hash is recorded for the next comparison.
+	///Otherwise the file is only hashed when the on-disk modification-time changes, in the background when called
+	///from the main thread, and the on-disk time is reported until the hash is known. Files that were not checked
+	///for 30 days are forgotten. Before the duchain is initialized, the on-disk modification-time is returned.
+	static QDateTime contentModificationTime(const IndexedString& fileName, const QDateTime& diskModificationTime,
+	                                         const QByteArray* content = nullptr);
+
 	///The default-revision is 0, because that is the kate moving-revision for cleanly opened documents
 	explicit ModificationRevision( const QDateTime& modTime = QDateTime(), int revision_ = 0 );
 
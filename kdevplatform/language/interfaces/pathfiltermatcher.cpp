@@ -0,0 +1,285 @@
+/*
+ * This file is part of KDevelop
+ *
+ * Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "pathfiltermatcher.h"
+
+#include "abbreviations.h"
+
+#include <util/path.h>
+
+#include <QtConcurrentMap>
+
+using namespace KDevelop;
+
+namespace {
+
+// Lists shorter than this are matched in the calling thread
+const int chunkSize = 8192;
+
+quint64 characterBit(QChar c)
+{
+    const ushort code = c.unicode();
+    if (code >= 'a' && code <= 'z') {
+        return 1ull << (code - 'a');
+    }
+    if (code >= '0' && code <= '9') {
+        return 1ull << (26 + code - '0');
+    }
+    return 1ull << (36 + code % 28);
+}
+
+/**
+ * The mask of the characters in a path segment.
+ *
+ * The typed text is compared case-insensitively, either by folding or lowering the case.
+ * The segment contributes the bits of both forms, so a typed character whose folded and lowered
+ * forms are equal has its bit set in the mask of every segment it can match.
+ */
+quint64 segmentMask(const QString& segment)
+{
+    quint64 mask = 0;
+    for (const QChar c : segment) {
+        mask |= characterBit(c.toCaseFolded()) | characterBit(c.toLower());
+    }
+    return mask;
+}
+
+quint64 typedMask(const QString& text)
+{
+    quint64 mask = 0;
+    for (const QChar c : text) {
+        const QChar folded = c.toCaseFolded();
+        if (folded == c.toLower()) {
+            mask |= characterBit(folded);
+        }
+    }
+    return mask;
+}
+
+QString foldCase(const QString& text)
+{
+    // Folds every character on its own, so the folded text has the same length as the original
+    QString ret(text.size(), Qt::Uninitialized);
+    for (int i = 0; i < text.size(); ++i) {
+        ret[i] = text.at(i).toCaseFolded();
+    }
+    return ret;
+}
+
+// Same as matchesPath(), for a segment that is not stored in a string of its own
+bool matchesSegment(const QStringRef& segment, const QString& typed)
+{
+    int consumed = 0;
+    int pos = 0;
+    while (consumed < typed.size() && pos < segment.size()) {
+        if (typed.at(consumed).toLower() == segment.at(pos).toLower()) {
+            consumed++;
+        }
+        pos++;
+    }
+    return consumed == typed.size();
+}
+
+}
+
+struct PathFilterMatcher::Query
+{
+    explicit Query(const QStringList& text)
+        : text(text)
+        , joinedText(text.join(QString()))
+        , mask(typedMask(joinedText))
+    {
+        foldedText.reserve(text.size());
+        for (const QString& segment : text) {
+            foldedText << foldCase(segment);
+        }
+    }
+
+    const QStringList text;
+    QStringList foldedText;
+    const QString joinedText;
+    const quint64 mask;
+};
+
+void PathFilterMatcher::clear()
+{
+    m_text.clear();
+    m_foldedText.clear();
+    m_segmentOffsets = {0};
+    m_segmentMasks.clear();
+    m_segmentIds.clear();
+    m_pathSegments.clear();
+    m_pathOffsets = {0};
+    m_pathMasks.clear();
+}
+
+void PathFilterMatcher::reserve(int count)
+{
+    m_pathOffsets.reserve(count + 1);
+    m_pathMasks.reserve(count);
+}
+
+int PathFilterMatcher::addSegment(const QString& segment)
+{
+    auto it = m_segmentIds.constFind(segment);
+    if (it == m_segmentIds.constEnd()) {
+        m_text += segment;
+        m_foldedText += foldCase(segment);
+        m_segmentOffsets << m_text.size();
+        m_segmentMasks << segmentMask(segment);
+        it = m_segmentIds.insert(segment, m_segmentMasks.size() - 1);
+    }
+    return *it;
+}
+
+void PathFilterMatcher::addPath(const Path& path)
+{
+    quint64 mask = 0;
+    for (const QString& segment : path.segments()) {
+        const int id = addSegment(segment);
+        m_pathSegments << id;
+        mask |= m_segmentMasks.at(id);
+    }
+    m_pathOffsets << m_pathSegments.size();
+    m_pathMasks << mask;
+}
+
+int PathFilterMatcher::count() const
+{
+    return m_pathMasks.size();
+}
+
+QVector<int> PathFilterMatcher::filter(const QStringList& text) const
+{
+    return filter(Query(text), nullptr);
+}
+
+QVector<int> PathFilterMatcher::filter(const QStringList& text, const QVector<int>& candidates) const
+{
+    return filter(Query(text), &candidates);
+}
+
+QVector<int> PathFilterMatcher::filter(const Query& query, const QVector<int>* candidates) const
+{
+    struct Chunk
+    {
+        int begin;
+        int end;
+        QVector<int> matches[3];
+    };
+
+    const int size = candidates ? candidates->size() : count();
+    QVector<Chunk> chunks;
+    for (int begin = 0; begin < size; begin += chunkSize) {
+        chunks.append({begin, qMin(begin + chunkSize, size), {}});
+    }
+
+    auto matchChunk = [&](Chunk& chunk) {
+        for (int i = chunk.begin; i < chunk.end; ++i) {
+            const int path = candidates ? candidates->at(i) : i;
+            const Match result = match(query, path);
+            if (result != NoMatch) {
+                chunk.matches[result] << path;
+            }
+        }
+    };
+
+    if (chunks.size() > 1) {
+        QtConcurrent::blockingMap(chunks, matchChunk);
+    } else if (!chunks.isEmpty()) {
+        matchChunk(chunks.first());
+    }
+
+    // Concatenating the chunks in order gives the same result as matching all paths in one go
+    QVector<int> ret;
+    for (int group = ExactMatch; group <= OtherMatch; ++group) {
+        for (const Chunk& chunk : chunks) {
+            ret += chunk.matches[group];
+        }
+    }
+    return ret;
+}
+
+PathFilterMatcher::Match PathFilterMatcher::match(const Query& query, int path) const
+{
+    // Every typed character must occur somewhere in the path
+    if ((m_pathMasks.at(path) & query.mask) != query.mask) {
+        return NoMatch;
+    }
+
+    const int* segments = m_pathSegments.constData() + m_pathOffsets.at(path);
+    const int segmentCount = m_pathOffsets.at(path + 1) - m_pathOffsets.at(path);
+    const QStringList& text = query.text;
+
+    auto segment = [&](const QString& arena, int index) {
+        const int id = segments[index];
+        const int offset = m_segmentOffsets.at(id);
+        return QStringRef(&arena, offset, m_segmentOffsets.at(id + 1) - offset);
+    };
+
+    if (text.count() > segmentCount) {
+        // number of segments mismatches, thus item cannot match
+        return NoMatch;
+    }
+    {
+        bool allMatched = true;
+        // try to put exact matches up front
+        for (int i = segmentCount - 1, j = text.count() - 1; i >= 0 && j >= 0; --i, --j) {
+            if (segment(m_text, i) != text.at(j)) {
+                allMatched = false;
+                break;
+            }
+        }
+        if (allMatched) {
+            return ExactMatch;
+        }
+    }
+
+    int searchIndex = 0;
+    int pathIndex = 0;
+    int lastMatchIndex = -1;
+    // stop early if more search fragments remain than available after path index
+    while (pathIndex < segmentCount && searchIndex < text.size()
+            && (pathIndex + text.size() - searchIndex - 1) < segmentCount)
+    {
+        lastMatchIndex = segment(m_foldedText, pathIndex).indexOf(query.foldedText.at(searchIndex));
+        if (lastMatchIndex == -1 && !matchesAbbreviation(segment(m_text, pathIndex), text.at(searchIndex))) {
+            // no match, try with next path segment
+            ++pathIndex;
+            continue;
+        }
+        // else we matched
+        ++searchIndex;
+        ++pathIndex;
+    }
+
+    if (searchIndex != text.size()) {
+        if (!matchesSegment(segment(m_text, segmentCount - 1), query.joinedText)) {
+            return NoMatch;
+        }
+    }
+
+    // prefer matches whose last element starts with the filter
+    if (pathIndex == segmentCount && lastMatchIndex == 0) {
+        return StartMatch;
+    }
+    return OtherMatch;
+}
@@ -0,0 +1,103 @@
+/*
+ * This file is part of KDevelop
+ *
+ * Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KDEVPLATFORM_PATHFILTERMATCHER_H
+#define KDEVPLATFORM_PATHFILTERMATCHER_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <language/languageexport.h>
+
+namespace KDevelop {
+
+class Path;
+
+/**
+ * Matches the text typed into quick open against a list of paths, for PathFilter.
+ *
+ * The segments of all paths are stored once each in a flat buffer, together with a case-folded
+ * copy that is used for the case-insensitive substring search. Each path additionally keeps a
+ * 64 bit mask of the characters it contains, so most paths are rejected with a single comparison.
+ *
+ * Large lists are matched in parallel chunks, the result does not depend on the count of threads.
+ */
+class KDEVPLATFORMLANGUAGE_EXPORT PathFilterMatcher
+{
+public:
+    /// Drops all paths
+    void clear();
+
+    /// Reserves memory for @p count paths
+    void reserve(int count);
+
+    /// Appends @p path, it is referred to by its position in the order of the added paths
+    void addPath(const Path& path);
+
+    /// @returns the count of added paths
+    int count() const;
+
+    /**
+     * @returns the indexes of the paths that match the typed path segments in @p text.
+     *
+     * Paths whose trailing segments equal @p text come first, followed by the paths whose last
+     * segment starts with the last typed segment, and then all other matches.
+     * The paths of each group are in the order in which they were added.
+     */
+    QVector<int> filter(const QStringList& text) const;
+
+    /// Like filter(), but only matches the paths with the given indexes, and keeps their order within each group.
+    QVector<int> filter(const QStringList& text, const QVector<int>& candidates) const;
+
+private:
+    enum Match {
+        NoMatch = -1,
+        ExactMatch,
+        StartMatch,
+        OtherMatch
+    };
+
+    struct Query;
+
+    QVector<int> filter(const Query& query, const QVector<int>* candidates) const;
+    Match match(const Query& query, int path) const;
+    int addSegment(const QString& segment);
+
+    // All distinct segments one after another, and their case-folded copy
+    QString m_text;
+    QString m_foldedText;
+    // The offsets of the segments into the text, followed by the end of the text
+    QVector<int> m_segmentOffsets{0};
+    QVector<quint64> m_segmentMasks;
+    QHash<QString, int> m_segmentIds;
+
+    // The segment ids of all paths one after another
+    QVector<int> m_pathSegments;
+    // The offsets of the paths into m_pathSegments, followed by the end
+    QVector<int> m_pathOffsets{0};
+    QVector<quint64> m_pathMasks;
+};
+
+}
+
+#endif // KDEVPLATFORM_PATHFILTERMATCHER_H
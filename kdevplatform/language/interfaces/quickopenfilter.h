@@ -25,6 +25,7 @@
 #include <QStringList>
 
 #include "abbreviations.h"
+#include "pathfiltermatcher.h"
 
 #include <util/path.h>
 
@@ -143,6 +144,14 @@ private:
 
 namespace KDevelop {
 
+/**
+ * Filters items by their path, for quick open data-providers.
+ *
+ * The paths are passed to a PathFilterMatcher in setItems(), so filtering doesn't need to
+ * compute them again for every typed character.
+ *
+ * @tparam Parent must provide a function "Path itemPath(const Item&)" that returns the path of an item.
+ */
 template<class Item, class Parent>
 class PathFilter
 {
@@ -151,6 +160,7 @@ public:
     void clearFilter()
     {
         m_filtered = m_items;
+        m_filteredIndexes.clear();
         m_oldFilterText.clear();
     }
 
@@ -158,6 +168,11 @@ public:
     void setItems( const QList<Item>& data )
     {
         m_items = data;
+        m_matcher.clear();
+        m_matcher.reserve(m_items.size());
+        foreach( const Item& item, m_items ) {
+            m_matcher.addPath(static_cast<Parent*>(this)->itemPath(item));
+        }
         clearFilter();
     }
 
@@ -183,12 +198,10 @@ public:
             return;
         }
 
-        const QString joinedText = text.join(QString());
-
-        QList<Item> filterBase = m_filtered;
+        bool filterAll = false;
 
         if ( m_oldFilterText.isEmpty()) {
-            filterBase = m_items;
+            filterAll = true;
         } else if (m_oldFilterText.mid(0, m_oldFilterText.count() - 1) == text.mid(0, text.count() - 1)
                    && text.last().startsWith(m_oldFilterText.last())) {
             //Good, the prefix is the same, and the last item has been extended
@@ -196,83 +209,26 @@ public:
             //Good, an item has been added
         } else {
             //Start filtering based on the whole data, there was a big change to the filter
-            filterBase = m_items;
+            filterAll = true;
         }
 
-        // filterBase is correctly sorted, to keep it that way we add
-        // exact matches to this list in sorted way and then prepend the whole list in one go.
-        QList<Item> exactMatches;
-        // similar for starting matches
-        QList<Item> startMatches;
-        // all other matches
-        QList<Item> otherMatches;
-        foreach( const Item& data, filterBase ) {
-            const Path toFilter = static_cast<Parent*>(this)->itemPath(data);
-            const QVector<QString>& segments = toFilter.segments();
-
-            if (text.count() > segments.count()) {
-                // number of segments mismatches, thus item cannot match
-                continue;
-            }
-            {
-                bool allMatched = true;
-                // try to put exact matches up front
-                for(int i = segments.count() - 1, j = text.count() - 1;
-                    i >= 0 && j >= 0; --i, --j)
-                {
-                    if (segments.at(i) != text.at(j)) {
-                        allMatched = false;
-                        break;
-                    }
-                }
-                if (allMatched) {
-                    exactMatches << data;
-                    continue;
-                }
-            }
+        // the matcher keeps the order of the filter base within exact, starting and other matches
+        m_filteredIndexes = filterAll ? m_matcher.filter(text) : m_matcher.filter(text, m_filteredIndexes);
 
-            int searchIndex = 0;
-            int pathIndex = 0;
-            int lastMatchIndex = -1;
-            // stop early if more search fragments remain than available after path index
-            while (pathIndex < segments.size() && searchIndex < text.size()
-                    && (pathIndex + text.size() - searchIndex - 1) < segments.size() )
-            {
-                const QString& segment = segments.at(pathIndex);
-                const QString& typedSegment = text.at(searchIndex);
-                lastMatchIndex = segment.indexOf(typedSegment, 0, Qt::CaseInsensitive);
-                if (lastMatchIndex == -1 && !matchesAbbreviation(segment.midRef(0), typedSegment)) {
-                    // no match, try with next path segment
-                    ++pathIndex;
-                    continue;
-                }
-                // else we matched
-                ++searchIndex;
-                ++pathIndex;
-            }
-
-            if (searchIndex != text.size()) {
-                if ( ! matchesPath(segments.last(), joinedText) ) {
-                    continue;
-                }
-            }
-
-            // prefer matches whose last element starts with the filter
-            if (pathIndex == segments.size() && lastMatchIndex == 0) {
-                startMatches << data;
-            } else {
-                otherMatches << data;
-            }
+        m_filtered.clear();
+        m_filtered.reserve(m_filteredIndexes.size());
+        foreach( int index, m_filteredIndexes ) {
+            m_filtered << m_items.at(index);
         }
-
-        m_filtered = exactMatches + startMatches + otherMatches;
         m_oldFilterText = text;
     }
 
 private:
     QStringList m_oldFilterText;
     QList<Item> m_filtered;
+    QVector<int> m_filteredIndexes;
     QList<Item> m_items;
+    PathFilterMatcher m_matcher;
 };
 
 }
@@ -36,11 +36,11 @@ void initializeFilteredItem(FilteredItem& item, const ErrorFormat& filter, const
 }
 
 
-template<typename ErrorFormats>
-FilteredItem match(const ErrorFormats& errorFormats, const QString& line)
+FilteredItem match(const FormatList<ErrorFormat>& errorFormats, const QString& line)
 {
     FilteredItem item(line);
-    for( const ErrorFormat& curErrFilter : errorFormats ) {
+    for (const ErrorFormat* format : errorFormats.candidates(line)) {
+        const ErrorFormat& curErrFilter = *format;
         const auto match = curErrFilter.expression.match(line);
         if( match.hasMatch() ) {
             initializeFilteredItem(item, curErrFilter, match);
@@ -161,50 +161,51 @@ QVector<QString> CompilerFilterStrategy::getCurrentDirs()
 FilteredItem CompilerFilterStrategy::actionInLine(const QString& line)
 {
     // A list of filters for possible compiler, linker, and make actions
-    static const ActionFormat ACTION_FILTERS[] = {
-        ActionFormat( 2,
-                      QStringLiteral("(?:^|[^=])\\b(gcc|CC|cc|distcc|c\\+\\+|g\\+\\+|clang(?:\\+\\+)|mpicc|icc|icpc)\\s+.*-c.*[/ '\\\\]+(\\w+\\.(?:cpp|CPP|c|C|cxx|CXX|cs|java|hpf|f|F|f90|F90|f95|F95))")),
+    static const FormatList<ActionFormat> ACTION_FILTERS = {
+        {ActionFormat( 2,
+                       QStringLiteral("(?:^|[^=])\\b(gcc|CC|cc|distcc|c\\+\\+|g\\+\\+|clang(?:\\+\\+)|mpicc|icc|icpc)\\s+.*-c.*[/ '\\\\]+(\\w+\\.(?:cpp|CPP|c|C|cxx|CXX|cs|java|hpf|f|F|f90|F90|f95|F95))")), QLatin1String("-c")},
         //moc and uic
-        ActionFormat( 2, QStringLiteral("/(moc|uic)\\b.*\\s-o\\s([^\\s;]+)")),
+        {ActionFormat( 2, QStringLiteral("/(moc|uic)\\b.*\\s-o\\s([^\\s;]+)")), QLatin1String("-o")},
         //libtool linking
-        ActionFormat( QStringLiteral("libtool"), QStringLiteral("/bin/sh\\s.*libtool.*--mode=link\\s.*\\s-o\\s([^\\s;]+)"), 1 ),
+        {ActionFormat( QStringLiteral("libtool"), QStringLiteral("/bin/sh\\s.*libtool.*--mode=link\\s.*\\s-o\\s([^\\s;]+)"), 1 ), QLatin1String("--mode=link")},
         //unsermake
-        ActionFormat( 1, QStringLiteral("^compiling (.*)") ),
-        ActionFormat( 2, QStringLiteral("^generating (.*)") ),
-        ActionFormat( 2, QStringLiteral("(gcc|cc|c\\+\\+|g\\+\\+|clang(?:\\+\\+)|mpicc|icc|icpc)\\S* (?:\\S* )*-o ([^\\s;]+)")),
-        ActionFormat( 2, QStringLiteral("^linking (.*)") ),
+        {ActionFormat( 1, QStringLiteral("^compiling (.*)") ), QLatin1String("compiling ")},
+        {ActionFormat( 2, QStringLiteral("^generating (.*)") ), QLatin1String("generating ")},
+        {ActionFormat( 2, QStringLiteral("(gcc|cc|c\\+\\+|g\\+\\+|clang(?:\\+\\+)|mpicc|icc|icpc)\\S* (?:\\S* )*-o ([^\\s;]+)")), QLatin1String("-o ")},
+        {ActionFormat( 2, QStringLiteral("^linking (.*)") ), QLatin1String("linking ")},
         //cmake
-        ActionFormat( 1, QStringLiteral("\\[.+%\\] Built target (.*)") ),
-        ActionFormat( QStringLiteral("cmake"),
-                      QStringLiteral("\\[.+%\\] Building .* object (.*)"), 1 ),
-        ActionFormat( 1, QStringLiteral("\\[.+%\\] Generating (.*)") ),
-        ActionFormat( 1, QStringLiteral("^Linking (.*)") ),
-        ActionFormat( QStringLiteral("cmake"),
-                      QStringLiteral("(-- Configuring (done|incomplete)|-- Found|-- Adding|-- Enabling)"), -1 ),
-        ActionFormat( 1, QStringLiteral("-- Installing (.*)") ),
+        {ActionFormat( 1, QStringLiteral("\\[.+%\\] Built target (.*)") ), QLatin1String("] Built target ")},
+        {ActionFormat( QStringLiteral("cmake"),
+                       QStringLiteral("\\[.+%\\] Building .* object (.*)"), 1 ), QLatin1String("] Building ")},
+        {ActionFormat( 1, QStringLiteral("\\[.+%\\] Generating (.*)") ), QLatin1String("] Generating ")},
+        {ActionFormat( 1, QStringLiteral("^Linking (.*)") ), QLatin1String("Linking ")},
+        {ActionFormat( QStringLiteral("cmake"),
+                       QStringLiteral("(-- Configuring (done|incomplete)|-- Found|-- Adding|-- Enabling)"), -1 ), QLatin1String("-- ")},
+        {ActionFormat( 1, QStringLiteral("-- Installing (.*)") ), QLatin1String("-- Installing ")},
         //cmake - cd - filter for project directory
-        ActionFormat( QStringLiteral("cd"),
-                      QStringLiteral("(?:)cmake(?:\\.exe|\\.bat)? (?:.*?) ((?:[A-Za-z]:|/).*$)"), 1),
+        {ActionFormat( QStringLiteral("cd"),
+                       QStringLiteral("(?:)cmake(?:\\.exe|\\.bat)? (?:.*?) ((?:[A-Za-z]:|/).*$)"), 1), QLatin1String("cmake")},
         //libtool install
-        ActionFormat( {},
-                      QStringLiteral("/(?:bin/sh\\s.*mkinstalldirs).*\\s([^\\s;]+)"), 1 ),
-        ActionFormat( {},
-                      QStringLiteral("/(?:usr/bin/install|bin/sh\\s.*mkinstalldirs|bin/sh\\s.*libtool.*--mode=install).*\\s([^\\s;]+)"), 1 ),
+        {ActionFormat( {},
+                       QStringLiteral("/(?:bin/sh\\s.*mkinstalldirs).*\\s([^\\s;]+)"), 1 ), QLatin1String("mkinstalldirs")},
+        {ActionFormat( {},
+                       QStringLiteral("/(?:usr/bin/install|bin/sh\\s.*mkinstalldirs|bin/sh\\s.*libtool.*--mode=install).*\\s([^\\s;]+)"), 1 ), QLatin1String("bin/")},
         //dcop
-        ActionFormat( QStringLiteral("dcopidl"),
-                      QStringLiteral("dcopidl .* > ([^\\s;]+)"), 1 ),
-        ActionFormat( QStringLiteral("dcopidl2cpp"),
-                      QStringLiteral("dcopidl2cpp (?:\\S* )*([^\\s;]+)"), 1 ),
+        {ActionFormat( QStringLiteral("dcopidl"),
+                       QStringLiteral("dcopidl .* > ([^\\s;]+)"), 1 ), QLatin1String("dcopidl ")},
+        {ActionFormat( QStringLiteral("dcopidl2cpp"),
+                       QStringLiteral("dcopidl2cpp (?:\\S* )*([^\\s;]+)"), 1 ), QLatin1String("dcopidl2cpp ")},
         // match against Entering directory to update current build dir
-        ActionFormat( QStringLiteral("cd"),
-                      QStringLiteral("make\\[\\d+\\]: Entering directory (\\`|\\')(.+)'"), 2),
+        {ActionFormat( QStringLiteral("cd"),
+                       QStringLiteral("make\\[\\d+\\]: Entering directory (\\`|\\')(.+)'"), 2), QLatin1String("Entering directory ")},
         // waf and scons use the same basic convention as make
-        ActionFormat( QStringLiteral("cd"),
-                      QStringLiteral("(Waf|scons): Entering directory (\\`|\\')(.+)'"), 3)
+        {ActionFormat( QStringLiteral("cd"),
+                       QStringLiteral("(Waf|scons): Entering directory (\\`|\\')(.+)'"), 3), QLatin1String("Entering directory ")}
     };
 
     FilteredItem item(line);
-    for (const auto& curActFilter : ACTION_FILTERS) {
+    for (const ActionFormat* format : ACTION_FILTERS.candidates(line)) {
+        const ActionFormat& curActFilter = *format;
         const auto match = curActFilter.expression.match(line);
         if( match.hasMatch() ) {
             item.type = FilteredItem::ActionItem;
@@ -253,55 +254,56 @@ FilteredItem CompilerFilterStrategy::errorInLine(const QString& line)
     };
 
     // A list of filters for possible compiler, linker, and make errors
-    static const ErrorFormat ERROR_FILTERS[] = {
+    static const FormatList<ErrorFormat> ERROR_FILTERS = {
 #ifdef Q_OS_WIN
         // MSVC
-        ErrorFormat( QStringLiteral("^([a-zA-Z]:\\\\.+)\\(([1-9][0-9]*)\\): ((?:error|warning) .+\\:).*$"), 1, 2, 3 ),
+        {ErrorFormat( QStringLiteral("^([a-zA-Z]:\\\\.+)\\(([1-9][0-9]*)\\): ((?:error|warning) .+\\:).*$"), 1, 2, 3 ), QLatin1String("): ")},
 #endif
         // GCC - another case, eg. for #include "pixmap.xpm" which does not exists
-        ErrorFormat( QStringLiteral("^([^:\\t]+):([0-9]+):([0-9]+):([^0-9]+)"), 1, 2, 4, 3 ),
+        {ErrorFormat( QStringLiteral("^([^:\\t]+):([0-9]+):([0-9]+):([^0-9]+)"), 1, 2, 4, 3 ), QLatin1String(":")},
         // ant
-        ErrorFormat( QStringLiteral("\\[javac\\][\\s]+([^:\\t]+):([0-9]+): (warning: .*|error: .*)"), 1, 2, 3, QStringLiteral("javac")),
+        {ErrorFormat( QStringLiteral("\\[javac\\][\\s]+([^:\\t]+):([0-9]+): (warning: .*|error: .*)"), 1, 2, 3, QStringLiteral("javac")), QLatin1String("[javac]")},
         // GCC
-        ErrorFormat( QStringLiteral("^([^:\\t]+):([0-9]+):([^0-9]+)"), 1, 2, 3 ),
+        {ErrorFormat( QStringLiteral("^([^:\\t]+):([0-9]+):([^0-9]+)"), 1, 2, 3 ), QLatin1String(":")},
         // GCC
-        ErrorFormat( QStringLiteral("^(In file included from |[ ]+from )([^:\\t]+):([0-9]+)(:|,)(|[0-9]+)"), 2, 3, 5 ),
+        {ErrorFormat( QStringLiteral("^(In file included from |[ ]+from )([^:\\t]+):([0-9]+)(:|,)(|[0-9]+)"), 2, 3, 5 ), QLatin1String("from ")},
         // ICC
-        ErrorFormat( QStringLiteral("^([^:\\t]+)\\(([0-9]+)\\):([^0-9]+)"), 1, 2, 3, QStringLiteral("intel") ),
+        {ErrorFormat( QStringLiteral("^([^:\\t]+)\\(([0-9]+)\\):([^0-9]+)"), 1, 2, 3, QStringLiteral("intel") ), QLatin1String("):")},
         //libtool link
-        ErrorFormat( QStringLiteral("^(libtool):( link):( warning): "), 0, 0, 0 ),
+        {ErrorFormat( QStringLiteral("^(libtool):( link):( warning): "), 0, 0, 0 ), QLatin1String("libtool: link: warning: ")},
         // make
-        ErrorFormat( QStringLiteral("No rule to make target"), 0, 0, 0 ),
+        {ErrorFormat( QStringLiteral("No rule to make target"), 0, 0, 0 ), QLatin1String("No rule to make target")},
         // cmake - multiline expression
-        ErrorFormat( QStringLiteral("(^\\/[\\w|\\/| |\\.]+):([0-9]+):"), 1, 2, 0, QStringLiteral("cmake") ),
+        {ErrorFormat( QStringLiteral("(^\\/[\\w|\\/| |\\.]+):([0-9]+):"), 1, 2, 0, QStringLiteral("cmake") ), QLatin1String(":")},
         // cmake
-        ErrorFormat( QStringLiteral("CMake (Error|Warning) (|\\([a-zA-Z]+\\) )(in|at) ([^:]+):($|[0-9]+)"), 4, 5, 1, QStringLiteral("cmake") ),
+        {ErrorFormat( QStringLiteral("CMake (Error|Warning) (|\\([a-zA-Z]+\\) )(in|at) ([^:]+):($|[0-9]+)"), 4, 5, 1, QStringLiteral("cmake") ), QLatin1String("CMake ")},
         // cmake/automoc
         // example: AUTOMOC: error: /foo/bar.cpp The file includes (...),
         // example: AUTOMOC: error: /foo/bar.cpp: The file includes (...)
         // note: ':' after file name isn't always appended, see http://cmake.org/gitweb?p=cmake.git;a=commitdiff;h=317d8498aa02c9f486bf5071963bb2034777cdd6
         // example: AUTOGEN: error: /foo/bar.cpp: The file includes (...)
         // note: AUTOMOC got renamed to AUTOGEN at some point
-        ErrorFormat( QStringLiteral("^(AUTOMOC|AUTOGEN): error: ([^:]+):? (The file .*)$"), 2, 0, 0 ),
+        {ErrorFormat( QStringLiteral("^(AUTOMOC|AUTOGEN): error: ([^:]+):? (The file .*)$"), 2, 0, 0 ), QLatin1String(": error: ")},
         // via qt4_automoc
         // example: automoc4: The file "/foo/bar.cpp" includes the moc file "bar1.moc", but ...
-        ErrorFormat( QStringLiteral("^automoc4: The file \"([^\"]+)\" includes the moc file"), 1, 0, 0 ),
+        {ErrorFormat( QStringLiteral("^automoc4: The file \"([^\"]+)\" includes the moc file"), 1, 0, 0 ), QLatin1String("automoc4: ")},
         // Fortran
-        ErrorFormat( QStringLiteral("\"(.*)\", line ([0-9]+):(.*)"), 1, 2, 3 ),
+        {ErrorFormat( QStringLiteral("\"(.*)\", line ([0-9]+):(.*)"), 1, 2, 3 ), QLatin1String("\", line ")},
         // GFortran
-        ErrorFormat( QStringLiteral("^(.*):([0-9]+)\\.([0-9]+):(.*)"), 1, 2, 4, QStringLiteral("gfortran"), 3 ),
+        {ErrorFormat( QStringLiteral("^(.*):([0-9]+)\\.([0-9]+):(.*)"), 1, 2, 4, QStringLiteral("gfortran"), 3 ), QLatin1String(":")},
         // Jade
-        ErrorFormat( QStringLiteral("^[a-zA-Z]+:([^:\\t]+):([0-9]+):[0-9]+:[a-zA-Z]:(.*)"), 1, 2, 3 ),
+        {ErrorFormat( QStringLiteral("^[a-zA-Z]+:([^:\\t]+):([0-9]+):[0-9]+:[a-zA-Z]:(.*)"), 1, 2, 3 ), QLatin1String(":")},
         // ifort
-        ErrorFormat( QStringLiteral("^fortcom: (.*): (.*), line ([0-9]+):(.*)"), 2, 3, 1, QStringLiteral("intel") ),
+        {ErrorFormat( QStringLiteral("^fortcom: (.*): (.*), line ([0-9]+):(.*)"), 2, 3, 1, QStringLiteral("intel") ), QLatin1String("fortcom: ")},
         // PGI
-        ErrorFormat( QStringLiteral("PGF9(.*)-(.*)-(.*)-(.*) \\((.*): ([0-9]+)\\)"), 5, 6, 4, QStringLiteral("pgi") ),
+        {ErrorFormat( QStringLiteral("PGF9(.*)-(.*)-(.*)-(.*) \\((.*): ([0-9]+)\\)"), 5, 6, 4, QStringLiteral("pgi") ), QLatin1String("PGF9")},
         // PGI (2)
-        ErrorFormat( QStringLiteral("PGF9(.*)-(.*)-(.*)-Symbol, (.*) \\((.*)\\)"), 5, 5, 4, QStringLiteral("pgi") ),
+        {ErrorFormat( QStringLiteral("PGF9(.*)-(.*)-(.*)-Symbol, (.*) \\((.*)\\)"), 5, 5, 4, QStringLiteral("pgi") ), QLatin1String("PGF9")},
     };
 
     FilteredItem item(line);
-    for (const auto& curErrFilter : ERROR_FILTERS) {
+    for (const ErrorFormat* format : ERROR_FILTERS.candidates(line)) {
+        const ErrorFormat& curErrFilter = *format;
         const auto match = curErrFilter.expression.match(line);
         if( match.hasMatch() && !( line.contains( QLatin1String("Each undeclared identifier is reported only once") )
                                || line.contains( QLatin1String("for each function it appears in.") ) ) )
@@ -364,10 +366,10 @@ FilteredItem ScriptErrorFilterStrategy::actionInLine(const QString& line)
 FilteredItem ScriptErrorFilterStrategy::errorInLine(const QString& line)
 {
     // A list of filters for possible Python and PHP errors
-    static const ErrorFormat SCRIPT_ERROR_FILTERS[] = {
-        ErrorFormat( QStringLiteral("^  File \"(.*)\", line ([0-9]+)(.*$|, in(.*)$)"), 1, 2, -1 ),
-        ErrorFormat( QStringLiteral("^.*(/.*):([0-9]+).*$"), 1, 2, -1 ),
-        ErrorFormat( QStringLiteral("^.* in (/.*) on line ([0-9]+).*$"), 1, 2, -1 )
+    static const FormatList<ErrorFormat> SCRIPT_ERROR_FILTERS = {
+        {ErrorFormat( QStringLiteral("^  File \"(.*)\", line ([0-9]+)(.*$|, in(.*)$)"), 1, 2, -1 ), QLatin1String("  File \"")},
+        {ErrorFormat( QStringLiteral("^.*(/.*):([0-9]+).*$"), 1, 2, -1 ), QLatin1String(":")},
+        {ErrorFormat( QStringLiteral("^.* in (/.*) on line ([0-9]+).*$"), 1, 2, -1 ), QLatin1String(" on line ")}
     };
 
     return match(SCRIPT_ERROR_FILTERS, line);
@@ -386,11 +388,11 @@ FilteredItem NativeAppErrorFilterStrategy::actionInLine(const QString& line)
 
 FilteredItem NativeAppErrorFilterStrategy::errorInLine(const QString& line)
 {
-    static const ErrorFormat NATIVE_APPLICATION_ERROR_FILTERS[] = {
+    static const FormatList<ErrorFormat> NATIVE_APPLICATION_ERROR_FILTERS = {
         // BEGIN: C++
 
         // a.out: test.cpp:5: int main(): Assertion `false' failed.
-        ErrorFormat(QStringLiteral("^.+: (.+):([1-9][0-9]*): .*: Assertion `.*' failed\\.$"), 1, 2, -1),
+        {ErrorFormat(QStringLiteral("^.+: (.+):([1-9][0-9]*): .*: Assertion `.*' failed\\.$"), 1, 2, -1), QLatin1String("Assertion `")},
 
         // END: C++
 
@@ -402,9 +404,9 @@ FilteredItem NativeAppErrorFilterStrategy::errorInLine(const QString& line)
 
         // QObject::connect related errors, also see err_method_notfound() in qobject.cpp
         // QObject::connect: No such slot Foo::bar() in /foo/bar.cpp:313
-        ErrorFormat(QStringLiteral("QObject::connect: (?:No such|Parentheses expected,) (?:slot|signal) [^ ]* in (.*):([0-9]+)"), 1, 2, -1),
+        {ErrorFormat(QStringLiteral("QObject::connect: (?:No such|Parentheses expected,) (?:slot|signal) [^ ]* in (.*):([0-9]+)"), 1, 2, -1), QLatin1String("QObject::connect: ")},
         // ASSERT: "errors().isEmpty()" in file /foo/bar.cpp, line 49
-        ErrorFormat(QStringLiteral("ASSERT: \"(.*)\" in file (.*), line ([0-9]+)"), 2, 3, -1),
+        {ErrorFormat(QStringLiteral("ASSERT: \"(.*)\" in file (.*), line ([0-9]+)"), 2, 3, -1), QLatin1String("ASSERT: \"")},
         // Catch:
         // FAIL!  : FooTest::testBar() Compared pointers are not the same
         //    Actual   ...
@@ -414,14 +416,14 @@ FilteredItem NativeAppErrorFilterStrategy::errorInLine(const QString& line)
         // Do *not* catch:
         //    ...
         //    Loc: [Unknown file(0)]
-        ErrorFormat(QStringLiteral("   Loc: \\[(.*)\\(([1-9][0-9]*)\\)\\]"), 1, 2, -1),
+        {ErrorFormat(QStringLiteral("   Loc: \\[(.*)\\(([1-9][0-9]*)\\)\\]"), 1, 2, -1), QLatin1String("   Loc: [")},
 
         // file:///path/to/foo.qml:7:1: Bar is not a type
         // file:///path/to/foo.qml:49:5: QML Row: Binding loop detected for property "height"
-        ErrorFormat(QStringLiteral("(file:\\/\\/(?:[^:]+)):([1-9][0-9]*):([1-9][0-9]*): (.*) (?:is not a type|is ambiguous|is instantiated recursively|Binding loop detected)"), 1, 2, -1, 3),
+        {ErrorFormat(QStringLiteral("(file:\\/\\/(?:[^:]+)):([1-9][0-9]*):([1-9][0-9]*): (.*) (?:is not a type|is ambiguous|is instantiated recursively|Binding loop detected)"), 1, 2, -1, 3), QLatin1String("file://")},
 
         // file:///path/to/foo.qml:52: TypeError: Cannot read property 'height' of null
-        ErrorFormat(QStringLiteral("(file:\\/\\/(?:[^:]+)):([1-9][0-9]*): ([a-zA-Z]+)Error"), 1, 2, -1),
+        {ErrorFormat(QStringLiteral("(file:\\/\\/(?:[^:]+)):([1-9][0-9]*): ([a-zA-Z]+)Error"), 1, 2, -1), QLatin1String("file://")},
 
         // END: Qt
     };
@@ -443,13 +445,13 @@ FilteredItem StaticAnalysisFilterStrategy::actionInLine(const QString& line)
 FilteredItem StaticAnalysisFilterStrategy::errorInLine(const QString& line)
 {
     // A list of filters for static analysis tools (krazy2, cppcheck)
-    static const ErrorFormat STATIC_ANALYSIS_FILTERS[] = {
+    static const FormatList<ErrorFormat> STATIC_ANALYSIS_FILTERS = {
         // CppCheck
-        ErrorFormat( QStringLiteral("^\\[(.*):([0-9]+)\\]:(.*)"), 1, 2, 3 ),
+        {ErrorFormat( QStringLiteral("^\\[(.*):([0-9]+)\\]:(.*)"), 1, 2, 3 ), QLatin1String("]:")},
         // krazy2
-        ErrorFormat( QStringLiteral("^\\t([^:]+).*line#([0-9]+).*"), 1, 2, -1 ),
+        {ErrorFormat( QStringLiteral("^\\t([^:]+).*line#([0-9]+).*"), 1, 2, -1 ), QLatin1String("line#")},
         // krazy2 without line info
-        ErrorFormat( QStringLiteral("^\\t(.*): missing license"), 1, -1, -1 )
+        {ErrorFormat( QStringLiteral("^\\t(.*): missing license"), 1, -1, -1 ), QLatin1String(": missing license")}
     };
 
     return match(STATIC_ANALYSIS_FILTERS, line);
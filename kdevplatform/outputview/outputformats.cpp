@@ -23,7 +23,9 @@ ErrorFormat::ErrorFormat( const QString& regExp, int file, int line, int text, i
     , lineGroup( line )
     , columnGroup( column )
     , textGroup( text )
-{}
+{
+    expression.optimize();
+}
 
 ErrorFormat::ErrorFormat( const QString& regExp, int file, int line, int text, const QString& comp, int column )
     : expression( regExp )
@@ -32,19 +34,23 @@ ErrorFormat::ErrorFormat( const QString& regExp, int file, int line, int text, c
     , columnGroup( column )
     , textGroup( text )
     , compiler( comp )
-{}
+{
+    expression.optimize();
+}
 
 ActionFormat::ActionFormat(const QString& _tool, const QString& regExp, int file )
     : expression( regExp )
     , tool( _tool )
     , fileGroup( file )
 {
+    expression.optimize();
 }
 
 ActionFormat::ActionFormat(int file, const QString& regExp)
     : expression( regExp )
     , fileGroup( file )
 {
+    expression.optimize();
 }
 
 int ErrorFormat::columnNumber(const QRegularExpressionMatch& match) const
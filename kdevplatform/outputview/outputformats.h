@@ -14,6 +14,10 @@
 
 #include <QString>
 #include <QRegularExpression>
+#include <QVarLengthArray>
+#include <QVector>
+
+#include <initializer_list>
 
 namespace KDevelop
 {
@@ -45,6 +49,82 @@ struct ErrorFormat
     int columnNumber(const QRegularExpressionMatch& match) const;
 };
 
+/**
+ * A list of formats that are tried on a line in their order.
+ *
+ * Every format comes with a literal text that is part of each line it can match.
+ * The literals of all formats are searched in one pass over a line, and only the
+ * formats whose literal was found are left as candidates, so the expressions of
+ * most formats don't need to run for most lines of a build.
+ */
+template<typename Format>
+class FormatList
+{
+public:
+    struct Entry
+    {
+        Format format;
+        QLatin1String literal;
+    };
+
+    FormatList(std::initializer_list<Entry> entries)
+    {
+        for (const Entry& entry : entries) {
+            const QString text(entry.literal);
+            int literal = m_literals.indexOf(text);
+            if (literal == -1) {
+                literal = m_literals.size();
+                m_literals << text;
+                const uchar first = text.at(0).unicode();
+                Q_ASSERT(first < 128);
+                m_literalsByFirstChar[first] << literal;
+            }
+            m_formats << entry.format;
+            m_formatLiterals << literal;
+        }
+        Q_ASSERT(m_literals.size() <= 64);
+        m_allLiterals = m_literals.size() == 64 ? ~quint64(0) : (quint64(1) << m_literals.size()) - 1;
+    }
+
+    /// @returns the formats that may match @p line, in the order they were given
+    QVarLengthArray<const Format*, 16> candidates(const QString& line) const
+    {
+        quint64 found = 0;
+        const QChar* data = line.constData();
+        const int size = line.size();
+        for (int i = 0; i < size && found != m_allLiterals; ++i) {
+            const ushort c = data[i].unicode();
+            if (c >= 128) {
+                continue;
+            }
+            for (int literal : m_literalsByFirstChar[c]) {
+                const QString& text = m_literals.at(literal);
+                if (!(found & (quint64(1) << literal)) && text.size() <= size - i
+                    && QStringRef(&line, i, text.size()) == text)
+                {
+                    found |= quint64(1) << literal;
+                }
+            }
+        }
+
+        QVarLengthArray<const Format*, 16> ret;
+        for (int i = 0; i < m_formats.size(); ++i) {
+            if (found & (quint64(1) << m_formatLiterals.at(i))) {
+                ret.append(&m_formats.at(i));
+            }
+        }
+        return ret;
+    }
+
+private:
+    QVector<Format> m_formats;
+    // the index of the literal of each format
+    QVector<int> m_formatLiterals;
+    QVector<QString> m_literals;
+    QVector<int> m_literalsByFirstChar[128];
+    quint64 m_allLiterals;
+};
+
 }
 #endif
 
@@ -0,0 +1,189 @@
+/*
+    This file is part of KDevelop
+
+    Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "outputitemstore.h"
+#include "debug.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QTemporaryFile>
+
+#include <limits>
+
+namespace KDevelop
+{
+
+namespace {
+
+void writeItem(QDataStream& stream, const FilteredItem& item)
+{
+    stream << item.originalLine << qint8(item.type) << item.isActivatable << item.url
+           << qint32(item.lineNo) << qint32(item.columnNo);
+}
+
+FilteredItem readItem(QDataStream& stream)
+{
+    FilteredItem item;
+    qint8 type;
+    qint32 lineNo;
+    qint32 columnNo;
+    stream >> item.originalLine >> type >> item.isActivatable >> item.url >> lineNo >> columnNo;
+    item.type = static_cast<FilteredItem::FilteredOutputItemType>(type);
+    item.lineNo = lineNo;
+    item.columnNo = columnNo;
+    return item;
+}
+
+}
+
+OutputItemStore::OutputItemStore(int chunkSize, int cachedChunks, qint64 memoryLimit)
+    : m_chunkSize(chunkSize)
+    , m_memoryLimit(memoryLimit)
+    , m_cache(cachedChunks)
+{
+    Q_ASSERT(chunkSize > 0);
+    m_tail.reserve(m_chunkSize);
+}
+
+OutputItemStore::~OutputItemStore() = default;
+
+void OutputItemStore::append(const FilteredItem& item)
+{
+    m_tail << item;
+    if (m_tail.size() == m_chunkSize) {
+        sealTail();
+    }
+}
+
+FilteredItem OutputItemStore::at(int row) const
+{
+    Q_ASSERT(row >= 0 && row < count());
+    const int chunk = row / m_chunkSize;
+    const int offset = row % m_chunkSize;
+    if (chunk == m_chunks.size()) {
+        return m_tail.at(offset);
+    }
+
+    if (const QVector<FilteredItem>* items = m_cache.object(chunk)) {
+        return items->at(offset);
+    }
+    auto items = new QVector<FilteredItem>(load(chunk));
+    const FilteredItem item = items->value(offset);
+    m_cache.insert(chunk, items);
+    return item;
+}
+
+int OutputItemStore::count() const
+{
+    return m_chunks.size() * m_chunkSize + m_tail.size();
+}
+
+void OutputItemStore::clear()
+{
+    m_chunks.clear();
+    m_tail.clear();
+    m_tail.reserve(m_chunkSize);
+    m_cache.clear();
+    m_memoryUsage = 0;
+    m_file.reset();
+}
+
+bool OutputItemStore::isSpilled() const
+{
+    return !m_file.isNull();
+}
+
+void OutputItemStore::sealTail()
+{
+    QByteArray data;
+    {
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_5_5);
+        for (const FilteredItem& item : m_tail) {
+            writeItem(stream, item);
+        }
+    }
+
+    Chunk chunk;
+    chunk.data = qCompress(data);
+    chunk.size = chunk.data.size();
+    m_memoryUsage += chunk.size;
+    // the chunk is likely still shown, so its items stay around for a while
+    m_cache.insert(m_chunks.size(), new QVector<FilteredItem>(m_tail));
+    m_chunks << chunk;
+    m_tail.clear();
+    m_tail.reserve(m_chunkSize);
+
+    if (m_memoryUsage > m_memoryLimit) {
+        spill();
+    }
+}
+
+void OutputItemStore::spill()
+{
+    if (!m_file) {
+        m_file.reset(new QTemporaryFile(QDir::tempPath() + QLatin1String("/kdevelop-output-XXXXXX")));
+        if (!m_file->open()) {
+            qCWarning(OUTPUTVIEW) << "failed to create a file for the output, keeping it in memory:" << m_file->errorString();
+            m_file.reset();
+            m_memoryLimit = std::numeric_limits<qint64>::max();
+            return;
+        }
+    }
+
+    for (Chunk& chunk : m_chunks) {
+        if (chunk.data.isEmpty()) {
+            continue;
+        }
+        const qint64 offset = m_file->size();
+        if (!m_file->seek(offset) || m_file->write(chunk.data) != chunk.size) {
+            qCWarning(OUTPUTVIEW) << "failed to write the output to" << m_file->fileName() << m_file->errorString();
+            m_memoryLimit = std::numeric_limits<qint64>::max();
+            return;
+        }
+        chunk.offset = offset;
+        m_memoryUsage -= chunk.size;
+        chunk.data.clear();
+    }
+}
+
+QVector<FilteredItem> OutputItemStore::load(int chunk) const
+{
+    const Chunk& stored = m_chunks.at(chunk);
+    QByteArray data = stored.data;
+    if (data.isEmpty() && m_file && m_file->seek(stored.offset)) {
+        data = m_file->read(stored.size);
+    }
+
+    QVector<FilteredItem> items;
+    items.reserve(m_chunkSize);
+    QDataStream stream(qUncompress(data));
+    stream.setVersion(QDataStream::Qt_5_5);
+    while (!stream.atEnd() && items.size() < m_chunkSize) {
+        items << readItem(stream);
+    }
+    if (items.size() != m_chunkSize) {
+        qCWarning(OUTPUTVIEW) << "failed to read" << m_chunkSize << "output lines, got" << items.size();
+    }
+    return items;
+}
+
+}
@@ -0,0 +1,89 @@
+/*
+    This file is part of KDevelop
+
+    Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KDEVPLATFORM_OUTPUTITEMSTORE_H
+#define KDEVPLATFORM_OUTPUTITEMSTORE_H
+
+#include "filtereditem.h"
+
+#include <QByteArray>
+#include <QCache>
+#include <QScopedPointer>
+#include <QVector>
+
+class QTemporaryFile;
+
+namespace KDevelop
+{
+
+/**
+ * @short Stores the items of an output model in compressed chunks.
+ *
+ * Items are appended to an open chunk, which is compressed once it is full. The compressed
+ * chunks are kept in memory until they exceed a limit, then they are moved to a temporary
+ * file. A few decompressed chunks are cached, so reading the rows shown in a view only
+ * decompresses each of their chunks once.
+ */
+class KDEVPLATFORMOUTPUTVIEW_EXPORT OutputItemStore
+{
+public:
+    /**
+     * @param chunkSize the number of items that are compressed together
+     * @param cachedChunks the number of decompressed chunks that are kept
+     * @param memoryLimit the size in bytes of the compressed chunks that are kept in memory
+     */
+    explicit OutputItemStore(int chunkSize = 1024, int cachedChunks = 16, qint64 memoryLimit = 8 * 1024 * 1024);
+    ~OutputItemStore();
+
+    void append(const FilteredItem& item);
+    FilteredItem at(int row) const;
+    int count() const;
+    void clear();
+
+    /// @returns whether some chunks were moved to the temporary file
+    bool isSpilled() const;
+
+private:
+    struct Chunk
+    {
+        // the compressed items while they are kept in memory
+        QByteArray data;
+        // the location in the temporary file otherwise
+        qint64 offset = -1;
+        int size = 0;
+    };
+
+    void sealTail();
+    void spill();
+    QVector<FilteredItem> load(int chunk) const;
+
+    const int m_chunkSize;
+    qint64 m_memoryLimit;
+    QVector<Chunk> m_chunks;
+    QVector<FilteredItem> m_tail;
+    qint64 m_memoryUsage = 0;
+    QScopedPointer<QTemporaryFile> m_file;
+    mutable QCache<int, QVector<FilteredItem>> m_cache;
+};
+
+}
+
+#endif // KDEVPLATFORM_OUTPUTITEMSTORE_H
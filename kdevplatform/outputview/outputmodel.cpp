@@ -23,6 +23,7 @@
 #include "outputmodel.h"
 #include "filtereditem.h"
 #include "outputfilteringstrategies.h"
+#include "outputitemstore.h"
 #include "debug.h"
 
 #include <interfaces/icore.h>
@@ -189,9 +190,11 @@ public:
     OutputModel* model;
     ParseWorker* worker;
 
-    QVector<FilteredItem> m_filteredItems;
+    OutputItemStore m_filteredItems;
     // We use std::set because that is ordered
     std::set<int> m_errorItems; // Indices of all items that we want to move to using previous and next
+    // Indices of all items that can be activated, used when there are no errors
+    std::set<int> m_activatableItems;
     QUrl m_buildDir;
 
     void linesParsed(const QVector<KDevelop::FilteredItem>& items)
@@ -200,9 +203,12 @@ public:
 
         foreach( const FilteredItem& item, items ) {
             if( item.type == FilteredItem::ErrorItem ) {
-                m_errorItems.insert(m_filteredItems.size());
+                m_errorItems.insert(m_errorItems.end(), m_filteredItems.count());
             }
-            m_filteredItems << item;
+            if( item.isActivatable ) {
+                m_activatableItems.insert(m_activatableItems.end(), m_filteredItems.count());
+            }
+            m_filteredItems.append(item);
         }
 
         model->endInsertRows();
@@ -321,10 +327,8 @@ QModelIndex OutputModel::firstHighlightIndex()
         return index( *d->m_errorItems.begin(), 0, QModelIndex() );
     }
 
-    for( int row = 0; row < rowCount(); ++row ) {
-        if( d->m_filteredItems.at( row ).isActivatable ) {
-            return index( row, 0, QModelIndex() );
-        }
+    if( !d->m_activatableItems.empty() ) {
+        return index( *d->m_activatableItems.begin(), 0, QModelIndex() );
     }
 
     return QModelIndex();
@@ -345,21 +349,21 @@ QModelIndex OutputModel::nextHighlightIndex( const QModelIndex &currentIdx )
         return index( *next, 0, QModelIndex() );
     }
 
-    for( int row = 0; row < rowCount(); ++row )
+    if( !d->m_activatableItems.empty() )
     {
-        int currow = (startrow + row) % rowCount();
-        if( d->m_filteredItems.at( currow ).isActivatable )
-        {
-            return index( currow, 0, QModelIndex() );
-        }
+        // Jump to the next activatable item
+        std::set< int >::const_iterator next = d->m_activatableItems.lower_bound( startrow );
+        if( next == d->m_activatableItems.end() )
+            next = d->m_activatableItems.begin();
+
+        return index( *next, 0, QModelIndex() );
     }
     return QModelIndex();
 }
 
 QModelIndex OutputModel::previousHighlightIndex( const QModelIndex &currentIdx )
 {
-    //We have to ensure that startrow is >= rowCount - 1 to get a positive value from the % operation.
-    int startrow = rowCount() + (d->isValidIndex(currentIdx, rowCount()) ? currentIdx.row() : rowCount()) - 1;
+    int startrow = d->isValidIndex(currentIdx, rowCount()) ? currentIdx.row() : rowCount();
 
     if(!d->m_errorItems.empty())
     {
@@ -376,13 +380,16 @@ QModelIndex OutputModel::previousHighlightIndex( const QModelIndex &currentIdx )
         return index( *previous, 0, QModelIndex() );
     }
 
-    for ( int row = 0; row < rowCount(); ++row )
+    if( !d->m_activatableItems.empty() )
     {
-        int currow = (startrow - row) % rowCount();
-        if( d->m_filteredItems.at( currow ).isActivatable )
-        {
-            return index( currow, 0, QModelIndex() );
-        }
+        // Jump to the previous activatable item
+        std::set< int >::const_iterator previous = d->m_activatableItems.lower_bound( startrow );
+        if( previous == d->m_activatableItems.begin() )
+            previous = d->m_activatableItems.end();
+
+        --previous;
+
+        return index( *previous, 0, QModelIndex() );
     }
     return QModelIndex();
 }
@@ -393,10 +400,8 @@ QModelIndex OutputModel::lastHighlightIndex()
         return index( *d->m_errorItems.rbegin(), 0, QModelIndex() );
     }
 
-    for( int row = rowCount()-1; row >=0; --row ) {
-        if( d->m_filteredItems.at( row ).isActivatable ) {
-            return index( row, 0, QModelIndex() );
-        }
+    if( !d->m_activatableItems.empty() ) {
+        return index( *d->m_activatableItems.rbegin(), 0, QModelIndex() );
     }
 
     return QModelIndex();
@@ -464,6 +469,8 @@ void OutputModel::clear()
     ensureAllDone();
     beginResetModel();
     d->m_filteredItems.clear();
+    d->m_errorItems.clear();
+    d->m_activatableItems.clear();
     endResetModel();
 }
 
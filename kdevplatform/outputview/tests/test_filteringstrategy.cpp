@@ -553,3 +553,48 @@ void TestFilteringStrategy::testExtractionOfLineAndColumn()
     QCOMPARE(item1.lineNo , lineNr);
     QCOMPARE(item1.columnNo , column);
 }
+
+void TestFilteringStrategy::benchMarkCompilerFilterBuildLog()
+{
+    // the output of a parallel build, where most lines are actions and a few are diagnostics
+    const QString projecturl = projectPath();
+    const QString buildDir = projecturl + QLatin1String("/build");
+    const int numLines = 500000;
+    QStringList outputlines;
+    outputlines.reserve(numLines + 16);
+    int expectedErrors = 0;
+    for (int i = 0; outputlines.size() < numLines; ++i) {
+        const QString dir = QStringLiteral("src/module%1/part%2").arg(i % 97).arg(i % 7);
+        const QString file = QStringLiteral("%1/file%2.cpp").arg(dir).arg(i);
+        const int percent = qMin(100, i * 100 / (numLines / 6));
+        outputlines << QStringLiteral("make[2]: Entering directory '%1/%2'").arg(buildDir, dir)
+                    << QStringLiteral("[%1%] Building CXX object %2/CMakeFiles/target%3.dir/file%4.cpp.o").arg(percent, 3).arg(dir).arg(i % 97).arg(i)
+                    << QStringLiteral("Scanning dependencies of target target%1").arg(i % 97);
+        if (i % 10 == 0) {
+            outputlines << QStringLiteral("In file included from %1/%2/header%3.h:12:0,").arg(projecturl, dir).arg(i)
+                        << QStringLiteral("%1/%2:%3:%4: warning: unused variable 'x' [-Wunused-variable]").arg(projecturl, file).arg(i % 500 + 1).arg(i % 80 + 1)
+                        << QStringLiteral("     int x = 0;")
+                        << QStringLiteral("         ^");
+            expectedErrors += 2;
+        }
+        if (i % 50 == 0) {
+            outputlines << QStringLiteral("[%1%] Linking CXX shared library libtarget%2.so").arg(percent, 3).arg(i % 97)
+                        << QStringLiteral("[%1%] Built target target%2").arg(percent, 3).arg(i % 97);
+        }
+    }
+
+    CompilerFilterStrategy testee(QUrl::fromLocalFile(buildDir));
+    int errors = 0;
+    QBENCHMARK_ONCE {
+        // like the parse worker of the output model, which only looks for actions in lines without errors
+        foreach (const QString& line, outputlines) {
+            FilteredItem item = testee.errorInLine(line);
+            if (item.type == FilteredItem::InvalidItem) {
+                item = testee.actionInLine(line);
+            } else {
+                ++errors;
+            }
+        }
+    }
+    QCOMPARE(errors, expectedErrors);
+}
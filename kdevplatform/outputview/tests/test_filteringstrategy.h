@@ -45,6 +45,7 @@ private Q_SLOTS:
     void testExtractionOfLineAndColumn();
 
     void benchMarkCompilerFilterAction();
+    void benchMarkCompilerFilterBuildLog();
 };
 
 }
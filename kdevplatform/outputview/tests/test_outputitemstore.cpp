@@ -0,0 +1,119 @@
+/*
+    This file is part of KDevelop
+
+    Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "test_outputitemstore.h"
+#include "../outputitemstore.h"
+
+#include <QTest>
+
+QTEST_GUILESS_MAIN(KDevelop::TestOutputItemStore)
+
+namespace KDevelop
+{
+
+namespace {
+
+FilteredItem makeItem(int row)
+{
+    FilteredItem item(QStringLiteral("line %1").arg(row));
+    if (row % 3 == 0) {
+        item.type = FilteredItem::ErrorItem;
+        item.isActivatable = true;
+        item.url = QUrl::fromLocalFile(QStringLiteral("/path/to/file%1.cpp").arg(row));
+        item.lineNo = row;
+        item.columnNo = row % 80;
+    }
+    return item;
+}
+
+void verifyItem(const FilteredItem& item, int row)
+{
+    const FilteredItem expected = makeItem(row);
+    QCOMPARE(item.originalLine, expected.originalLine);
+    QCOMPARE(item.type, expected.type);
+    QCOMPARE(item.isActivatable, expected.isActivatable);
+    QCOMPARE(item.url, expected.url);
+    QCOMPARE(item.lineNo, expected.lineNo);
+    QCOMPARE(item.columnNo, expected.columnNo);
+}
+
+}
+
+void TestOutputItemStore::testItems()
+{
+    // more chunks than are cached, and an open one at the end
+    OutputItemStore store(10, 2);
+    const int count = 105;
+    for (int row = 0; row < count; ++row) {
+        store.append(makeItem(row));
+    }
+    QCOMPARE(store.count(), count);
+    QVERIFY(!store.isSpilled());
+
+    for (int row = 0; row < count; ++row) {
+        verifyItem(store.at(row), row);
+    }
+    for (int row = count - 1; row >= 0; row -= 7) {
+        verifyItem(store.at(row), row);
+    }
+}
+
+void TestOutputItemStore::testSpill()
+{
+    OutputItemStore store(10, 2, 0);
+    const int count = 100;
+    for (int row = 0; row < count; ++row) {
+        store.append(makeItem(row));
+    }
+    QVERIFY(store.isSpilled());
+
+    for (int row = 0; row < count; row += 3) {
+        verifyItem(store.at(row), row);
+    }
+    // items appended after the spill end up in the same file
+    for (int row = count; row < 2 * count; ++row) {
+        store.append(makeItem(row));
+    }
+    for (int row = 0; row < 2 * count; ++row) {
+        verifyItem(store.at(row), row);
+    }
+}
+
+void TestOutputItemStore::testClear()
+{
+    OutputItemStore store(10, 2, 0);
+    for (int row = 0; row < 50; ++row) {
+        store.append(makeItem(row));
+    }
+    store.clear();
+    QCOMPARE(store.count(), 0);
+    QVERIFY(!store.isSpilled());
+
+    for (int row = 0; row < 25; ++row) {
+        store.append(makeItem(row));
+    }
+    QCOMPARE(store.count(), 25);
+    for (int row = 0; row < 25; ++row) {
+        verifyItem(store.at(row), row);
+    }
+}
+
+}
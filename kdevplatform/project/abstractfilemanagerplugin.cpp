@@ -24,12 +24,13 @@
 #include "projectmodel.h"
 #include "helper.h"
 
-#include <QHashIterator>
+#include <algorithm>
+
+#include <QSet>
 #include <QFileInfo>
 #include <QApplication>
-#ifdef TIME_IMPORT_JOB
 #include <QElapsedTimer>
-#endif
+#include <QTimer>
 
 #include <KMessageBox>
 #include <KLocalizedString>
@@ -41,6 +42,8 @@
 #include <serialization/indexedstring.h>
 
 #include "projectfiltermanager.h"
+#include "projectsnapshot.h"
+#include "trigramindex.h"
 #include "debug.h"
 
 #define ifDebug(x)
@@ -51,6 +54,11 @@ using namespace KDevelop;
 
 namespace {
 
+// How long the file system has to be quiet before the collected changes are applied
+const int changeDelay = 100;
+// The longest time changes are collected while the file system keeps changing
+const int maxChangeDelay = 1000;
+
 /**
  * Returns the parent folder item for a given item or the project root item if there is no parent.
  */
@@ -75,8 +83,28 @@ public:
     explicit AbstractFileManagerPluginPrivate(AbstractFileManagerPlugin* qq)
         : q(qq)
     {
+        m_changeTimer.setSingleShot(true);
+        m_changeTimer.setInterval(changeDelay);
+        QObject::connect(&m_changeTimer, &QTimer::timeout,
+                         q, [this] { applyChanges(); });
     }
 
+    /// The kinds of events seen for a path
+    enum Change {
+        Created = 1,
+        Deleted = 2,
+        Modified = 4
+    };
+
+    /// The queued events of a path, and its current state on disk
+    struct PathChange
+    {
+        Path path;
+        int events;
+        bool exists;
+        bool isDir;
+    };
+
     AbstractFileManagerPlugin* q;
 
     /**
@@ -87,13 +115,40 @@ public:
     void addJobItems(FileManagerListJob* job,
                      ProjectFolderItem* baseItem,
                      const KIO::UDSEntryList& entries);
+    void addScannedItems(FileManagerListJob* job,
+                         ProjectFolderItem* baseItem,
+                         Path::List files, Path::List folders);
+    /// Replaces the child items of @p baseItem with the given valid files and folders.
+    void updateJobItems(FileManagerListJob* job,
+                        ProjectFolderItem* baseItem,
+                        Path::List files, Path::List folders);
 
     void deleted(const QString &path);
     void created(const QString &path);
+    void dirty(const QString &path);
+    /// Remembers the change of @p path, it is applied together with the following ones
+    void queueChange(const QString& path, Change change);
+    /**
+     * Applies all queued changes to the project models, grouped by the folders they happened in.
+     *
+     * Only the current state on disk is compared with the model, so a file that got created and
+     * deleted again in the meantime is ignored, and each path is handled once no matter how many
+     * events were seen for it.
+     */
+    void applyChanges();
+    void applyChanges(IProject* project, const QVector<PathChange>& changes);
 
+    void projectOpened(IProject* project);
     void projectClosing(IProject* project);
     void jobFinished(KJob* job);
 
+    /// Creates the items stored in the snapshot of the project, and lets @p job reconcile them
+    void restoreSnapshot(FileManagerListJob* job);
+    void writeSnapshot(IProject* project);
+
+    /// Indexes the given file again if the project has a trigram index
+    void updateTrigramIndex(IProject* project, const QString& path);
+
     /// Stops watching the given folder for changes, only useful for local files.
     void stopWatcher(ProjectFolderItem* folder);
     /// Continues watching the given folder for changes.
@@ -104,13 +159,125 @@ public:
     void removeFolder(ProjectFolderItem* folder);
 
     QHash<IProject*, KDirWatch*> m_watchers;
+    QHash<IProject*, TrigramIndex*> m_trigramIndexes;
     QHash<IProject*, QList<FileManagerListJob*> > m_projectJobs;
+    QHash<IProject*, ProjectSnapshot::FolderStamps> m_folderStamps;
+    QHash<IProject*, ProjectSnapshot::IgnoreFileStamps> m_ignoreFiles;
     QVector<QString> m_stoppedFolders;
     ProjectFilterManager m_filters;
+
+    QHash<QString, int> m_pendingChanges;
+    QTimer m_changeTimer;
+    // started with the first change that is pending
+    QElapsedTimer m_pendingSince;
 };
 
+void AbstractFileManagerPluginPrivate::projectOpened(IProject* project)
+{
+    TrigramIndex* index = m_trigramIndexes.value(project);
+    if (!index) {
+        return;
+    }
+
+    // the whole project is imported now, so the index can be brought up to date
+    QStringList files;
+    foreach (const IndexedString& file, project->fileSet()) {
+        files << file.toUrl().toLocalFile();
+    }
+    index->setFiles(files);
+}
+
+void AbstractFileManagerPluginPrivate::updateTrigramIndex(IProject* project, const QString& path)
+{
+    if (TrigramIndex* index = m_trigramIndexes.value(project)) {
+        index->update(path);
+    }
+}
+
+void AbstractFileManagerPluginPrivate::restoreSnapshot(FileManagerListJob* job)
+{
+    ProjectFolderItem* root = job->item();
+    IProject* project = root->project();
+    if (!ProjectSnapshot::isEnabled() || root->rowCount()) {
+        return;
+    }
+    ProjectSnapshot snapshot;
+    if (!snapshot.read(ProjectSnapshot::fileName(project, q), project)) {
+        return;
+    }
+
+    m_ignoreFiles[project] = snapshot.ignoreFiles();
+
+    const QVector<ProjectSnapshot::Folder> folders = snapshot.folders();
+    QVector<ProjectFolderItem*> items(folders.size(), nullptr);
+    ProjectSnapshot::Stamps stamps;
+    stamps.reserve(folders.size());
+    // the rows of every folder are inserted into the model at once
+    QVector<ProjectFolderItem*> batches;
+    QList<ProjectFileItem*> newFiles;
+    QList<ProjectFolderItem*> newFolders;
+    for (int i = 0; i < folders.size(); ++i) {
+        const ProjectSnapshot::Folder& folder = folders.at(i);
+        ProjectFolderItem* item = root;
+        if (folder.parent != -1) {
+            ProjectFolderItem* parent = items.at(folder.parent);
+            item = parent ? q->createFolderItem(project, Path(parent->path(), folder.name), parent) : nullptr;
+            if (!item) {
+                continue;
+            }
+            newFolders << item;
+        }
+        item->beginAppendRows();
+        batches << item;
+        items[i] = item;
+        stamps << qMakePair(item->path(), folder.stamp);
+        // the folders that changed in the meantime are listed again, which replaces their stamp
+        m_folderStamps[project].insert(item->path(), folder.stamp);
+
+        for (const QString& name : folder.files) {
+            ProjectFileItem* file = q->createFileItem(project, Path(item->path(), name), item);
+            if (file) {
+                newFiles << file;
+            }
+        }
+    }
+    // the sub folders come first, so every folder is inserted along with its contents
+    for (int i = batches.size() - 1; i >= 0; --i) {
+        batches.at(i)->endAppendRows();
+    }
+    foreach (ProjectFolderItem* folder, newFolders) {
+        emit q->folderAdded(folder);
+    }
+    foreach (ProjectFileItem* file, newFiles) {
+        emit q->fileAdded(file);
+    }
+    qCDebug(FILEMANAGER) << "restored" << stamps.size() << "folders of project" << project->name() << "from its snapshot";
+
+    job->setSnapshotStamps(stamps);
+}
+
+void AbstractFileManagerPluginPrivate::writeSnapshot(IProject* project)
+{
+    if (!ProjectSnapshot::isEnabled() || !project->projectItem() || !m_projectJobs.value(project).isEmpty()) {
+        // the project was not imported completely
+        return;
+    }
+    const QString fileName = ProjectSnapshot::fileName(project, q);
+    if (!fileName.isEmpty()) {
+        ProjectSnapshot::write(fileName, project->projectItem(), m_folderStamps.value(project), m_ignoreFiles.value(project));
+    }
+}
+
 void AbstractFileManagerPluginPrivate::projectClosing(IProject* project)
 {
+    if (!m_pendingChanges.isEmpty()) {
+        // the snapshot should contain them
+        applyChanges();
+    }
+    writeSnapshot(project);
+    m_folderStamps.remove(project);
+    m_ignoreFiles.remove(project);
+
     if ( m_projectJobs.contains(project) ) {
         // make sure the import job does not live longer than the project
         // see also addLotsOfFiles test
@@ -127,6 +294,8 @@ void AbstractFileManagerPluginPrivate::projectClosing(IProject* project)
     }
 #endif
     delete m_watchers.take(project);
+    // waits for the indexing, and writes the index to disk
+    delete m_trigramIndexes.take(project);
 #ifdef TIME_IMPORT_JOB
     if (timer.isValid()) {
         qCDebug(FILEMANAGER) << "Deleting dir watcher took" << timer.elapsed() / 1000.0 << "seconds for project" << project->name();
@@ -138,6 +307,8 @@ void AbstractFileManagerPluginPrivate::projectClosing(IProject* project)
 KIO::Job* AbstractFileManagerPluginPrivate::eventuallyReadFolder(ProjectFolderItem* item)
 {
     FileManagerListJob* listJob = new FileManagerListJob( item );
+    // the filters are applied while the folders are listed
+    listJob->setFilters(m_filters.filtersForProject(item->project()));
     m_projectJobs[ item->project() ] << listJob;
     qCDebug(FILEMANAGER) << "adding job" << listJob << item << item->path() << "for project" << item->project();
 
@@ -148,6 +319,10 @@ KIO::Job* AbstractFileManagerPluginPrivate::eventuallyReadFolder(ProjectFolderIt
                 q, [&] (FileManagerListJob* job, ProjectFolderItem* baseItem, const KIO::UDSEntryList& entries) {
                     addJobItems(job, baseItem, entries); } );
 
+    q->connect( listJob, &FileManagerListJob::scannedEntries,
+                q, [&] (FileManagerListJob* job, ProjectFolderItem* baseItem, const Path::List& files, const Path::List& folders) {
+                    addScannedItems(job, baseItem, files, folders); } );
+
     return listJob;
 }
 
@@ -206,9 +381,41 @@ void AbstractFileManagerPluginPrivate::addJobItems(FileManagerListJob* job,
         }
     }
 
+    updateJobItems(job, baseItem, files, folders);
+}
+
+void AbstractFileManagerPluginPrivate::addScannedItems(FileManagerListJob* job,
+                                                         ProjectFolderItem* baseItem,
+                                                         Path::List files, Path::List folders)
+{
+    qCDebug(FILEMANAGER) << "reading scanned entries of" << baseItem->path();
+
+    // the project filters were applied by the scanner already, only the checks of subclasses are left
+    IProject* project = baseItem->project();
+    files.erase(std::remove_if(files.begin(), files.end(), [&] (const Path& path) {
+        return !q->isValidIgnoringFilters(path, false, project);
+    }), files.end());
+    folders.erase(std::remove_if(folders.begin(), folders.end(), [&] (const Path& path) {
+        return !q->isValidIgnoringFilters(path, true, project);
+    }), folders.end());
+
+    updateJobItems(job, baseItem, files, folders);
+}
+
+void AbstractFileManagerPluginPrivate::updateJobItems(FileManagerListJob* job,
+                                                        ProjectFolderItem* baseItem,
+                                                        Path::List files, Path::List folders)
+{
     ifDebug(qCDebug(FILEMANAGER) << "valid folders:" << folders;)
     ifDebug(qCDebug(FILEMANAGER) << "valid files:" << files;)
 
+    // folders that changed after they were listed don't match this stamp when the snapshot is read
+    m_folderStamps[baseItem->project()].insert(baseItem->path(), job->listedStamp());
+    const ProjectSnapshot::IgnoreFileStamps ignoreFiles = job->listedIgnoreFiles();
+    for (auto it = ignoreFiles.constBegin(); it != ignoreFiles.constEnd(); ++it) {
+        m_ignoreFiles[baseItem->project()].insert(it.key(), it.value());
+    }
+
     // remove obsolete rows
     for ( int j = 0; j < baseItem->rowCount(); ++j ) {
         if ( ProjectFolderItem* f = baseItem->child(j)->folder() ) {
@@ -221,8 +428,11 @@ void AbstractFileManagerPluginPrivate::addJobItems(FileManagerListJob* job,
             } else {
                 // this folder already exists in the view
                 folders.remove( index );
-                // no need to add this item, but we still want to recurse into it
-                job->addSubDir( f );
+                // no need to add this item, but we still want to recurse into it,
+                // unless it is known to be unchanged since the snapshot
+                if (!job->isReconciling()) {
+                    job->addSubDir( f );
+                }
                 emit q->reloadedFolderItem( f );
             }
         } else if ( ProjectFileItem* f =  baseItem->child(j)->file() ) {
@@ -241,121 +451,227 @@ void AbstractFileManagerPluginPrivate::addJobItems(FileManagerListJob* job,
         }
     }
 
-    // add new rows
+    // add new rows, they are inserted into the model at once
+    QList<ProjectFileItem*> newFiles;
+    QList<ProjectFolderItem*> newFolders;
+    baseItem->beginAppendRows();
     foreach ( const Path& path, files ) {
         ProjectFileItem* file = q->createFileItem( baseItem->project(), path, baseItem );
         if (file) {
-            emit q->fileAdded( file );
+            newFiles << file;
         }
     }
     foreach ( const Path& path, folders ) {
         ProjectFolderItem* folder = q->createFolderItem( baseItem->project(), path, baseItem );
         if (folder) {
-            emit q->folderAdded( folder );
-            job->addSubDir( folder );
+            newFolders << folder;
         }
     }
+    baseItem->endAppendRows();
+
+    foreach ( ProjectFileItem* file, newFiles ) {
+        emit q->fileAdded( file );
+    }
+    foreach ( ProjectFolderItem* folder, newFolders ) {
+        emit q->folderAdded( folder );
+        job->addSubDir( folder );
+    }
 }
 
 void AbstractFileManagerPluginPrivate::created(const QString& path_)
 {
-    qCDebug(FILEMANAGER) << "created:" << path_;
-    QFileInfo info(path_);
-
-    ///FIXME: share memory with parent
-    const Path path(path_);
-    const IndexedString indexedPath(path.pathOrUrl());
-    const IndexedString indexedParent(path.parent().pathOrUrl());
-
-    QHashIterator<IProject*, KDirWatch*> it(m_watchers);
-    while (it.hasNext()) {
-        const auto p = it.next().key();
-        if ( !p->projectItem()->model() ) {
-            // not yet finished with loading
-            // FIXME: how should this be handled? see unit test
-            continue;
-        }
-        if ( !q->isValid(path, info.isDir(), p) ) {
-            continue;
-        }
-        if ( info.isDir() ) {
-            bool found = false;
-            foreach ( ProjectFolderItem* folder, p->foldersForPath(indexedPath) ) {
-                // exists already in this project, happens e.g. when we restart the dirwatcher
-                // or if we delete and remove folders consecutively https://bugs.kde.org/show_bug.cgi?id=260741
-                qCDebug(FILEMANAGER) << "force reload of" << path << folder;
-                auto job = eventuallyReadFolder( folder );
-                job->start();
-                found = true;
-            }
-            if ( found ) {
-                continue;
-            }
-        } else if (!p->filesForPath(indexedPath).isEmpty()) {
-            // also gets triggered for kate's backup files
-            continue;
-        }
-        foreach ( ProjectFolderItem* parentItem, p->foldersForPath(indexedParent) ) {
-            if ( info.isDir() ) {
-                ProjectFolderItem* folder = q->createFolderItem( p, path, parentItem );
-                if (folder) {
-                    emit q->folderAdded( folder );
-                    auto job = eventuallyReadFolder( folder );
-                    job->start();
-                }
-            } else {
-                ProjectFileItem* file = q->createFileItem( p, path, parentItem );
-                if (file) {
-                    emit q->fileAdded( file );
-                }
-            }
-        }
-    }
+    ifDebug(qCDebug(FILEMANAGER) << "created:" << path_;)
+    queueChange(path_, Created);
 }
 
 void AbstractFileManagerPluginPrivate::deleted(const QString& path_)
 {
-    if ( QFile::exists(path_) ) {
-        // stopDirScan...
-        return;
-    }
     // ensure that the path is not inside a stopped folder
     foreach(const QString& folder, m_stoppedFolders) {
         if (path_.startsWith(folder)) {
             return;
         }
     }
-    qCDebug(FILEMANAGER) << "deleted:" << path_;
+    ifDebug(qCDebug(FILEMANAGER) << "deleted:" << path_;)
+    queueChange(path_, Deleted);
+}
 
-    const Path path(QUrl::fromLocalFile(path_));
-    const IndexedString indexed(path.pathOrUrl());
+void AbstractFileManagerPluginPrivate::dirty(const QString& path_)
+{
+    ifDebug(qCDebug(FILEMANAGER) << "dirty:" << path_;)
+    queueChange(path_, Modified);
+}
+
+void AbstractFileManagerPluginPrivate::queueChange(const QString& path, Change change)
+{
+    m_pendingChanges[path] |= change;
+    if (!m_changeTimer.isActive()) {
+        m_pendingSince.start();
+        m_changeTimer.start();
+    } else if (m_pendingSince.elapsed() < maxChangeDelay) {
+        // wait until the file system is quiet again, e.g. when a whole branch gets checked out
+        m_changeTimer.start();
+    }
+}
 
-    QHashIterator<IProject*, KDirWatch*> it(m_watchers);
-    while (it.hasNext()) {
-        const auto p = it.next().key();
-        if (path == p->path()) {
+void AbstractFileManagerPluginPrivate::applyChanges()
+{
+    QHash<QString, int> pending;
+    pending.swap(m_pendingChanges);
+    m_changeTimer.stop();
+
+    QVector<PathChange> changes;
+    changes.reserve(pending.size());
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        // only the current state of a path counts, e.g. a file that got deleted and written again
+        // is handled as a modified file even if its creation wasn't reported
+        const QFileInfo info(it.key());
+        changes.append({Path(it.key()), it.value(), info.exists(), info.isDir()});
+    }
+    // parents come first, directly followed by all paths below them
+    std::sort(changes.begin(), changes.end(), [] (const PathChange& a, const PathChange& b) {
+        return a.path < b.path;
+    });
+    qCDebug(FILEMANAGER) << "applying" << changes.size() << "file system changes";
+
+    foreach (IProject* project, m_watchers.keys()) {
+        if (!m_watchers.contains(project)) {
+            // closed while the message box below was shown for another project
+            continue;
+        }
+        const auto rootChange = std::find_if(changes.constBegin(), changes.constEnd(), [project] (const PathChange& change) {
+            return change.path == project->path();
+        });
+        if (rootChange != changes.constEnd() && !rootChange->exists) {
             KMessageBox::error(qApp->activeWindow(),
                                i18n("The base folder of project <b>%1</b>"
                                     " got deleted or moved outside of KDevelop.\n"
-                                    "The project has to be closed.", p->name()),
+                                    "The project has to be closed.", project->name()),
                                i18n("Project Folder Deleted") );
-            ICore::self()->projectController()->closeProject(p);
+            ICore::self()->projectController()->closeProject(project);
             continue;
         }
-        if ( !p->projectItem()->model() ) {
+        if ( !project->projectItem()->model() ) {
             // not yet finished with loading
             // FIXME: how should this be handled? see unit test
             continue;
         }
-        foreach ( ProjectFolderItem* item, p->foldersForPath(indexed) ) {
-            removeFolder(item);
+        applyChanges(project, changes);
+    }
+}
+
+void AbstractFileManagerPluginPrivate::applyChanges(IProject* project, const QVector<PathChange>& changes)
+{
+    QSet<IndexedString> changedFiles;
+    QVector<ProjectFolderItem*> reloadedFolders;
+    // the new items, grouped by the folder they are added to
+    QVector<ProjectFolderItem*> parents;
+    QHash<ProjectFolderItem*, QVector<const PathChange*>> additions;
+    // the last folder that got removed or is listed again, the paths below it need no handling
+    Path handledFolder;
+
+    for (const PathChange& change : changes) {
+        if (!project->path().isParentOf(change.path)) {
+            continue;
+        }
+        const IndexedString indexedPath(change.path.pathOrUrl());
+        if (change.exists && !change.isDir && !project->filesForPath(indexedPath).isEmpty()) {
+            // also gets triggered for kate's backup files
+            // and when a file is replaced, e.g. when it is saved or checked out
+            updateTrigramIndex(project, change.path.toLocalFile());
+            changedFiles.insert(indexedPath);
+            continue;
         }
-        foreach ( ProjectFileItem* item, p->filesForPath(indexed) ) {
-            emit q->fileRemoved(item);
-            ifDebug(qCDebug(FILEMANAGER) << "removing file" << item;)
-            item->parent()->removeRow(item->row());
+        if (handledFolder.isValid() && handledFolder.isParentOf(change.path)) {
+            continue;
+        }
+
+        if (!change.exists) {
+            if (TrigramIndex* index = m_trigramIndexes.value(project)) {
+                // only the files of the project are indexed, so a removed folder doesn't require a scan of the index
+                QStringList files;
+                foreach (ProjectBaseItem* item, project->projectItem()->model()->itemsBelowPath(change.path)) {
+                    if (item->file() && item->project() == project) {
+                        files << item->path().toLocalFile();
+                    }
+                }
+                index->remove(files);
+            }
+            foreach ( ProjectFolderItem* item, project->foldersForPath(indexedPath) ) {
+                removeFolder(item);
+                handledFolder = change.path;
+            }
+            foreach ( ProjectFileItem* item, project->filesForPath(indexedPath) ) {
+                emit q->fileRemoved(item);
+                ifDebug(qCDebug(FILEMANAGER) << "removing file" << item;)
+                item->parent()->removeRow(item->row());
+            }
+            continue;
+        }
+
+        if (change.isDir) {
+            const QList<ProjectFolderItem*> folders = project->foldersForPath(indexedPath);
+            if (!folders.isEmpty()) {
+                if (change.events & Created) {
+                    // exists already in this project, happens e.g. when we restart the dirwatcher
+                    // or if we delete and remove folders consecutively https://bugs.kde.org/show_bug.cgi?id=260741
+                    qCDebug(FILEMANAGER) << "force reload of" << change.path;
+                    reloadedFolders += folders.toVector();
+                    handledFolder = change.path;
+                }
+                // otherwise only the entries of the folder changed, they come with their own events
+                continue;
+            }
+        }
+        if ( !q->isValid(change.path, change.isDir, project) ) {
+            continue;
+        }
+        foreach ( ProjectFolderItem* parentItem, project->foldersForPath(IndexedString(change.path.parent().pathOrUrl())) ) {
+            auto& parentAdditions = additions[parentItem];
+            if (parentAdditions.isEmpty()) {
+                parents << parentItem;
+            }
+            parentAdditions << &change;
+        }
+        if (change.isDir) {
+            // the contents of a new folder are listed along with it
+            handledFolder = change.path;
         }
     }
+
+    for (ProjectFolderItem* parentItem : parents) {
+        QList<ProjectFolderItem*> newFolders;
+        QList<ProjectFileItem*> newFiles;
+        parentItem->beginAppendRows();
+        for (const PathChange* change : additions.value(parentItem)) {
+            if (change->isDir) {
+                if (ProjectFolderItem* folder = q->createFolderItem(project, change->path, parentItem)) {
+                    newFolders << folder;
+                }
+            } else if (ProjectFileItem* file = q->createFileItem(project, change->path, parentItem)) {
+                newFiles << file;
+            }
+        }
+        parentItem->endAppendRows();
+
+        foreach ( ProjectFolderItem* folder, newFolders ) {
+            emit q->folderAdded(folder);
+            reloadedFolders << folder;
+        }
+        foreach ( ProjectFileItem* file, newFiles ) {
+            emit q->fileAdded(file);
+            changedFiles.insert(file->indexedPath());
+        }
+    }
+
+    foreach ( ProjectFolderItem* folder, reloadedFolders ) {
+        auto job = eventuallyReadFolder( folder );
+        job->start();
+    }
+
+    if (!changedFiles.isEmpty()) {
+        emit q->filesChanged(project, changedFiles.toList());
+    }
 }
 
 bool AbstractFileManagerPluginPrivate::rename(ProjectBaseItem* item, const Path& newPath)
@@ -462,6 +778,17 @@ AbstractFileManagerPlugin::AbstractFileManagerPlugin( const QString& componentNa
 {
     connect(core()->projectController(), &IProjectController::projectClosing,
             this, [&] (IProject* project) { d->projectClosing(project); });
+    connect(core()->projectController(), &IProjectController::projectOpened,
+            this, [&] (IProject* project) { d->projectOpened(project); });
+    connect(this, &AbstractFileManagerPlugin::fileAdded,
+            this, [&] (ProjectFileItem* file) { d->updateTrigramIndex(file->project(), file->path().toLocalFile()); });
+    connect(this, &AbstractFileManagerPlugin::fileRenamed,
+            this, [&] (const Path& oldPath, ProjectFileItem* file) {
+                if (TrigramIndex* index = d->m_trigramIndexes.value(file->project())) {
+                    index->remove(oldPath.toLocalFile());
+                    index->update(file->path().toLocalFile());
+                }
+            });
 }
 
 AbstractFileManagerPlugin::~AbstractFileManagerPlugin() = default;
@@ -494,8 +821,16 @@ ProjectFolderItem *AbstractFileManagerPlugin::import( IProject *project )
                 this, [&] (const QString& path_) { d->created(path_); });
         connect(watcher, &KDirWatch::deleted,
                 this, [&] (const QString& path_) { d->deleted(path_); });
+        connect(watcher, &KDirWatch::dirty,
+                this, [&] (const QString& path_) { d->dirty(path_); });
         watcher->addDir(project->path().toLocalFile(), KDirWatch::WatchSubDirs | KDirWatch:: WatchFiles );
         d->m_watchers[project] = watcher;
+
+        if (TrigramIndex::isEnabled()) {
+            const QString root = project->path().toLocalFile();
+            // modified, created and deleted files are indexed together with the changes of the project model
+            d->m_trigramIndexes[project] = new TrigramIndex(root, TrigramIndex::defaultIndexFile(root));
+        }
     }
 
     d->m_filters.add(project);
@@ -505,7 +840,12 @@ ProjectFolderItem *AbstractFileManagerPlugin::import( IProject *project )
 
 KJob* AbstractFileManagerPlugin::createImportJob(ProjectFolderItem* item)
 {
-    return d->eventuallyReadFolder(item);
+    auto job = static_cast<FileManagerListJob*>(d->eventuallyReadFolder(item));
+    if (item->path() == item->project()->path()) {
+        // show the project as it was when it got closed, then only list the folders that changed since
+        d->restoreSnapshot(job);
+    }
+    return job;
 }
 
 bool AbstractFileManagerPlugin::reload( ProjectFolderItem* item )
@@ -652,7 +992,16 @@ bool AbstractFileManagerPlugin::copyFilesAndFolders(const Path::List& items, Pro
 bool AbstractFileManagerPlugin::isValid( const Path& path, const bool isFolder,
                                          IProject* project ) const
 {
-    return d->m_filters.isValid( path, isFolder, project );
+    return d->m_filters.isValid( path, isFolder, project ) && isValidIgnoringFilters( path, isFolder, project );
+}
+
+bool AbstractFileManagerPlugin::isValidIgnoringFilters( const Path& path, const bool isFolder,
+                                                        IProject* project ) const
+{
+    Q_UNUSED(path);
+    Q_UNUSED(isFolder);
+    Q_UNUSED(project);
+    return true;
 }
 
 ProjectFileItem* AbstractFileManagerPlugin::createFileItem( IProject* project, const Path& path,
@@ -28,6 +28,7 @@
 #include <QVariant>
 
 #include <interfaces/iplugin.h>
+#include <serialization/indexedstring.h>
 
 class KDirWatch;
 
@@ -77,12 +78,25 @@ protected:
      * Filter interface making it possible to hide files and folders from a project.
      *
      * The default implementation will query all IProjectFilter plugins and ask them
-     * whether a given url should be included or not.
+     * whether a given url should be included or not, and then isValidIgnoringFilters().
      *
      * @return True when @p path should belong to @p project, false otherwise.
      */
     virtual bool isValid(const Path& path, const bool isFolder, IProject* project) const;
 
+    /**
+     * Hook for the checks of a plugin that come on top of the IProjectFilter plugins.
+     *
+     * Local folders are listed on worker threads, which apply the project filters themselves,
+     * so the items found there are only checked with this function. Reimplement it rather
+     * than isValid() to hide items from every project.
+     *
+     * The default implementation accepts all items.
+     *
+     * @return True when @p path should belong to @p project, false otherwise.
+     */
+    virtual bool isValidIgnoringFilters(const Path& path, const bool isFolder, IProject* project) const;
+
     /**
      * Customization hook enabling you to create custom FolderItems if required.
      *
@@ -116,6 +130,12 @@ Q_SIGNALS:
     void fileRemoved(KDevelop::ProjectFileItem* file);
     void fileRenamed(const KDevelop::Path& oldFile, KDevelop::ProjectFileItem* newFile);
 
+    /**
+     * Emitted after a batch of changes on disk got applied to the project model,
+     * with the files of @p project that were created or modified, each one listed once.
+     */
+    void filesChanged(KDevelop::IProject* project, const QList<KDevelop::IndexedString>& files);
+
 private:
     const QScopedPointer<class AbstractFileManagerPluginPrivate> d;
     friend class AbstractFileManagerPluginPrivate;
@@ -25,17 +25,30 @@
 #include "path.h"
 #include "debug.h"
 
+#include <algorithm>
+
 #include <QtConcurrentRun>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFutureWatcher>
 
 using namespace KDevelop;
 
+namespace {
+
+// Scanned directories are handled for this long before the event loop gets a chance to run
+const int scanHandlingBudget = 30;
+
+}
+
 FileManagerListJob::FileManagerListJob(ProjectFolderItem* item)
     : KIO::Job(), m_item(item), m_aborted(false)
 {
     qRegisterMetaType<KIO::UDSEntryList>("KIO::UDSEntryList");
     qRegisterMetaType<KIO::Job*>();
     qRegisterMetaType<KJob*>();
+    qRegisterMetaType<ProjectSnapshot::Stamp>();
 
     /* the following line is not an error in judgment, apparently starting a
      * listJob while the previous one hasn't self-destructed takes a lot of time,
@@ -64,7 +77,82 @@ void FileManagerListJob::addSubDir( ProjectFolderItem* item )
 
 void FileManagerListJob::removeSubDir(ProjectFolderItem* item)
 {
-    m_listQueue.removeAll(item);
+    if (m_snapshotStamps.isEmpty()) {
+        m_listQueue.removeAll(item);
+        return;
+    }
+    // changed folders are queued at any depth when reconciling a snapshot
+    const Path path = item->path();
+    m_listQueue.erase(std::remove_if(m_listQueue.begin(), m_listQueue.end(), [&] (ProjectFolderItem* queued) {
+        return queued == item || path.isParentOf(queued->path());
+    }), m_listQueue.end());
+}
+
+void FileManagerListJob::setFilters(const QVector<QSharedPointer<IProjectFilter>>& filters)
+{
+    m_filters = filters;
+    m_useScanner = true;
+}
+
+void FileManagerListJob::setSnapshotStamps(const ProjectSnapshot::Stamps& stamps)
+{
+    m_snapshotStamps = stamps;
+}
+
+bool FileManagerListJob::isReconciling() const
+{
+    return !m_snapshotStamps.isEmpty();
+}
+
+ProjectSnapshot::Stamp FileManagerListJob::listedStamp() const
+{
+    return m_itemStamp;
+}
+
+ProjectSnapshot::IgnoreFileStamps FileManagerListJob::listedIgnoreFiles() const
+{
+    return m_itemIgnoreFiles;
+}
+
+void FileManagerListJob::snapshotChecked(const Path::List& changedFolders)
+{
+    if (m_aborted) {
+        return;
+    }
+
+    ProjectFolderItem* root = m_item;
+    for (const Path& path : changedFolders) {
+        // find the item of the folder, it might have been removed in the meantime
+        Path::List parents;
+        for (Path parent = path; parent != root->path() && root->path().isParentOf(parent); parent = parent.parent()) {
+            parents.prepend(parent);
+        }
+        ProjectFolderItem* folder = root;
+        for (const Path& parent : parents) {
+            ProjectFolderItem* next = nullptr;
+            foreach (ProjectFolderItem* child, folder->folderList()) {
+                if (child->path() == parent) {
+                    next = child;
+                    break;
+                }
+            }
+            folder = next;
+            if (!folder) {
+                break;
+            }
+        }
+        if (folder) {
+            m_listQueue.enqueue(folder);
+        }
+    }
+
+    qCDebug(FILEMANAGER) << "folders changed since the snapshot was taken:" << m_listQueue.size() << "of" << m_snapshotStamps.size();
+
+    if (m_listQueue.isEmpty()) {
+        emitResult();
+    } else {
+        startNextJob();
+    }
 }
 
 void FileManagerListJob::slotEntries(KIO::Job* job, const KIO::UDSEntryList& entriesIn)
@@ -79,6 +167,11 @@ void FileManagerListJob::startNextJob()
         return;
     }
 
+    if (m_scanner) {
+        handleScannedDirectories();
+        return;
+    }
+
 #ifdef TIME_IMPORT_JOB
     m_subTimer.start();
 #endif
@@ -90,6 +183,7 @@ void FileManagerListJob::startNextJob()
             if (m_aborted) {
                 return;
             }
+            const auto stamp = ProjectSnapshot::Stamp::forPath(path.toLocalFile());
             QDir dir(path.toLocalFile());
             const auto entries = dir.entryInfoList(QDir::NoDotAndDotDot | QDir::AllEntries | QDir::Hidden);
             if (m_aborted) {
@@ -107,7 +201,8 @@ void FileManagerListJob::startNextJob()
                 }
                 return entry;
             });
-            QMetaObject::invokeMethod(this, "handleResults", Q_ARG(KIO::UDSEntryList, results));
+            QMetaObject::invokeMethod(this, "handleResults", Q_ARG(KIO::UDSEntryList, results),
+                                      Q_ARG(KDevelop::ProjectSnapshot::Stamp, stamp));
         }, m_item->path());
     } else {
         KIO::ListJob* job = KIO::listDir( m_item->path().toUrl(), KIO::HideProgressInfo );
@@ -119,6 +214,58 @@ void FileManagerListJob::startNextJob()
     }
 }
 
+void FileManagerListJob::directoriesScanned(const QVector<LocalDirectoryScanner::Directory>& directories)
+{
+    for (const auto& directory : directories) {
+        m_scannedDirectories.insert(directory.path, directory);
+    }
+    handleScannedDirectories();
+}
+
+void FileManagerListJob::scanFinished()
+{
+    m_scanFinished = true;
+    handleScannedDirectories();
+}
+
+void FileManagerListJob::handleScannedDirectories()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    while (!m_listQueue.isEmpty() && !m_aborted) {
+        auto it = m_scannedDirectories.find(m_listQueue.head()->path());
+        if (it == m_scannedDirectories.end()) {
+            if (!m_scanFinished) {
+                // continued once the folder got scanned
+                return;
+            }
+            // the scanner doesn't know this folder, keep its contents
+            m_item = m_listQueue.dequeue();
+        } else {
+            m_item = m_listQueue.dequeue();
+            const LocalDirectoryScanner::Directory directory = it.value();
+            m_scannedDirectories.erase(it);
+            m_itemStamp = directory.stamp;
+            m_itemIgnoreFiles = directory.ignoreFiles;
+            emit scannedEntries(this, m_item, directory.files, directory.folders);
+        }
+
+        if (m_listQueue.isEmpty()) {
+            emitResult();
+
+#ifdef TIME_IMPORT_JOB
+            qCDebug(PROJECT) << "TIME FOR LISTJOB:" << m_timer.elapsed();
+#endif
+            return;
+        }
+        if (timer.elapsed() > scanHandlingBudget) {
+            emit nextJob();
+            return;
+        }
+    }
+}
+
 void FileManagerListJob::slotResult(KJob* job)
 {
     if (m_aborted) {
@@ -129,12 +276,12 @@ void FileManagerListJob::slotResult(KJob* job)
         qCDebug(FILEMANAGER) << "error in list job:" << job->error() << job->errorString();
     }
 
-    handleResults(entryList);
+    handleResults(entryList, {});
     entryList.clear();
 }
 
 
-void FileManagerListJob::handleResults(const KIO::UDSEntryList& entriesIn)
+void FileManagerListJob::handleResults(const KIO::UDSEntryList& entriesIn, const ProjectSnapshot::Stamp& stamp)
 {
     if (m_aborted) {
         return;
@@ -148,6 +295,8 @@ void FileManagerListJob::handleResults(const KIO::UDSEntryList& entriesIn)
     }
 #endif
 
+    m_itemStamp = stamp;
+    m_itemIgnoreFiles.clear();
     emit entries(this, m_item, entriesIn);
 
     if( m_listQueue.isEmpty() ) {
@@ -172,5 +321,42 @@ void FileManagerListJob::abort()
 
 void FileManagerListJob::start()
 {
+    if (isReconciling()) {
+        // the folders are compared with the snapshot in the background, then the changed ones are listed
+        m_listQueue.clear();
+        auto watcher = new QFutureWatcher<Path::List>(this);
+        connect(watcher, &QFutureWatcher<Path::List>::finished, this, [this, watcher] () {
+            snapshotChecked(watcher->result());
+        });
+        const ProjectSnapshot::Stamps stamps = m_snapshotStamps;
+        watcher->setFuture(QtConcurrent::run([stamps] () {
+            Path::List changed;
+            for (int i = 0; i < stamps.size(); ++i) {
+                const auto& folder = stamps.at(i);
+                if (folder.second.isEmpty()
+                    || ProjectSnapshot::Stamp::forPath(folder.first.toLocalFile()) != folder.second) {
+                    // a folder that got a .kdev_ignore file is dropped when its parent is listed again
+                    if (i > 0 && QFile::exists(folder.first.toLocalFile() + QLatin1String("/.kdev_ignore"))) {
+                        changed << folder.first.parent();
+                    }
+                    changed << folder.first;
+                }
+            }
+            return changed;
+        }));
+        return;
+    }
+
+    if (m_useScanner && m_item->path().isLocalFile() && LocalDirectoryScanner::isEnabled()) {
+        // the folders are handled in the order in which they are queued, as soon as they got scanned
+        m_scanner = new LocalDirectoryScanner(m_item->path(), m_filters, m_item->project()->path(), this);
+        connect(m_scanner, &LocalDirectoryScanner::directoriesScanned,
+                this, &FileManagerListJob::directoriesScanned);
+        connect(m_scanner, &LocalDirectoryScanner::finished,
+                this, &FileManagerListJob::scanFinished);
+        m_scanner->start();
+        return;
+    }
+
     startNextJob();
 }
@@ -21,7 +21,12 @@
 #define KDEVPLATFORM_FILEMANAGERLISTJOB_H
 
 #include <KIO/Job>
+#include <QHash>
 #include <QQueue>
+#include <QSharedPointer>
+
+#include "localdirectoryscanner.h"
+#include "projectsnapshot.h"
 
 // uncomment to time imort jobs
 // #define TIME_IMPORT_JOB
@@ -32,6 +37,7 @@
 
 namespace KDevelop
 {
+    class IProjectFilter;
     class ProjectFolderItem;
 
 class FileManagerListJob : public KIO::Job
@@ -45,29 +51,68 @@ public:
     void addSubDir(ProjectFolderItem* item);
     void removeSubDir(ProjectFolderItem* item);
 
+    /**
+     * Lists local folders with a LocalDirectoryScanner, which drops the entries that are
+     * rejected by the given @p filters. The remaining entries are emitted with scannedEntries().
+     *
+     * Must be called before the job is started.
+     */
+    void setFilters(const QVector<QSharedPointer<IProjectFilter>>& filters);
+
+    /**
+     * Reconciles the items restored from a ProjectSnapshot with the file system. Only the folders whose
+     * stamp differs from the stored one are listed, as well as all the new folders found below them.
+     *
+     * Must be called before the job is started.
+     */
+    void setSnapshotStamps(const ProjectSnapshot::Stamps& stamps);
+    /// @returns whether the existing sub folders of a listed folder are left alone
+    bool isReconciling() const;
+
+    /// @returns the stamp that the folder whose entries are emitted had before it was listed, empty for remote folders
+    ProjectSnapshot::Stamp listedStamp() const;
+    /// @returns the .kdev_ignore files that hid sub folders of the folder whose entries are emitted
+    ProjectSnapshot::IgnoreFileStamps listedIgnoreFiles() const;
+
     void abort();
     void start() override;
 
 Q_SIGNALS:
     void entries(FileManagerListJob* job, ProjectFolderItem* baseItem,
                  const KIO::UDSEntryList& entries);
+    void scannedEntries(FileManagerListJob* job, ProjectFolderItem* baseItem,
+                        const Path::List& files, const Path::List& folders);
     void nextJob();
 
 private Q_SLOTS:
     void slotEntries(KIO::Job* job, const KIO::UDSEntryList& entriesIn );
     void slotResult(KJob* job) override;
-    void handleResults(const KIO::UDSEntryList& entries);
+    void handleResults(const KIO::UDSEntryList& entries, const KDevelop::ProjectSnapshot::Stamp& stamp);
     void startNextJob();
+    void directoriesScanned(const QVector<KDevelop::LocalDirectoryScanner::Directory>& directories);
+    void scanFinished();
 
 private:
+    void handleScannedDirectories();
+    void snapshotChecked(const Path::List& changedFolders);
 
     QQueue<ProjectFolderItem*> m_listQueue;
     /// current base dir
     ProjectFolderItem* m_item;
+    ProjectSnapshot::Stamp m_itemStamp;
+    ProjectSnapshot::IgnoreFileStamps m_itemIgnoreFiles;
     KIO::UDSEntryList entryList;
     // kill does not delete the job instantaniously
     QAtomicInt m_aborted;
 
+    QVector<QSharedPointer<IProjectFilter>> m_filters;
+    bool m_useScanner = false;
+    LocalDirectoryScanner* m_scanner = nullptr;
+    bool m_scanFinished = false;
+    // the scanned directories that were not handled yet
+    QHash<Path, LocalDirectoryScanner::Directory> m_scannedDirectories;
+    ProjectSnapshot::Stamps m_snapshotStamps;
+
 #ifdef TIME_IMPORT_JOB
     QElapsedTimer m_timer;
     QElapsedTimer m_subTimer;
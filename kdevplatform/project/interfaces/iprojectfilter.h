@@ -44,6 +44,10 @@ public:
     /**
      * Check whether the given @p path should be included in a project.
      *
+     * This is called concurrently from several threads while a local project is
+     * listed, so implementations must be thread-safe. Any state they depend on
+     * must not change after the filter was created, or must be protected by a mutex.
+     *
      * @param path is the path that you want to be checked.
      * @param isFolder distinguishes between files and folders.
      *
@@ -0,0 +1,233 @@
+/*
+    This file is part of KDevelop
+
+    Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "localdirectoryscanner.h"
+
+#include "interfaces/iprojectfilter.h"
+#include "debug.h"
+
+#include <QFile>
+#include <QMutex>
+#include <QtConcurrentRun>
+
+#ifdef Q_OS_UNIX
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace KDevelop;
+
+namespace {
+
+// How often the listed directories are handed over to the thread of the scanner
+const int deliveryInterval = 25;
+
+}
+
+struct LocalDirectoryScanner::State
+{
+    QVector<QSharedPointer<IProjectFilter>> filters;
+    Path projectPath;
+    QThreadPool* pool;
+    QAtomicInt canceled;
+
+    QMutex mutex;
+    // Listed directories that were not delivered yet
+    QVector<Directory> pending;
+    // Count of the started tasks that did not finish yet
+    int running = 0;
+
+    bool isValid(const Path& path, bool isFolder) const
+    {
+        for (const auto& filter : filters) {
+            if (!filter->isValid(path, isFolder)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool isLoop(const Path& linkedPath) const
+    {
+        return linkedPath.isParentOf(projectPath) || projectPath.isParentOf(linkedPath) || linkedPath == projectPath;
+    }
+};
+
+LocalDirectoryScanner::LocalDirectoryScanner(const Path& root, const QVector<QSharedPointer<IProjectFilter>>& filters,
+                                             const Path& projectPath, QObject* parent)
+    : QObject(parent)
+    , m_root(root)
+    , m_state(new State)
+{
+    qRegisterMetaType<QVector<KDevelop::LocalDirectoryScanner::Directory>>();
+
+    m_state->filters = filters;
+    m_state->projectPath = projectPath;
+    m_state->pool = &m_pool;
+    m_state->running = 1;
+
+    m_deliveryTimer.setInterval(deliveryInterval);
+    connect(&m_deliveryTimer, &QTimer::timeout, this, &LocalDirectoryScanner::deliver);
+}
+
+LocalDirectoryScanner::~LocalDirectoryScanner()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+bool LocalDirectoryScanner::isEnabled()
+{
+#ifdef Q_OS_UNIX
+    static const bool enabled = qEnvironmentVariableIsEmpty("KDEV_NATIVE_SCANNER")
+                             || qEnvironmentVariableIntValue("KDEV_NATIVE_SCANNER");
+    return enabled;
+#else
+    return false;
+#endif
+}
+
+void LocalDirectoryScanner::start()
+{
+    m_deliveryTimer.start();
+    QtConcurrent::run(&m_pool, &LocalDirectoryScanner::scan, m_state, m_root);
+}
+
+void LocalDirectoryScanner::cancel()
+{
+    m_state->canceled.store(true);
+    m_deliveryTimer.stop();
+}
+
+void LocalDirectoryScanner::scan(const QSharedPointer<State>& state, const Path& directory)
+{
+    Directory result;
+    result.path = directory;
+
+#ifdef Q_OS_UNIX
+    result.stamp = ProjectSnapshot::Stamp::forPath(directory.toLocalFile());
+    const int fd = state->canceled.load() ? -1
+        : ::open(QFile::encodeName(directory.toLocalFile()).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    DIR* dir = fd == -1 ? nullptr : fdopendir(fd);
+    if (fd != -1 && !dir) {
+        ::close(fd);
+    }
+    if (dir) {
+        while (const dirent* entry = readdir(dir)) {
+            const char* name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+
+            // the type is only looked up when the directory entry doesn't tell it
+            bool isLink = entry->d_type == DT_LNK;
+            bool isFolder = entry->d_type == DT_DIR;
+            if (entry->d_type != DT_DIR && entry->d_type != DT_REG) {
+                struct stat info;
+                if (entry->d_type == DT_UNKNOWN) {
+                    if (fstatat(fd, name, &info, AT_SYMLINK_NOFOLLOW) != 0) {
+                        continue;
+                    }
+                    isLink = S_ISLNK(info.st_mode);
+                }
+                if (isLink || entry->d_type != DT_UNKNOWN) {
+                    if (fstatat(fd, name, &info, 0) != 0) {
+                        // broken links are skipped, like QDir does
+                        continue;
+                    }
+                }
+                // sockets, fifos and devices are skipped as well
+                if (!S_ISDIR(info.st_mode) && !S_ISREG(info.st_mode)) {
+                    continue;
+                }
+                isFolder = S_ISDIR(info.st_mode);
+            }
+
+            const Path path(directory, QFile::decodeName(name));
+            if (!state->isValid(path, isFolder)) {
+                if (isFolder) {
+                    // the folder has to be listed once its .kdev_ignore file is removed
+                    const QString ignoreFile = path.toLocalFile() + QLatin1String("/.kdev_ignore");
+                    const auto stamp = ProjectSnapshot::Stamp::forPath(ignoreFile);
+                    if (!stamp.isEmpty()) {
+                        result.ignoreFiles.insert(Path(ignoreFile), stamp);
+                    }
+                }
+                continue;
+            }
+            if (!isFolder) {
+                result.files << path;
+                continue;
+            }
+            if (isLink) {
+                char target[PATH_MAX];
+                const ssize_t size = readlinkat(fd, name, target, sizeof(target));
+                if (size <= 0 || size == sizeof(target)) {
+                    continue;
+                }
+                // make sure we don't end in an infinite loop
+                if (state->isLoop(directory.cd(QFile::decodeName(QByteArray(target, size))))) {
+                    continue;
+                }
+            }
+            result.folders << path;
+        }
+        closedir(dir);
+    } else if (!state->canceled.load()) {
+        qCDebug(FILEMANAGER) << "failed to list" << directory;
+    }
+#endif
+
+    // the parent is queued before any of its children can be listed
+    QMutexLocker lock(&state->mutex);
+    state->pending << result;
+    if (!state->canceled.load()) {
+        state->running += result.folders.size();
+        for (const Path& folder : result.folders) {
+            QtConcurrent::run(state->pool, &LocalDirectoryScanner::scan, state, folder);
+        }
+    }
+    --state->running;
+}
+
+void LocalDirectoryScanner::deliver()
+{
+    QVector<Directory> directories;
+    bool done;
+    {
+        QMutexLocker lock(&m_state->mutex);
+        directories.swap(m_state->pending);
+        done = m_state->running == 0;
+    }
+
+    if (done) {
+        m_deliveryTimer.stop();
+    }
+    if (!directories.isEmpty()) {
+        emit directoriesScanned(directories);
+    }
+    if (done) {
+        emit finished();
+    }
+}
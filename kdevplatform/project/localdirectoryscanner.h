@@ -0,0 +1,109 @@
+/*
+    This file is part of KDevelop
+
+    Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KDEVPLATFORM_LOCALDIRECTORYSCANNER_H
+#define KDEVPLATFORM_LOCALDIRECTORYSCANNER_H
+
+#include "projectexport.h"
+#include "projectsnapshot.h"
+
+#include <util/path.h>
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+namespace KDevelop {
+
+class IProjectFilter;
+
+/**
+ * @short Lists a local directory tree in background threads.
+ *
+ * Every directory is listed by its own task on a thread pool, so idle threads pick up the
+ * pending subtrees. The entries of a directory are looked up relative to its opened file
+ * descriptor, and filtered with the given project filters right away, so excluded folders
+ * are never listed.
+ *
+ * The results are collected and delivered in batches in the thread of the scanner.
+ */
+class KDEVPLATFORMPROJECT_EXPORT LocalDirectoryScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// The valid entries of a listed directory
+    struct Directory
+    {
+        Path path;
+        /// The stamp of the directory, taken before it was listed
+        ProjectSnapshot::Stamp stamp;
+        Path::List files;
+        Path::List folders;
+        /// The .kdev_ignore files of the folders that were dropped by the filters
+        ProjectSnapshot::IgnoreFileStamps ignoreFiles;
+    };
+
+    /**
+     * Creates a scanner for the directory tree at @p root.
+     *
+     * Entries for which one of the @p filters returns false are dropped. Symbolic links to folders
+     * that contain @p projectPath, or that are contained in it, are dropped to avoid endless loops.
+     */
+    LocalDirectoryScanner(const Path& root, const QVector<QSharedPointer<IProjectFilter>>& filters,
+                          const Path& projectPath, QObject* parent = nullptr);
+    /// Cancels the scan, and waits for the running tasks.
+    ~LocalDirectoryScanner() override;
+
+    /**
+     * @returns whether local directories should be listed with a scanner, which is the default on Unix.
+     * It can be disabled by setting KDEV_NATIVE_SCANNER=0.
+     */
+    static bool isEnabled();
+
+    void start();
+    void cancel();
+
+Q_SIGNALS:
+    /// Emitted for every batch of listed directories, parents are delivered before their children.
+    void directoriesScanned(const QVector<KDevelop::LocalDirectoryScanner::Directory>& directories);
+    /// Emitted once all directories have been listed and delivered.
+    void finished();
+
+private:
+    struct State;
+
+    static void scan(const QSharedPointer<State>& state, const Path& directory);
+    void deliver();
+
+    const Path m_root;
+    QSharedPointer<State> m_state;
+    QThreadPool m_pool;
+    QTimer m_deliveryTimer;
+};
+
+}
+
+Q_DECLARE_METATYPE(QVector<KDevelop::LocalDirectoryScanner::Directory>)
+
+#endif // KDEVPLATFORM_LOCALDIRECTORYSCANNER_H
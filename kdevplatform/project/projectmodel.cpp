@@ -24,6 +24,7 @@
 #include <QIcon>
 #include <QMimeDatabase>
 #include <QMimeType>
+#include <QSet>
 
 #include <KIO/StatJob>
 #include <KLocalizedString>
@@ -75,6 +76,120 @@ inline uint indexForPath( const Path& path )
     return IndexedString::indexForString(path.pathOrUrl());
 }
 
+/**
+ * Maps paths to the items of the model, in a tree that mirrors the folder hierarchy.
+ *
+ * Items are found by the index of their IndexedString path in constant time, and all items
+ * below a folder by walking its subtree. Nodes are only kept while they or their children
+ * contain items.
+ */
+class ProjectPathIndex
+{
+public:
+    ~ProjectPathIndex()
+    {
+        qDeleteAll(m_nodes);
+    }
+
+    void insert(ProjectBaseItem* item, const Path& path, uint pathIndex)
+    {
+        Node* node = findOrCreate(path);
+        if (!node->pathIndex) {
+            node->pathIndex = pathIndex;
+            m_indexes.insert(pathIndex, node);
+        }
+        node->items.append(item);
+    }
+
+    void remove(ProjectBaseItem* item, const Path& path)
+    {
+        Node* node = m_nodes.value(path);
+        if (!node || !node->items.removeOne(item)) {
+            return;
+        }
+        if (node->items.isEmpty()) {
+            m_indexes.remove(node->pathIndex);
+            node->pathIndex = 0;
+            prune(node);
+        }
+    }
+
+    QList<ProjectBaseItem*> items(uint pathIndex) const
+    {
+        const Node* node = m_indexes.value(pathIndex);
+        return node ? node->items : QList<ProjectBaseItem*>();
+    }
+
+    ProjectBaseItem* item(uint pathIndex) const
+    {
+        const Node* node = m_indexes.value(pathIndex);
+        return node ? node->items.first() : nullptr;
+    }
+
+    QList<ProjectBaseItem*> itemsBelow(const Path& path) const
+    {
+        QList<ProjectBaseItem*> ret;
+        QVector<const Node*> stack;
+        if (const Node* node = m_nodes.value(path)) {
+            stack << node;
+        }
+        while (!stack.isEmpty()) {
+            const Node* node = stack.takeLast();
+            ret += node->items;
+            for (const Node* child : node->children) {
+                stack << child;
+            }
+        }
+        return ret;
+    }
+
+private:
+    struct Node
+    {
+        Path path;
+        // the index of the IndexedString of the path, only set while the node contains items
+        uint pathIndex = 0;
+        Node* parent = nullptr;
+        QList<ProjectBaseItem*> items;
+        QSet<Node*> children;
+    };
+
+    Node* findOrCreate(const Path& path)
+    {
+        Node*& node = m_nodes[path];
+        if (node) {
+            return node;
+        }
+        node = new Node;
+        node->path = path;
+        Node* created = node;
+        const Path parent = path.parent();
+        if (parent.isValid() && parent != path) {
+            // the reference into the hash may be invalidated when the parents are created
+            created->parent = findOrCreate(parent);
+            created->parent->children.insert(created);
+        }
+        return created;
+    }
+
+    /// Drops the given node and its parents, as long as they are empty
+    void prune(Node* node)
+    {
+        while (node && node->items.isEmpty() && node->children.isEmpty()) {
+            Node* parent = node->parent;
+            if (parent) {
+                parent->children.remove(node);
+            }
+            m_nodes.remove(node->path);
+            delete node;
+            node = parent;
+        }
+    }
+
+    QHash<Path, Node*> m_nodes;
+    QHash<uint, Node*> m_indexes;
+};
+
 class ProjectModelPrivate
 {
 public:
@@ -93,8 +208,7 @@ public:
         return model->itemFromIndex( idx );
     }
 
-    // a hash of IndexedString::indexForString(path) <-> ProjectBaseItem for fast lookup
-    QMultiHash<uint, ProjectBaseItem*> pathLookupTable;
+    ProjectPathIndex pathIndex;
 };
 
 class ProjectBaseItemPrivate
@@ -105,6 +219,9 @@ public:
     ProjectBaseItem* parent;
     int row;
     QList<ProjectBaseItem*> children;
+    // items appended between beginAppendRows() and endAppendRows()
+    QList<ProjectBaseItem*> pendingChildren;
+    int appendBatches = 0;
     QString text;
     ProjectBaseItem::ProjectItemType type;
     Qt::ItemFlags flags;
@@ -178,7 +295,7 @@ ProjectBaseItem::~ProjectBaseItem()
     Q_D(ProjectBaseItem);
 
     if (model() && d->m_pathIndex) {
-        model()->d->pathLookupTable.remove(d->m_pathIndex, this);
+        model()->d->pathIndex.remove(this, d->m_path);
     }
 
     if( parent() ) {
@@ -187,6 +304,11 @@ ProjectBaseItem::~ProjectBaseItem()
         model()->takeRow( d->row );
     }
     removeRows(0, d->children.size());
+
+    foreach (ProjectBaseItem* item, d->pendingChildren) {
+        item->d_func()->parent = nullptr;
+        delete item;
+    }
 }
 
 ProjectBaseItem* ProjectBaseItem::child( int row ) const
@@ -207,7 +329,19 @@ QList< ProjectBaseItem* > ProjectBaseItem::children() const
 ProjectBaseItem* ProjectBaseItem::takeRow(int row)
 {
     Q_D(ProjectBaseItem);
-    Q_ASSERT(row >= 0 && row < d->children.size());
+    Q_ASSERT(row >= 0 && row < d->children.size() + d->pendingChildren.size());
+
+    if (row >= d->children.size()) {
+        // the item is not part of the model yet
+        const int pendingRow = row - d->children.size();
+        ProjectBaseItem* olditem = d->pendingChildren.takeAt(pendingRow);
+        olditem->d_func()->parent = nullptr;
+        olditem->d_func()->row = -1;
+        for (int i = pendingRow; i < d->pendingChildren.size(); ++i) {
+            d->pendingChildren.at(i)->d_func()->row--;
+        }
+        return olditem;
+    }
 
     if( model() ) {
         model()->beginRemoveRows(index(), row, row);
@@ -221,6 +355,9 @@ ProjectBaseItem* ProjectBaseItem::takeRow(int row)
         child(i)->d_func()->row--;
         Q_ASSERT(child(i)->d_func()->row==i);
     }
+    foreach (ProjectBaseItem* item, d->pendingChildren) {
+        item->d_func()->row--;
+    }
 
     if( model() ) {
         model()->endRemoveRows();
@@ -257,18 +394,22 @@ void ProjectBaseItem::removeRows(int row, int count)
         }
         d->children.clear();
     } else {
-        for (int i = row; i < count; ++i) {
-            ProjectBaseItem* item = d->children.at(i);
+        for (int i = 0; i < count; ++i) {
+            ProjectBaseItem* item = d->children.takeAt(row);
             item->d_func()->parent = nullptr;
             item->d_func()->row = -1;
             item->setModel( nullptr );
-            delete d->children.takeAt( row );
+            delete item;
         }
         for(int i = row; i < d->children.size(); ++i) {
-            d->children.at(i)->d_func()->row--;
+            d->children.at(i)->d_func()->row -= count;
             Q_ASSERT(child(i)->d_func()->row==i);
         }
     }
+    // the rows of a pending batch follow the children
+    foreach (ProjectBaseItem* item, d->pendingChildren) {
+        item->d_func()->row -= count;
+    }
 
     if( model() ) {
         model()->endRemoveRows();
@@ -333,18 +474,25 @@ void ProjectBaseItem::setModel( ProjectModel* model )
         return;
     }
 
-    if (d->model && d->m_pathIndex) {
-        d->model->d->pathLookupTable.remove(d->m_pathIndex, this);
-    }
-
-    d->model = model;
-
-    if (model && d->m_pathIndex) {
-        model->d->pathLookupTable.insert(d->m_pathIndex, this);
+    // the whole subtree moves, collect it once instead of recursing for every item
+    QVector<ProjectBaseItem*> items{this};
+    for (int i = 0; i < items.size(); ++i) {
+        foreach (ProjectBaseItem* child, items.at(i)->d_func()->children) {
+            if (child->d_func()->model != model) {
+                items << child;
+            }
+        }
     }
 
-    foreach( ProjectBaseItem* item, d->children ) {
-        item->setModel( model );
+    for (ProjectBaseItem* item : items) {
+        ProjectBaseItemPrivate* itemData = item->d_func();
+        if (itemData->model && itemData->m_pathIndex) {
+            itemData->model->d->pathIndex.remove(item, itemData->m_path);
+        }
+        itemData->model = model;
+        if (model && itemData->m_pathIndex) {
+            model->d->pathIndex.insert(item, itemData->m_path, itemData->m_pathIndex);
+        }
     }
 }
 
@@ -418,27 +566,79 @@ IProject* ProjectBaseItem::project() const
 }
 
 void ProjectBaseItem::appendRow( ProjectBaseItem* item )
+{
+    appendRows({item});
+}
+
+void ProjectBaseItem::appendRows( const QList<ProjectBaseItem*>& items )
 {
     Q_D(ProjectBaseItem);
-    if( !item ) {
+    QList<ProjectBaseItem*> newItems;
+    newItems.reserve(items.size());
+    foreach (ProjectBaseItem* item, items) {
+        if( !item ) {
+            continue;
+        }
+        if( item->parent() ) {
+            // Proper way is to first removeRow() on the original parent, then appendRow on this one
+            qCWarning(PROJECT) << "Ignoring double insertion of item" << item;
+            continue;
+        }
+        // this is too slow... O(n) and thankfully not a problem anyways
+    //     Q_ASSERT(!d->children.contains(item));
+        item->d_func()->parent = this;
+        newItems << item;
+    }
+    if (newItems.isEmpty()) {
+        return;
+    }
+
+    if (d->appendBatches) {
+        foreach (ProjectBaseItem* item, newItems) {
+            item->setRow( d->children.count() + d->pendingChildren.count() );
+            d->pendingChildren.append( item );
+        }
         return;
     }
-    if( item->parent() ) {
-        // Proper way is to first removeRow() on the original parent, then appendRow on this one
-        qCWarning(PROJECT) << "Ignoring double insertion of item" << item;
+
+    if( model() ) {
+        const int startrow = d->children.count();
+        model()->beginInsertRows(index(), startrow, startrow + newItems.count() - 1);
+    }
+    foreach (ProjectBaseItem* item, newItems) {
+        d->children.append( item );
+        item->setRow( d->children.count() - 1 );
+        item->setModel( model() );
+    }
+    if( model() ) {
+        model()->endInsertRows();
+    }
+}
+
+void ProjectBaseItem::beginAppendRows()
+{
+    Q_D(ProjectBaseItem);
+    ++d->appendBatches;
+}
+
+void ProjectBaseItem::endAppendRows()
+{
+    Q_D(ProjectBaseItem);
+    Q_ASSERT(d->appendBatches > 0);
+    if (--d->appendBatches || d->pendingChildren.isEmpty()) {
         return;
     }
-    // this is too slow... O(n) and thankfully not a problem anyways
-//     Q_ASSERT(!d->children.contains(item));
-    int startrow,endrow;
+
+    const QList<ProjectBaseItem*> items = d->pendingChildren;
+    d->pendingChildren.clear();
     if( model() ) {
-        startrow = endrow = d->children.count();
-        model()->beginInsertRows(index(), startrow, endrow);
+        const int startrow = d->children.count();
+        model()->beginInsertRows(index(), startrow, startrow + items.count() - 1);
+    }
+    d->children += items;
+    foreach (ProjectBaseItem* item, items) {
+        item->setModel( model() );
     }
-    d->children.append( item );
-    item->setRow( d->children.count() - 1 );
-    item->d_func()->parent = this;
-    item->setModel( model() );
     if( model() ) {
         model()->endInsertRows();
     }
@@ -460,7 +660,7 @@ void ProjectBaseItem::setPath( const Path& path)
     Q_D(ProjectBaseItem);
 
     if (model() && d->m_pathIndex) {
-        model()->d->pathLookupTable.remove(d->m_pathIndex, this);
+        model()->d->pathIndex.remove(this, d->m_path);
     }
 
     d->m_path = path;
@@ -468,7 +668,7 @@ void ProjectBaseItem::setPath( const Path& path)
     setText( path.lastPathSegment() );
 
     if (model() && d->m_pathIndex) {
-        model()->d->pathLookupTable.insert(d->m_pathIndex, this);
+        model()->d->pathIndex.insert(this, d->m_path, d->m_pathIndex);
     }
 }
 
@@ -1086,12 +1286,17 @@ bool ProjectModel::setData(const QModelIndex&, const QVariant&, int)
 
 QList<ProjectBaseItem*> ProjectModel::itemsForPath(const IndexedString& path) const
 {
-    return d->pathLookupTable.values(path.index());
+    return d->pathIndex.items(path.index());
 }
 
 ProjectBaseItem* ProjectModel::itemForPath(const IndexedString& path) const
 {
-    return d->pathLookupTable.value(path.index());
+    return d->pathIndex.item(path.index());
+}
+
+QList<ProjectBaseItem*> ProjectModel::itemsBelowPath(const Path& path) const
+{
+    return d->pathIndex.itemsBelow(path);
 }
 
 void ProjectVisitor::visit( ProjectModel* model )
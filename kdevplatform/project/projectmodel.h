@@ -175,6 +175,21 @@ class KDEVPLATFORMPROJECT_EXPORT ProjectBaseItem
          */
         void appendRow( ProjectBaseItem* item );
 
+        /**
+         * Adds new child items to this item, they are inserted into the model at once.
+         */
+        void appendRows( const QList<ProjectBaseItem*>& items );
+
+        /**
+         * Collects the rows that are appended to this item until endAppendRows() is called,
+         * and inserts them into the model at once.
+         *
+         * Until then, the appended items are not part of the model: they are not counted
+         * by rowCount(), have no index and can't be found by their path.
+         */
+        void beginAppendRows();
+        void endAppendRows();
+
         /**
          * Removes and deletes the item at the given @p row if there is one.
          */
@@ -468,6 +483,11 @@ public:
      */
     ProjectBaseItem* itemForPath(const IndexedString& path) const;
 
+    /**
+     * @return all items for the given path and for the paths below it.
+     */
+    QList<ProjectBaseItem*> itemsBelowPath(const Path& path) const;
+
 private:
     const QScopedPointer<class ProjectModelPrivate> d;
     friend class ProjectBaseItem;
@@ -0,0 +1,227 @@
+/*
+    This file is part of KDevelop
+
+    Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "projectsnapshot.h"
+
+#include "projectmodel.h"
+#include "debug.h"
+
+#include <interfaces/icore.h>
+#include <interfaces/iproject.h>
+#include <interfaces/isession.h>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+using namespace KDevelop;
+
+namespace {
+
+const quint32 snapshotMagic = 0x4b445053;
+// increase when the format changes
+const quint32 snapshotVersion = 2;
+
+/// @returns the developer file of @p project, in which ProjectFilterProvider stores the filters configured in KDevelop
+QString developerFile(IProject* project)
+{
+    Path file = project->projectFile();
+    file.setLastPathSegment(QStringLiteral(".kdev4"));
+    file.addPath(project->projectFile().lastPathSegment());
+    return file.toLocalFile();
+}
+
+/**
+ * The shared project file may come with different filters, e.g. after it got updated by a VCS, and the
+ * developer file may have been changed by another session. Both are part of the configuration stamp.
+ */
+QVector<ProjectSnapshot::Stamp> configurationStamps(IProject* project)
+{
+    return {ProjectSnapshot::Stamp::forPath(project->projectFile().toLocalFile()),
+            ProjectSnapshot::Stamp::forPath(developerFile(project))};
+}
+
+void writeStamp(QDataStream& stream, const ProjectSnapshot::Stamp& stamp)
+{
+    stream << stamp.modificationTime << stamp.inode;
+}
+
+void readStamp(QDataStream& stream, ProjectSnapshot::Stamp* stamp)
+{
+    stream >> stamp->modificationTime >> stamp->inode;
+}
+
+void writeFolder(QDataStream& stream, ProjectFolderItem* folder, const ProjectSnapshot::FolderStamps& stamps,
+                 qint32 parent, qint32* count)
+{
+    const qint32 index = (*count)++;
+    QStringList files;
+    foreach (ProjectFileItem* file, folder->fileList()) {
+        files << file->baseName();
+    }
+    stream << parent << (parent == -1 ? QString() : folder->baseName());
+    writeStamp(stream, stamps.value(folder->path()));
+    stream << files;
+    foreach (ProjectFolderItem* child, folder->folderList()) {
+        writeFolder(stream, child, stamps, index, count);
+    }
+}
+
+}
+
+ProjectSnapshot::Stamp ProjectSnapshot::Stamp::forPath(const QString& path)
+{
+    Stamp stamp;
+#ifdef Q_OS_UNIX
+    struct stat info;
+    if (::stat(QFile::encodeName(path).constData(), &info) == 0) {
+#ifdef Q_OS_LINUX
+        stamp.modificationTime = qint64(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#else
+        stamp.modificationTime = qint64(info.st_mtime) * 1000000000;
+#endif
+        stamp.inode = info.st_ino;
+    }
+#else
+    Q_UNUSED(path);
+#endif
+    return stamp;
+}
+
+bool ProjectSnapshot::isEnabled()
+{
+#ifdef Q_OS_UNIX
+    static const bool enabled = qEnvironmentVariableIsEmpty("KDEV_PROJECT_SNAPSHOT")
+                             || qEnvironmentVariableIntValue("KDEV_PROJECT_SNAPSHOT");
+    return enabled;
+#else
+    return false;
+#endif
+}
+
+QString ProjectSnapshot::fileName(IProject* project, const IPlugin* plugin)
+{
+    ISession* session = ICore::self()->activeSession();
+    if (!session || !project->path().isLocalFile()) {
+        return {};
+    }
+    const QString dataArea = session->pluginDataArea(plugin).toLocalFile();
+    if (dataArea.isEmpty()) {
+        return {};
+    }
+    const QByteArray hash = QCryptographicHash::hash(project->path().toLocalFile().toUtf8(), QCryptographicHash::Md5).toHex();
+    return dataArea + QLatin1String("/snapshots/") + QString::fromLatin1(hash);
+}
+
+bool ProjectSnapshot::write(const QString& fileName, ProjectFolderItem* root, const FolderStamps& stamps,
+                            const IgnoreFileStamps& ignoreFiles)
+{
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(FILEMANAGER) << "failed to write project snapshot" << fileName << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_5);
+    stream << snapshotMagic << snapshotVersion << root->path().toLocalFile();
+    for (const Stamp& stamp : configurationStamps(root->project())) {
+        writeStamp(stream, stamp);
+    }
+    stream << qint32(ignoreFiles.size());
+    for (auto it = ignoreFiles.constBegin(); it != ignoreFiles.constEnd(); ++it) {
+        stream << it.key().toLocalFile();
+        writeStamp(stream, it.value());
+    }
+
+    qint32 count = 0;
+    writeFolder(stream, root, stamps, -1, &count);
+    return stream.status() == QDataStream::Ok && file.commit();
+}
+
+bool ProjectSnapshot::read(const QString& fileName, IProject* project)
+{
+    m_folders.clear();
+    m_ignoreFiles.clear();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_5);
+    quint32 magic;
+    quint32 version;
+    QString root;
+    stream >> magic >> version;
+    if (magic != snapshotMagic || version != snapshotVersion) {
+        return false;
+    }
+    stream >> root;
+    bool outdated = root != project->path().toLocalFile();
+    for (const Stamp& current : configurationStamps(project)) {
+        Stamp config;
+        readStamp(stream, &config);
+        outdated |= config != current;
+    }
+    // a folder shows up again once its .kdev_ignore file is removed
+    qint32 ignoreFileCount = 0;
+    stream >> ignoreFileCount;
+    for (qint32 i = 0; i < ignoreFileCount && !outdated && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Stamp stamp;
+        stream >> path;
+        readStamp(stream, &stamp);
+        outdated = stamp != Stamp::forPath(path);
+        m_ignoreFiles.insert(Path(path), stamp);
+    }
+    if (outdated) {
+        qCDebug(FILEMANAGER) << "project snapshot is outdated" << fileName;
+        m_ignoreFiles.clear();
+        return false;
+    }
+
+    while (!stream.atEnd()) {
+        Folder folder;
+        qint32 parent;
+        stream >> parent >> folder.name;
+        readStamp(stream, &folder.stamp);
+        stream >> folder.files;
+        if (stream.status() != QDataStream::Ok || parent >= m_folders.size() || (parent < 0) != m_folders.isEmpty()) {
+            qCWarning(FILEMANAGER) << "invalid project snapshot" << fileName;
+            m_folders.clear();
+            m_ignoreFiles.clear();
+            return false;
+        }
+        folder.parent = parent;
+        m_folders << folder;
+    }
+    return !m_folders.isEmpty();
+}
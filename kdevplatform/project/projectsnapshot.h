@@ -0,0 +1,139 @@
+/*
+    This file is part of KDevelop
+
+    Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KDEVPLATFORM_PROJECTSNAPSHOT_H
+#define KDEVPLATFORM_PROJECTSNAPSHOT_H
+
+#include "projectexport.h"
+
+#include <util/path.h>
+
+#include <QHash>
+#include <QMetaType>
+#include <QPair>
+#include <QStringList>
+#include <QVector>
+
+namespace KDevelop {
+
+class IPlugin;
+class IProject;
+class ProjectFolderItem;
+
+/**
+ * @short The files and folders of a project, as they were when the project was closed.
+ *
+ * The snapshot is stored in the session, and allows to show the project right away when it is
+ * opened again. Every folder is stored with the modification time and inode it had, so the
+ * folders that changed in the meantime can be found without listing all of them.
+ *
+ * A snapshot is discarded when the project file or the developer file, which may contain filters,
+ * changed, or when one of the .kdev_ignore files that hid folders was changed or removed.
+ */
+class KDEVPLATFORMPROJECT_EXPORT ProjectSnapshot
+{
+public:
+    /// Identifies the state of a folder, its modification time changes when entries are added or removed.
+    struct Stamp
+    {
+        qint64 modificationTime = 0;
+        quint64 inode = 0;
+
+        /// @returns the current stamp of the given local path, or an empty stamp if it doesn't exist
+        static Stamp forPath(const QString& path);
+
+        /// @returns whether the stamp is unknown, such a folder is always considered changed
+        bool isEmpty() const
+        {
+            return modificationTime == 0 && inode == 0;
+        }
+
+        bool operator==(const Stamp& other) const
+        {
+            return modificationTime == other.modificationTime && inode == other.inode;
+        }
+        bool operator!=(const Stamp& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    struct Folder
+    {
+        /// The index of the parent folder, folders are stored after their parent. The root has no parent.
+        int parent = -1;
+        QString name;
+        Stamp stamp;
+        QStringList files;
+    };
+
+    using Stamps = QVector<QPair<Path, Stamp>>;
+    /// The stamps the folders had when they were listed
+    using FolderStamps = QHash<Path, Stamp>;
+    /// The stamps of the .kdev_ignore files that hid folders when their parents were listed
+    using IgnoreFileStamps = QHash<Path, Stamp>;
+
+    /**
+     * @returns whether projects should be opened from snapshots, which is the default for local projects on Unix.
+     * It can be disabled by setting KDEV_PROJECT_SNAPSHOT=0.
+     */
+    static bool isEnabled();
+
+    /// @returns the location of the snapshot of @p project in the session data of @p plugin, or an empty string
+    static QString fileName(IProject* project, const IPlugin* plugin);
+
+    /**
+     * Stores the files and folders below @p root.
+     *
+     * Every folder is stored with its stamp in @p stamps, which must have been taken before it was listed,
+     * so changes that were not applied to the items are found when the snapshot is read. Folders without
+     * a stamp are listed again.
+     *
+     * The snapshot is outdated once one of the @p ignoreFiles doesn't match its stamp anymore.
+     */
+    static bool write(const QString& fileName, ProjectFolderItem* root, const FolderStamps& stamps,
+                      const IgnoreFileStamps& ignoreFiles = {});
+
+    /// Reads the snapshot of @p project, fails if it is outdated.
+    bool read(const QString& fileName, IProject* project);
+
+    /// The stored folders, starting with the root of the project
+    QVector<Folder> folders() const
+    {
+        return m_folders;
+    }
+
+    /// The stored .kdev_ignore files, which still match their stamps
+    IgnoreFileStamps ignoreFiles() const
+    {
+        return m_ignoreFiles;
+    }
+
+private:
+    QVector<Folder> m_folders;
+    IgnoreFileStamps m_ignoreFiles;
+};
+
+}
+
+Q_DECLARE_METATYPE(KDevelop::ProjectSnapshot::Stamp)
+
+#endif // KDEVPLATFORM_PROJECTSNAPSHOT_H
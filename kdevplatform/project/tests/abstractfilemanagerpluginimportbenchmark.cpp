@@ -22,6 +22,7 @@
 #include <interfaces/iplugincontroller.h>
 
 #include <project/abstractfilemanagerplugin.h>
+#include <project/localdirectoryscanner.h>
 #include <project/projectmodel.h>
 
 #include <shell/projectcontroller.h>
@@ -37,6 +38,8 @@
 #include <KDirWatch>
 
 #include <QApplication>
+#include <QDir>
+#include <QEventLoop>
 #include <QList>
 #include <QFileInfo>
 #include <QElapsedTimer>
@@ -124,14 +127,81 @@ private Q_SLOTS:
 int AbstractFileManagerPluginImportBenchmark::s_numBenchmarksRunning = 0;
 }
 
+namespace {
+
+// lists the directory tree one folder at a time, the way FileManagerListJob does without the scanner
+int listWithQDir(const QString& path)
+{
+    int count = 0;
+    QVector<QString> queue{path};
+    while (!queue.isEmpty()) {
+        const QDir dir(queue.takeLast());
+        const auto entries = dir.entryInfoList(QDir::NoDotAndDotDot | QDir::AllEntries | QDir::Hidden);
+        for (const QFileInfo& info : entries) {
+            ++count;
+            if (info.isDir() && !info.isSymLink()) {
+                queue << info.filePath();
+            }
+        }
+    }
+    return count;
+}
+
+int listWithScanner(const QString& path)
+{
+    int count = 0;
+    LocalDirectoryScanner scanner(Path(path), {}, Path(path));
+    QEventLoop loop;
+    QObject::connect(&scanner, &LocalDirectoryScanner::directoriesScanned,
+                     [&count] (const QVector<LocalDirectoryScanner::Directory>& directories) {
+                        for (const auto& directory : directories) {
+                            count += directory.files.size() + directory.folders.size();
+                        }
+                     });
+    QObject::connect(&scanner, &LocalDirectoryScanner::finished, &loop, &QEventLoop::quit);
+    scanner.start();
+    loop.exec();
+    return count;
+}
+
+// compares the listing of the directory trees without importing them into a project
+int scanOnly(const QStringList& paths, QTextStream& qout)
+{
+    for (const QString& path : paths) {
+        QElapsedTimer timer;
+        timer.start();
+        const int qdirCount = listWithQDir(path);
+        const qint64 qdirElapsed = timer.restart();
+        const int scannerCount = listWithScanner(path);
+        const qint64 scannerElapsed = timer.elapsed();
+        qout << path << ":" << endl
+            << "	QDir listed " << qdirCount << " entries in " << qdirElapsed / 1000.0 << " seconds" << endl
+            << "	LocalDirectoryScanner listed " << scannerCount << " entries in " << scannerElapsed / 1000.0 << " seconds" << endl;
+    }
+    return 0;
+}
+
+}
+
 int main(int argc, char** argv)
 {
     if (argc < 2) {
-        qWarning() << "Usage:" << argv[0] << "projectDir1 [...projectDirN]";
+        qWarning() << "Usage:" << argv[0] << "[--scan-only] projectDir1 [...projectDirN]";
+        qWarning() << "Set KDEV_NATIVE_SCANNER=0 to import the projects without the LocalDirectoryScanner.";
         return 1;
     }
     QApplication app(argc, argv);
     QTextStream qout(stdout);
+
+    if (qstrcmp(argv[1], "--scan-only") == 0) {
+        QStringList paths;
+        for (int i = 2; i < argc; ++i) {
+            paths << QString::fromUtf8(argv[i]);
+        }
+        return scanOnly(paths, qout);
+    }
+
+    qout << "LocalDirectoryScanner: " << (LocalDirectoryScanner::isEnabled() ? "enabled" : "disabled") << endl;
     // measure the total test time, this provides an indication
     // of overhead and how well multiple projects are imported in parallel
     // (= how different is the total time from the import time of the largest
@@ -497,6 +497,82 @@ void TestProjectModel::testItemsForPath_data()
     }
 }
 
+void TestProjectModel::testItemsBelowPath()
+{
+    ProjectFolderItem* root = new ProjectFolderItem(nullptr, Path(QUrl::fromLocalFile(QDir::tempPath())));
+    ProjectFolderItem* folder = new ProjectFolderItem(QStringLiteral("a"), root);
+    ProjectFolderItem* subFolder = new ProjectFolderItem(QStringLiteral("b"), folder);
+    ProjectFileItem* file = new ProjectFileItem(QStringLiteral("foo"), subFolder);
+    ProjectFileItem* otherFile = new ProjectFileItem(QStringLiteral("ab"), root);
+    model->appendRow(root);
+
+    auto items = model->itemsBelowPath(folder->path());
+    QCOMPARE(items.size(), 3);
+    QVERIFY(items.contains(folder));
+    QVERIFY(items.contains(subFolder));
+    QVERIFY(items.contains(file));
+    QVERIFY(!items.contains(otherFile));
+
+    QCOMPARE(model->itemsBelowPath(root->path()).size(), 5);
+    QVERIFY(model->itemsBelowPath(Path(folder->path(), QStringLiteral("missing"))).isEmpty());
+
+    // removed items are dropped from the index
+    folder->removeRow(subFolder->row());
+    QCOMPARE(model->itemsBelowPath(folder->path()), QList<ProjectBaseItem*>{folder});
+    QVERIFY(model->itemsForPath(IndexedString(Path(folder->path(), QStringLiteral("b/foo")).pathOrUrl())).isEmpty());
+
+    model->clear();
+    QVERIFY(model->itemsBelowPath(root->path()).isEmpty());
+}
+
+void TestProjectModel::testAppendRows()
+{
+    ProjectFolderItem* root = new ProjectFolderItem(nullptr, Path(QUrl::fromLocalFile(QDir::tempPath())));
+    model->appendRow(root);
+
+    QSignalSpy spy(model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    root->beginAppendRows();
+    ProjectFileItem* file = new ProjectFileItem(QStringLiteral("a"), root);
+    ProjectFolderItem* folder = new ProjectFolderItem(QStringLiteral("b"), root);
+    ProjectFileItem* removed = new ProjectFileItem(QStringLiteral("c"), root);
+    ProjectFileItem* last = new ProjectFileItem(QStringLiteral("d"), root);
+    delete removed;
+
+    // the items are not part of the model yet
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(root->rowCount(), 0);
+    QVERIFY(model->itemsForPath(IndexedString(file->path().pathOrUrl())).isEmpty());
+
+    root->endAppendRows();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(1).toInt(), 0);
+    QCOMPARE(spy.first().at(2).toInt(), 2);
+    QCOMPARE(root->children(), (QList<ProjectBaseItem*>{file, folder, last}));
+    QCOMPARE(last->row(), 2);
+    QCOMPARE(model->itemForPath(IndexedString(folder->path().pathOrUrl())), folder);
+
+    spy.clear();
+    root->appendRows({new ProjectFileItem(nullptr, Path(root->path(), QStringLiteral("e"))),
+                      new ProjectFileItem(nullptr, Path(root->path(), QStringLiteral("f")))});
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(root->rowCount(), 5);
+
+    // removing rows renumbers the rows that are still pending
+    root->beginAppendRows();
+    ProjectFileItem* pending = new ProjectFileItem(QStringLiteral("g"), root);
+    QCOMPARE(pending->row(), 5);
+    root->removeRows(0, 2);
+    QCOMPARE(last->row(), 0);
+    QCOMPARE(pending->row(), 3);
+    root->removeRow(last->row());
+    QCOMPARE(pending->row(), 2);
+    root->endAppendRows();
+    QCOMPARE(root->child(2), pending);
+    QCOMPARE(pending->row(), 2);
+
+    model->clear();
+}
+
 void TestProjectModel::testProjectProxyModel()
 {
     ProjectFolderItem* root = new ProjectFolderItem(nullptr, Path(QUrl::fromLocalFile(QDir::tempPath())));
@@ -51,6 +51,8 @@ private Q_SLOTS:
     void testTakeRow();
     void testItemsForPath();
     void testItemsForPath_data();
+    void testItemsBelowPath();
+    void testAppendRows();
     void testProjectProxyModel();
     void testProjectFileSet();
     void testProjectFileIcon();
@@ -0,0 +1,166 @@
+/*
+    This file is part of KDevelop
+
+    Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "test_projectsnapshot.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <project/projectmodel.h>
+#include <project/projectsnapshot.h>
+#include <tests/autotestshell.h>
+#include <tests/testcore.h>
+#include <tests/testproject.h>
+
+using namespace KDevelop;
+
+QTEST_MAIN(TestProjectSnapshot)
+
+namespace {
+
+void touch(const QString& path)
+{
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+}
+
+/// Creates a project with the files a.txt, src/b.cpp, and the empty folder src/sub
+TestProject* createProject(const QTemporaryDir& dir)
+{
+    QDir(dir.path()).mkpath(QStringLiteral("src/sub"));
+    touch(dir.path() + QLatin1String("/a.txt"));
+    touch(dir.path() + QLatin1String("/src/b.cpp"));
+
+    auto project = new TestProject(Path(dir.path()));
+    touch(project->projectFile().toLocalFile());
+
+    ProjectFolderItem* root = project->projectItem();
+    new ProjectFileItem(project, Path(root->path(), QStringLiteral("a.txt")), root);
+    auto src = new ProjectFolderItem(project, Path(root->path(), QStringLiteral("src")), root);
+    new ProjectFileItem(project, Path(src->path(), QStringLiteral("b.cpp")), src);
+    new ProjectFolderItem(project, Path(src->path(), QStringLiteral("sub")), src);
+    return project;
+}
+
+}
+
+void TestProjectSnapshot::initTestCase()
+{
+    AutoTestShell::init();
+    TestCore::initialize(Core::NoUi);
+}
+
+void TestProjectSnapshot::cleanupTestCase()
+{
+    TestCore::shutdown();
+}
+
+void TestProjectSnapshot::testRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QScopedPointer<TestProject> project(createProject(dir));
+    const QString fileName = dir.path() + QLatin1String("/snapshot");
+
+    ProjectSnapshot::FolderStamps stamps;
+    for (const QString& folder : {QString(), QStringLiteral("/src"), QStringLiteral("/src/sub")}) {
+        stamps.insert(Path(dir.path() + folder), ProjectSnapshot::Stamp::forPath(dir.path() + folder));
+    }
+    QVERIFY(ProjectSnapshot::write(fileName, project->projectItem(), stamps));
+
+    ProjectSnapshot snapshot;
+    QVERIFY(snapshot.read(fileName, project.data()));
+    const auto folders = snapshot.folders();
+    QCOMPARE(folders.size(), 3);
+
+    QCOMPARE(folders.at(0).parent, -1);
+    QCOMPARE(folders.at(0).files, QStringList{QStringLiteral("a.txt")});
+    QCOMPARE(folders.at(0).stamp, ProjectSnapshot::Stamp::forPath(dir.path()));
+
+    QCOMPARE(folders.at(1).parent, 0);
+    QCOMPARE(folders.at(1).name, QStringLiteral("src"));
+    QCOMPARE(folders.at(1).files, QStringList{QStringLiteral("b.cpp")});
+    QCOMPARE(folders.at(1).stamp, ProjectSnapshot::Stamp::forPath(dir.path() + QLatin1String("/src")));
+
+    QCOMPARE(folders.at(2).parent, 1);
+    QCOMPARE(folders.at(2).name, QStringLiteral("sub"));
+    QVERIFY(folders.at(2).files.isEmpty());
+    QCOMPARE(folders.at(2).stamp, ProjectSnapshot::Stamp::forPath(dir.path() + QLatin1String("/src/sub")));
+
+    // a removed folder doesn't match its stamp anymore
+    QVERIFY(QDir(dir.path()).rmdir(QStringLiteral("src/sub")));
+    QVERIFY(ProjectSnapshot::Stamp::forPath(dir.path() + QLatin1String("/src/sub")) != folders.at(2).stamp);
+
+    // a folder that was not listed is stored without a stamp
+    stamps.remove(Path(dir.path() + QLatin1String("/src")));
+    QVERIFY(ProjectSnapshot::write(fileName, project->projectItem(), stamps));
+    QVERIFY(snapshot.read(fileName, project.data()));
+    QVERIFY(snapshot.folders().at(1).stamp.isEmpty());
+}
+
+void TestProjectSnapshot::testOutdated()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QScopedPointer<TestProject> project(createProject(dir));
+    const QString fileName = dir.path() + QLatin1String("/snapshot");
+
+    QVERIFY(ProjectSnapshot::write(fileName, project->projectItem(), {}));
+
+    // the project file may contain other filters now
+    QVERIFY(QFile::remove(project->projectFile().toLocalFile()));
+    ProjectSnapshot snapshot;
+    QVERIFY(!snapshot.read(fileName, project.data()));
+    QVERIFY(snapshot.folders().isEmpty());
+
+    // neither may the developer file
+    touch(project->projectFile().toLocalFile());
+    QVERIFY(ProjectSnapshot::write(fileName, project->projectItem(), {}));
+    QVERIFY(snapshot.read(fileName, project.data()));
+    Path developerFile = project->projectFile();
+    developerFile.setLastPathSegment(QStringLiteral(".kdev4"));
+    QVERIFY(QDir().mkpath(developerFile.toLocalFile()));
+    developerFile.addPath(project->projectFile().lastPathSegment());
+    touch(developerFile.toLocalFile());
+    QVERIFY(!snapshot.read(fileName, project.data()));
+
+    // a folder that was hidden by a .kdev_ignore file shows up once it is removed
+    QVERIFY(QDir(dir.path()).mkpath(QStringLiteral("ignored")));
+    const QString ignoreFile = dir.path() + QLatin1String("/ignored/.kdev_ignore");
+    touch(ignoreFile);
+    ProjectSnapshot::IgnoreFileStamps ignoreFiles;
+    ignoreFiles.insert(Path(ignoreFile), ProjectSnapshot::Stamp::forPath(ignoreFile));
+    QVERIFY(ProjectSnapshot::write(fileName, project->projectItem(), {}, ignoreFiles));
+    QVERIFY(snapshot.read(fileName, project.data()));
+    QCOMPARE(snapshot.ignoreFiles(), ignoreFiles);
+    QVERIFY(QFile::remove(ignoreFile));
+    QVERIFY(!snapshot.read(fileName, project.data()));
+
+    // a broken snapshot is not used either
+    QVERIFY(ProjectSnapshot::write(fileName, project->projectItem(), {}));
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() - 2));
+    file.close();
+    QVERIFY(!snapshot.read(fileName, project.data()));
+}
@@ -0,0 +1,153 @@
+/*
+    This file is part of KDevelop
+
+    Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "test_trigramindex.h"
+
+#include <QTest>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <project/trigramindex.h>
+
+using namespace KDevelop;
+
+QTEST_GUILESS_MAIN(TestTrigramIndex)
+
+namespace {
+
+QString writeFile(const QTemporaryDir& dir, const QString& name, const QByteArray& contents)
+{
+    const QString path = dir.path() + QLatin1Char('/') + name;
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    file.write(contents);
+    return path;
+}
+
+QList<QUrl> urls(const QStringList& paths)
+{
+    QList<QUrl> ret;
+    foreach (const QString& path, paths) {
+        ret << QUrl::fromLocalFile(path);
+    }
+    return ret;
+}
+
+}
+
+void TestTrigramIndex::testCandidates()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString hello = writeFile(dir, QStringLiteral("hello.cpp"), "int Hello(World);");
+    const QString goodbye = writeFile(dir, QStringLiteral("goodbye.cpp"), "int goodbye;");
+    const QString binary = writeFile(dir, QStringLiteral("binary.o"), QByteArray("nothing", 8));
+    const QList<QUrl> files = urls({hello, goodbye, binary});
+
+    TrigramIndex index(dir.path(), dir.path() + QLatin1String("/trigrams.index"));
+    // not used before it knows the files
+    QCOMPARE(TrigramIndex::candidates(files, {QStringLiteral("hello")}), files);
+
+    index.setFiles({hello, goodbye, binary});
+    index.waitForIdle();
+    QCOMPARE(index.indexedFileCount(), 3);
+
+    // binary files are always candidates
+    QCOMPARE(TrigramIndex::candidates(files, {QStringLiteral("hello")}), urls({hello, binary}));
+    QCOMPARE(TrigramIndex::candidates(files, {QStringLiteral("WORLD"), QStringLiteral("int")}), urls({hello, binary}));
+    QCOMPARE(TrigramIndex::candidates(files, {QStringLiteral("int")}), files);
+    QCOMPARE(TrigramIndex::candidates(files, {QStringLiteral("missing")}), urls({binary}));
+    // too short, or not ASCII
+    QCOMPARE(TrigramIndex::candidates(files, {QStringLiteral("in")}), files);
+    QCOMPARE(TrigramIndex::candidates(files, {QStringLiteral("äöü")}), files);
+
+    // files that are not indexed are always candidates
+    QTemporaryDir otherDir;
+    const QString other = writeFile(otherDir, QStringLiteral("other.cpp"), "int other;");
+    QCOMPARE(TrigramIndex::candidates(urls({hello, other}), {QStringLiteral("missing")}), urls({other}));
+}
+
+void TestTrigramIndex::testUpdate()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString first = writeFile(dir, QStringLiteral("first.cpp"), "int foo;");
+    const QString second = writeFile(dir, QStringLiteral("second.cpp"), "int bar;");
+    const QList<QUrl> files = urls({first, second});
+
+    TrigramIndex index(dir.path(), dir.path() + QLatin1String("/trigrams.index"));
+    index.setFiles({first, second});
+    index.waitForIdle();
+    QCOMPARE(TrigramIndex::candidates(files, {QStringLiteral("foo")}), urls({first}));
+
+    // changed files are candidates even before the index is updated
+    writeFile(dir, QStringLiteral("second.cpp"), "int foobar;");
+    QCOMPARE(TrigramIndex::candidates(files, {QStringLiteral("foo")}), files);
+    index.update(second);
+    index.waitForIdle();
+    QCOMPARE(TrigramIndex::candidates(files, {QStringLiteral("foo")}), files);
+    QCOMPARE(TrigramIndex::candidates(files, {QStringLiteral("bar")}), urls({second}));
+
+    QFile::remove(first);
+    index.update(first);
+    index.waitForIdle();
+    QCOMPARE(index.indexedFileCount(), 1);
+
+    // only exact paths are dropped from a list
+    index.remove(QStringList{dir.path()});
+    QCOMPARE(index.indexedFileCount(), 1);
+
+    // only the files below the directory are dropped, not the ones sharing its prefix
+    index.remove(dir.path().left(dir.path().size() - 1));
+    QCOMPARE(index.indexedFileCount(), 1);
+
+    index.remove(dir.path());
+    QCOMPARE(index.indexedFileCount(), 0);
+}
+
+void TestTrigramIndex::testPersistence()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString indexFile = dir.path() + QLatin1String("/trigrams.index");
+    const QString first = writeFile(dir, QStringLiteral("first.cpp"), "int foo;");
+    const QString second = writeFile(dir, QStringLiteral("second.cpp"), "int bar;");
+    const QList<QUrl> files = urls({first, second});
+
+    {
+        TrigramIndex index(dir.path(), indexFile);
+        index.setFiles({first});
+        index.waitForIdle();
+        index.flush();
+        QVERIFY(QFile::exists(indexFile));
+
+        // kept in memory until the index is destroyed
+        index.update(second);
+        index.waitForIdle();
+    }
+
+    TrigramIndex index(dir.path(), indexFile);
+    QCOMPARE(index.indexedFileCount(), 2);
+    index.setFiles({first, second});
+    index.waitForIdle();
+    QCOMPARE(TrigramIndex::candidates(files, {QStringLiteral("foo")}), urls({first}));
+    QCOMPARE(TrigramIndex::candidates(files, {QStringLiteral("bar")}), urls({second}));
+}
@@ -0,0 +1,632 @@
+/*
+    This file is part of KDevelop
+
+    Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "trigramindex.h"
+
+#include "debug.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QtConcurrentRun>
+
+#include <serialization/itemrepositoryregistry.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace KDevelop;
+
+// The index file consists of the header, the files, the postings, the trigrams and the paths of the files
+struct TrigramIndex::FileHeader
+{
+    uint magic;
+    uint version;
+    uint fileCount;
+    uint trigramCount;
+    quint64 postingCount;
+    quint64 stringsSize;
+};
+
+struct TrigramIndex::FileEntry
+{
+    qint64 modificationTime;
+    qint64 size;
+    uint pathOffset;
+    uint pathLength;
+    uint flags;
+    uint padding;
+};
+
+struct TrigramIndex::TrigramEntry
+{
+    uint trigram;
+    ///Count of the files containing the trigram
+    uint count;
+    ///Position of the first of those files in the postings
+    uint first;
+};
+
+namespace {
+
+const uint indexMagic = 0x4b545249;
+const uint indexVersion = 1;
+
+// Larger files are not indexed, they are always searched
+const qint64 maxIndexedFileSize = 4 * 1024 * 1024;
+
+// The index is written to disk when this many files changed since it was last written
+const int saveThreshold = 1000;
+
+enum FileFlags {
+    IndexedFile = 1
+};
+
+QMutex registryMutex;
+
+QVector<TrigramIndex*>& registry()
+{
+    static QVector<TrigramIndex*> indexes;
+    return indexes;
+}
+
+inline uint lower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? uchar(c | 0x20) : uchar(c);
+}
+
+void appendTrigrams(const char* data, qint64 size, QVector<uint>& trigrams)
+{
+    if (size < 3) {
+        return;
+    }
+    uint trigram = (lower(data[0]) << 8) | lower(data[1]);
+    for (qint64 i = 2; i < size; ++i) {
+        trigram = ((trigram << 8) | lower(data[i])) & 0xffffff;
+        trigrams.append(trigram);
+    }
+}
+
+void sortUnique(QVector<uint>& trigrams)
+{
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+/// @returns the trigrams that every file containing all the given literals contains
+QVector<uint> literalTrigrams(const QStringList& literals)
+{
+    QVector<uint> trigrams;
+    for (const QString& literal : literals) {
+        QByteArray run;
+        for (int i = 0; i <= literal.size(); ++i) {
+            if (i < literal.size() && literal[i].unicode() < 0x80) {
+                run.append(char(literal[i].unicode()));
+            } else {
+                appendTrigrams(run.constData(), run.size(), trigrams);
+                run.clear();
+            }
+        }
+    }
+    sortUnique(trigrams);
+    return trigrams;
+}
+
+}
+
+TrigramIndex::TrigramIndex(const QString& rootDirectory, const QString& indexFile)
+    : m_root(rootDirectory)
+    , m_indexFile(indexFile)
+    , m_file(indexFile)
+{
+    m_pool.setMaxThreadCount(1);
+    load();
+
+    QMutexLocker lock(&registryMutex);
+    registry().append(this);
+}
+
+TrigramIndex::~TrigramIndex()
+{
+    {
+        QMutexLocker lock(&registryMutex);
+        registry().removeOne(this);
+    }
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stopping = true;
+    }
+    m_pool.waitForDone();
+
+    QMutexLocker lock(&m_mutex);
+    if (m_changes) {
+        save();
+    }
+}
+
+bool TrigramIndex::isEnabled()
+{
+    static const bool enabled = qEnvironmentVariableIntValue("KDEV_TRIGRAM_INDEX");
+    return enabled;
+}
+
+QString TrigramIndex::defaultIndexFile(const QString& rootDirectory)
+{
+    const QByteArray hash = QCryptographicHash::hash(rootDirectory.toUtf8(), QCryptographicHash::Md5).toHex();
+    return globalItemRepositoryRegistry().path() + QLatin1String("/trigrams/") + QString::fromLatin1(hash) + QLatin1String(".index");
+}
+
+const TrigramIndex::FileHeader* TrigramIndex::header() const
+{
+    return reinterpret_cast<const FileHeader*>(m_data);
+}
+
+const TrigramIndex::FileEntry* TrigramIndex::baseFiles() const
+{
+    return reinterpret_cast<const FileEntry*>(m_data + sizeof(FileHeader));
+}
+
+const uint* TrigramIndex::basePostings() const
+{
+    return reinterpret_cast<const uint*>(baseFiles() + header()->fileCount);
+}
+
+const TrigramIndex::TrigramEntry* TrigramIndex::baseTrigrams() const
+{
+    return reinterpret_cast<const TrigramEntry*>(basePostings() + header()->postingCount);
+}
+
+QString TrigramIndex::basePath(int id) const
+{
+    const char* strings = reinterpret_cast<const char*>(baseTrigrams() + header()->trigramCount);
+    const FileEntry& file = baseFiles()[id];
+    return QString::fromUtf8(strings + file.pathOffset, file.pathLength);
+}
+
+void TrigramIndex::load()
+{
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    m_dataSize = m_file.size();
+    if (m_dataSize >= qint64(sizeof(FileHeader))) {
+        m_data = m_file.map(0, m_dataSize);
+    }
+
+    bool valid = m_data && header()->magic == indexMagic && header()->version == indexVersion;
+    if (valid) {
+        const quint64 expectedSize = sizeof(FileHeader) + quint64(header()->fileCount) * sizeof(FileEntry)
+            + header()->postingCount * sizeof(uint) + quint64(header()->trigramCount) * sizeof(TrigramEntry)
+            + header()->stringsSize;
+        valid = expectedSize == quint64(m_dataSize);
+    }
+    for (uint id = 0; valid && id < header()->fileCount; ++id) {
+        const FileEntry& file = baseFiles()[id];
+        valid = quint64(file.pathOffset) + file.pathLength <= header()->stringsSize;
+    }
+    for (uint i = 0; valid && i < header()->trigramCount; ++i) {
+        const TrigramEntry& trigram = baseTrigrams()[i];
+        valid = quint64(trigram.first) + trigram.count <= header()->postingCount;
+    }
+
+    if (!valid) {
+        qCWarning(PROJECT) << "discarding invalid trigram index" << m_indexFile;
+        if (m_data) {
+            m_file.unmap(const_cast<uchar*>(m_data));
+            m_data = nullptr;
+        }
+        m_file.close();
+        m_dataSize = 0;
+        return;
+    }
+
+    m_baseCount = header()->fileCount;
+    for (int id = 0; id < m_baseCount; ++id) {
+        m_ids.insert(basePath(id), id);
+    }
+}
+
+void TrigramIndex::save()
+{
+    QDir().mkpath(QFileInfo(m_indexFile).path());
+    QSaveFile out(m_indexFile);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qCWarning(PROJECT) << "failed to write trigram index" << m_indexFile << out.errorString();
+        return;
+    }
+
+    // The files keep their order, so the postings stay sorted when they are renumbered
+    QVector<QPair<int, QString>> files;
+    files.reserve(m_ids.size());
+    for (auto it = m_ids.constBegin(); it != m_ids.constEnd(); ++it) {
+        files.append({it.value(), it.key()});
+    }
+    std::sort(files.begin(), files.end());
+    QVector<int> newIds(m_baseCount + m_delta.size(), -1);
+    for (int i = 0; i < files.size(); ++i) {
+        newIds[files[i].first] = i;
+    }
+
+    FileHeader fileHeader = {indexMagic, indexVersion, uint(files.size()), 0, 0, 0};
+    out.write(reinterpret_cast<const char*>(&fileHeader), sizeof(FileHeader));
+
+    QByteArray strings;
+    for (const QPair<int, QString>& file : files) {
+        const QByteArray path = file.second.toUtf8();
+        FileEntry entry;
+        if (file.first < m_baseCount) {
+            entry = baseFiles()[file.first];
+        } else {
+            const DeltaEntry& delta = m_delta[file.first - m_baseCount];
+            entry.modificationTime = delta.modificationTime;
+            entry.size = delta.size;
+            entry.flags = delta.indexed ? IndexedFile : 0;
+        }
+        entry.pathOffset = strings.size();
+        entry.pathLength = path.size();
+        entry.padding = 0;
+        strings += path;
+        out.write(reinterpret_cast<const char*>(&entry), sizeof(FileEntry));
+    }
+
+    // Merges the trigrams of the mapped index with the ones of the changed files
+    QVector<uint> deltaTrigrams = m_deltaPostings.keys().toVector();
+    std::sort(deltaTrigrams.begin(), deltaTrigrams.end());
+    const TrigramEntry* base = m_data ? baseTrigrams() : nullptr;
+    const TrigramEntry* baseEnd = m_data ? base + header()->trigramCount : nullptr;
+    auto delta = deltaTrigrams.constBegin();
+
+    QVector<TrigramEntry> trigrams;
+    QVector<uint> ids;
+    while (base != baseEnd || delta != deltaTrigrams.constEnd()) {
+        uint trigram;
+        if (base != baseEnd && (delta == deltaTrigrams.constEnd() || base->trigram <= *delta)) {
+            trigram = base->trigram;
+        } else {
+            trigram = *delta;
+        }
+
+        ids.clear();
+        if (base != baseEnd && base->trigram == trigram) {
+            const uint* postings = basePostings() + base->first;
+            for (uint i = 0; i < base->count; ++i) {
+                const int id = newIds[postings[i]];
+                if (id != -1) {
+                    ids.append(id);
+                }
+            }
+            ++base;
+        }
+        if (delta != deltaTrigrams.constEnd() && *delta == trigram) {
+            for (int oldId : m_deltaPostings[trigram]) {
+                const int id = newIds[oldId];
+                if (id != -1) {
+                    ids.append(id);
+                }
+            }
+            ++delta;
+        }
+
+        if (!ids.isEmpty()) {
+            trigrams.append({trigram, uint(ids.size()), uint(fileHeader.postingCount)});
+            out.write(reinterpret_cast<const char*>(ids.constData()), ids.size() * sizeof(uint));
+            fileHeader.postingCount += ids.size();
+        }
+    }
+
+    out.write(reinterpret_cast<const char*>(trigrams.constData()), trigrams.size() * sizeof(TrigramEntry));
+    out.write(strings);
+
+    fileHeader.trigramCount = trigrams.size();
+    fileHeader.stringsSize = strings.size();
+    out.seek(0);
+    out.write(reinterpret_cast<const char*>(&fileHeader), sizeof(FileHeader));
+
+    // The ids are only valid for the mapped data, so the new index is mapped even if writing failed
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+        m_data = nullptr;
+    }
+    m_file.close();
+    if (!out.commit()) {
+        qCWarning(PROJECT) << "failed to write trigram index" << m_indexFile << out.errorString();
+    }
+
+    m_ids.clear();
+    m_delta.clear();
+    m_deltaPostings.clear();
+    m_baseCount = 0;
+    m_dataSize = 0;
+    m_changes = 0;
+    load();
+}
+
+void TrigramIndex::setFiles(const QStringList& files)
+{
+    QMutexLocker lock(&m_mutex);
+
+    const QSet<QString> fileSet = files.toSet();
+    for (auto it = m_ids.begin(); it != m_ids.end();) {
+        if (fileSet.contains(it.key())) {
+            ++it;
+        } else {
+            it = m_ids.erase(it);
+            ++m_changes;
+        }
+    }
+
+    m_ready = true;
+    for (const QString& file : files) {
+        enqueue(file);
+    }
+}
+
+void TrigramIndex::update(const QString& file)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_ready) {
+        enqueue(file);
+    }
+}
+
+void TrigramIndex::remove(const QString& path)
+{
+    QMutexLocker lock(&m_mutex);
+    m_changes += m_ids.remove(path);
+    // The files below the directory follow each other in the sorted paths
+    const QString prefix = path + QLatin1Char('/');
+    for (auto it = m_ids.lowerBound(prefix); it != m_ids.end() && it.key().startsWith(prefix);) {
+        it = m_ids.erase(it);
+        ++m_changes;
+    }
+}
+
+void TrigramIndex::remove(const QStringList& files)
+{
+    QMutexLocker lock(&m_mutex);
+    for (const QString& file : files) {
+        m_changes += m_ids.remove(file);
+    }
+}
+
+void TrigramIndex::enqueue(const QString& file)
+{
+    m_queue.append(file);
+    ++m_pending[file];
+    if (!m_running && !m_stopping) {
+        m_running = true;
+        QtConcurrent::run(&m_pool, [this] { processQueue(); });
+    }
+}
+
+void TrigramIndex::processQueue()
+{
+    QMutexLocker lock(&m_mutex);
+    while (!m_stopping && !m_queue.isEmpty()) {
+        const QString path = m_queue.takeFirst();
+        // The ids change when the index is saved, so only the stamp of the file is kept while unlocked
+        qint64 indexedModificationTime = -1;
+        qint64 indexedSize = -1;
+        const int id = m_ids.value(path, -1);
+        if (id != -1) {
+            fileStamp(id, &indexedModificationTime, &indexedSize);
+        }
+        lock.unlock();
+
+        QFileInfo info(path);
+        const bool exists = info.isFile();
+        const qint64 modificationTime = exists ? info.lastModified().toMSecsSinceEpoch() : 0;
+        const qint64 size = exists ? info.size() : 0;
+        const bool upToDate = exists && modificationTime == indexedModificationTime && size == indexedSize;
+
+        QVector<uint> trigrams;
+        bool indexed = false;
+        if (exists && !upToDate && size <= maxIndexedFileSize) {
+            QFile file(path);
+            if (file.open(QIODevice::ReadOnly)) {
+                const QByteArray data = file.readAll();
+                // Binary files are always searched
+                indexed = !memchr(data.constData(), 0, data.size());
+                if (indexed) {
+                    trigrams.reserve(data.size());
+                    appendTrigrams(data.constData(), data.size(), trigrams);
+                    sortUnique(trigrams);
+                }
+            }
+        }
+
+        lock.relock();
+        if (!exists) {
+            if (m_ids.remove(path)) {
+                ++m_changes;
+            }
+        } else if (!upToDate) {
+            add(path, modificationTime, size, indexed, trigrams);
+        }
+        if (--m_pending[path] == 0) {
+            m_pending.remove(path);
+        }
+    }
+
+    if (!m_stopping && m_changes >= saveThreshold) {
+        save();
+    }
+    m_running = false;
+    m_idle.wakeAll();
+}
+
+void TrigramIndex::add(const QString& path, qint64 modificationTime, qint64 size, bool indexed, const QVector<uint>& trigrams)
+{
+    const int id = m_baseCount + m_delta.size();
+    m_delta.append({path, modificationTime, size, indexed});
+    m_ids.insert(path, id);
+    for (uint trigram : trigrams) {
+        m_deltaPostings[trigram].append(id);
+    }
+    ++m_changes;
+}
+
+void TrigramIndex::fileStamp(int id, qint64* modificationTime, qint64* size) const
+{
+    if (id < m_baseCount) {
+        const FileEntry& file = baseFiles()[id];
+        *modificationTime = file.modificationTime;
+        *size = file.size;
+    } else {
+        const DeltaEntry& file = m_delta[id - m_baseCount];
+        *modificationTime = file.modificationTime;
+        *size = file.size;
+    }
+}
+
+bool TrigramIndex::isIndexed(int id) const
+{
+    if (id < m_baseCount) {
+        return baseFiles()[id].flags & IndexedFile;
+    }
+    return m_delta[id - m_baseCount].indexed;
+}
+
+void TrigramIndex::waitForIdle()
+{
+    QMutexLocker lock(&m_mutex);
+    while (m_running) {
+        m_idle.wait(&m_mutex);
+    }
+}
+
+void TrigramIndex::flush()
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_changes) {
+        save();
+    }
+}
+
+int TrigramIndex::indexedFileCount() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_ids.size();
+}
+
+QVector<int> TrigramIndex::postings(uint trigram) const
+{
+    QVector<int> ret;
+    if (m_data) {
+        const TrigramEntry* begin = baseTrigrams();
+        const TrigramEntry* end = begin + header()->trigramCount;
+        const TrigramEntry* it = std::lower_bound(begin, end, trigram, [](const TrigramEntry& entry, uint trigram) {
+            return entry.trigram < trigram;
+        });
+        if (it != end && it->trigram == trigram) {
+            const uint* postings = basePostings() + it->first;
+            ret.reserve(it->count);
+            std::copy(postings, postings + it->count, std::back_inserter(ret));
+        }
+    }
+    // The ids of the changed files follow the ones of the mapped index, so the result stays sorted
+    const auto it = m_deltaPostings.constFind(trigram);
+    if (it != m_deltaPostings.constEnd()) {
+        ret += *it;
+    }
+    return ret;
+}
+
+QVector<int> TrigramIndex::candidateIds(const QVector<uint>& trigrams) const
+{
+    QVector<int> ret = postings(trigrams.first());
+    for (int i = 1; i < trigrams.size() && !ret.isEmpty(); ++i) {
+        const QVector<int> ids = postings(trigrams[i]);
+        QVector<int> intersection;
+        std::set_intersection(ret.constBegin(), ret.constEnd(), ids.constBegin(), ids.constEnd(), std::back_inserter(intersection));
+        ret.swap(intersection);
+    }
+    return ret;
+}
+
+bool TrigramIndex::excludes(const QString& path, const QVector<int>& candidateIds, qint64* modificationTime, qint64* size) const
+{
+    if (m_pending.contains(path)) {
+        return false;
+    }
+    const int id = m_ids.value(path, -1);
+    if (id == -1 || !isIndexed(id) || std::binary_search(candidateIds.constBegin(), candidateIds.constEnd(), id)) {
+        return false;
+    }
+    fileStamp(id, modificationTime, size);
+    return true;
+}
+
+QList<QUrl> TrigramIndex::candidates(const QList<QUrl>& files, const QStringList& literals)
+{
+    const QVector<uint> trigrams = literalTrigrams(literals);
+    if (trigrams.isEmpty()) {
+        return files;
+    }
+
+    QStringList paths;
+    paths.reserve(files.size());
+    for (const QUrl& file : files) {
+        paths.append(file.toLocalFile());
+    }
+    QVector<bool> excluded(files.size(), false);
+    // The stamps of the excluded files when they were indexed
+    QVector<QPair<qint64, qint64>> stamps(files.size());
+
+    QMutexLocker registryLock(&registryMutex);
+    const QVector<TrigramIndex*>& indexes = registry();
+    for (const TrigramIndex* index : indexes) {
+        // The ids are only valid as long as the index is locked
+        QMutexLocker lock(&index->m_mutex);
+        if (!index->m_ready) {
+            continue;
+        }
+        const QVector<int> ids = index->candidateIds(trigrams);
+        const QString prefix = index->m_root + QLatin1Char('/');
+        for (int i = 0; i < paths.size(); ++i) {
+            if (!excluded[i] && paths[i].startsWith(prefix)) {
+                excluded[i] = index->excludes(paths[i], ids, &stamps[i].first, &stamps[i].second);
+            }
+        }
+    }
+    registryLock.unlock();
+
+    // Files that changed since they were indexed may contain the literals now, even if the index
+    // wasn't notified about the change yet
+    for (int i = 0; i < paths.size(); ++i) {
+        if (excluded[i]) {
+            const QFileInfo info(paths[i]);
+            excluded[i] = info.isFile() && info.lastModified().toMSecsSinceEpoch() == stamps[i].first
+                && info.size() == stamps[i].second;
+        }
+    }
+
+    QList<QUrl> ret;
+    for (int i = 0; i < files.size(); ++i) {
+        if (!excluded[i]) {
+            ret.append(files[i]);
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,166 @@
+/*
+    This file is part of KDevelop
+
+    Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KDEVPLATFORM_TRIGRAMINDEX_H
+#define KDEVPLATFORM_TRIGRAMINDEX_H
+
+#include "projectexport.h"
+
+#include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QUrl>
+#include <QVector>
+#include <QWaitCondition>
+
+namespace KDevelop {
+
+/**
+ * @short Index of the trigrams contained in the files below a directory.
+ *
+ * The index maps every sequence of three bytes to the files that contain it, so the files that
+ * may contain a text can be found without reading them. Letters are indexed in lower case,
+ * so the index can be used for case-sensitive and case-insensitive searches alike.
+ *
+ * The index is stored in a file that is mapped into memory when the index is opened. Files that
+ * change afterwards are indexed again in a background thread, and kept in memory until the index
+ * is written back to disk.
+ *
+ * Files that are too large, binary, not indexed yet, or changed on disk since they were indexed are
+ * always considered to be candidates, so candidates() never drops a file that could contain a match.
+ *
+ * All functions are thread-safe.
+ */
+class KDEVPLATFORMPROJECT_EXPORT TrigramIndex
+{
+public:
+    /**
+     * Opens the index of the files below @p rootDirectory, stored in @p indexFile.
+     *
+     * The index is not used until setFiles() has been called.
+     */
+    TrigramIndex(const QString& rootDirectory, const QString& indexFile);
+    /// Waits for the background thread, and writes the index to disk.
+    ~TrigramIndex();
+
+    /// @returns whether trigram indexes should be maintained, which is enabled by setting KDEV_TRIGRAM_INDEX=1
+    static bool isEnabled();
+
+    /// @returns the default location of the index file for the given directory
+    static QString defaultIndexFile(const QString& rootDirectory);
+
+    /**
+     * Sets the files that are indexed. Files that are not indexed yet, or that changed since they were
+     * indexed, are indexed in the background. Other files are dropped from the index.
+     */
+    void setFiles(const QStringList& files);
+
+    /// Indexes the given file again, or drops it from the index if it doesn't exist anymore.
+    void update(const QString& file);
+
+    /// Drops the given file, or all the files below the given directory, from the index.
+    void remove(const QString& path);
+
+    /// Drops the given files from the index, without looking for other files below them.
+    void remove(const QStringList& files);
+
+    /// Blocks until all changed files have been indexed.
+    void waitForIdle();
+
+    /// Writes the changes to disk.
+    void flush();
+
+    /**
+     * Drops the files that can't contain all the given @p literals from @p files, using the indexes
+     * of all opened TrigramIndex instances.
+     *
+     * Only trigrams of ASCII characters are used, other characters may have a different encoding in the files.
+     */
+    static QList<QUrl> candidates(const QList<QUrl>& files, const QStringList& literals);
+
+    /// @returns the count of files that are currently indexed
+    int indexedFileCount() const;
+
+private:
+    struct FileHeader;
+    struct FileEntry;
+    struct TrigramEntry;
+
+    struct DeltaEntry
+    {
+        QString path;
+        qint64 modificationTime;
+        qint64 size;
+        bool indexed;
+    };
+
+    void load();
+    void save();
+    void enqueue(const QString& file);
+    bool excludes(const QString& path, const QVector<int>& candidateIds, qint64* modificationTime, qint64* size) const;
+    void processQueue();
+    void add(const QString& path, qint64 modificationTime, qint64 size, bool indexed, const QVector<uint>& trigrams);
+    void fileStamp(int id, qint64* modificationTime, qint64* size) const;
+    bool isIndexed(int id) const;
+    QVector<int> candidateIds(const QVector<uint>& trigrams) const;
+    QVector<int> postings(uint trigram) const;
+
+    const FileHeader* header() const;
+    const FileEntry* baseFiles() const;
+    const TrigramEntry* baseTrigrams() const;
+    const uint* basePostings() const;
+    QString basePath(int id) const;
+
+    const QString m_root;
+    const QString m_indexFile;
+
+    mutable QMutex m_mutex;
+    QFile m_file;
+    const uchar* m_data = nullptr;
+    qint64 m_dataSize = 0;
+    int m_baseCount = 0;
+
+    // Maps the indexed files to their ids, the ids below m_baseCount refer to the mapped index.
+    // The paths are sorted, so the files below a directory can be found without scanning all of them
+    QMap<QString, int> m_ids;
+    QVector<DeltaEntry> m_delta;
+    QHash<uint, QVector<int>> m_deltaPostings;
+    int m_changes = 0;
+
+    // Files that are going to be indexed, with the count of their queued updates
+    QStringList m_queue;
+    QHash<QString, int> m_pending;
+    bool m_ready = false;
+    bool m_running = false;
+    bool m_stopping = false;
+    QWaitCondition m_idle;
+    QThreadPool m_pool;
+
+    Q_DISABLE_COPY(TrigramIndex)
+};
+
+}
+
+#endif // KDEVPLATFORM_TRIGRAMINDEX_H
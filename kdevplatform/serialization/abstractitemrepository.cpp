@@ -20,13 +20,29 @@
 
 #include "config-kdevplatform.h"
 
+#include <QAtomicInt>
+
 namespace KDevelop {
 
+namespace {
+QAtomicInt compressionEnabled(qEnvironmentVariableIntValue("KDEV_DUCHAIN_COMPRESSION") != 0);
+}
+
 uint staticItemRepositoryVersion()
 {
   return KDEV_ITEMREPOSITORY_VERSION;
 }
 
+bool itemRepositoryCompressionEnabled()
+{
+  return compressionEnabled.loadAcquire();
+}
+
+void setItemRepositoryCompressionEnabled(bool enabled)
+{
+  compressionEnabled.storeRelease(enabled);
+}
+
 AbstractItemRepository::~AbstractItemRepository()
 {
 }
@@ -45,4 +61,9 @@ void AbstractRepositoryManager::deleteRepository()
   m_repository = nullptr;
 }
 
+QMutex* AbstractRepositoryManager::repositoryMutex() const
+{
+  return nullptr;
+}
+
 }
@@ -30,6 +30,13 @@ namespace KDevelop {
 /// Returns a version-number that is used to reset the item-repository after incompatible layout changes.
 KDEVPLATFORMSERIALIZATION_EXPORT uint staticItemRepositoryVersion();
 
+/// Returns whether newly created item-repositories compress the data they store to disk.
+/// Disabled by default, it can be enabled by setting the environment variable KDEV_DUCHAIN_COMPRESSION=1.
+KDEVPLATFORMSERIALIZATION_EXPORT bool itemRepositoryCompressionEnabled();
+
+/// Changes the default returned by itemRepositoryCompressionEnabled(). Repositories that already exist are not affected.
+KDEVPLATFORMSERIALIZATION_EXPORT void setItemRepositoryCompressionEnabled(bool enabled);
+
 /// The interface class for an item-repository object.
 class KDEVPLATFORMSERIALIZATION_EXPORT AbstractItemRepository
 {
@@ -40,7 +47,18 @@ class KDEVPLATFORMSERIALIZATION_EXPORT AbstractItemRepository
     virtual bool open(const QString& path) = 0;
     virtual void close(bool doStore = false) = 0;
     /// Stores the repository contents to disk, eventually unloading unused data to save memory.
+    /// Equivalent to prepareStore(0) followed by applyStore().
     virtual void store() = 0;
+    /// First phase of a crash-safe store: Writes all changes into the journal of the repository,
+    /// tagged with @p generation, without touching the repository files yet.
+    /// A nonzero @p generation is only replayed after a crash if it has been committed, see ItemRepositoryJournal.
+    virtual void prepareStore(uint generation) = 0;
+    /// Second phase of a crash-safe store: Writes the journal into the repository files,
+    /// eventually unloading unused data to save memory.
+    virtual void applyStore() = 0;
+    /// Drops the journal written by prepareStore() instead of applying it, the changes
+    /// are written again by the next store.
+    virtual void discardStore() = 0;
     /// Does a big cleanup, removing all non-persistent items in the repositories.
     /// @returns Count of bytes of data that have been removed.
     virtual int finalCleanup() = 0;
@@ -57,7 +75,9 @@ class KDEVPLATFORMSERIALIZATION_EXPORT AbstractRepositoryManager
 
     void deleteRepository();
 
-    virtual QMutex* repositoryMutex() const = 0;
+    /// @returns the mutex that protects the repository, so that other repositories can share it,
+    ///          or nullptr if the repository has no single mutex, like a ShardedItemRepository
+    virtual QMutex* repositoryMutex() const;
 
   protected:
     mutable AbstractItemRepository* m_repository;
@@ -19,9 +19,15 @@
 
 #include "indexedstring.h"
 #include "serialization/stringrepository.h"
+#include "serialization/shardeditemrepository.h"
 
 #include "referencecounting.h"
 
+#include <QThreadStorage>
+
+#include <algorithm>
+#include <iterator>
+
 using namespace KDevelop;
 
 namespace {
@@ -150,20 +156,28 @@ inline char indexToChar(uint index)
     return static_cast<char>(index & 0xff);
 }
 
-using IndexedStringRepository = ItemRepository<IndexedStringData, IndexedStringRepositoryItemRequest, false, false>;
-using IndexedStringRepositoryManagerBase = RepositoryManager<IndexedStringRepository, true, false>;
-class IndexedStringRepositoryManager : public IndexedStringRepositoryManagerBase
+using IndexedStringRepository = ShardedItemRepository<IndexedStringData, IndexedStringRepositoryItemRequest, false, false>;
+
+class IndexedStringRepositoryManager : public AbstractRepositoryManager
 {
 public:
     IndexedStringRepositoryManager()
-      : IndexedStringRepositoryManagerBase(QStringLiteral("String Index"))
     {
-        repository()->setMutex(&m_mutex);
+        auto* repo = new IndexedStringRepository(QStringLiteral("String Index"), &globalItemRepositoryRegistry(), 1, this);
+        for (uint a = 0; a < IndexedStringRepository::ShardCount; ++a) {
+            repo->setShardMutex(a, &m_mutexes[a]);
+        }
+        m_repository = repo;
+    }
+
+    IndexedStringRepository* repository() const
+    {
+        return static_cast<IndexedStringRepository*>(m_repository);
     }
 
 private:
-    // non-recursive mutex to increase speed
-    QMutex m_mutex;
+    // non-recursive mutexes to increase speed
+    QMutex m_mutexes[IndexedStringRepository::ShardCount];
 };
 
 IndexedStringRepository* globalIndexedStringRepository()
@@ -172,28 +186,78 @@ IndexedStringRepository* globalIndexedStringRepository()
     return manager.repository();
 }
 
+/// Calls @p action with the shard that contains @p index locked
 template<typename ReadAction>
-auto readRepo(ReadAction action) -> decltype(action(globalIndexedStringRepository()))
+auto readRepo(uint index, ReadAction action) -> decltype(action(globalIndexedStringRepository()))
 {
     const auto* repo = globalIndexedStringRepository();
-    QMutexLocker lock(repo->mutex());
+    QMutexLocker lock(repo->mutexForIndex(index));
+    return action(repo);
+}
+
+/// Calls @p action with the shard that contains @p index locked
+template<typename EditAction>
+auto editRepo(uint index, EditAction action) -> decltype(action(globalIndexedStringRepository()))
+{
+    auto* repo = globalIndexedStringRepository();
+    QMutexLocker lock(repo->mutexForIndex(index));
     return action(repo);
 }
 
+/// Calls @p action with the shard that strings with the given @p hash belong to locked
 template<typename EditAction>
-auto editRepo(EditAction action) -> decltype(action(globalIndexedStringRepository()))
+auto editRepoForHash(uint hash, EditAction action) -> decltype(action(globalIndexedStringRepository()))
 {
     auto* repo = globalIndexedStringRepository();
-    QMutexLocker lock(repo->mutex());
+    QMutexLocker lock(repo->mutexForHash(hash));
     return action(repo);
 }
 
+/// Small per-thread cache for decoded strings, so hot strings like file paths can be
+/// converted repeatedly without locking the repository.
+struct StringCache
+{
+    enum {
+        SizeBits = 9
+    };
+
+    struct Entry
+    {
+        uint index = 0;
+        QString string;
+        QByteArray byteArray;
+    };
+
+    /// @returns the entry for @p index, which is reset if it held another string before
+    Entry& entry(uint index)
+    {
+        const uint generation = globalIndexedStringRepository()->generation();
+        if (generation != m_generation) {
+            // strings may have been removed from the repository, so the indices may now belong to other strings
+            std::fill(std::begin(m_entries), std::end(m_entries), Entry());
+            m_generation = generation;
+        }
+
+        Entry& ret = m_entries[(index * 2654435769u) >> (32 - SizeBits)];
+        if (ret.index != index) {
+            ret = Entry();
+            ret.index = index;
+        }
+        return ret;
+    }
+
+    uint m_generation = 0;
+    Entry m_entries[1 << SizeBits];
+};
+
+QThreadStorage<StringCache> threadStringCache;
+
 inline void ref(IndexedString* string)
 {
     const uint index = string->index();
     if (index && !isSingleCharIndex(index)) {
         if (shouldDoDUChainReferenceCounting(string)) {
-            editRepo([index] (IndexedStringRepository* repo) {
+            editRepo(index, [index] (IndexedStringRepository* repo) {
                 increase(repo->dynamicItemFromIndexSimple(index)->refCount);
             });
         }
@@ -205,7 +269,7 @@ inline void deref(IndexedString* string)
     const uint index = string->index();
     if (index && !isSingleCharIndex(index)) {
         if (shouldDoDUChainReferenceCounting(string)) {
-            editRepo([index] (IndexedStringRepository* repo) {
+            editRepo(index, [index] (IndexedStringRepository* repo) {
                 decrease(repo->dynamicItemFromIndexSimple(index)->refCount);
             });
         }
@@ -230,7 +294,7 @@ IndexedString::IndexedString(const char* str, unsigned short length, uint hash)
     } else {
         const auto request = IndexedStringRepositoryItemRequest(str, hash ? hash : hashString(str, length), length);
         bool refcount = shouldDoDUChainReferenceCounting(this);
-        m_index = editRepo([request, refcount] (IndexedStringRepository* repo) {
+        m_index = editRepoForHash(request.hash(), [request, refcount] (IndexedStringRepository* repo) {
             auto index = repo->index(request);
             if (refcount) {
                 increase(repo->dynamicItemFromIndexSimple(index)->refCount);
@@ -312,9 +376,13 @@ QString IndexedString::str() const
         return QString(QLatin1Char(indexToChar(m_index)));
     } else {
         const uint index = m_index;
-        return readRepo([index] (const IndexedStringRepository* repo) {
-            return stringFromItem(repo->itemFromIndex(index));
-        });
+        auto& entry = threadStringCache.localData().entry(index);
+        if (entry.string.isNull()) {
+            entry.string = readRepo(index, [index] (const IndexedStringRepository* repo) {
+                return stringFromItem(repo->itemFromIndex(index));
+            });
+        }
+        return entry.string;
     }
 }
 
@@ -330,7 +398,7 @@ int IndexedString::lengthFromIndex(uint index)
     } else if (isSingleCharIndex(index)) {
         return 1;
     } else {
-        return readRepo([index] (const IndexedStringRepository* repo) {
+        return readRepo(index, [index] (const IndexedStringRepository* repo) {
             return repo->itemFromIndex(index)->length;
         });
     }
@@ -349,7 +417,7 @@ const char* IndexedString::c_str() const
         return reinterpret_cast<const char*>(&m_index) + offset;
     } else {
         const uint index = m_index;
-        return readRepo([index] (const IndexedStringRepository* repo) {
+        return readRepo(index, [index] (const IndexedStringRepository* repo) {
             return c_strFromItem(repo->itemFromIndex(index));
         });
     }
@@ -364,9 +432,13 @@ QByteArray IndexedString::byteArray() const
         return QByteArray(1, indexToChar(m_index));
     } else {
         const uint index = m_index;
-        return readRepo([index] (const IndexedStringRepository* repo) {
-            return arrayFromItem(repo->itemFromIndex(index));
-        });
+        auto& entry = threadStringCache.localData().entry(index);
+        if (entry.byteArray.isNull()) {
+            entry.byteArray = readRepo(index, [index] (const IndexedStringRepository* repo) {
+                return arrayFromItem(repo->itemFromIndex(index));
+            });
+        }
+        return entry.byteArray;
     }
 }
 
@@ -388,7 +460,7 @@ uint IndexedString::indexForString(const char* str, short unsigned length, uint
         return charToIndex(str[0]);
     } else {
         const auto request = IndexedStringRepositoryItemRequest(str, hash ? hash : hashString(str, length), length);
-        return editRepo([request] (IndexedStringRepository* repo) {
+        return editRepoForHash(request.hash(), [request] (IndexedStringRepository* repo) {
             return repo->index(request);
         });
     }
@@ -19,6 +19,7 @@
 #ifndef KDEVPLATFORM_ITEMREPOSITORY_H
 #define KDEVPLATFORM_ITEMREPOSITORY_H
 
+#include <QBuffer>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
@@ -30,6 +31,7 @@
 #include "abstractitemrepository.h"
 #include "repositorymanager.h"
 #include "itemrepositoryregistry.h"
+#include "itemrepositoryjournal.h"
 
 //#define DEBUG_MONSTERBUCKETS
 
@@ -196,14 +198,12 @@ class Bucket {
       }
     }
 
-    void store(QFile* file, size_t offset) {
+    ///Serializes the bucket into @p file, starting at its current position
+    void store(QIODevice* file) {
       if(!m_data)
         return;
 
-      if(static_cast<size_t>(file->size()) < offset + (1+m_monsterBucketExtent)*DataSize)
-        file->resize(offset + (1+m_monsterBucketExtent)*DataSize);
-
-      file->seek(offset);
+      const size_t offset = file->pos();
 
       file->write((char*)&m_monsterBucketExtent, sizeof(unsigned int));
       file->write((char*)&m_available, sizeof(unsigned int));
@@ -216,14 +216,13 @@ class Bucket {
 
       if(static_cast<size_t>(file->pos()) != offset + (1+m_monsterBucketExtent)*DataSize)
       {
-        KMessageBox::error(nullptr, i18n("Failed writing to %1, probably the disk is full", file->fileName()));
+        qWarning() << "failed serializing a bucket of size" << (1+m_monsterBucketExtent)*DataSize;
         abort();
       }
 
       m_changed = false;
 #ifdef DEBUG_ITEMREPOSITORY_LOADING
       {
-        file->flush();
         file->seek(offset);
 
         uint available, freeItemCount, monsterBucketExtent;
@@ -756,6 +755,11 @@ class Bucket {
       return m_changed;
     }
 
+    //Marks the bucket as changed again after its stored data was discarded
+    void setChanged() {
+      m_changed = true;
+    }
+
     void prepareChange() {
       m_changed = true;
       m_dirty = true;
@@ -1029,6 +1033,10 @@ class DynamicItem {
     DynamicItem& operator=(const DynamicItem&);
 };
 
+template<class Item, class ItemRequest, bool markForReferenceCounting, bool threadSafe, uint fixedItemSize,
+         unsigned int targetBucketHashSize, uint shardBits>
+class ShardedItemRepository;
+
 ///@tparam Item See ExampleItem
 ///@tparam ItemRequest See ExampleReqestItem
 ///@tparam fixedItemSize When this is true, all inserted items must have the same size.
@@ -1055,6 +1063,11 @@ class ItemRepository : public AbstractItemRepository {
     BucketStartOffset = sizeof(uint) * 7 + sizeof(short unsigned int) * bucketHashSize //Position in the data where the bucket array starts
   };
 
+  enum : uint {
+    //Stored instead of the monster-bucket extent at the start of a compressed bucket, followed by the size of the compressed data
+    CompressedBucketMarker = 0xffffffff
+  };
+
   public:
   ///@param registry May be zero, then the repository will not be registered at all. Else, the repository will register itself to that registry.
   ///                If this is zero, you have to care about storing the data using store() and/or close() by yourself. It does not happen automatically.
@@ -1071,6 +1084,9 @@ class ItemRepository : public AbstractItemRepository {
     , m_manager(manager)
   {
     m_unloadingEnabled = true;
+    m_journalUnapplied = false;
+    m_bucketLimit = 0xfffe;
+    m_compressionEnabled = itemRepositoryCompressionEnabled();
     m_metaDataChanged = true;
     m_buckets.resize(10);
     m_buckets.fill(nullptr);
@@ -1095,6 +1111,21 @@ class ItemRepository : public AbstractItemRepository {
       m_unloadingEnabled = enabled;
   }
 
+  ///Limits the count of buckets this repository may use, so indices stay below (@p limit << 16).
+  ///When the limit is reached, index() returns zero. Used by ShardedItemRepository, which needs the highest bits of the indices.
+  void setBucketLimit(uint limit) {
+    Q_ASSERT(limit <= 0xfffe);
+    m_bucketLimit = limit;
+  }
+
+  ///Enables or disables compressing the buckets that are stored to disk, the default is itemRepositoryCompressionEnabled().
+  ///Compressed and uncompressed buckets can be mixed in one file, so this can be changed at any time.
+  ///Compressed buckets cannot be memory-mapped, they are decompressed into memory when loaded.
+  void setCompressionEnabled(bool enabled) {
+    ThisLocker lock(m_mutex);
+    m_compressionEnabled = enabled;
+  }
+
   ///Returns the index for the given item. If the item is not in the repository yet, it is inserted.
   ///The index can never be zero. Zero is reserved for your own usage as invalid
   ///@param request Item to retrieve the index from
@@ -1170,6 +1201,10 @@ class ItemRepository : public AbstractItemRepository {
 
     //The item isn't in the repository yet, find a new bucket for it
     while(1) {
+      if(useBucket >= m_bucketLimit) {
+        qWarning() << "Found no room for an item in" << m_repositoryName << "size of the item:" << request.itemSize();
+        return 0;
+      }
       if(useBucket >= m_buckets.size()) {
           if(m_buckets.size() >= 0xfffe) { //We have reserved the last bucket index 0xffff for special purposes
           //the repository has overflown.
@@ -1235,6 +1270,10 @@ class ItemRepository : public AbstractItemRepository {
           //Create a new monster-bucket at the end of the data
           int needMonsterExtent = (totalSize - ItemRepositoryBucketSize) / MyBucket::DataSize + 1;
           Q_ASSERT(needMonsterExtent);
+          if(m_currentBucket + needMonsterExtent + 1 > m_bucketLimit) {
+            qWarning() << "Found no room for an item in" << m_repositoryName << "size of the item:" << request.itemSize();
+            return 0;
+          }
           if(m_currentBucket + needMonsterExtent + 1 > m_buckets.size()) {
             m_buckets.resize(m_buckets.size() + 10 + needMonsterExtent + 1);
           }
@@ -1680,59 +1719,115 @@ class ItemRepository : public AbstractItemRepository {
   ///Synchronizes the state on disk to the one in memory, and does some memory-management.
   ///Should be called on a regular basis. Can be called centrally from the global item repository registry.
   void store() override {
+    //The mutex may be non-recursive, so it is locked separately by both phases
+    prepareStore(0);
+    applyStore();
+  }
+
+  ///Writes all changed buckets and the meta-data into the journal, and commits it for @p generation.
+  ///The repository files are not touched, so a crash at any time leaves them consistent.
+  void prepareStore(uint generation) override {
     QMutexLocker lock(m_mutex);
     if(m_file) {
-
-      if(!m_file->open( QFile::ReadWrite ) || !m_dynamicFile->open( QFile::ReadWrite )) {
-        qFatal("cannot re-open repository file for storing");
-        return;
+      if(m_journalUnapplied) {
+        //The journal still holds the committed changes of the previous store, they must not be dropped
+        if(!m_journal.apply(m_file, m_dynamicFile)) {
+          KMessageBox::error(nullptr, i18n("Failed writing to %1, probably the disk is full", m_file->fileName()));
+          abort();
+        }
+        m_journalUnapplied = false;
       }
 
+      m_journal.begin();
+      m_journaledBuckets.clear();
+
       for(int a = 0; a < m_buckets.size(); ++a) {
-        if(m_buckets[a]) {
-          if(m_buckets[a]->changed()) {
-            storeBucket(a);
-          }
-          if(m_unloadingEnabled) {
-            const int unloadAfterTicks = 2;
-            if(m_buckets[a]->lastUsed() > unloadAfterTicks) {
-                delete m_buckets[a];
-                m_buckets[a] = nullptr;
-            }else{
-                m_buckets[a]->tick();
-            }
-          }
+        if(m_buckets[a] && m_buckets[a]->changed()) {
+          storeBucket(a);
+          m_journaledBuckets.append(a);
         }
       }
 
       if(m_metaDataChanged) {
         Q_ASSERT(m_dynamicFile);
 
-        m_file->seek(0);
-        m_file->write((char*)&m_repositoryVersion, sizeof(uint));
+        QByteArray metaData;
+        metaData.reserve(BucketStartOffset);
+        metaData.append((char*)&m_repositoryVersion, sizeof(uint));
         uint hashSize = bucketHashSize;
-        m_file->write((char*)&hashSize, sizeof(uint));
+        metaData.append((char*)&hashSize, sizeof(uint));
         uint itemRepositoryVersion  = staticItemRepositoryVersion();
-        m_file->write((char*)&itemRepositoryVersion, sizeof(uint));
-        m_file->write((char*)&m_statBucketHashClashes, sizeof(uint));
-        m_file->write((char*)&m_statItemCount, sizeof(uint));
+        metaData.append((char*)&itemRepositoryVersion, sizeof(uint));
+        metaData.append((char*)&m_statBucketHashClashes, sizeof(uint));
+        metaData.append((char*)&m_statItemCount, sizeof(uint));
 
         const uint bucketCount = static_cast<uint>(m_buckets.size());
-        m_file->write((char*)&bucketCount, sizeof(uint));
-        m_file->write((char*)&m_currentBucket, sizeof(uint));
-        m_file->write((char*)m_firstBucketForHash, sizeof(short unsigned int) * bucketHashSize);
-        Q_ASSERT(m_file->pos() == BucketStartOffset);
+        metaData.append((char*)&bucketCount, sizeof(uint));
+        metaData.append((char*)&m_currentBucket, sizeof(uint));
+        metaData.append((char*)m_firstBucketForHash, sizeof(short unsigned int) * bucketHashSize);
+        Q_ASSERT(metaData.size() == BucketStartOffset);
+        writeJournalRecord(ItemRepositoryJournal::MainFile, 0, metaData);
 
-        m_dynamicFile->seek(0);
+        QByteArray dynamicData;
         const uint freeSpaceBucketsSize = static_cast<uint>(m_freeSpaceBuckets.size());
-        m_dynamicFile->write((char*)&freeSpaceBucketsSize, sizeof(uint));
-        m_dynamicFile->write((char*)m_freeSpaceBuckets.data(), sizeof(uint) * freeSpaceBucketsSize);
+        dynamicData.append((char*)&freeSpaceBucketsSize, sizeof(uint));
+        dynamicData.append((char*)m_freeSpaceBuckets.data(), sizeof(uint) * freeSpaceBucketsSize);
+        writeJournalRecord(ItemRepositoryJournal::DynamicFile, 0, dynamicData);
+      }
+
+      if(!m_journal.commit(generation)) {
+        KMessageBox::error(nullptr, i18n("Failed writing to %1, probably the disk is full", m_file->fileName()));
+        abort();
+      }
+    }
+  }
+
+  ///Writes the journal committed by prepareStore() into the repository files, and unloads buckets that were not used recently.
+  void applyStore() override {
+    QMutexLocker lock(m_mutex);
+    if(m_file) {
+      if(!m_journal.apply(m_file, m_dynamicFile)) {
+        //The repository files may be partially written, the committed journal is applied again by the next
+        //store, or recovered when the repository is opened the next time. Until then the journaled buckets
+        //must not be unloaded, since the files don't contain their current data.
+        qWarning() << "failed to apply the journal of repository" << m_repositoryName << ", keeping it";
+        m_journalUnapplied = true;
+        foreach(int bucket, m_journaledBuckets) {
+          m_buckets[bucket]->setChanged();
+        }
+        m_journaledBuckets.clear();
+        return;
+      }
+      m_journaledBuckets.clear();
+
+      if(m_unloadingEnabled) {
+        for(int a = 0; a < m_buckets.size(); ++a) {
+          //Buckets changed after prepareStore() have not been written yet, so they must stay in memory
+          if(m_buckets[a] && !m_buckets[a]->changed()) {
+            const int unloadAfterTicks = 2;
+            if(m_buckets[a]->lastUsed() > unloadAfterTicks) {
+                delete m_buckets[a];
+                m_buckets[a] = nullptr;
+            }else{
+                m_buckets[a]->tick();
+            }
+          }
+        }
       }
-      //To protect us from inconsistency due to crashes. flush() is not enough. We need to close.
-      m_file->close();
-      m_dynamicFile->close();
-      Q_ASSERT(!m_file->isOpen());
-      Q_ASSERT(!m_dynamicFile->isOpen());
+    }
+  }
+
+  ///Drops the journal written by prepareStore(), so the repository files keep their previous state.
+  ///The buckets that were journaled are written again by the next store.
+  void discardStore() override {
+    QMutexLocker lock(m_mutex);
+    if(m_file) {
+      m_journal.discard();
+      foreach(int bucket, m_journaledBuckets) {
+        //Buckets are only unloaded by applyStore(), so they are all still there
+        m_buckets[bucket]->setChanged();
+      }
+      m_journaledBuckets.clear();
     }
   }
 
@@ -1910,14 +2005,21 @@ class ItemRepository : public AbstractItemRepository {
     QDir dir(path);
     m_file = new QFile(dir.absoluteFilePath( m_repositoryName ));
     m_dynamicFile = new QFile(dir.absoluteFilePath( m_repositoryName + QLatin1String("_dynamic") ));
-    if(!m_file->open( QFile::ReadWrite ) || !m_dynamicFile->open( QFile::ReadWrite ) ) {
+    if(!m_file->open( QFile::ReadWrite ) || !m_dynamicFile->open( QFile::ReadWrite )
+       || !m_journal.open(dir.absoluteFilePath( m_repositoryName + QLatin1String("_journal") ))) {
       delete m_file;
       m_file = nullptr;
       delete m_dynamicFile;
       m_dynamicFile = nullptr;
+      m_journal.close();
       return false;
     }
 
+    //If we crashed while applying a store, finish it now. Uncommitted changes are dropped.
+    if(m_journal.recover(m_file, m_dynamicFile, ItemRepositoryJournal::generations(path))) {
+      qDebug() << "recovered repository" << m_repositoryName << "from its journal";
+    }
+
     m_metaDataChanged = true;
     if(m_file->size() == 0) {
 
@@ -1972,6 +2074,7 @@ class ItemRepository : public AbstractItemRepository {
         m_file = nullptr;
         delete m_dynamicFile;
         m_dynamicFile = nullptr;
+        m_journal.close();
         return false;
       }
       m_metaDataChanged = false;
@@ -2006,9 +2109,13 @@ class ItemRepository : public AbstractItemRepository {
       }
     }
 #endif
-    //To protect us from inconsistency due to crashes. flush() is not enough.
-    m_file->close();
-    m_dynamicFile->close();
+    //Keep the files open for storing, the journal protects us from inconsistency due to crashes.
+    //The map stays valid when the file is closed and re-opened.
+    if(!m_file->isWritable()) {
+      m_file->close();
+      bool res = m_file->open( QFile::ReadWrite );
+      VERIFY(res);
+    }
 
     return true;
   }
@@ -2031,8 +2138,12 @@ class ItemRepository : public AbstractItemRepository {
     delete m_dynamicFile;
     m_dynamicFile = nullptr;
 
+    m_journal.close();
+    m_journalUnapplied = false;
+
     qDeleteAll(m_buckets);
     m_buckets.clear();
+    m_journaledBuckets.clear();
 
     memset(m_firstBucketForHash, 0, bucketHashSize * sizeof(short unsigned int));
   }
@@ -2106,25 +2217,34 @@ class ItemRepository : public AbstractItemRepository {
       } else if(m_file) {
         //Either memory-mapping is disabled, or the item is not in the existing memory-map,
         //so we have to load it the classical way.
-        bool res = m_file->open( QFile::ReadOnly );
+        Q_ASSERT(m_file->isOpen());
 
         if(offset + BucketStartOffset < m_file->size()) {
-          VERIFY(res);
           offset += BucketStartOffset;
           m_file->seek(offset);
           uint monsterBucketExtent;
           m_file->read((char*)(&monsterBucketExtent), sizeof(unsigned int));;
-          m_file->seek(offset);
-          ///FIXME: use the data here instead of copying it again in prepareChange
-          QByteArray data = m_file->read((1+monsterBucketExtent) * MyBucket::DataSize);
+          QByteArray data;
+          if(monsterBucketExtent == CompressedBucketMarker) {
+            uint compressedSize = 0;
+            m_file->read((char*)(&compressedSize), sizeof(unsigned int));
+            data = qUncompress(m_file->read(compressedSize));
+            if(static_cast<uint>(data.size()) < MyBucket::DataSize ||
+               static_cast<uint>(data.size()) != (1 + *reinterpret_cast<uint*>(data.data())) * MyBucket::DataSize)
+            {
+              qWarning() << "failed decompressing bucket" << bucketNumber << "of" << m_file->fileName();
+              abort();
+            }
+          }else{
+            m_file->seek(offset);
+            ///FIXME: use the data here instead of copying it again in prepareChange
+            data = m_file->read((1+monsterBucketExtent) * MyBucket::DataSize);
+          }
           m_buckets[bucketNumber]->initializeFromMap(data.data());
           m_buckets[bucketNumber]->prepareChange();
         }else{
           m_buckets[bucketNumber]->initialize(0);
         }
-
-        m_file->close();
-
       }else{
         m_buckets[bucketNumber]->initialize(0);
       }
@@ -2141,10 +2261,30 @@ class ItemRepository : public AbstractItemRepository {
     m_buckets[bucketNumber] = nullptr;
   }
 
-  //m_file must be opened
-  void storeBucket(int bucketNumber) const {
+  //Writes the bucket into the journal, m_journal must be opened
+  void storeBucket(int bucketNumber) {
     if(m_file && m_buckets[bucketNumber]) {
-      m_buckets[bucketNumber]->store(m_file, BucketStartOffset + (bucketNumber-1) * MyBucket::DataSize);
+      QByteArray data;
+      QBuffer buffer(&data);
+      buffer.open(QIODevice::ReadWrite);
+      m_buckets[bucketNumber]->store(&buffer);
+      if(m_compressionEnabled) {
+        //Fast compression, the buckets contain mostly zeroes and small integers. The remainder of the slot is not
+        //written, so it stays a hole in the file system if the slot has not been written uncompressed before.
+        const QByteArray compressed = qCompress(data, 1);
+        if(compressed.size() + 2 * sizeof(uint) < static_cast<uint>(data.size())) {
+          const uint header[2] = {CompressedBucketMarker, static_cast<uint>(compressed.size())};
+          data = QByteArray(reinterpret_cast<const char*>(header), sizeof(header)) + compressed;
+        }
+      }
+      writeJournalRecord(ItemRepositoryJournal::MainFile, BucketStartOffset + quint64(bucketNumber-1) * MyBucket::DataSize, data);
+    }
+  }
+
+  void writeJournalRecord(ItemRepositoryJournal::Target target, quint64 offset, const QByteArray& data) {
+    if(!m_journal.addRecord(target, offset, data)) {
+      KMessageBox::error(nullptr, i18n("Failed writing to %1, probably the disk is full", m_file->fileName()));
+      abort();
     }
   }
 
@@ -2243,10 +2383,20 @@ class ItemRepository : public AbstractItemRepository {
   uint m_fileMapSize;
   //File that contains more dynamic data, like the list of buckets with deleted items
   QFile* m_dynamicFile;
+  //Journal that makes storing to m_file and m_dynamicFile crash-safe
+  ItemRepositoryJournal m_journal;
+  //The buckets written into the journal by prepareStore(), until it is applied or discarded
+  QVector<int> m_journaledBuckets;
+  //Whether applying the committed journal failed, it must be applied before the next store
+  bool m_journalUnapplied;
   uint m_repositoryVersion;
   bool m_unloadingEnabled;
+  uint m_bucketLimit;
+  bool m_compressionEnabled;
   AbstractRepositoryManager* m_manager;
   friend class ::TestItemRepository;
+  template<class, class, bool, bool, uint, unsigned int, uint>
+  friend class ShardedItemRepository;
 };
 
 }
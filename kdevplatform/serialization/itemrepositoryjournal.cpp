@@ -0,0 +1,319 @@
+/*
+   Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "itemrepositoryjournal.h"
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QSaveFile>
+
+#include <cstddef>
+
+#ifndef Q_OS_WIN
+#include <unistd.h>
+#endif
+
+#include "debug.h"
+
+using namespace KDevelop;
+
+namespace {
+
+enum : quint32 {
+  DataRecordMagic = 0x4a524e44, // "JRND"
+  CommitRecordMagic = 0x4a524e43 // "JRNC"
+};
+
+// Records larger than this can only be the result of a corrupted journal
+const quint32 maxRecordSize = 1u << 30;
+
+struct RecordHeader
+{
+  quint32 magic;
+  // The target file for data records, the generation for the commit record
+  quint32 target;
+  // The offset in the target file for data records, the count of data records for the commit record
+  quint64 offset;
+  quint32 size;
+  // Checksum of header and payload for data records, checksum of the whole transaction for the commit record
+  quint32 checksum;
+};
+
+quint32 crc32(const char* data, size_t size, quint32 crc = 0)
+{
+  static const struct Table {
+    Table()
+    {
+      for (quint32 i = 0; i < 256; ++i) {
+        quint32 c = i;
+        for (int k = 0; k < 8; ++k) {
+          c = (c & 1) ? (0xedb88320u ^ (c >> 1)) : (c >> 1);
+        }
+        values[i] = c;
+      }
+    }
+    quint32 values[256];
+  } table;
+
+  crc = ~crc;
+  for (size_t i = 0; i < size; ++i) {
+    crc = table.values[(crc ^ static_cast<uchar>(data[i])) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+quint32 recordChecksum(const RecordHeader& header, const QByteArray& payload)
+{
+  // The checksum itself is the last member, and not part of the checksum
+  quint32 crc = crc32(reinterpret_cast<const char*>(&header), offsetof(RecordHeader, checksum));
+  return crc32(payload.constData(), payload.size(), crc);
+}
+
+bool syncToDisk(QFile& file)
+{
+  if (!file.flush()) {
+    return false;
+  }
+#ifndef Q_OS_WIN
+  return ::fsync(file.handle()) == 0;
+#else
+  return true;
+#endif
+}
+
+QString generationsFilePath(const QString& path)
+{
+  return path + QLatin1String("/journal_generations");
+}
+
+}
+
+ItemRepositoryJournal::ItemRepositoryJournal()
+  : m_recordCount(0)
+  , m_transactionChecksum(0)
+{
+}
+
+ItemRepositoryJournal::~ItemRepositoryJournal()
+{
+  close();
+}
+
+bool ItemRepositoryJournal::open(const QString& fileName)
+{
+  close();
+  m_file.setFileName(fileName);
+  return m_file.open(QIODevice::ReadWrite);
+}
+
+void ItemRepositoryJournal::close()
+{
+  if (m_file.isOpen()) {
+    m_file.close();
+  }
+  m_recordCount = 0;
+  m_transactionChecksum = 0;
+}
+
+void ItemRepositoryJournal::truncate()
+{
+  m_file.resize(0);
+  m_file.seek(0);
+  m_recordCount = 0;
+  m_transactionChecksum = 0;
+}
+
+void ItemRepositoryJournal::begin()
+{
+  Q_ASSERT(m_file.isOpen());
+  truncate();
+}
+
+void ItemRepositoryJournal::discard()
+{
+  Q_ASSERT(m_file.isOpen());
+  truncate();
+}
+
+bool ItemRepositoryJournal::addRecord(Target target, quint64 offset, const QByteArray& data)
+{
+  Q_ASSERT(m_file.isOpen());
+
+  RecordHeader header;
+  header.magic = DataRecordMagic;
+  header.target = target;
+  header.offset = offset;
+  header.size = data.size();
+  header.checksum = recordChecksum(header, data);
+
+  if (m_file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header)
+      || m_file.write(data) != data.size()) {
+    return false;
+  }
+
+  ++m_recordCount;
+  m_transactionChecksum = crc32(reinterpret_cast<const char*>(&header.checksum), sizeof(header.checksum), m_transactionChecksum);
+  return true;
+}
+
+bool ItemRepositoryJournal::commit(uint generation)
+{
+  Q_ASSERT(m_file.isOpen());
+
+  if (!m_recordCount) {
+    // Nothing has changed, the journal stays empty
+    return true;
+  }
+
+  RecordHeader header;
+  header.magic = CommitRecordMagic;
+  header.target = generation;
+  header.offset = m_recordCount;
+  header.size = 0;
+  header.checksum = crc32(reinterpret_cast<const char*>(&generation), sizeof(generation), m_transactionChecksum);
+
+  if (m_file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header)) {
+    return false;
+  }
+
+  return syncToDisk(m_file);
+}
+
+bool ItemRepositoryJournal::apply(QFile* mainFile, QFile* dynamicFile)
+{
+  return replay(mainFile, dynamicFile, nullptr) != ReplayFailed;
+}
+
+bool ItemRepositoryJournal::recover(QFile* mainFile, QFile* dynamicFile, const Generations& generations)
+{
+  return replay(mainFile, dynamicFile, &generations) == Replayed;
+}
+
+ItemRepositoryJournal::ReplayResult ItemRepositoryJournal::replay(QFile* mainFile, QFile* dynamicFile, const Generations* generations)
+{
+  Q_ASSERT(m_file.isOpen());
+
+  if (m_file.size() == 0) {
+    return NothingReplayed;
+  }
+
+  // First pass: Verify that the journal contains a complete transaction
+  m_file.seek(0);
+  uint recordCount = 0;
+  quint32 transactionChecksum = 0;
+  bool committed = false;
+  uint generation = 0;
+
+  RecordHeader header;
+  while (m_file.read(reinterpret_cast<char*>(&header), sizeof(header)) == sizeof(header)) {
+    if (header.magic == DataRecordMagic) {
+      if (header.size > maxRecordSize || header.target > DynamicFile) {
+        break;
+      }
+      const QByteArray payload = m_file.read(header.size);
+      if (static_cast<quint32>(payload.size()) != header.size || recordChecksum(header, payload) != header.checksum) {
+        break;
+      }
+      ++recordCount;
+      transactionChecksum = crc32(reinterpret_cast<const char*>(&header.checksum), sizeof(header.checksum), transactionChecksum);
+    } else if (header.magic == CommitRecordMagic) {
+      generation = header.target;
+      committed = header.offset == recordCount && header.size == 0
+               && header.checksum == crc32(reinterpret_cast<const char*>(&generation), sizeof(generation), transactionChecksum);
+      break;
+    } else {
+      break;
+    }
+  }
+
+  if (!committed) {
+    qCWarning(SERIALIZATION) << "dropping incomplete transaction in" << m_file.fileName();
+    truncate();
+    return NothingReplayed;
+  }
+
+  if (generations && !generations->isCommitted(generation)) {
+    qCWarning(SERIALIZATION) << "dropping transaction of uncommitted generation" << generation << "in" << m_file.fileName();
+    truncate();
+    return NothingReplayed;
+  }
+
+  // Second pass: Write the records into the target files
+  m_file.seek(0);
+  for (uint a = 0; a < recordCount; ++a) {
+    m_file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    const QByteArray payload = m_file.read(header.size);
+
+    QFile* target = header.target == MainFile ? mainFile : dynamicFile;
+    if (!target->seek(header.offset) || target->write(payload) != payload.size()) {
+      qCWarning(SERIALIZATION) << "failed to apply journal to" << target->fileName();
+      return ReplayFailed;
+    }
+  }
+
+  // The journal may only be dropped once the data has safely reached the repository files
+  if (!syncToDisk(*mainFile) || !syncToDisk(*dynamicFile)) {
+    qCWarning(SERIALIZATION) << "failed to sync repository files of" << m_file.fileName();
+    return ReplayFailed;
+  }
+
+  truncate();
+  return Replayed;
+}
+
+bool ItemRepositoryJournal::Generations::isCommitted(uint generation) const
+{
+  // Transactions of repositories that are stored on their own are not tagged
+  return !generation || (generation <= committed && generation != pending && !abandoned.contains(generation));
+}
+
+uint ItemRepositoryJournal::Generations::next() const
+{
+  // Generations are handed out in increasing order, so the abandoned ones are sorted
+  uint last = qMax(committed, pending);
+  if (!abandoned.isEmpty()) {
+    last = qMax(last, abandoned.last());
+  }
+  return last + 1;
+}
+
+ItemRepositoryJournal::Generations ItemRepositoryJournal::generations(const QString& path)
+{
+  Generations generations;
+  QFile file(generationsFilePath(path));
+  if (file.open(QIODevice::ReadOnly)) {
+    QDataStream stream(&file);
+    stream >> generations.committed >> generations.pending >> generations.abandoned;
+    if (stream.status() != QDataStream::Ok) {
+      qCWarning(SERIALIZATION) << "failed to read" << file.fileName();
+      generations = {};
+    }
+  }
+  return generations;
+}
+
+bool ItemRepositoryJournal::setGenerations(const QString& path, const Generations& generations)
+{
+  QSaveFile file(generationsFilePath(path));
+  if (!file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  QDataStream stream(&file);
+  stream << generations.committed << generations.pending << generations.abandoned;
+  return file.commit();
+}
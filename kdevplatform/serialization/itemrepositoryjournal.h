@@ -0,0 +1,130 @@
+/*
+   Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KDEVPLATFORM_ITEMREPOSITORYJOURNAL_H
+#define KDEVPLATFORM_ITEMREPOSITORYJOURNAL_H
+
+#include <QFile>
+#include <QVector>
+
+#include "serializationexport.h"
+
+class QByteArray;
+
+namespace KDevelop {
+
+/**
+ * Append-only redo journal used by ItemRepository to store its data crash-safely.
+ *
+ * A store first appends every changed region of the repository files (buckets and meta-data)
+ * as a checksummed record to the journal, and finishes the transaction with a commit record.
+ * Only then the records are written into the repository files in place, and the journal is truncated.
+ *
+ * If the application crashes while the repository files are written, the committed transaction
+ * is replayed the next time the repository is opened. An incomplete transaction is dropped, in which
+ * case the repository files still contain the state of the last completed store.
+ *
+ * A transaction can be tagged with a nonzero generation, so that the ItemRepositoryRegistry can commit all
+ * of its repositories at once: such a transaction is only replayed if the registry has committed that
+ * generation, see Generations. Every store of the registry uses a new generation, so a transaction that was
+ * left behind in the journal of a repository that is only opened much later is never mistaken for a committed one.
+ */
+class KDEVPLATFORMSERIALIZATION_EXPORT ItemRepositoryJournal
+{
+  public:
+    enum Target {
+      MainFile = 0,
+      DynamicFile = 1
+    };
+
+    /// The generations used by the stores of all repositories at one path, written atomically by the registry.
+    struct KDEVPLATFORMSERIALIZATION_EXPORT Generations
+    {
+      /// The last generation committed by the registry
+      uint committed = 0;
+      /// The generation that is currently being stored, or zero. It counts as abandoned until it is committed.
+      uint pending = 0;
+      /// Generations whose store was never committed, their transactions must not be replayed
+      QVector<uint> abandoned;
+
+      /// @returns whether a transaction tagged with @p generation may be replayed
+      bool isCommitted(uint generation) const;
+
+      /// @returns a generation that has not been used by any store before
+      uint next() const;
+    };
+
+    ItemRepositoryJournal();
+    ~ItemRepositoryJournal();
+
+    /// Opens the journal at @p fileName, creating it if needed.
+    bool open(const QString& fileName);
+    void close();
+
+    /// Starts a new transaction. Anything that was still in the journal is dropped.
+    void begin();
+
+    /// Appends a record that writes @p data to @p target at @p offset once the transaction is applied.
+    /// @returns false if writing the journal failed, for example because the disk is full
+    bool addRecord(Target target, quint64 offset, const QByteArray& data);
+
+    /// Finishes the current transaction by appending a commit record tagged with @p generation,
+    /// and makes sure the journal has reached the disk.
+    bool commit(uint generation);
+
+    /// Drops the current transaction, for example because the registry could not commit its generation.
+    void discard();
+
+    /// Applies the committed transaction to @p mainFile and @p dynamicFile, and truncates the journal.
+    /// Both files must be opened for writing.
+    /// @returns false if the transaction could not be written into the files. It stays in the journal then,
+    ///          and must be applied again before a new transaction is started.
+    bool apply(QFile* mainFile, QFile* dynamicFile);
+
+    /// Like apply(), but used while opening a repository after a possible crash: a transaction tagged
+    /// with a nonzero generation is only replayed if @p generations marks it as committed,
+    /// and incomplete or corrupted transactions are dropped.
+    /// @returns whether anything was replayed
+    bool recover(QFile* mainFile, QFile* dynamicFile, const Generations& generations);
+
+    /// @returns the generations stored by the registry at @p path
+    static Generations generations(const QString& path);
+
+    /// Atomically replaces the generations stored for all repositories at @p path.
+    static bool setGenerations(const QString& path, const Generations& generations);
+
+  private:
+    enum ReplayResult {
+      NothingReplayed,
+      Replayed,
+      ReplayFailed
+    };
+
+    ReplayResult replay(QFile* mainFile, QFile* dynamicFile, const Generations* generations);
+    void truncate();
+
+    QFile m_file;
+    uint m_recordCount;
+    uint m_transactionChecksum;
+
+    Q_DISABLE_COPY(ItemRepositoryJournal)
+};
+
+}
+
+#endif // KDEVPLATFORM_ITEMREPOSITORYJOURNAL_H
@@ -29,6 +29,7 @@
 #include <util/shellutils.h>
 
 #include "abstractitemrepository.h"
+#include "itemrepositoryjournal.h"
 #include "debug.h"
 
 using namespace KDevelop;
@@ -325,8 +326,44 @@ bool ItemRepositoryRegistryPrivate::open(const QString& path)
 void ItemRepositoryRegistry::store()
 {
   QMutexLocker lock(&d->m_mutex);
-  foreach(AbstractItemRepository* repository, d->m_repositories.keys()) {
-    repository->store();
+
+  //The repositories reference each other, so they are committed together: First all changes are written
+  //into the journals, then their generation is committed atomically, and only then the repository files are touched.
+  //If we crash before the generation is committed, all repositories are recovered to the previous store.
+  //Every store uses a new generation, so the journal of a repository that is only opened in a later session
+  //can't be mistaken for the one of a later store.
+  auto generations = ItemRepositoryJournal::generations(d->m_path);
+  if(generations.pending) {
+    //We crashed while preparing that store
+    generations.abandoned.append(generations.pending);
+  }
+  const uint generation = generations.next();
+  generations.pending = generation;
+  if(!ItemRepositoryJournal::setGenerations(d->m_path, generations)) {
+    //The generation could be used again after a crash, so nothing may be journaled with it
+    qCWarning(SERIALIZATION) << "Could not reserve a generation for the repository journals, not storing";
+    return;
+  }
+
+  const auto repositories = d->m_repositories.keys();
+  foreach(AbstractItemRepository* repository, repositories) {
+    repository->prepareStore(generation);
+  }
+
+  generations.pending = 0;
+  generations.committed = generation;
+  if(!ItemRepositoryJournal::setGenerations(d->m_path, generations)) {
+    //Recovery would roll back to the previous store, so the repository files must not be touched.
+    //The generation stays pending, so it is abandoned by the next store.
+    qCWarning(SERIALIZATION) << "Could not commit the repository journals, discarding them";
+    foreach(AbstractItemRepository* repository, repositories) {
+      repository->discardStore();
+    }
+    return;
+  }
+
+  foreach(AbstractItemRepository* repository, repositories) {
+    repository->applyStore();
   }
 
   QFile versionFile(d->m_path + QStringLiteral("/version_%1").arg(staticItemRepositoryVersion()));
@@ -65,6 +65,8 @@ class KDEVPLATFORMSERIALIZATION_EXPORT ItemRepositoryRegistry {
     QString path() const;
 
     /// Stores all repositories to disk, eventually unloading unused data to save memory.
+    /// The repositories are committed together through their journals, so after a crash
+    /// they are recovered to the state of the last completed store.
     /// @note Should be called on a regular basis.
     void store();
 
@@ -81,6 +83,8 @@ class KDEVPLATFORMSERIALIZATION_EXPORT ItemRepositoryRegistry {
 
     /// Marks the directory as inconsistent, so it will be discarded
     /// on next startup if the application crashes during the write process.
+    /// @note Storing the repositories is crash-safe by itself, this is only needed
+    ///       while writing data that is not covered by their journals.
     void lockForWriting();
 
     /// Removes the inconsistency mark set by @ref lockForWriting().
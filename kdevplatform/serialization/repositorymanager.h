@@ -72,7 +72,11 @@ private:
       if(!m_repository) {
         m_repository = new ItemRepositoryType(m_name, &m_registry, m_version, const_cast<RepositoryManager*>(this));
         if(m_shareMutex) {
-          (*this)->setMutex(m_shareMutex()->repositoryMutex());
+          QMutex* mutex = m_shareMutex()->repositoryMutex();
+          Q_ASSERT_X(mutex, Q_FUNC_INFO, "the mutex of the shared repository cannot be shared");
+          if(mutex) {
+            (*this)->setMutex(mutex);
+          }
         }
         (*this)->setUnloadingEnabled(unloadingEnabled);
       }
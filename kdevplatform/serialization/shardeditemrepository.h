@@ -0,0 +1,280 @@
+/*
+   Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KDEVPLATFORM_SHARDEDITEMREPOSITORY_H
+#define KDEVPLATFORM_SHARDEDITEMREPOSITORY_H
+
+#include <QAtomicInt>
+
+#include "itemrepository.h"
+
+namespace KDevelop {
+
+/**
+ * An item-repository that is split up into 2^shardBits independent ItemRepository shards.
+ *
+ * Every item is placed into the shard selected by its hash, and each shard has its own mutex.
+ * That way threads that index different items rarely wait for each other, while a plain
+ * ItemRepository serializes all accesses behind one mutex.
+ *
+ * The shard number is stored in the highest bits of the index, so each shard can only use
+ * 2^(16-shardBits)-1 buckets. The index 0 and the indices starting with 0xffff____ are still
+ * never returned, so they can be used for own purposes just like with ItemRepository.
+ *
+ * The API mirrors ItemRepository. When threadSafe is false, the mutex of the shard that contains
+ * an item must be locked while accessing it, see mutexForIndex() and mutexForHash().
+ *
+ * @tparam shardBits The count of bits used for the shard number in an index
+ * @see ItemRepository for the other template parameters
+ */
+template<class Item, class ItemRequest, bool markForReferenceCounting = true, bool threadSafe = true, uint fixedItemSize = 0,
+         unsigned int targetBucketHashSize = 524288*2, uint shardBits = 4>
+class ShardedItemRepository : public AbstractItemRepository {
+
+  static_assert(shardBits > 0 && shardBits < 8, "shardBits must leave enough buckets for each shard");
+
+  typedef Locker<threadSafe> ThisLocker;
+
+  public:
+  enum {
+    ShardCount = 1 << shardBits,
+    ShardShift = 32 - shardBits,
+    //Leaves room for the shard number in the bucket part of the index, and keeps 0xffff free
+    BucketsPerShard = (1 << (16 - shardBits)) - 1
+  };
+
+  //The shards never lock by themselves, the locking is done by this class
+  typedef ItemRepository<Item, ItemRequest, markForReferenceCounting, false, fixedItemSize, targetBucketHashSize / ShardCount> Shard;
+
+  ///@see ItemRepository::ItemRepository
+  explicit ShardedItemRepository(const QString& repositoryName, ItemRepositoryRegistry* registry = &globalItemRepositoryRegistry(),
+                                 uint repositoryVersion = 1, AbstractRepositoryManager* manager = nullptr)
+    : m_repositoryName(repositoryName)
+    , m_registry(registry)
+  {
+    for(uint a = 0; a < ShardCount; ++a) {
+      //The shards are opened and stored through this repository, so they are not registered anywhere
+      m_shards[a] = new Shard(repositoryName + QLatin1Char('_') + QString::number(a), nullptr, repositoryVersion);
+      m_shards[a]->setBucketLimit(BucketsPerShard);
+    }
+    if(m_registry)
+      m_registry->registerRepository(this, manager);
+  }
+
+  ~ShardedItemRepository() override {
+    if(m_registry)
+      m_registry->unRegisterRepository(this);
+    close();
+    for(uint a = 0; a < ShardCount; ++a)
+      delete m_shards[a];
+  }
+
+  ///@see ItemRepository::setUnloadingEnabled
+  void setUnloadingEnabled(bool enabled) {
+    for(uint a = 0; a < ShardCount; ++a)
+      m_shards[a]->setUnloadingEnabled(enabled);
+  }
+
+  ///@see ItemRepository::index
+  unsigned int index(const ItemRequest& request) {
+    const uint shard = shardForHash(request.hash());
+    ThisLocker lock(m_shards[shard]->mutex());
+    return globalIndex(shard, m_shards[shard]->index(request));
+  }
+
+  ///@see ItemRepository::findIndex
+  unsigned int findIndex(const ItemRequest& request) {
+    const uint shard = shardForHash(request.hash());
+    ThisLocker lock(m_shards[shard]->mutex());
+    return globalIndex(shard, m_shards[shard]->findIndex(request));
+  }
+
+  ///@see ItemRepository::deleteItem
+  void deleteItem(unsigned int index) {
+    m_generation.ref();
+    Shard* shard = shardForIndex(index);
+    {
+      ThisLocker lock(shard->mutex());
+      shard->deleteItem(localIndex(index));
+    }
+    // a cache may have read the item after the first change, so it is invalidated again once the item is gone
+    m_generation.ref();
+  }
+
+  typedef typename Shard::MyDynamicItem MyDynamicItem;
+
+  ///@see ItemRepository::dynamicItemFromIndex
+  ///@warning Lock mutexForIndex() before calling, and hold it until you're ready using/changing the data.
+  MyDynamicItem dynamicItemFromIndex(unsigned int index) {
+    Shard* shard = shardForIndex(index);
+    ThisLocker lock(shard->mutex());
+    return shard->dynamicItemFromIndex(localIndex(index));
+  }
+
+  ///@see ItemRepository::dynamicItemFromIndexSimple
+  ///@warning Lock mutexForIndex() before calling, and hold it until you're ready using/changing the data.
+  Item* dynamicItemFromIndexSimple(unsigned int index) {
+    Shard* shard = shardForIndex(index);
+    ThisLocker lock(shard->mutex());
+    return shard->dynamicItemFromIndexSimple(localIndex(index));
+  }
+
+  ///@see ItemRepository::itemFromIndex
+  const Item* itemFromIndex(unsigned int index) const {
+    const Shard* shard = shardForIndex(index);
+    ThisLocker lock(shard->mutex());
+    return shard->itemFromIndex(localIndex(index));
+  }
+
+  ///@see ItemRepository::visitAllItems
+  template<class Visitor>
+  void visitAllItems(Visitor& visitor, bool onlyInMemory = false) const {
+    for(uint a = 0; a < ShardCount; ++a) {
+      ThisLocker lock(m_shards[a]->mutex());
+      m_shards[a]->visitAllItems(visitor, onlyInMemory);
+    }
+  }
+
+  ///@returns the mutex that protects the shard which contains the item with the given @p index
+  QMutex* mutexForIndex(unsigned int index) const {
+    return shardForIndex(index)->mutex();
+  }
+
+  ///@returns the mutex that protects the shard which contains, or will contain, items with the given @p hash
+  QMutex* mutexForHash(unsigned int hash) const {
+    return m_shards[shardForHash(hash)]->mutex();
+  }
+
+  ///Replaces the mutex of the given @p shard, for example with a non-recursive one to increase speed.
+  ///@see ItemRepository::setMutex
+  void setShardMutex(uint shard, QMutex* mutex) {
+    Q_ASSERT(shard < ShardCount);
+    m_shards[shard]->setMutex(mutex);
+  }
+
+  ///@returns a counter that changes whenever items may have been removed, so indices may have been reused.
+  ///Can be used to invalidate caches that map indices to the item data without locking any mutex.
+  uint generation() const {
+    return m_generation.loadAcquire();
+  }
+
+  ///@returns the count of items in all shards
+  uint totalItems() const {
+    uint ret = 0;
+    for(uint a = 0; a < ShardCount; ++a) {
+      ThisLocker lock(m_shards[a]->mutex());
+      ret += m_shards[a]->statistics().totalItems;
+    }
+    return ret;
+  }
+
+  void store() override {
+    for(uint a = 0; a < ShardCount; ++a)
+      m_shards[a]->store();
+  }
+
+  void prepareStore(uint generation) override {
+    for(uint a = 0; a < ShardCount; ++a)
+      m_shards[a]->prepareStore(generation);
+  }
+
+  void applyStore() override {
+    for(uint a = 0; a < ShardCount; ++a)
+      m_shards[a]->applyStore();
+  }
+
+  void discardStore() override {
+    for(uint a = 0; a < ShardCount; ++a)
+      m_shards[a]->discardStore();
+  }
+
+  QString repositoryName() const override {
+    return m_repositoryName;
+  }
+
+  QString printStatistics() const override {
+    QString ret;
+    for(uint a = 0; a < ShardCount; ++a) {
+      ret += QStringLiteral("shard %1:\n").arg(a);
+      ret += m_shards[a]->printStatistics();
+      ret += QLatin1Char('\n');
+    }
+    return ret;
+  }
+
+  private:
+  static uint shardForHash(uint hash) {
+    //Fibonacci hashing, so also short strings with small hash values are spread over all shards
+    return (hash * 2654435769u) >> ShardShift;
+  }
+
+  Shard* shardForIndex(uint index) const {
+    //The index must be valid, so it cannot start with 0xffff
+    Q_ASSERT(index && (index >> 16) != 0xffff);
+    return m_shards[index >> ShardShift];
+  }
+
+  static uint localIndex(uint index) {
+    return index & ((1u << ShardShift) - 1);
+  }
+
+  static uint globalIndex(uint shard, uint localIndex) {
+    Q_ASSERT(localIndex < (1u << ShardShift));
+    return localIndex ? ((shard << ShardShift) | localIndex) : 0;
+  }
+
+  // The generation changes before and after items are removed, see deleteItem()
+  bool open(const QString& path) override {
+    m_generation.ref();
+    for(uint a = 0; a < ShardCount; ++a) {
+      if(!m_shards[a]->open(path)) {
+        close();
+        return false;
+      }
+    }
+    m_generation.ref();
+    return true;
+  }
+
+  void close(bool doStore = false) override {
+    m_generation.ref();
+    for(uint a = 0; a < ShardCount; ++a)
+      m_shards[a]->close(doStore);
+    m_generation.ref();
+  }
+
+  int finalCleanup() override {
+    m_generation.ref();
+    int changed = 0;
+    for(uint a = 0; a < ShardCount; ++a) {
+      QMutexLocker lock(m_shards[a]->mutex());
+      changed += m_shards[a]->finalCleanup();
+    }
+    m_generation.ref();
+    return changed;
+  }
+
+  Shard* m_shards[ShardCount];
+  QString m_repositoryName;
+  ItemRepositoryRegistry* m_registry;
+  QAtomicInt m_generation;
+};
+
+}
+
+#endif // KDEVPLATFORM_SHARDEDITEMREPOSITORY_H
@@ -26,10 +26,22 @@
 #include <tests/autotestshell.h>
 
 #include <serialization/itemrepository.h>
+#include <serialization/itemrepositoryregistry.h>
+#include <serialization/shardeditemrepository.h>
 #include <serialization/indexedstring.h>
 
 #include <algorithm>
+#include <numeric>
+#include <QDir>
+#include <QFileInfo>
 #include <QTest>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
 
 QTEST_GUILESS_MAIN(TestItemRepository);
 
@@ -108,6 +120,7 @@ struct TestDataRepositoryItemRequest
 };
 
 typedef ItemRepository<TestData, TestDataRepositoryItemRequest, false, true> TestDataRepository;
+typedef ShardedItemRepository<TestData, TestDataRepositoryItemRequest, false, true> ShardedTestDataRepository;
 
 void TestItemRepository::initTestCase()
 {
@@ -221,3 +234,138 @@ void TestItemRepository::lookupValue()
   }
 }
 
+
+template<typename Repository>
+static void insertAndLookupConcurrently(const QVector<QByteArray>& data, int threads, Repository& repo)
+{
+  QVector<int> slices(threads);
+  std::iota(slices.begin(), slices.end(), 0);
+  QtConcurrent::blockingMap(slices, [&] (int slice) {
+    // every thread inserts its own items, and looks up all the others
+    for(int i = slice; i < data.size(); i += slices.size()) {
+      const QByteArray& item = data[i];
+      const uint index = repo.index(TestDataRepositoryItemRequest(item.constData(), item.length()));
+      repo.itemFromIndex(index);
+    }
+    for(const QByteArray& item : data) {
+      repo.findIndex(TestDataRepositoryItemRequest(item.constData(), item.length()));
+    }
+  });
+}
+
+void TestItemRepository::contention_data()
+{
+  QTest::addColumn<bool>("sharded");
+  QTest::addColumn<int>("threads");
+
+  const int maxThreads = qMax(2, QThread::idealThreadCount());
+  for(int threads = 1; threads <= maxThreads; threads *= 2) {
+    QTest::newRow(qPrintable(QStringLiteral("plain-%1").arg(threads))) << false << threads;
+    QTest::newRow(qPrintable(QStringLiteral("sharded-%1").arg(threads))) << true << threads;
+  }
+}
+
+void TestItemRepository::contention()
+{
+  QFETCH(bool, sharded);
+  QFETCH(int, threads);
+
+  QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+  QVector<QByteArray> data;
+  foreach(const QString& item, generateData()) {
+    data << item.toUtf8();
+  }
+
+  uint totalItems = 0;
+  if(sharded) {
+    ShardedTestDataRepository repo(QStringLiteral("TestDataRepositoryContentionSharded%1").arg(threads));
+    QBENCHMARK_ONCE {
+      insertAndLookupConcurrently(data, threads, repo);
+    }
+    totalItems = repo.totalItems();
+  } else {
+    TestDataRepository repo(QStringLiteral("TestDataRepositoryContentionPlain%1").arg(threads));
+    QBENCHMARK_ONCE {
+      insertAndLookupConcurrently(data, threads, repo);
+    }
+    totalItems = repo.statistics().totalItems;
+  }
+  QCOMPARE(totalItems, uint(data.size()));
+
+  QThreadPool::globalInstance()->setMaxThreadCount(QThread::idealThreadCount());
+}
+
+// Returns the space used by the file, which is smaller than its size if it contains holes
+static qint64 diskUsage(const QString& fileName)
+{
+#ifdef Q_OS_UNIX
+  struct stat info;
+  if(stat(QFile::encodeName(fileName).constData(), &info) == 0) {
+    return qint64(info.st_blocks) * 512;
+  }
+#endif
+  return QFileInfo(fileName).size();
+}
+
+// Creates a repository on disk, and returns the indices of its items
+static QVector<uint> createCompressionRepository(const QString& name, bool compressed)
+{
+  TestDataRepository repo(name);
+  repo.setCompressionEnabled(compressed);
+  QVector<uint> indices = insertData(generateData(), repo);
+  repo.store();
+
+  const QString fileName = QDir(globalItemRepositoryRegistry().path()).absoluteFilePath(name);
+  qDebug() << (compressed ? "compressed" : "raw") << "repository uses" << diskUsage(fileName) << "bytes on disk,"
+           << QFileInfo(fileName).size() << "bytes file size";
+  return indices;
+}
+
+void TestItemRepository::compressedLoad_data()
+{
+  QTest::addColumn<bool>("compressed");
+
+  QTest::newRow("raw") << false;
+  QTest::newRow("compressed") << true;
+}
+
+void TestItemRepository::compressedLoad()
+{
+  QFETCH(bool, compressed);
+
+  const QString name = QStringLiteral("TestDataRepositoryCompressedLoad%1").arg(compressed);
+  const QVector<uint> indices = createCompressionRepository(name, compressed);
+
+  // Cold load: every bucket is mapped or decompressed on first access
+  QBENCHMARK_ONCE {
+    TestDataRepository repo(name);
+    foreach(uint index, indices) {
+      repo.itemFromIndex(index);
+    }
+    QCOMPARE(repo.statistics().totalItems, uint(indices.size()));
+  }
+}
+
+void TestItemRepository::compressedLookup_data()
+{
+  compressedLoad_data();
+}
+
+void TestItemRepository::compressedLookup()
+{
+  QFETCH(bool, compressed);
+
+  const QString name = QStringLiteral("TestDataRepositoryCompressedLookup%1").arg(compressed);
+  QVector<uint> indices = createCompressionRepository(name, compressed);
+
+  TestDataRepository repo(name);
+  srand(0);
+  std::random_shuffle(indices.begin(), indices.end());
+  // Warm access: all buckets stay loaded, so this should not depend on the compression
+  QBENCHMARK {
+    foreach(uint index, indices) {
+      repo.itemFromIndex(index);
+    }
+  }
+}
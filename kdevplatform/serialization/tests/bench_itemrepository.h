@@ -36,6 +36,12 @@ private Q_SLOTS:
     void removeDisk();
     void lookupKey();
     void lookupValue();
+    void contention_data();
+    void contention();
+    void compressedLoad_data();
+    void compressedLoad();
+    void compressedLookup_data();
+    void compressedLookup();
 };
 
 #endif // TESTITEMREPOSITORY_H
@@ -27,7 +27,11 @@
 #include <language/util/kdevhash.h>
 #include <serialization/indexedstring.h>
 #include <QTest>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentMap>
 
+#include <numeric>
 #include <utility>
 
 QTEST_GUILESS_MAIN(TestIndexedString);
@@ -126,6 +130,51 @@ void TestIndexedString::bench_qstring()
   }
 }
 
+void TestIndexedString::bench_qstringThreaded_data()
+{
+  QTest::addColumn<bool>("cached");
+  QTest::addColumn<int>("threads");
+
+  const int maxThreads = qMax(2, QThread::idealThreadCount());
+  for(int threads = 1; threads <= maxThreads; threads *= 2) {
+    QTest::newRow(qPrintable(QStringLiteral("locked-%1").arg(threads))) << false << threads;
+    QTest::newRow(qPrintable(QStringLiteral("cached-%1").arg(threads))) << true << threads;
+  }
+}
+
+void TestIndexedString::bench_qstringThreaded()
+{
+  QFETCH(bool, cached);
+  QFETCH(int, threads);
+
+  // decode a working set of hot strings many times, as done by completion and the project model
+  QVector<uint> indices = setupTest().mid(0, 1000);
+  QVector<IndexedString> strings;
+  foreach(uint index, indices) {
+    strings << IndexedString::fromIndex(index);
+  }
+  QVector<int> slices(threads);
+  std::iota(slices.begin(), slices.end(), 0);
+  QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+  QBENCHMARK {
+    QtConcurrent::blockingMap(slices, [&] (int) {
+      for(int i = 0; i < 100; ++i) {
+        foreach(const IndexedString& str, strings) {
+          if (cached) {
+            str.str();
+          } else {
+            // c_str() always locks the repository
+            QString::fromUtf8(str.c_str(), str.length());
+          }
+        }
+      }
+    });
+  }
+
+  QThreadPool::globalInstance()->setMaxThreadCount(QThread::idealThreadCount());
+}
+
 void TestIndexedString::bench_kurl()
 {
   QVector<uint> indices = setupTest();
@@ -37,6 +37,8 @@ private Q_SLOTS:
     void bench_index();
     void bench_length();
     void bench_qstring();
+    void bench_qstringThreaded_data();
+    void bench_qstringThreaded();
     void bench_kurl();
     void bench_qhashQString();
     void bench_qhashIndexedString();
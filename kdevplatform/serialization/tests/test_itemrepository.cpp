@@ -1,4 +1,5 @@
 #include <QObject>
+#include <QTemporaryDir>
 #include <QTest>
 #include <serialization/itemrepository.h>
 #include <serialization/indexedstring.h>
@@ -254,6 +255,145 @@ class TestItemRepository : public QObject {
       QVERIFY(!repository.findIndex(TestItemRequest(*monsterItem, true)));
       repository.deleteItem(smallIndex);
     }
+    void recoverFromJournal_data()
+    {
+      QTest::addColumn<uint>("generation");
+      QTest::addColumn<uint>("committed");
+      QTest::addColumn<uint>("abandoned");
+      QTest::addColumn<bool>("recovered");
+
+      QTest::newRow("standalone") << 0u << 0u << 0u << true;
+      QTest::newRow("committed-generation") << 1u << 1u << 0u << true;
+      QTest::newRow("uncommitted-generation") << 1u << 0u << 0u << false;
+      // The store crashed before committing, and a later store was committed
+      QTest::newRow("abandoned-generation") << 1u << 2u << 1u << false;
+    }
+    void recoverFromJournal()
+    {
+      QFETCH(uint, generation);
+      QFETCH(uint, committed);
+      QFETCH(uint, abandoned);
+      QFETCH(bool, recovered);
+
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+      QScopedArrayPointer<TestItem> item(createItem(4711, 100));
+      uint index = 0;
+
+      {
+        KDevelop::ItemRepository<TestItem, TestItemRequest> repository(QStringLiteral("JournalRecovery"), nullptr);
+        QVERIFY(repository.open(dir.path()));
+        index = repository.index(TestItemRequest(*item, true));
+        QVERIFY(index);
+        // Simulate a crash after the journal has been written, but before it has been applied:
+        // The repository is closed without storing
+        repository.prepareStore(generation);
+        KDevelop::ItemRepositoryJournal::Generations generations;
+        generations.committed = committed;
+        if (abandoned) {
+          generations.abandoned << abandoned;
+        }
+        QVERIFY(KDevelop::ItemRepositoryJournal::setGenerations(dir.path(), generations));
+      }
+
+      KDevelop::ItemRepository<TestItem, TestItemRequest> repository(QStringLiteral("JournalRecovery"), nullptr);
+      QVERIFY(repository.open(dir.path()));
+      QCOMPARE(repository.findIndex(TestItemRequest(*item, true)), recovered ? index : 0u);
+    }
+    void nextGeneration()
+    {
+      KDevelop::ItemRepositoryJournal::Generations generations;
+      QCOMPARE(generations.next(), 1u);
+      generations.committed = 2;
+      generations.abandoned << 3;
+      QCOMPARE(generations.next(), 4u);
+      generations.pending = 4;
+      QCOMPARE(generations.next(), 5u);
+      QVERIFY(generations.isCommitted(2));
+      QVERIFY(!generations.isCommitted(3));
+      QVERIFY(!generations.isCommitted(4));
+    }
+    void keepUnappliedJournal()
+    {
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+      const QByteArray data("0123456789");
+
+      KDevelop::ItemRepositoryJournal journal;
+      QVERIFY(journal.open(dir.filePath(QStringLiteral("journal"))));
+      journal.begin();
+      QVERIFY(journal.addRecord(KDevelop::ItemRepositoryJournal::MainFile, 4, data));
+      QVERIFY(journal.commit(1));
+
+      QFile mainFile(dir.filePath(QStringLiteral("main")));
+      QFile dynamicFile(dir.filePath(QStringLiteral("dynamic")));
+      QVERIFY(mainFile.open(QIODevice::WriteOnly));
+      mainFile.close();
+      QVERIFY(mainFile.open(QIODevice::ReadOnly));
+      QVERIFY(dynamicFile.open(QIODevice::ReadWrite));
+      QVERIFY(!journal.apply(&mainFile, &dynamicFile));
+
+      // The committed transaction must still be there
+      mainFile.close();
+      QVERIFY(mainFile.open(QIODevice::ReadWrite));
+      QVERIFY(journal.apply(&mainFile, &dynamicFile));
+      QVERIFY(mainFile.seek(4));
+      QCOMPARE(mainFile.read(data.size()), data);
+    }
+    void discardStore()
+    {
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+      QScopedArrayPointer<TestItem> item(createItem(4711, 100));
+      uint index = 0;
+
+      {
+        KDevelop::ItemRepository<TestItem, TestItemRequest> repository(QStringLiteral("DiscardStore"), nullptr);
+        QVERIFY(repository.open(dir.path()));
+        index = repository.index(TestItemRequest(*item, true));
+        QVERIFY(index);
+        // The registry failed to commit the generation, the changes must be stored again by the next store
+        repository.prepareStore(1);
+        repository.discardStore();
+        repository.store();
+      }
+
+      KDevelop::ItemRepository<TestItem, TestItemRequest> repository(QStringLiteral("DiscardStore"), nullptr);
+      QVERIFY(repository.open(dir.path()));
+      QCOMPARE(repository.findIndex(TestItemRequest(*item, true)), index);
+    }
+    void loadCompressedBuckets()
+    {
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+      // Includes a monster-bucket
+      QList<TestItem*> items;
+      items << createItem(1, KDevelop::ItemRepositoryBucketSize + 10);
+      for(uint a = 2; a < 100; ++a) {
+        items << createItem(a, 200);
+      }
+      QVector<uint> indices;
+
+      {
+        KDevelop::ItemRepository<TestItem, TestItemRequest> repository(QStringLiteral("CompressedBuckets"), nullptr);
+        repository.setCompressionEnabled(true);
+        QVERIFY(repository.open(dir.path()));
+        foreach(auto item, items) {
+          indices << repository.index(TestItemRequest(*item, true));
+        }
+        repository.close(true);
+      }
+
+      KDevelop::ItemRepository<TestItem, TestItemRequest> repository(QStringLiteral("CompressedBuckets"), nullptr);
+      QVERIFY(repository.open(dir.path()));
+      for(int a = 0; a < items.size(); ++a) {
+        QCOMPARE(repository.findIndex(TestItemRequest(*items[a], true)), indices[a]);
+        QVERIFY(items[a]->equals(repository.itemFromIndex(indices[a])));
+      }
+      foreach(auto item, items) {
+        delete[] item;
+      }
+    }
     void usePermissiveModuloWhenRemovingClashLinks()
     {
       KDevelop::ItemRepository<TestItem, TestItemRequest> repository(QStringLiteral("PermissiveModulo"));
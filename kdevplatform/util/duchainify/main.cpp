@@ -267,6 +267,14 @@ QSet< QUrl > Manager::waiting()
 void Manager::finish()
 {
     std::cerr << "ready" << std::endl;
+    if (m_args->isSet(QStringLiteral("dump-lock-statistics"))) {
+        QTextStream stream(stdout);
+        DUChain::lock()->dumpStatistics(stream);
+    }
+    if (m_args->isSet(QStringLiteral("dump-parse-timings"))) {
+        QTextStream stream(stdout);
+        ICore::self()->languageController()->backgroundParser()->dumpParseTimings(stream);
+    }
     QApplication::quit();
 }
 
@@ -303,6 +311,8 @@ int main(int argc, char** argv)
     parser.addOption(QCommandLineOption{QStringList{QStringLiteral("dump-graph")}, i18n("Dump DUChain graph (in .dot format)")});
     parser.addOption(QCommandLineOption{QStringList{QStringLiteral("d"), QStringLiteral("dump-errors")}, i18n("Print problems encountered during parsing")});
     parser.addOption(QCommandLineOption{QStringList{QStringLiteral("dump-imported-errors")}, i18n("Recursively dump errors from imported contexts.")});
+    parser.addOption(QCommandLineOption{QStringList{QStringLiteral("dump-lock-statistics")}, i18n("Print how often the DUChain lock was acquired, and histograms of its wait and hold times when finished")});
+    parser.addOption(QCommandLineOption{QStringList{QStringLiteral("dump-parse-timings")}, i18n("Print the longest parse jobs and the critical path through the parsed files when finished")});
 
     parser.process(app);
 
@@ -24,11 +24,39 @@
 
 #include <QStringList>
 #include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QVarLengthArray>
 
 #include <language/util/kdevhash.h>
 
+#include <algorithm>
+
 using namespace KDevelop;
 
+namespace KDevelop {
+
+/**
+ * The last segment of an interned path.
+ *
+ * Nodes never change after they have been created, except for their reference count.
+ * Each node holds a reference to its parent node.
+ */
+struct PathNode
+{
+    QAtomicInt ref;
+    // count of segments up to and including this one, including the remote URL prefix
+    int size;
+    // whether the first segment is a remote URL prefix
+    bool remote;
+    // same as qHash() of the path
+    uint hash;
+    PathNode* parent;
+    QString segment;
+};
+
+}
+
 namespace {
 
 inline bool isWindowsDriveLetter(const QString& segment)
@@ -54,6 +82,155 @@ inline bool isAbsolutePath(const QString& path)
 #endif
 }
 
+inline bool isDotSegment(const QString& segment)
+{
+    return segment == QLatin1String(".") || segment == QLatin1String("..");
+}
+
+inline uint childHash(const PathNode* parent, const QString& segment)
+{
+    return KDevHash::hash_combine(parent ? parent->hash : uint(KDevHash::DEFAULT_SEED), qHash(segment));
+}
+
+struct NodeKey
+{
+    const PathNode* parent;
+    QString segment;
+
+    bool operator==(const NodeKey& other) const
+    {
+        return parent == other.parent && segment == other.segment;
+    }
+};
+
+inline uint qHash(const NodeKey& key)
+{
+    return childHash(key.parent, key.segment);
+}
+
+/**
+ * Owns all path nodes, so equal paths share the same node.
+ *
+ * References to existing nodes are only taken while the mutex is locked, so a node whose
+ * reference count drops to zero can be removed while holding the lock.
+ */
+struct PathNodeRegistry
+{
+    QMutex mutex;
+    QHash<NodeKey, PathNode*> nodes;
+};
+
+Q_GLOBAL_STATIC(PathNodeRegistry, registry)
+
+using NodeChain = QVarLengthArray<const PathNode*, 32>;
+
+/// @return all nodes of the path ending in @p node, starting with the first segment
+NodeChain chain(const PathNode* node)
+{
+    NodeChain ret;
+    if (node) {
+        ret.resize(node->size);
+        for (; node; node = node->parent) {
+            ret[node->size - 1] = node;
+        }
+    }
+    return ret;
+}
+
+/// @return the node of the first @p size segments of the path ending in @p node
+PathNode* ancestor(PathNode* node, int size)
+{
+    while (node->size > size) {
+        node = node->parent;
+    }
+    return node;
+}
+
+inline void acquire(PathNode* node)
+{
+    if (node) {
+        node->ref.ref();
+    }
+}
+
+void release(PathNode* node)
+{
+    if (!node) {
+        return;
+    }
+
+    int count = node->ref.load();
+    while (count > 1) {
+        if (node->ref.testAndSetOrdered(count, count - 1)) {
+            return;
+        }
+        count = node->ref.load();
+    }
+
+    // this may be the last reference
+    auto* nodes = registry();
+    if (!nodes) {
+        // the registry is gone during shutdown, leak the remaining nodes
+        node->ref.deref();
+        return;
+    }
+    QMutexLocker lock(&nodes->mutex);
+    while (node && !node->ref.deref()) {
+        PathNode* parent = node->parent;
+        nodes->nodes.remove({parent, node->segment});
+        delete node;
+        node = parent;
+    }
+}
+
+/// @return a new reference to the child of @p parent with the given @p segment, the registry must be locked
+PathNode* childNode(PathNodeRegistry* nodes, PathNode* parent, const QString& segment)
+{
+    if (nodes) {
+        const auto it = nodes->nodes.constFind({parent, segment});
+        if (it != nodes->nodes.constEnd()) {
+            (*it)->ref.ref();
+            return *it;
+        }
+    }
+
+    auto* node = new PathNode;
+    node->ref.store(1);
+    node->size = parent ? parent->size + 1 : 1;
+    // if the first segment contains a '/' it is a Path prefix
+    node->remote = parent ? parent->remote : segment.contains(QLatin1Char('/'));
+    node->hash = childHash(parent, segment);
+    node->parent = parent;
+    node->segment = segment;
+    acquire(parent);
+    if (nodes) {
+        nodes->nodes.insert({parent, node->segment}, node);
+    }
+    return node;
+}
+
+/// @return a new reference to the node of the path @p base followed by the segments in [ @p begin, @p end )
+PathNode* appendNodes(PathNode* base, const QString* begin, const QString* end)
+{
+    if (begin == end) {
+        acquire(base);
+        return base;
+    }
+
+    auto* nodes = registry();
+    QMutexLocker lock(nodes ? &nodes->mutex : nullptr);
+    PathNode* node = base;
+    for (auto it = begin; it != end; ++it) {
+        PathNode* child = childNode(nodes, node, *it);
+        if (node != base) {
+            // the child keeps its parent alive
+            node->ref.deref();
+        }
+        node = child;
+    }
+    return node;
+}
+
 }
 
 QString KDevelop::toUrlOrLocalFile(const QUrl& url, QUrl::FormattingOptions options)
@@ -68,11 +245,18 @@ QString KDevelop::toUrlOrLocalFile(const QUrl& url, QUrl::FormattingOptions opti
     return str;
 }
 
+static void addPathSegments(QVector<QString>* data, const QString& path);
+
 Path::Path()
 {
 
 }
 
+Path::Path(PathNode* node)
+    : m_node(node)
+{
+}
+
 Path::Path(const QString& pathOrUrl)
     : Path(QUrl::fromUserInput(pathOrUrl, QString(), QUrl::DefaultResolution))
 {
@@ -96,6 +280,7 @@ Path::Path(const QUrl& url)
         return;
     }
 
+    QVector<QString> data;
     if (!url.isLocalFile()) {
         // handle remote urls
         QString urlPrefix;
@@ -110,24 +295,34 @@ Path::Path(const QUrl& url)
         if (url.port() != -1) {
             urlPrefix += QLatin1Char(':') + QString::number(url.port());
         }
-        m_data << urlPrefix;
+        data << urlPrefix;
     }
 
-    addPath(url.isLocalFile() ? url.toLocalFile() : url.path());
+    addPathSegments(&data, url.isLocalFile() ? url.toLocalFile() : url.path());
 
     // support for root paths, they are valid but don't really contain any data
-    if (m_data.isEmpty() || (isRemote() && m_data.size() == 1)) {
-        m_data << QString();
+    if (data.isEmpty() || (!url.isLocalFile() && data.size() == 1)) {
+        data << QString();
     }
+
+    setSegments(data);
 }
 
 Path::Path(const Path& other, const QString& child)
-: m_data(other.m_data)
+: m_node(other.m_node)
 {
+    acquire(m_node);
+    if (child.isEmpty()) {
+        return;
+    }
+
     if (isAbsolutePath(child)) {
         // absolute path: only share the remote part of @p other
-        m_data.resize(isRemote() ? 1 : 0);
-    } else if (!other.isValid() && !child.isEmpty()) {
+        PathNode* prefix = isRemote() ? ancestor(m_node, 1) : nullptr;
+        acquire(prefix);
+        release(m_node);
+        m_node = prefix;
+    } else if (!other.isValid()) {
         qWarning("Path::Path: tried to append relative path \"%s\" to invalid base",
                  qPrintable(child));
         return;
@@ -135,7 +330,41 @@ Path::Path(const Path& other, const QString& child)
     addPath(child);
 }
 
-static QString generatePathOrUrl(bool onlyPath, bool isLocalFile, const QVector<QString>& data)
+Path::Path(Path&& other) noexcept
+    : m_node(other.m_node)
+{
+    other.m_node = nullptr;
+}
+
+Path::~Path()
+{
+    release(m_node);
+}
+
+Path& Path::operator=(const Path& other)
+{
+    if (m_node != other.m_node) {
+        acquire(other.m_node);
+        release(m_node);
+        m_node = other.m_node;
+    }
+    return *this;
+}
+
+Path& Path::operator=(Path&& other) noexcept
+{
+    qSwap(m_node, other.m_node);
+    return *this;
+}
+
+void Path::setSegments(const QVector<QString>& segments)
+{
+    PathNode* node = appendNodes(nullptr, segments.constData(), segments.constData() + segments.size());
+    release(m_node);
+    m_node = node;
+}
+
+static QString generatePathOrUrl(bool onlyPath, bool isLocalFile, const NodeChain& data)
 {
     // more or less a copy of QtPrivate::QStringList_join
     const int size = data.size();
@@ -153,7 +382,7 @@ static QString generatePathOrUrl(bool onlyPath, bool isLocalFile, const QVector<
 
     // path and url prefix
     for (int i = start; i < size; ++i) {
-        totalLength += data.at(i).size();
+        totalLength += data.at(i)->segment.size();
     }
 
     // build string representation
@@ -162,8 +391,8 @@ static QString generatePathOrUrl(bool onlyPath, bool isLocalFile, const QVector<
 
 #ifdef Q_OS_WIN
     if (start == 0 && isLocalFile) {
-        Q_ASSERT(data.at(0).endsWith(QLatin1Char(':'))); // assume something along "C:"
-        res += data.at(0);
+        Q_ASSERT(data.at(0)->segment.endsWith(QLatin1Char(':'))); // assume something along "C:"
+        res += data.at(0)->segment;
         start++;
     }
 #endif
@@ -173,7 +402,7 @@ static QString generatePathOrUrl(bool onlyPath, bool isLocalFile, const QVector<
             res += QLatin1Char('/');
         }
 
-        res += data.at(i);
+        res += data.at(i)->segment;
     }
 
     return res;
@@ -181,12 +410,12 @@ static QString generatePathOrUrl(bool onlyPath, bool isLocalFile, const QVector<
 
 QString Path::pathOrUrl() const
 {
-    return generatePathOrUrl(false, isLocalFile(), m_data);
+    return generatePathOrUrl(false, isLocalFile(), chain(m_node));
 }
 
 QString Path::path() const
 {
-    return generatePathOrUrl(true, isLocalFile(), m_data);
+    return generatePathOrUrl(true, isLocalFile(), chain(m_node));
 }
 
 QString Path::toLocalFile() const
@@ -208,26 +437,29 @@ QString Path::relativePath(const Path& path) const
     // so instead, do it on our own based on _relativePath in kurl.cpp
     // this should also be more performant I think
 
-    // Find where they meet
+    const NodeChain data = chain(m_node);
+    const NodeChain pathData = chain(path.m_node);
+
+    // Find where they meet, equal nodes have equal segments and parents
     int level = isRemote() ? 1 : 0;
-    const int maxLevel = qMin(m_data.count(), path.m_data.count());
-    while(level < maxLevel && m_data.at(level) == path.m_data.at(level)) {
+    const int maxLevel = qMin(data.size(), pathData.size());
+    while(level < maxLevel && data.at(level) == pathData.at(level)) {
         ++level;
     }
 
     // Need to go down out of our path to the common branch.
     // but keep in mind that e.g. '/' paths have an empty name
-    int backwardSegments = m_data.count() - level;
-    if (backwardSegments && level < maxLevel && m_data.at(level).isEmpty()) {
+    int backwardSegments = data.size() - level;
+    if (backwardSegments && level < maxLevel && data.at(level)->segment.isEmpty()) {
         --backwardSegments;
     }
 
     // Now up up from the common branch to the second path.
     int forwardSegmentsLength = 0;
-    for (int i = level; i < path.m_data.count(); ++i) {
-        forwardSegmentsLength += path.m_data.at(i).length();
+    for (int i = level; i < pathData.size(); ++i) {
+        forwardSegmentsLength += pathData.at(i)->segment.length();
         // slashes
-        if (i + 1 != path.m_data.count()) {
+        if (i + 1 != pathData.size()) {
             forwardSegmentsLength += 1;
         }
     }
@@ -237,9 +469,9 @@ QString Path::relativePath(const Path& path) const
     for(int i = 0; i < backwardSegments; ++i) {
         relativePath.append(QLatin1String("../"));
     }
-    for (int i = level; i < path.m_data.count(); ++i) {
-        relativePath.append(path.m_data.at(i));
-        if (i + 1 != path.m_data.count()) {
+    for (int i = level; i < pathData.size(); ++i) {
+        relativePath.append(pathData.at(i)->segment);
+        if (i + 1 != pathData.size()) {
             relativePath.append(QLatin1Char('/'));
         }
     }
@@ -248,56 +480,74 @@ QString Path::relativePath(const Path& path) const
     return relativePath;
 }
 
-static bool isParentPath(const QVector<QString>& parent, const QVector<QString>& child, bool direct)
+static bool isParentPath(PathNode* parent, PathNode* child, bool direct)
 {
-    if (direct && child.size() != parent.size() + 1) {
+    if (direct && child->size != parent->size + 1) {
         return false;
-    } else if (!direct && child.size() <= parent.size()) {
+    } else if (!direct && child->size <= parent->size) {
         return false;
     }
-    for (int i = 0; i < parent.size(); ++i) {
-        if (child.at(i) != parent.at(i)) {
-            // support for trailing '/'
-            if (i + 1 == parent.size() && parent.at(i).isEmpty()) {
-                return true;
-            }
-            // otherwise we take a different branch here
-            return false;
-        }
+    const PathNode* node = ancestor(child, parent->size);
+    if (node == parent) {
+        return true;
     }
-    return true;
+    // support for trailing '/': the paths only differ in the last, empty segment of @p parent
+    return node->parent == parent->parent && parent->segment.isEmpty();
 }
 
 bool Path::isParentOf(const Path& path) const
 {
-    if (!isValid() || !path.isValid() || remotePrefix() != path.remotePrefix()) {
+    // different remote prefixes are sorted out by isParentPath
+    if (!isValid() || !path.isValid() || isRemote() != path.isRemote()) {
         return false;
     }
-    return isParentPath(m_data, path.m_data, false);
+    return isParentPath(m_node, path.m_node, false);
 }
 
 bool Path::isDirectParentOf(const Path& path) const
 {
-    if (!isValid() || !path.isValid() || remotePrefix() != path.remotePrefix()) {
+    if (!isValid() || !path.isValid() || isRemote() != path.isRemote()) {
         return false;
     }
-    return isParentPath(m_data, path.m_data, true);
+    return isParentPath(m_node, path.m_node, true);
 }
 
 QString Path::remotePrefix() const
 {
-    return isRemote() ? m_data.first() : QString();
+    return isRemote() ? ancestor(m_node, 1)->segment : QString();
+}
+
+QVector<QString> Path::segments() const
+{
+    QVector<QString> ret;
+    if (m_node) {
+        ret.resize(m_node->size);
+        for (const PathNode* node = m_node; node; node = node->parent) {
+            ret[node->size - 1] = node->segment;
+        }
+    }
+    return ret;
 }
 
 bool Path::operator<(const Path& other) const
 {
-    const int size = m_data.size();
-    const int otherSize = other.m_data.size();
+    if (m_node == other.m_node) {
+        return false;
+    }
+
+    const NodeChain data = chain(m_node);
+    const NodeChain otherData = chain(other.m_node);
+    const int size = data.size();
+    const int otherSize = otherData.size();
     const int toCompare = qMin(size, otherSize);
 
     // compare each Path segment in turn and try to return early
     for (int i = 0; i < toCompare; ++i) {
-        int comparison = m_data.at(i).compare(other.m_data.at(i));
+        if (data.at(i) == otherData.at(i)) {
+            // same node, try next segment
+            continue;
+        }
+        int comparison = data.at(i)->segment.compare(otherData.at(i)->segment);
         if (comparison == 0) {
             // equal, try next segment
             continue;
@@ -318,34 +568,36 @@ QUrl Path::toUrl() const
 
 bool Path::isLocalFile() const
 {
-    // if the first data element contains a '/' it is a Path prefix
-    return !m_data.isEmpty() && !m_data.first().contains(QLatin1Char('/'));
+    return m_node && !m_node->remote;
 }
 
 bool Path::isRemote() const
 {
-    return !m_data.isEmpty() && m_data.first().contains(QLatin1Char('/'));
+    return m_node && m_node->remote;
 }
 
 QString Path::lastPathSegment() const
 {
     // remote Paths are offset by one, thus never return the first item of them as file name
-    if (m_data.isEmpty() || (!isLocalFile() && m_data.size() == 1)) {
+    if (!m_node || (isRemote() && m_node->size == 1)) {
         return QString();
     }
-    return m_data.last();
+    return m_node->segment;
 }
 
 void Path::setLastPathSegment(const QString& name)
 {
+    PathNode* node;
     // remote Paths are offset by one, thus never return the first item of them as file name
-    if (m_data.isEmpty() || (!isLocalFile() && m_data.size() == 1)) {
+    if (!m_node || (isRemote() && m_node->size == 1)) {
         // append the name to empty Paths or remote Paths only containing the Path prefix
-        m_data.append(name);
+        node = appendNodes(m_node, &name, &name + 1);
     } else {
         // overwrite the last data member
-        m_data.last() = name;
+        node = appendNodes(m_node->parent, &name, &name + 1);
     }
+    release(m_node);
+    m_node = node;
 }
 
 static void cleanPath(QVector<QString>* data, const bool isRemote)
@@ -397,61 +649,98 @@ static QVarLengthArray<QString, 16> splitPath(const QString &source)
     return list;
 }
 
-void Path::addPath(const QString& path)
+static void addPathSegments(QVector<QString>* data, const QVarLengthArray<QString, 16>& newData)
 {
-    if (path.isEmpty()) {
-        return;
-    }
+    // if the first data element contains a '/' it is a Path prefix
+    const bool isRemote = !data->isEmpty() && data->first().contains(QLatin1Char('/'));
 
-    const auto& newData = splitPath(path);
     if (newData.isEmpty()) {
-        if (m_data.size() == (isRemote() ? 1 : 0)) {
+        if (data->size() == (isRemote ? 1 : 0)) {
             // this represents the root path, we just turned an invalid path into it
-            m_data << QString();
+            *data << QString();
         }
         return;
     }
 
     auto it = newData.begin();
-    if (!m_data.isEmpty() && m_data.last().isEmpty()) {
+    if (!data->isEmpty() && data->last().isEmpty()) {
         // the root item is empty, set its contents and continue appending
-        m_data.last() = *it;
+        data->last() = *it;
         ++it;
     }
 
-    std::copy(it, newData.end(), std::back_inserter(m_data));
-    cleanPath(&m_data, isRemote());
+    std::copy(it, newData.end(), std::back_inserter(*data));
+    cleanPath(data, isRemote);
+}
+
+static void addPathSegments(QVector<QString>* data, const QString& path)
+{
+    if (path.isEmpty()) {
+        return;
+    }
+
+    addPathSegments(data, splitPath(path));
+}
+
+void Path::addPath(const QString& path)
+{
+    if (path.isEmpty()) {
+        return;
+    }
+
+    const auto& newData = splitPath(path);
+
+    // "." and ".." need to be cleaned up, which is only possible for the new segments and,
+    // after setLastPathSegment(), for the last one. Otherwise just append the new nodes.
+    if (!newData.isEmpty() && !(m_node && isDotSegment(m_node->segment))
+        && std::none_of(newData.begin(), newData.end(), isDotSegment))
+    {
+        PathNode* base = m_node;
+        if (base && base->segment.isEmpty()) {
+            // the root item is empty, set its contents and continue appending
+            base = base->parent;
+        }
+        PathNode* node = appendNodes(base, newData.constData(), newData.constData() + newData.size());
+        release(m_node);
+        m_node = node;
+        return;
+    }
+
+    QVector<QString> data = segments();
+    addPathSegments(&data, newData);
+    setSegments(data);
 }
 
 Path Path::parent() const
 {
-    if (m_data.isEmpty()) {
+    if (!m_node) {
         return Path();
     }
 
-    Path ret(*this);
-    if (m_data.size() == (1 + (isRemote() ? 1 : 0))) {
+    if (m_node->size == (1 + (isRemote() ? 1 : 0))) {
         // keep the root item, but clear it, otherwise we'd make the path invalid
         // or a URL a local path
-        auto& root = ret.m_data.last();
-        if (!isWindowsDriveLetter(root)) {
-            root.clear();
+        if (isWindowsDriveLetter(m_node->segment)) {
+            return *this;
         }
-    } else {
-        ret.m_data.pop_back();
+        const QString root;
+        return Path(appendNodes(m_node->parent, &root, &root + 1));
     }
-    return ret;
+
+    acquire(m_node->parent);
+    return Path(m_node->parent);
 }
 
 bool Path::hasParent() const
 {
     const int rootIdx = isRemote() ? 1 : 0;
-    return m_data.size() > rootIdx && !m_data[rootIdx].isEmpty();
+    return m_node && m_node->size > rootIdx && !ancestor(m_node, rootIdx + 1)->segment.isEmpty();
 }
 
 void Path::clear()
 {
-    m_data.clear();
+    release(m_node);
+    m_node = nullptr;
 }
 
 Path Path::cd(const QString& dir) const
@@ -465,11 +754,7 @@ Path Path::cd(const QString& dir) const
 namespace KDevelop {
 uint qHash(const Path& path)
 {
-    KDevHash hash;
-    foreach (const QString& segment, path.segments()) {
-        hash << qHash(segment);
-    }
-    return hash;
+    return path.m_node ? path.m_node->hash : uint(KDevHash::DEFAULT_SEED);
 }
 
 template<typename Container>
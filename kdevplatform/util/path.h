@@ -31,6 +31,8 @@
 
 namespace KDevelop {
 
+struct PathNode;
+
 /**
  * @return Return a string representation of @p url, if possible as local file
  *
@@ -62,13 +64,18 @@ QString KDEVPLATFORMUTIL_EXPORT toUrlOrLocalFile(const QUrl& url, QUrl::Formatti
  * Path asdf(foo, "asdf.txt");
  * @endcode
  *
- * @note Just as with QString e.g. you won't share any data implicitly when
- * you do something like this:
+ * Paths are interned: every path refers to a node in a global tree of
+ * reference-counted path segments, and each node only stores its last segment
+ * together with a pointer to the node of its parent path. Equal paths share
+ * the same node, even when they were created independently:
  *
  * @code
  * Path foo1("/foo");
  * Path foo2("/foo");
  * @endcode
+ *
+ * Thus comparing paths for equality, hashing them and getting their parent
+ * are constant-time operations.
  */
 class KDEVPLATFORMUTIL_EXPORT Path
 {
@@ -124,6 +131,14 @@ public:
      */
     Path(const Path& base, const QString& subPath = QString());
 
+    Path(Path&& other) noexcept;
+
+    ~Path();
+
+    Path& operator=(const Path& other);
+
+    Path& operator=(Path&& other) noexcept;
+
     /**
      * Equality comparison between @p other and this Path.
      *
@@ -131,7 +146,7 @@ public:
      */
     inline bool operator==(const Path& other) const
     {
-        return m_data == other.m_data;
+        return m_node == other.m_node;
     }
 
     /**
@@ -188,7 +203,7 @@ public:
      */
     inline bool isValid() const
     {
-        return !m_data.isEmpty();
+        return m_node != nullptr;
     }
 
     /**
@@ -198,7 +213,7 @@ public:
      */
     inline bool isEmpty() const
     {
-        return m_data.isEmpty();
+        return !m_node;
     }
 
     /**
@@ -270,12 +285,9 @@ public:
     QString remotePrefix() const;
 
     /**
-     * @return an implicitly shared copy of the internal data.
+     * @return the segments of this path, starting with the remote URL prefix for remote paths.
      */
-    inline QVector<QString> segments() const
-    {
-        return m_data;
-    }
+    QVector<QString> segments() const;
 
     /**
      * @return the Path converted to a QUrl.
@@ -341,9 +353,15 @@ public:
     Path cd(const QString& dir) const;
 
 private:
-    // for remote urls the first element contains the a Path prefix
-    // containing the protocol, user, port etc. pp.
-    QVector<QString> m_data;
+    friend KDEVPLATFORMUTIL_EXPORT uint qHash(const Path& path);
+
+    explicit Path(PathNode* node);
+
+    void setSegments(const QVector<QString>& segments);
+
+    // the node of the last segment, for remote urls the first node contains
+    // the Path prefix containing the protocol, user, port etc. pp.
+    PathNode* m_node = nullptr;
 };
 
 KDEVPLATFORMUTIL_EXPORT uint qHash(const Path& path);
@@ -31,6 +31,11 @@
 
 #include <QTest>
 
+#ifdef Q_OS_LINUX
+#include <QFile>
+#include <unistd.h>
+#endif
+
 QTEST_MAIN(TestPath);
 
 using namespace KDevelop;
@@ -176,6 +181,57 @@ void TestPath::bench_hash()
     }
 }
 
+#ifdef Q_OS_LINUX
+static qint64 residentMemory()
+{
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.value(1).toLongLong() * sysconf(_SC_PAGESIZE);
+}
+#endif
+
+void TestPath::bench_memory()
+{
+#ifdef Q_OS_LINUX
+    const qint64 before = residentMemory();
+    const QVector<Path> data = generateData(Path(QStringLiteral("/tmp/foo/bar")), 0);
+    const qint64 after = residentMemory();
+    QVERIFY(!data.isEmpty());
+    // resident memory grows in pages, so this is only a rough estimate of the bytes per path
+    QTest::setBenchmarkResult(qreal(after - before) / data.size(), QTest::BytesAllocated);
+#else
+    QSKIP("Memory is only measured on Linux");
+#endif
+}
+
+void TestPath::bench_parent()
+{
+    const QVector<Path> data = generateData(Path(QStringLiteral("/tmp/foo/bar")), 0);
+    QBENCHMARK {
+        for (const Path& path : data) {
+            Path parent = path.parent();
+            Q_UNUSED(parent);
+        }
+    }
+}
+
+void TestPath::bench_isParentOf()
+{
+    const QVector<Path> data = generateData(Path(QStringLiteral("/tmp/foo/bar")), 0);
+    const Path folder(QStringLiteral("/tmp/foo/bar/folder2/folder3"));
+    int children = 0;
+    QBENCHMARK {
+        children = 0;
+        for (const Path& path : data) {
+            children += folder.isParentOf(path);
+        }
+    }
+    QVERIFY(children > 0);
+}
+
 /// Invoke @p op on URL @p base, but preserve drive letter if @p op removes it
 template<typename Func>
 QUrl preserveWindowsDriveLetter(const QUrl& base, Func op)
@@ -605,6 +661,31 @@ void TestPath::testHasParent()
     QTEST(path.hasParent(), "hasParent");
 }
 
+void TestPath::testPathSharing()
+{
+    const Path base(QStringLiteral("/tmp/foo"));
+    const Path child(base, QStringLiteral("bar/asdf.txt"));
+    const Path fromString(QStringLiteral("/tmp/foo/bar/asdf.txt"));
+    QCOMPARE(child, fromString);
+    QCOMPARE(qHash(child), qHash(fromString));
+    QCOMPARE(child.parent().parent(), base);
+    QVERIFY(base.isParentOf(child));
+    QVERIFY(!base.isDirectParentOf(child));
+    QVERIFY(child.parent().isDirectParentOf(child));
+
+    Path renamed(child);
+    renamed.setLastPathSegment(QStringLiteral("blub.txt"));
+    QCOMPARE(renamed, Path(QStringLiteral("/tmp/foo/bar/blub.txt")));
+    QCOMPARE(child, fromString);
+    QCOMPARE(renamed.parent(), child.parent());
+
+    // paths that are created again after all their copies were destroyed are still equal
+    const uint hash = qHash(Path(QStringLiteral("/tmp/other/file.txt")));
+    const Path other(QStringLiteral("/tmp/other/file.txt"));
+    QCOMPARE(qHash(other), hash);
+    QCOMPARE(other.segments(), QVector<QString>({QStringLiteral("tmp"), QStringLiteral("other"), QStringLiteral("file.txt")}));
+}
+
 void TestPath::QUrl_acceptance()
 {
     const QUrl baseLocal = QUrl(QStringLiteral("file:///foo.h"));
@@ -37,6 +37,9 @@ private Q_SLOTS:
     void bench_fromLocalPath();
     void bench_fromLocalPath_data();
     void bench_hash();
+    void bench_memory();
+    void bench_parent();
+    void bench_isParentOf();
 
     void testPath();
     void testPath_data();
@@ -52,6 +55,7 @@ private Q_SLOTS:
     void testPathCd_data();
     void testHasParent_data();
     void testHasParent();
+    void testPathSharing();
 
     void QUrl_acceptance();
 };
@@ -237,6 +237,10 @@ void ClangParseJob::run(ThreadWeaver::JobPointer /*self*/, ThreadWeaver::Thread*
         m_environment.addFrameworkDirectories(IDefinesAndIncludesManager::manager()->frameworkDirectoriesInBackground(tuUrlStr));
         m_environment.addDefines(IDefinesAndIncludesManager::manager()->definesInBackground(tuUrlStr));
         m_environment.setPchInclude(userDefinedPchIncludeForFile(tuUrlStr));
+        if (!m_environment.pchInclude().isValid()) {
+            // share the precompiled system includes with the other translation units that start with them
+            m_environment.setPchInclude(clang()->index()->preambleHeader(m_environment));
+        }
     }
 
     if (abortRequested()) {
@@ -261,9 +265,12 @@ void ClangParseJob::run(ThreadWeaver::JobPointer /*self*/, ThreadWeaver::Thread*
             return;
         }
         ctx->setAst(IAstContainer::Ptr(session.data()));
+        lock.unlock();
+
+        clang()->index()->translationUnitPool()->insert(m_environment.translationUnitUrl(), document(),
+                                                        session.data().data(), session.memoryUsage());
 
         if (minimumFeatures() & UpdateHighlighting) {
-            lock.unlock();
             languageSupport()->codeHighlighting()->highlightDUChain(ctx);
         }
         return;
@@ -327,10 +334,14 @@ void ClangParseJob::run(ThreadWeaver::JobPointer /*self*/, ThreadWeaver::Thread*
         return;
     }
 
+    // the contexts that keep the parse session alive
+    QVector<IndexedString> attachedUrls;
+
     if (context) {
         if (minimumFeatures() & TopDUContext::AST) {
             DUChainWriteLocker lock;
             context->setAst(IAstContainer::Ptr(session.data()));
+            attachedUrls << context->url();
         }
 #ifdef QT_DEBUG
         DUChainReadLocker lock;
@@ -344,6 +355,15 @@ void ClangParseJob::run(ThreadWeaver::JobPointer /*self*/, ThreadWeaver::Thread*
 #endif
     }
 
+    QVector<IndexedString> includedUrls;
+    includedUrls.reserve(includedFiles.size());
+    foreach(const auto& context, includedFiles) {
+        if (context) {
+            includedUrls << context->url();
+        }
+    }
+    clang()->index()->setIncludedFiles(m_environment.translationUnitUrl(), includedUrls);
+
     foreach(const auto& context, includedFiles) {
         if (!context) {
             continue;
@@ -368,10 +388,20 @@ void ClangParseJob::run(ThreadWeaver::JobPointer /*self*/, ThreadWeaver::Thread*
                 // share the session data with all contexts that are pinned to this TU
                 DUChainWriteLocker lock;
                 context->setAst(IAstContainer::Ptr(session.data()));
+                attachedUrls << context->url();
             }
             languageSupport()->codeHighlighting()->highlightDUChain(context);
         }
     }
+
+    if (!attachedUrls.isEmpty()) {
+        // sessions of other translation units may get detached to stay within the memory budget
+        const auto memoryUsage = session.memoryUsage();
+        auto pool = clang()->index()->translationUnitPool();
+        foreach (const auto& url, attachedUrls) {
+            pool->insert(m_environment.translationUnitUrl(), url, session.data().data(), memoryUsage);
+        }
+    }
 }
 
 ParseSessionData::Ptr ClangParseJob::createSessionData() const
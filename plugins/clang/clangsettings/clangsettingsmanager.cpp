@@ -45,6 +45,8 @@ namespace
 
     const QString forwardDeclare = QStringLiteral("forwardDeclare");
 
+    const QString translationUnitMemory = QStringLiteral("translationUnitMemory");
+
 AssistantsSettings readAssistantsSettings(KConfig* cfg)
 {
     auto grp = cfg->group(settingsGroup);
@@ -65,6 +67,16 @@ CodeCompletionSettings readCodeCompletionSettings(KConfig* cfg)
 
     return settings;
 }
+
+MemorySettings readMemorySettings(KConfig* cfg)
+{
+    auto grp = cfg->group(settingsGroup);
+    MemorySettings settings;
+
+    settings.translationUnitMemory = grp.readEntry(translationUnitMemory, settings.translationUnitMemory);
+
+    return settings;
+}
 }
 
 ClangSettingsManager* ClangSettingsManager::self()
@@ -92,6 +104,16 @@ CodeCompletionSettings ClangSettingsManager::codeCompletionSettings() const
     return readCodeCompletionSettings(cfg.data());
 }
 
+MemorySettings ClangSettingsManager::memorySettings() const
+{
+    if (m_enableTesting) {
+        return {};
+    }
+
+    auto cfg = ICore::self()->activeSession()->config();
+    return readMemorySettings(cfg.data());
+}
+
 ParserSettings ClangSettingsManager::parserSettings(KDevelop::ProjectBaseItem* item) const
 {
     return {IDefinesAndIncludesManager::manager()->parserArguments(item)};
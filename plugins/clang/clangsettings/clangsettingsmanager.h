@@ -55,6 +55,12 @@ struct AssistantsSettings
     bool forwardDeclare = true;
 };
 
+struct MemorySettings
+{
+    /// The memory that the translation units of open documents may use, in MiB
+    int translationUnitMemory = 2048;
+};
+
 class KDEVCLANGPRIVATE_EXPORT ClangSettingsManager
 {
 public:
@@ -64,6 +70,8 @@ public:
 
     CodeCompletionSettings codeCompletionSettings() const;
 
+    MemorySettings memorySettings() const;
+
     ParserSettings parserSettings(KDevelop::ProjectBaseItem* item) const;
 
     ParserSettings parserSettings(const QString& path) const;
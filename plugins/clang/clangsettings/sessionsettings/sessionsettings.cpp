@@ -26,11 +26,15 @@
 #include "sessionconfig.h"
 #include "ui_sessionsettings.h"
 
-SessionSettings::SessionSettings(QWidget* parent)
+#include "duchain/translationunitpool.h"
+
+SessionSettings::SessionSettings(TranslationUnitPool* pool, QWidget* parent)
     : ConfigPage(nullptr, SessionConfig::self(), parent)
     , m_settings(new Ui::SessionSettings)
+    , m_pool(pool)
 {
     m_settings->setupUi(this);
+    updateStatistics();
 }
 
 void SessionSettings::reset()
@@ -38,6 +42,7 @@ void SessionSettings::reset()
      ConfigPage::reset();
 
     Q_ASSERT(ICore::self()->activeSession());
+    updateStatistics();
 }
 
 SessionSettings::~SessionSettings( )
@@ -46,6 +51,21 @@ SessionSettings::~SessionSettings( )
 void SessionSettings::apply()
 {
      ConfigPage::apply();
+
+    m_pool->setMemoryBudget(quint64(SessionConfig::translationUnitMemory()) * 1024 * 1024);
+    updateStatistics();
+}
+
+void SessionSettings::updateStatistics()
+{
+    const auto statistics = m_pool->statistics();
+    const auto memoryUsage = statistics.memoryUsage / (1024 * 1024);
+    m_settings->translationUnitStatistics->setText(
+        i18np("1 translation unit is kept in memory, using %2 MiB.",
+              "%1 translation units are kept in memory, using %2 MiB.", statistics.units, memoryUsage)
+        + QLatin1Char(' ')
+        + i18np("1 translation unit was released to stay within the limit.",
+                "%1 translation units were released to stay within the limit.", statistics.evictions));
 }
 
 QString SessionSettings::name() const
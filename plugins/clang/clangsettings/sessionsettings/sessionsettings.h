@@ -34,11 +34,13 @@ namespace Ui
     class SessionSettings;
 }
 
+class TranslationUnitPool;
+
 class KDEVCLANGPRIVATE_EXPORT SessionSettings: public KDevelop::ConfigPage
 {
     Q_OBJECT
 public:
-    explicit SessionSettings(QWidget* parent);
+    SessionSettings(TranslationUnitPool* pool, QWidget* parent);
     ~SessionSettings() override;
 
     QString name() const override;
@@ -51,7 +53,10 @@ public:
     void reset() override;
 
 private:
+    void updateStatistics();
+
     QScopedPointer<Ui::SessionSettings> m_settings;
+    TranslationUnitPool* m_pool;
 
 };
 
@@ -38,6 +38,8 @@
 #include <interfaces/ilanguagecontroller.h>
 #include <interfaces/contextmenuextension.h>
 #include <interfaces/idocumentcontroller.h>
+#include <interfaces/iproject.h>
+#include <interfaces/iprojectcontroller.h>
 
 #include "codegen/clangrefactoring.h"
 #include "codegen/clangclasshelper.h"
@@ -61,7 +63,9 @@
 #include <language/duchain/parsingenvironment.h>
 #include <language/duchain/use.h>
 #include <language/editor/documentcursor.h>
+#include <project/projectmodel.h>
 
+#include "clangsettings/clangsettingsmanager.h"
 #include "clangsettings/sessionsettings/sessionsettings.h"
 
 #include <KActionCollection>
@@ -184,6 +188,7 @@ ClangSupport::ClangSupport(QObject* parent, const QVariantList& )
     m_highlighting = new ClangHighlighting(this);
     m_refactoring = new ClangRefactoring(this);
     m_index.reset(new ClangIndex);
+    m_index->translationUnitPool()->setMemoryBudget(quint64(ClangSettingsManager::self()->memorySettings().translationUnitMemory) * 1024 * 1024);
 
     auto model = new KDevelop::CodeCompletion( this, new ClangCodeCompletionModel(m_index.data(), this), name() );
     // TODO: use direct signal/slot connect syntax for 5.1
@@ -201,6 +206,17 @@ ClangSupport::ClangSupport(QObject* parent, const QVariantList& )
 
     connect(ICore::self()->documentController(), &IDocumentController::documentActivated,
             this, &ClangSupport::documentActivated);
+    connect(ICore::self()->documentController(), &IDocumentController::documentClosed,
+            this, [this] (IDocument* doc) {
+                // the session is attached again when the document gets opened
+                m_index->translationUnitPool()->remove(IndexedString(doc->url()));
+            });
+
+    connect(ICore::self()->projectController(), &IProjectController::projectOpened,
+            this, &ClangSupport::projectOpened);
+    foreach (auto project, ICore::self()->projectController()->projects()) {
+        projectOpened(project);
+    }
 }
 
 ClangSupport::~ClangSupport()
@@ -218,7 +234,7 @@ ClangSupport::~ClangSupport()
 
 KDevelop::ConfigPage* ClangSupport::configPage(int number, QWidget* parent)
 {
-    return number == 0 ? new SessionSettings(parent) : nullptr;
+    return number == 0 ? new SessionSettings(m_index->translationUnitPool(), parent) : nullptr;
 }
 
 int ClangSupport::configPages() const
@@ -382,7 +398,11 @@ void ClangSupport::documentActivated(IDocument* doc)
 
     const auto indexedUrl = IndexedString(doc->url());
 
-    auto sessionData = ClangIntegration::DUChainUtils::findParseSessionData(indexedUrl, index()->translationUnitForUrl(IndexedString(doc->url())));
+    const auto tuUrl = index()->translationUnitForUrl(indexedUrl);
+    // keep the focused translation unit in memory, or attach it again if it was released
+    index()->translationUnitPool()->touch(tuUrl);
+
+    auto sessionData = ClangIntegration::DUChainUtils::findParseSessionData(indexedUrl, tuUrl);
     if (sessionData) {
         return;
     }
@@ -402,6 +422,17 @@ void ClangSupport::documentActivated(IDocument* doc)
     ICore::self()->languageController()->backgroundParser()->addDocument(indexedUrl, features);
 }
 
+void ClangSupport::projectOpened(IProject* project)
+{
+    // keep the translation units that were found for the files up to date
+    connect(project, &IProject::fileAddedToSet, this, [this] (ProjectFileItem* file) {
+        m_index->fileAdded(file->indexedPath());
+    });
+    connect(project, &IProject::fileRemovedFromSet, this, [this] (ProjectFileItem* file) {
+        m_index->fileRemoved(file->indexedPath());
+    });
+}
+
 static void setKeywordCompletion(KTextEditor::View* view, bool enabled)
 {
     if (auto config = qobject_cast<KTextEditor::ConfigInterface*>(view)) {
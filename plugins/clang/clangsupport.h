@@ -35,6 +35,7 @@ class ClangRefactoring;
 namespace KDevelop
 {
 class IDocument;
+class IProject;
 }
 
 namespace KTextEditor
@@ -91,6 +92,7 @@ public:
 
 private Q_SLOTS:
     void documentActivated(KDevelop::IDocument* doc);
+    void projectOpened(KDevelop::IProject* project);
     void disableKeywordCompletion(KTextEditor::View* view);
     void enableKeywordCompletion(KTextEditor::View* view);
 
@@ -54,8 +54,10 @@
 #include "../duchain/navigationwidget.h"
 #include "../clangsettings/clangsettingsmanager.h"
 
+#include <algorithm>
 #include <functional>
 #include <memory>
+#include <numeric>
 
 #include <KTextEditor/Document>
 #include <KTextEditor/View>
@@ -792,6 +794,30 @@ static MemberAccessReplacer s_memberAccessReplacer;
 
 Q_DECLARE_METATYPE(MemberAccessReplacer::Type)
 
+struct ClangCodeCompletionContext::CompletionItems
+{
+    CompletionItems(const TopDUContextPointer& topContext, uint resultCount)
+        : lookAheadMatcher(topContext)
+        , computed(resultCount, false)
+    {}
+
+    /// Normal completion items, such as 'void Foo::foo()'
+    QList<CompletionTreeItemPointer> items;
+    /// Stuff like 'Foo& Foo::operator=(const Foo&)', etc. Not regularly used by our users.
+    QList<CompletionTreeItemPointer> specialItems;
+    /// Macros from the current context
+    QList<CompletionTreeItemPointer> macros;
+    /// Builtins reported by Clang
+    QList<CompletionTreeItemPointer> builtin;
+
+    QSet<Declaration*> handled;
+
+    LookAheadItemMatcher lookAheadMatcher;
+
+    /// Whether the result at an index has been computed
+    QVector<bool> computed;
+};
+
 ClangCodeCompletionContext::ClangCodeCompletionContext(const DUContextPointer& context,
                                                        const ParseSessionData::Ptr& sessionData,
                                                        const QUrl& url,
@@ -924,32 +950,79 @@ QList<CompletionTreeItemPointer> ClangCodeCompletionContext::completionItems(boo
         return {};
     }
 
-    const auto ctx = DUContextPointer(m_duContext->findContextAt(m_position));
+    QVector<uint> indices;
+    indices.reserve(m_results->NumResults);
+    for (uint i = 0; i < m_results->NumResults; ++i) {
+        if (!m_items || !m_items->computed.at(i)) {
+            indices.append(i);
+        }
+    }
+    computeItems(abort, indices);
+    if (abort) {
+        return {};
+    }
 
-    /// Normal completion items, such as 'void Foo::foo()'
-    QList<CompletionTreeItemPointer> items;
-    /// Stuff like 'Foo& Foo::operator=(const Foo&)', etc. Not regularly used by our users.
-    QList<CompletionTreeItemPointer> specialItems;
-    /// Macros from the current context
-    QList<CompletionTreeItemPointer> macros;
-    /// Builtins reported by Clang
-    QList<CompletionTreeItemPointer> builtin;
+    const auto computed = std::move(m_items);
 
-    QSet<Declaration*> handled;
+    addImplementationHelperItems();
+    addOverwritableItems();
+
+    eventuallyAddGroup(i18n("Special"), 700, computed->specialItems);
+    eventuallyAddGroup(i18n("Look-ahead Matches"), 800, computed->lookAheadMatcher.matchedItems());
+    eventuallyAddGroup(i18n("Builtin"), 900, computed->builtin);
+    eventuallyAddGroup(i18n("Macros"), 1000, computed->macros);
+    return computed->items;
+}
+
+QList<CompletionTreeItemPointer> ClangCodeCompletionContext::bestCompletionItems(int count, bool& abort)
+{
+    if (!m_valid || !m_duContext || !m_results || m_results->NumResults <= static_cast<uint>(count)) {
+        return {};
+    }
 
-    LookAheadItemMatcher lookAheadMatcher(TopDUContextPointer(ctx->topContext()));
+    const auto priority = [this] (uint index) {
+        return clang_getCompletionPriority(m_results->Results[index].CompletionString);
+    };
+    QVector<uint> indices(m_results->NumResults);
+    std::iota(indices.begin(), indices.end(), 0);
+    // a lower priority is a better one
+    std::partial_sort(indices.begin(), indices.begin() + count, indices.end(), [&priority] (uint lhs, uint rhs) {
+        return priority(lhs) < priority(rhs);
+    });
+    indices.resize(count);
+    computeItems(abort, indices);
+    if (abort) {
+        return {};
+    }
+    return m_items->items + m_items->builtin + m_items->macros;
+}
+
+void ClangCodeCompletionContext::computeItems(bool& abort, const QVector<uint>& indices)
+{
+    const auto ctx = DUContextPointer(m_duContext->findContextAt(m_position));
+
+    if (!m_items) {
+        m_items.reset(new CompletionItems(TopDUContextPointer(ctx->topContext()), m_results->NumResults));
+    }
+    auto& items = m_items->items;
+    auto& specialItems = m_items->specialItems;
+    auto& macros = m_items->macros;
+    auto& builtin = m_items->builtin;
+    auto& handled = m_items->handled;
+    auto& lookAheadMatcher = m_items->lookAheadMatcher;
 
     // If ctx is/inside the Class context, this represents that context.
     const auto currentClassContext = classDeclarationForContext(ctx, m_position);
 
     clangDebug() << "Clang found" << m_results->NumResults << "completion results";
 
-    for (uint i = 0; i < m_results->NumResults; ++i) {
+    for (const uint index : indices) {
         if (abort) {
-            return {};
+            return;
         }
 
-        auto result = m_results->Results[i];
+        m_items->computed[index] = true;
+        auto result = m_results->Results[index];
 
         const auto availability = clang_getCompletionAvailability(result.CompletionString);
         if (availability == CXAvailability_NotAvailable) {
@@ -1196,19 +1269,6 @@ QList<CompletionTreeItemPointer> ClangCodeCompletionContext::completionItems(boo
             builtin.append(item);
         }
     }
-
-    if (abort) {
-        return {};
-    }
-
-    addImplementationHelperItems();
-    addOverwritableItems();
-
-    eventuallyAddGroup(i18n("Special"), 700, specialItems);
-    eventuallyAddGroup(i18n("Look-ahead Matches"), 800, lookAheadMatcher.matchedItems());
-    eventuallyAddGroup(i18n("Builtin"), 900, builtin);
-    eventuallyAddGroup(i18n("Macros"), 1000, macros);
-    return items;
 }
 
 void ClangCodeCompletionContext::eventuallyAddGroup(const QString& name, int priority,
@@ -28,6 +28,8 @@
 
 #include <clang-c/Index.h>
 
+#include <QVector>
+
 #include <memory>
 
 #include "completionhelper.h"
@@ -56,12 +58,28 @@ public:
 
     QList<KDevelop::CompletionTreeItemPointer> completionItems(bool& abort, bool fullCompletion = true) override;
 
+    /**
+     * Computes the items of the @p count results that Clang ranks best, including macros and builtins, without any groups.
+     *
+     * Looking up the declarations of all results takes long in big scopes, these items
+     * can be shown in the meantime. Call completionItems() afterwards to get all of them,
+     * it reuses the items computed here.
+     *
+     * @returns an empty list if there are not more than @p count results
+     */
+    QList<KDevelop::CompletionTreeItemPointer> bestCompletionItems(int count, bool& abort);
+
     QList<KDevelop::CompletionTreeElementPointer> ungroupedElements() override;
 
     ContextFilters filters() const;
     void setFilters(const ContextFilters& filters);
 
 private:
+    struct CompletionItems;
+
+    /// Adds the items of the results at @p indices to m_items, and marks those results as computed
+    void computeItems(bool& abort, const QVector<uint>& indices);
+
     void addOverwritableItems();
     void addImplementationHelperItems();
 
@@ -76,6 +94,8 @@ private:
     CompletionHelper m_completionHelper;
     ParseSessionData::Ptr m_parseSessionData;
     ContextFilters m_filters = NoFilter;
+    /// The items computed by bestCompletionItems(), until completionItems() takes them
+    std::unique_ptr<CompletionItems> m_items;
 };
 
 #endif // CLANGCODECOMPLETIONCONTEXT_H
@@ -41,6 +41,9 @@ using namespace KDevelop;
 
 namespace {
 
+/// The number of items that are shown before the declarations of all results are looked up
+const int bestItemsCount = 50;
+
 bool isSpaceOnly(const QString& string)
 {
     return std::find_if(string.begin(), string.end(), [] (const QChar c) { return !c.isSpace(); }) == string.end();
@@ -117,11 +120,22 @@ public Q_SLOTS:
             return;
         }
 
-        bool abort = false;
+        // looking up the declarations of all results takes long in big scopes, show the best ones first
+        if (auto clangContext = completionContext.dynamicCast<ClangCodeCompletionContext>()) {
+            const auto bestItems = clangContext->bestCompletionItems(bestItemsCount, aborting());
+            if (aborting()) {
+                failed();
+                return;
+            }
+            if (!bestItems.isEmpty()) {
+                foundDeclarations(computeGroups(bestItems, {}), {});
+            }
+        }
+
         // NOTE: cursor might be wrong here, but shouldn't matter much I hope...
         //       when the document changed significantly, then the cache is off anyways and we don't get anything sensible
         //       the position here is just a "optimization" to only search up to that position
-        const auto& items = completionContext->completionItems(abort);
+        const auto& items = completionContext->completionItems(aborting());
 
         if (aborting()) {
             failed();
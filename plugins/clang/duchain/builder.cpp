@@ -1440,10 +1440,14 @@ Visitor::Visitor(CXTranslationUnit tu, CXFile file,
     m_parentContext = &parent;
     clang_visitChildren(tuCursor, &visitCursor, this);
 
-    if (m_update) {
-        DUChainWriteLocker lock;
-        top->deleteUsesRecursively();
-    }
+    // resolve the uses first, so that the write lock isn't held while libclang is queried
+    struct PendingUse
+    {
+        DUContext* context;
+        DeclarationPointer used;
+        RangeInRevision range;
+    };
+    std::vector<PendingUse> pendingUses;
     for (const auto &contextUses : m_uses) {
         for (const auto &cursor : contextUses.second) {
             auto referenced = referencedCursor(cursor);
@@ -1483,12 +1487,18 @@ Visitor::Visitor(CXTranslationUnit tu, CXFile file,
 
             const auto useRange = clang_getCursorReferenceNameRange(cursor, 0, 0);
             const auto range = rangeInRevisionForUse(cursor, referenced.kind, useRange, m_macroExpansionLocations);
-
-            DUChainWriteLocker lock;
-            auto usedIndex = top->indexForUsedDeclaration(used.data());
-            contextUses.first->createUse(usedIndex, range);
+            pendingUses.push_back({contextUses.first, used, range});
         }
     }
+
+    DUChainWriteLocker lock;
+    if (m_update) {
+        top->deleteUsesRecursively();
+    }
+    for (const auto &use : pendingUses) {
+        auto usedIndex = top->indexForUsedDeclaration(use.used.data());
+        use.context->createUse(usedIndex, use.range);
+    }
 }
 
 //END Visitor
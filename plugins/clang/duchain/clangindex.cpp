@@ -34,17 +34,152 @@
 
 #include <clang-c/Index.h>
 
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+
 using namespace KDevelop;
 
+namespace {
+
+// translation units that start with fewer system includes don't get a shared preamble
+const int minPreambleIncludes = 3;
+// preambles that were not used for this many days are removed
+const int maxPreambleAge = 30;
+// the least recently used PCHs are released once they take more memory than this by default
+const quint64 defaultPchMemoryBudget = 512 * 1024 * 1024;
+
+/**
+ * @returns the system includes at the start of @p fileName, up to the first line that is neither a system include
+ * nor a comment. A local include ends them as well, since it may define macros that the following headers use.
+ */
+QList<QByteArray> leadingSystemIncludes(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    QList<QByteArray> includes;
+    bool inComment = false;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        if (inComment || line.startsWith("/*")) {
+            const int end = line.indexOf("*/", inComment ? 0 : 2);
+            inComment = end == -1;
+            if (inComment) {
+                continue;
+            }
+            line = line.mid(end + 2).trimmed();
+        }
+        if (line.isEmpty() || line.startsWith("//")) {
+            continue;
+        }
+        if (!line.startsWith('#')) {
+            break;
+        }
+        line = line.mid(1).trimmed();
+        if (!line.startsWith("include")) {
+            break;
+        }
+        line = line.mid(7).trimmed();
+        if (line.startsWith('<')) {
+            const int end = line.indexOf('>');
+            if (end == -1) {
+                break;
+            }
+            includes << line.left(end + 1);
+        } else {
+            break;
+        }
+    }
+    return includes;
+}
+
+void addPaths(QCryptographicHash* hash, const char* kind, const Path::List& paths)
+{
+    for (const auto& path : paths) {
+        hash->addData(kind);
+        hash->addData(path.pathOrUrl().toUtf8());
+        hash->addData("\n");
+    }
+}
+
+/// @returns a key for the preamble that includes @p includes in @p environment
+QByteArray preambleKey(const QList<QByteArray>& includes, const ClangParsingEnvironment& environment)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const auto& include : includes) {
+        hash.addData(include);
+        hash.addData("\n");
+    }
+
+    const auto defines = environment.defines();
+    for (auto it = defines.constBegin(); it != defines.constEnd(); ++it) {
+        hash.addData("-D");
+        hash.addData(it.key().toUtf8());
+        hash.addData("=");
+        hash.addData(it.value().toUtf8());
+        hash.addData("\n");
+    }
+
+    const auto includePaths = environment.includes();
+    addPaths(&hash, "-isystem", includePaths.system);
+    addPaths(&hash, "-I", includePaths.project);
+    const auto frameworkDirectories = environment.frameworkDirectories();
+    addPaths(&hash, "-iframework", frameworkDirectories.system);
+    addPaths(&hash, "-F", frameworkDirectories.project);
+
+    hash.addData(environment.parserSettings().parserOptions.toUtf8());
+    hash.addData("\n");
+    hash.addData(ClangString(clang_getClangVersion()).toByteArray());
+    return hash.result().toHex();
+}
+
+}
+
 ClangIndex::ClangIndex()
     // NOTE: We don't exclude PCH declarations. That way we could retrieve imports manually, as clang_getInclusions returns nothing on reparse with CXTranslationUnit_PrecompiledPreamble flag.
     : m_index(clang_createIndex(0 /*Exclude PCH Decls*/, qEnvironmentVariableIsSet("KDEV_CLANG_DISPLAY_DIAGS") /*Display diags*/))
+    , m_pchMemoryBudget(defaultPchMemoryBudget)
 {
     // demote the priority of the clang parse threads to reduce potential UI lockups
     // but the code completion threads still retain their normal priority to return
     // the results as quickly as possible
     clang_CXIndex_setGlobalOptions(m_index, clang_CXIndex_getGlobalOptions(m_index)
         | CXGlobalOpt_ThreadBackgroundPriorityForIndexing);
+
+    const QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if (!cacheLocation.isEmpty()) {
+        m_preambleDirectory = cacheLocation + QLatin1String("/kdevclang/preambles");
+        m_pchStateDirectory = cacheLocation + QLatin1String("/kdevclang/pch");
+        QDir directory(m_preambleDirectory);
+        directory.mkpath(QStringLiteral("."));
+        QDir stateDirectory(m_pchStateDirectory);
+        stateDirectory.mkpath(QStringLiteral("."));
+
+        // the environment of a PCH is written whenever the PCH is saved or loaded, which works on
+        // mounts that don't record access times as well
+        const auto expired = QDateTime::currentDateTime().addDays(-maxPreambleAge);
+        foreach (const QFileInfo& preamble, directory.entryInfoList({QStringLiteral("*.h")}, QDir::Files)) {
+            const QString fileName = preamble.absoluteFilePath();
+            const QFileInfo environment(pchStateFile(fileName + QLatin1String(".pch")) + QLatin1String(".environment"));
+            const auto lastUsed = environment.exists() ? environment.lastModified() : preamble.lastModified();
+            if (lastUsed < expired) {
+                QFile::remove(fileName + QLatin1String(".pch"));
+                QFile::remove(fileName);
+            }
+        }
+        foreach (const QFileInfo& environment, stateDirectory.entryInfoList({QStringLiteral("*.environment")}, QDir::Files)) {
+            if (environment.lastModified() < expired) {
+                const QString fileName = environment.absoluteFilePath();
+                QFile::remove(fileName.left(fileName.size() - environment.suffix().size()) + QLatin1String("defines"));
+                QFile::remove(fileName);
+            }
+        }
+    }
 }
 
 CXIndex ClangIndex::index() const
@@ -59,24 +194,108 @@ QSharedPointer<const ClangPCH> ClangIndex::pch(const ClangParsingEnvironment& en
         return {};
     }
 
-    UrlParseLock pchLock(IndexedString(pchInclude.pathOrUrl()));
-
     static const QString pchExt = QStringLiteral(".pch");
 
-    if (QFile::exists(pchInclude.toLocalFile() + pchExt)) {
-        QReadLocker lock(&m_pchLock);
-        auto pch = m_pch.constFind(pchInclude);
-        if (pch != m_pch.constEnd()) {
-            return pch.value();
-        }
+    QMutexLocker lock(&m_pchMutex);
+    // every PCH is only created once, by the first thread that needs it
+    bool waited = false;
+    while (m_pchInProgress.contains(pchInclude)) {
+        m_pchCreated.wait(&m_pchMutex);
+        waited = true;
+    }
+
+    auto cached = m_pch.constFind(pchInclude);
+    // a PCH whose file got removed is created again, unless it was just created and couldn't be saved
+    if (cached != m_pch.constEnd() && (waited || QFile::exists(pchInclude.toLocalFile() + pchExt))) {
+        m_pchUsage.removeOne(pchInclude);
+        m_pchUsage.append(pchInclude);
+        return cached->pch;
     }
 
-    auto pch = QSharedPointer<ClangPCH>::create(environment, this);
-    QWriteLocker lock(&m_pchLock);
-    m_pch.insert(pchInclude, pch);
+    m_pchInProgress.insert(pchInclude);
+    lock.unlock();
+
+    QSharedPointer<ClangPCH> pch;
+    {
+        // the PCH include may be parsed by a parse job as well
+        UrlParseLock pchLock(IndexedString(pchInclude.pathOrUrl()));
+        // an up to date PCH on disk is loaded instead of being built again
+        pch = QSharedPointer<ClangPCH>::create(environment, this);
+    }
+    const auto memoryUsage = pch->memoryUsage();
+
+    lock.relock();
+    m_pchInProgress.remove(pchInclude);
+    m_pchCreated.wakeAll();
+
+    auto replaced = m_pch.constFind(pchInclude);
+    if (replaced != m_pch.constEnd()) {
+        m_pchMemoryUsage -= replaced->memoryUsage;
+        m_pchUsage.removeOne(pchInclude);
+    }
+    m_pch.insert(pchInclude, CachedPCH{pch, memoryUsage});
+    m_pchUsage.append(pchInclude);
+    m_pchMemoryUsage += memoryUsage;
+
+    releasePchs();
     return pch;
 }
 
+void ClangIndex::setPchMemoryBudget(quint64 budget)
+{
+    QMutexLocker lock(&m_pchMutex);
+    m_pchMemoryBudget = budget;
+    releasePchs();
+}
+
+void ClangIndex::releasePchs()
+{
+    // parse jobs that still use a released PCH keep it alive
+    while (m_pchMemoryUsage > m_pchMemoryBudget && m_pchUsage.size() > 1) {
+        m_pchMemoryUsage -= m_pch.take(m_pchUsage.takeFirst()).memoryUsage;
+    }
+}
+
+Path ClangIndex::preambleHeader(const ClangParsingEnvironment& environment)
+{
+    static const bool enabled = qEnvironmentVariableIsEmpty("KDEV_CLANG_PREAMBLE_CACHE")
+                             || qEnvironmentVariableIntValue("KDEV_CLANG_PREAMBLE_CACHE");
+    if (!enabled || m_preambleDirectory.isEmpty()) {
+        return {};
+    }
+
+    const auto includes = leadingSystemIncludes(environment.translationUnitUrl().str());
+    if (includes.size() < minPreambleIncludes) {
+        return {};
+    }
+
+    const QString fileName = m_preambleDirectory + QLatin1Char('/')
+                           + QString::fromLatin1(preambleKey(includes, environment)) + QLatin1String(".h");
+    if (!QFile::exists(fileName)) {
+        QSaveFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qCWarning(KDEV_CLANG) << "Failed to write preamble:" << fileName << file.errorString();
+            return {};
+        }
+        for (const auto& include : includes) {
+            file.write("#include " + include + '\n');
+        }
+        if (!file.commit()) {
+            return {};
+        }
+    }
+    return Path(fileName);
+}
+
+QString ClangIndex::pchStateFile(const QString& pchFile) const
+{
+    if (m_pchStateDirectory.isEmpty()) {
+        return {};
+    }
+    const QByteArray hash = QCryptographicHash::hash(pchFile.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_pchStateDirectory + QLatin1Char('/') + QString::fromLatin1(hash);
+}
+
 ClangIndex::~ClangIndex()
 {
     clang_disposeIndex(m_index);
@@ -84,19 +303,37 @@ ClangIndex::~ClangIndex()
 
 IndexedString ClangIndex::translationUnitForUrl(const IndexedString& url)
 {
-    { // try explicit pin data first
+    {
         QMutexLocker lock(&m_mappingMutex);
-        auto tu = m_tuForUrl.find(url);
-        if (tu != m_tuForUrl.end()) {
-            if (!QFile::exists(tu.value().str())) {
-                // TU doesn't exist, unpin
-                m_tuForUrl.erase(tu);
-                return url;
-            }
+        // try explicit pin data first
+        auto tu = m_tuForUrl.constFind(url);
+        if (tu != m_tuForUrl.constEnd()) {
+            return tu.value();
+        }
+        tu = m_tuForFile.constFind(url);
+        if (tu != m_tuForFile.constEnd()) {
             return tu.value();
         }
+        if (m_standaloneUrls.contains(url)) {
+            return url;
+        }
     }
-    // if no explicit pin data is available, follow back the duchain import chain
+
+    const auto tu = findTranslationUnitForUrl(url);
+
+    QMutexLocker lock(&m_mappingMutex);
+    if (tu == url) {
+        m_standaloneUrls.insert(url);
+    } else if (!m_tuForFile.contains(url)) {
+        m_tuForFile.insert(url, tu);
+        m_filesForTu.insert(tu, url);
+    }
+    return tu;
+}
+
+IndexedString ClangIndex::findTranslationUnitForUrl(const IndexedString& url) const
+{
+    // follow back the duchain import chain
     {
         DUChainReadLocker lock;
         TopDUContext* top = DUChain::self()->chainForDocument(url);
@@ -146,4 +383,60 @@ void ClangIndex::unpinTranslationUnitForUrl(const IndexedString& url)
 {
     QMutexLocker lock(&m_mappingMutex);
     m_tuForUrl.remove(url);
+    // the translation unit is looked up again
+    m_tuForFile.remove(url);
+    m_standaloneUrls.remove(url);
+}
+
+void ClangIndex::setIncludedFiles(const IndexedString& tu, const QVector<IndexedString>& files)
+{
+    QMutexLocker lock(&m_mappingMutex);
+
+    // forget the files that were included when the translation unit was parsed before
+    removeFilesForTranslationUnit(tu);
+
+    for (const auto& file : files) {
+        if (file == tu) {
+            continue;
+        }
+        m_standaloneUrls.remove(file);
+        // the first translation unit that included a file is kept
+        if (!m_tuForFile.contains(file)) {
+            m_tuForFile.insert(file, tu);
+            m_filesForTu.insert(tu, file);
+        }
+    }
+}
+
+void ClangIndex::fileAdded(const IndexedString& /*url*/)
+{
+    QMutexLocker lock(&m_mappingMutex);
+    // the new file may be the buddy of a header that had no translation unit yet
+    m_standaloneUrls.clear();
+}
+
+void ClangIndex::fileRemoved(const IndexedString& url)
+{
+    QMutexLocker lock(&m_mappingMutex);
+    // files that are pinned to a removed translation unit are unpinned by their next parse job
+    m_tuForUrl.remove(url);
+    m_tuForFile.remove(url);
+    m_standaloneUrls.remove(url);
+    removeFilesForTranslationUnit(url);
+}
+
+void ClangIndex::removeFilesForTranslationUnit(const IndexedString& tu)
+{
+    foreach (const auto& file, m_filesForTu.values(tu)) {
+        auto it = m_tuForFile.find(file);
+        if (it != m_tuForFile.end() && it.value() == tu) {
+            m_tuForFile.erase(it);
+        }
+    }
+    m_filesForTu.remove(tu);
+}
+
+TranslationUnitPool* ClangIndex::translationUnitPool()
+{
+    return &m_translationUnitPool;
 }
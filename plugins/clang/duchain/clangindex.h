@@ -23,14 +23,18 @@
 #define CLANGINDEX_H
 
 #include "clanghelpers.h"
+#include "translationunitpool.h"
 
 #include "clangprivateexport.h"
 #include <serialization/indexedstring.h>
 
 #include <util/path.h>
 
-#include <QReadWriteLock>
+#include <QMutex>
+#include <QSet>
 #include <QSharedPointer>
+#include <QVector>
+#include <QWaitCondition>
 
 #include <clang-c/Index.h>
 
@@ -48,15 +52,49 @@ public:
     /**
      * @returns the existing ClangPCH for @p environment
      *
-     * The PCH is created using @p environment if it doesn't exist
+     * The PCH is created using @p environment if it doesn't exist, or loaded from disk if it was saved
+     * by an earlier session. Threads that ask for a PCH that is being created wait for it.
      * This function is thread safe.
      */
     QSharedPointer<const ClangPCH> pch(const ClangParsingEnvironment& environment);
 
+    /**
+     * Releases the least recently used PCHs once the PCHs take more than @p budget bytes
+     *
+     * The most recently used PCH is always kept. The default budget is 512 MiB.
+     */
+    void setPchMemoryBudget(quint64 budget);
+
+    /**
+     * @returns a header that includes the leading system includes of the translation unit of @p environment
+     *
+     * The header is stored in a cache that is shared by all sessions, and is the same for all translation
+     * units that start with the same system includes and use an equal environment. Using it as PCH include
+     * lets these translation units share one precompiled header.
+     *
+     * An invalid path is returned when the translation unit starts with too few system includes,
+     * or when the cache was disabled by setting KDEV_CLANG_PREAMBLE_CACHE=0.
+     * This function is thread safe.
+     */
+    KDevelop::Path preambleHeader(const ClangParsingEnvironment& environment);
+
+    /**
+     * @returns the path, without extension, of the files that keep the state of the precompiled header
+     * saved at @p pchFile, e.g. its defines and the environment it was built in
+     *
+     * These files are stored in a cache that is shared by all sessions, so none of them end up next to
+     * PCH includes in the source tree. An empty string is returned when there is no cache.
+     */
+    QString pchStateFile(const QString& pchFile) const;
+
     /**
      * Gets the currently pinned TU for @p url
      *
-     * If the currently pinned TU does not import @p url, @p url is returned
+     * If no TU is pinned, the TU that included @p url when it was parsed is returned. Otherwise the
+     * DUChain imports and the buddies of @p url are searched once, and the result is kept until the
+     * project files change. If no TU is found, @p url is returned
+     *
+     * This function is thread safe.
      */
     KDevelop::IndexedString translationUnitForUrl(const KDevelop::IndexedString& url);
 
@@ -70,14 +108,62 @@ public:
      */
     void unpinTranslationUnitForUrl(const KDevelop::IndexedString& url);
 
+    /**
+     * Remembers @p tu as the translation unit of the @p files it included, unless they already have one
+     */
+    void setIncludedFiles(const KDevelop::IndexedString& tu, const QVector<KDevelop::IndexedString>& files);
+
+    /**
+     * Invalidates the remembered translation units that may change now that @p url exists
+     */
+    void fileAdded(const KDevelop::IndexedString& url);
+
+    /**
+     * Forgets the translation unit of @p url, and of the files that were included by @p url
+     */
+    void fileRemoved(const KDevelop::IndexedString& url);
+
+    /**
+     * @returns the pool that limits the memory used by the translation units of open documents
+     */
+    TranslationUnitPool* translationUnitPool();
+
 private:
+    KDevelop::IndexedString findTranslationUnitForUrl(const KDevelop::IndexedString& url) const;
+    /// Releases PCHs until they fit into the budget, must be called with m_pchMutex locked
+    void releasePchs();
+    void removeFilesForTranslationUnit(const KDevelop::IndexedString& tu);
+
     CXIndex m_index;
 
-    QReadWriteLock m_pchLock;
-    QHash<KDevelop::Path, QSharedPointer<const ClangPCH>> m_pch;
+    struct CachedPCH
+    {
+        QSharedPointer<const ClangPCH> pch;
+        quint64 memoryUsage;
+    };
+
+    QMutex m_pchMutex;
+    QHash<KDevelop::Path, CachedPCH> m_pch;
+    /// The PCH includes, from the least to the most recently used one
+    QList<KDevelop::Path> m_pchUsage;
+    quint64 m_pchMemoryUsage = 0;
+    quint64 m_pchMemoryBudget;
+    /// The PCH includes that are being created, m_pchCreated is signaled once one is done
+    QSet<KDevelop::Path> m_pchInProgress;
+    QWaitCondition m_pchCreated;
+
+    QString m_preambleDirectory;
+    QString m_pchStateDirectory;
 
     QMutex m_mappingMutex;
     QHash<KDevelop::IndexedString, KDevelop::IndexedString> m_tuForUrl;
+    /// The translation units that were found for files that are not pinned
+    QHash<KDevelop::IndexedString, KDevelop::IndexedString> m_tuForFile;
+    QMultiHash<KDevelop::IndexedString, KDevelop::IndexedString> m_filesForTu;
+    /// The files that are their own translation unit
+    QSet<KDevelop::IndexedString> m_standaloneUrls;
+
+    TranslationUnitPool m_translationUnitPool;
 };
 
 #endif //CLANGINDEX_H
@@ -47,7 +47,8 @@ ClangPCH::ClangPCH(const ClangParsingEnvironment& environment, ClangIndex* index
     const TopDUContext::Features pchFeatures = TopDUContext::AllDeclarationsContextsUsesAndAST;
     const IndexedString doc(pchInclude.pathOrUrl());
 
-    ClangParsingEnvironment pchEnv;
+    // the PCH is only used when it was built with the includes and defines of the translation unit
+    ClangParsingEnvironment pchEnv = environment;
     pchEnv.setPchInclude(Path());
     pchEnv.setTranslationUnitUrl(doc);
     m_session.setData(ParseSessionData::Ptr(new ParseSessionData({}, index, pchEnv, ParseSessionData::PrecompiledHeader)));
@@ -79,3 +80,8 @@ ReferencedTopDUContext ClangPCH::context() const
 {
     return m_context;
 }
+
+quint64 ClangPCH::memoryUsage() const
+{
+    return m_session.memoryUsage();
+}
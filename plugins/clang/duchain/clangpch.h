@@ -40,6 +40,9 @@ public:
 
     KDevelop::ReferencedTopDUContext context() const;
 
+    /// @returns the memory used by the precompiled header, in bytes
+    quint64 memoryUsage() const;
+
 private:
     Q_DISABLE_COPY(ClangPCH);
 
@@ -38,12 +38,17 @@
 
 #include <KShell>
 
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
 #include <QFileInfo>
 #include <QMimeDatabase>
 #include <QMimeType>
+#include <QSaveFile>
+#include <QTemporaryFile>
 
 #include <algorithm>
+#include <cstdio>
 
 using namespace KDevelop;
 
@@ -190,6 +195,117 @@ QVector<CXUnsavedFile> toClangApi(const QVector<UnsavedFile>& unsavedFiles)
     return unsaved;
 }
 
+/**
+ * @returns a hash of everything a precompiled header is built with besides its input files,
+ * i.e. the @p arguments, the @p defines and the version of clang
+ */
+QByteArray environmentHash(const QVector<const char*>& arguments, const QMap<QString, QString>& defines)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const char* argument : arguments) {
+        hash.addData(argument);
+        hash.addData("\n");
+    }
+    for (auto it = defines.constBegin(); it != defines.constEnd(); ++it) {
+        hash.addData(it.key().toUtf8());
+        hash.addData("=");
+        hash.addData(it.value().toUtf8());
+        hash.addData("\n");
+    }
+    hash.addData(ClangString(clang_getClangVersion()).toByteArray());
+    return hash.result().toHex();
+}
+
+/**
+ * Writes @p environmentHash to @p environmentFile. The file is written whenever the precompiled header
+ * is saved or loaded, so its modification time tells when the precompiled header was last used.
+ */
+void writeEnvironmentFile(const QString& environmentFile, const QByteArray& environmentHash)
+{
+    QSaveFile file(environmentFile);
+    if (!file.open(QIODevice::WriteOnly) || file.write(environmentHash) != environmentHash.size() || !file.commit()) {
+        qCWarning(KDEV_CLANG) << "Failed to write precompiled header environment:" << environmentFile << file.errorString();
+    }
+}
+
+/**
+ * @returns the precompiled header saved at @p pchFile, or nullptr when it is missing, was built in another
+ * environment than the one @p environmentFile has to contain, or one of the files it was built from
+ * changed since then
+ */
+CXTranslationUnit loadPrecompiledHeader(CXIndex index, const QString& pchFile,
+                                        const QString& environmentFile, const QByteArray& environmentHash)
+{
+    const QFileInfo pchInfo(pchFile);
+    if (!pchInfo.exists()) {
+        return nullptr;
+    }
+
+    QFile savedEnvironment(environmentFile);
+    if (!savedEnvironment.open(QIODevice::ReadOnly) || savedEnvironment.readAll() != environmentHash) {
+        return nullptr;
+    }
+    savedEnvironment.close();
+
+    CXTranslationUnit unit = nullptr;
+    if (clang_createTranslationUnit2(index, QFile::encodeName(pchFile).constData(), &unit) != CXError_Success) {
+        // e.g. written by another version of clang
+        return nullptr;
+    }
+
+    struct Inputs
+    {
+        QDateTime savedAt;
+        bool upToDate;
+    } inputs = {pchInfo.lastModified(), true};
+    clang_getInclusions(unit, [] (CXFile file, CXSourceLocation* /*stack*/, unsigned /*depth*/, CXClientData data) {
+        auto inputs = static_cast<Inputs*>(data);
+        const QFileInfo info(ClangString(clang_getFileName(file)).toString());
+        if (!info.exists() || info.lastModified() > inputs->savedAt) {
+            inputs->upToDate = false;
+        }
+    }, &inputs);
+
+    if (!inputs.upToDate) {
+        clang_disposeTranslationUnit(unit);
+        return nullptr;
+    }
+    writeEnvironmentFile(environmentFile, environmentHash);
+    return unit;
+}
+
+/**
+ * Saves @p unit to @p pchFile, through a temporary file that is renamed once it is complete.
+ * Other sessions may load the file at any time, see loadPrecompiledHeader().
+ * @returns whether the precompiled header was saved
+ */
+bool savePrecompiledHeader(CXTranslationUnit unit, const QString& pchFile)
+{
+    QTemporaryFile file(pchFile + QLatin1String(".XXXXXX"));
+    if (!file.open()) {
+        qCWarning(KDEV_CLANG) << "Failed to save precompiled header:" << pchFile << file.errorString();
+        return false;
+    }
+    file.close();
+
+    const QByteArray tempName = QFile::encodeName(file.fileName());
+    if (clang_saveTranslationUnit(unit, tempName.constData(), CXSaveTranslationUnit_None) != CXSaveError_None) {
+        qCWarning(KDEV_CLANG) << "Failed to save precompiled header:" << pchFile;
+        return false;
+    }
+#ifdef Q_OS_WIN
+    // rename() doesn't replace an existing file there
+    QFile::remove(pchFile);
+#endif
+    // unlike QFile::rename(), this replaces the previous file atomically
+    if (std::rename(tempName.constData(), QFile::encodeName(pchFile).constData()) != 0) {
+        qCWarning(KDEV_CLANG) << "Failed to save precompiled header:" << pchFile;
+        return false;
+    }
+    file.setAutoRemove(false);
+    return true;
+}
+
 bool needGccCompatibility(const ClangParsingEnvironment& environment)
 {
     const auto& defines = environment.defines();
@@ -288,7 +404,10 @@ ParseSessionData::ParseSessionData(const QVector<UnsavedFile>& unsavedFiles, Cla
     addFrameworkDirectories(&clangArguments, &smartArgs, frameworkDirectories.system, "-iframework");
     addFrameworkDirectories(&clangArguments, &smartArgs, frameworkDirectories.project, "-F");
 
-    smartArgs << writeDefinesFile(environment.defines());
+    // the precompiled header may be used by later sessions, so its defines must stay where they are
+    const QString pchFile = tuUrl.str() + QLatin1String(".pch");
+    const QString pchStateFile = options.testFlag(PrecompiledHeader) ? index->pchStateFile(pchFile) : QString();
+    smartArgs << writeDefinesFile(environment.defines(), pchStateFile.isEmpty() ? QString() : pchStateFile + QLatin1String(".defines"));
     clangArguments << "-imacros" << smartArgs.last().constData();
 
     // append extra args from environment variable
@@ -313,17 +432,27 @@ ParseSessionData::ParseSessionData(const QVector<UnsavedFile>& unsavedFiles, Cla
         out << " " << tuUrl.byteArray().constData() << "\n";
     }
 
-    const CXErrorCode code = clang_parseTranslationUnit2(
-        index->index(), tuUrl.byteArray().constData(),
-        clangArguments.constData(), clangArguments.size(),
-        unsaved.data(), unsaved.size(),
-        flags,
-        &m_unit
-    );
-    if (code != CXError_Success) {
-        qCWarning(KDEV_CLANG) << "clang_parseTranslationUnit2 return with error code" << code;
-        if (!qEnvironmentVariableIsSet("KDEV_CLANG_DISPLAY_DIAGS")) {
-            qCWarning(KDEV_CLANG) << "  (start KDevelop with `KDEV_CLANG_DISPLAY_DIAGS=1 kdevelop` to see more diagnostics)";
+    bool loaded = false;
+    QByteArray pchEnvironment;
+    if (!pchStateFile.isEmpty()) {
+        pchEnvironment = environmentHash(clangArguments, environment.defines());
+        m_unit = loadPrecompiledHeader(index->index(), pchFile, pchStateFile + QLatin1String(".environment"), pchEnvironment);
+        loaded = m_unit != nullptr;
+    }
+
+    if (!loaded) {
+        const CXErrorCode code = clang_parseTranslationUnit2(
+            index->index(), tuUrl.byteArray().constData(),
+            clangArguments.constData(), clangArguments.size(),
+            unsaved.data(), unsaved.size(),
+            flags,
+            &m_unit
+        );
+        if (code != CXError_Success) {
+            qCWarning(KDEV_CLANG) << "clang_parseTranslationUnit2 return with error code" << code;
+            if (!qEnvironmentVariableIsSet("KDEV_CLANG_DISPLAY_DIAGS")) {
+                qCWarning(KDEV_CLANG) << "  (start KDevelop with `KDEV_CLANG_DISPLAY_DIAGS=1 kdevelop` to see more diagnostics)";
+            }
         }
     }
 
@@ -331,8 +460,10 @@ ParseSessionData::ParseSessionData(const QVector<UnsavedFile>& unsavedFiles, Cla
         setUnit(m_unit);
         m_environment = environment;
 
-        if (options.testFlag(PrecompiledHeader)) {
-            clang_saveTranslationUnit(m_unit, QByteArray(tuUrl.byteArray() + ".pch").constData(), CXSaveTranslationUnit_None);
+        if (options.testFlag(PrecompiledHeader) && !loaded) {
+            if (savePrecompiledHeader(m_unit, pchFile) && !pchStateFile.isEmpty()) {
+                writeEnvironmentFile(pchStateFile + QLatin1String(".environment"), pchEnvironment);
+            }
         }
     } else {
         qCWarning(KDEV_CLANG) << "Failed to parse translation unit:" << tuUrl;
@@ -344,13 +475,11 @@ ParseSessionData::~ParseSessionData()
     clang_disposeTranslationUnit(m_unit);
 }
 
-QByteArray ParseSessionData::writeDefinesFile(const QMap<QString, QString>& defines)
+QByteArray ParseSessionData::writeDefinesFile(const QMap<QString, QString>& defines, const QString& fileName)
 {
-    m_definesFile.open();
-    Q_ASSERT(m_definesFile.isWritable());
-
+    QByteArray contents;
     {
-        QTextStream definesStream(&m_definesFile);
+        QTextStream definesStream(&contents);
         // don't show warnings about redefined macros
         definesStream << "#pragma clang system_header\n";
         for (auto it = defines.begin(); it != defines.end(); ++it) {
@@ -362,10 +491,28 @@ QByteArray ParseSessionData::writeDefinesFile(const QMap<QString, QString>& defi
             definesStream << QStringLiteral("#define ") << it.key() << ' ' << it.value() << '\n';
         }
     }
-    m_definesFile.close();
+
+    QString definesFileName = fileName;
+    if (definesFileName.isEmpty()) {
+        m_definesFile.open();
+        Q_ASSERT(m_definesFile.isWritable());
+        m_definesFile.write(contents);
+        m_definesFile.close();
+        definesFileName = m_definesFile.fileName();
+    } else {
+        // keep the file untouched when the defines didn't change, it is an input of the precompiled header
+        QFile file(definesFileName);
+        if (!file.open(QIODevice::ReadOnly) || file.readAll() != contents) {
+            file.close();
+            QSaveFile saveFile(definesFileName);
+            if (!saveFile.open(QIODevice::WriteOnly) || saveFile.write(contents) != contents.size() || !saveFile.commit()) {
+                qCWarning(KDEV_CLANG) << "Failed to write defines file:" << definesFileName << saveFile.errorString();
+            }
+        }
+    }
 
     if (qEnvironmentVariableIsSet("KDEV_CLANG_DISPLAY_DEFINES")) {
-        QFile f(m_definesFile.fileName());
+        QFile f(definesFileName);
         f.open(QIODevice::ReadOnly);
         Q_ASSERT(f.isReadable());
         QTextStream out(stdout);
@@ -374,7 +521,7 @@ QByteArray ParseSessionData::writeDefinesFile(const QMap<QString, QString>& defi
             << "\n VS defines:" << defines.size() << "\n";
     }
 
-    return m_definesFile.fileName().toUtf8();
+    return definesFileName.toUtf8();
 }
 
 void ParseSessionData::setUnit(CXTranslationUnit unit)
@@ -500,6 +647,21 @@ CXTranslationUnit ParseSession::unit() const
     return d ? d->m_unit : nullptr;
 }
 
+quint64 ParseSession::memoryUsage() const
+{
+    if (!unit()) {
+        return 0;
+    }
+
+    quint64 usage = 0;
+    CXTUResourceUsage resources = clang_getCXTUResourceUsage(unit());
+    for (unsigned int i = 0; i < resources.numEntries; ++i) {
+        usage += resources.entries[i].amount;
+    }
+    clang_disposeCXTUResourceUsage(resources);
+    return usage;
+}
+
 CXFile ParseSession::file(const QByteArray& path) const
 {
     return clang_getFile(unit(), path.constData());
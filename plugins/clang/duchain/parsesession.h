@@ -69,7 +69,8 @@ public:
 private:
     friend class ParseSession;
     void setUnit(CXTranslationUnit unit);
-    QByteArray writeDefinesFile(const QMap<QString, QString>& defines);
+    /// Writes the @p defines to @p fileName, or to a temporary file if it is empty
+    QByteArray writeDefinesFile(const QMap<QString, QString>& defines, const QString& fileName);
 
     QMutex m_mutex;
 
@@ -124,6 +125,11 @@ public:
 
     CXTranslationUnit unit() const;
 
+    /**
+     * @return the memory used by the translation unit, in bytes.
+     */
+    quint64 memoryUsage() const;
+
     bool reparse(const QVector<UnsavedFile>& unsavedFiles, const ClangParsingEnvironment& environment);
 
     ClangParsingEnvironment environment() const;
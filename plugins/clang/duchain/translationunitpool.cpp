@@ -0,0 +1,159 @@
+/*
+ * Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License or (at your option) version 3 or any later version
+ * accepted by the membership of KDE e.V. (or its successor approved
+ * by the membership of KDE e.V.), which shall act as a proxy
+ * defined in Section 14 of version 3 of the license.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "translationunitpool.h"
+
+#include "parsesession.h"
+#include "util/clangdebug.h"
+
+#include <language/duchain/duchainlock.h>
+#include <language/duchain/duchainutils.h>
+#include <language/duchain/topducontext.h>
+
+using namespace KDevelop;
+
+TranslationUnitPool::TranslationUnitPool()
+    : m_memoryBudget(2048ull * 1024 * 1024)
+{
+}
+
+void TranslationUnitPool::setMemoryBudget(quint64 budget)
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_memoryBudget = budget;
+        if (m_memoryUsage <= m_memoryBudget) {
+            return;
+        }
+    }
+    evict();
+}
+
+void TranslationUnitPool::insert(const IndexedString& tuUrl, const IndexedString& url,
+                                 const ParseSessionData* session, quint64 memoryUsage)
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        auto& unit = m_units[tuUrl];
+        if (unit.session != session) {
+            // reparsing may create a new session, the contexts are attached to it again
+            unit.session = session;
+            unit.urls.clear();
+        }
+        if (!unit.urls.contains(url)) {
+            unit.urls.append(url);
+        }
+        m_memoryUsage = m_memoryUsage - unit.memoryUsage + memoryUsage;
+        unit.memoryUsage = memoryUsage;
+
+        m_usage.removeOne(tuUrl);
+        m_usage.append(tuUrl);
+        if (m_memoryUsage <= m_memoryBudget) {
+            return;
+        }
+    }
+    evict();
+}
+
+void TranslationUnitPool::touch(const IndexedString& tuUrl)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_usage.removeOne(tuUrl)) {
+        m_usage.append(tuUrl);
+    }
+}
+
+void TranslationUnitPool::remove(const IndexedString& url)
+{
+    // the DUChain is always locked before the pool
+    DUChainWriteLocker duchainLock;
+    QMutexLocker lock(&m_mutex);
+
+    for (auto it = m_units.begin(); it != m_units.end(); ++it) {
+        if (it->urls.removeOne(url)) {
+            auto context = DUChainUtils::standardContextForUrl(url.toUrl());
+            if (context && context->ast().data() == it->session) {
+                context->clearAst();
+            }
+        }
+    }
+    prune();
+}
+
+TranslationUnitPool::Statistics TranslationUnitPool::statistics()
+{
+    DUChainReadLocker duchainLock;
+    QMutexLocker lock(&m_mutex);
+    prune();
+
+    Statistics statistics;
+    statistics.units = m_units.size();
+    statistics.memoryUsage = m_memoryUsage;
+    statistics.memoryBudget = m_memoryBudget;
+    statistics.evictions = m_evictions;
+    return statistics;
+}
+
+void TranslationUnitPool::evict()
+{
+    // the DUChain is always locked before the pool
+    DUChainWriteLocker duchainLock;
+    QMutexLocker lock(&m_mutex);
+    prune();
+
+    // the most recently used translation unit is kept in any case
+    while (m_memoryUsage > m_memoryBudget && m_usage.size() > 1) {
+        const auto tuUrl = m_usage.takeFirst();
+        const auto unit = m_units.take(tuUrl);
+        m_memoryUsage -= unit.memoryUsage;
+        ++m_evictions;
+
+        for (const auto& url : unit.urls) {
+            auto context = DUChainUtils::standardContextForUrl(url.toUrl());
+            if (context && context->ast().data() == unit.session) {
+                context->clearAst();
+            }
+        }
+        clangDebug() << "detached translation unit" << tuUrl << "to free" << unit.memoryUsage << "bytes";
+    }
+}
+
+void TranslationUnitPool::prune()
+{
+    for (auto it = m_units.begin(); it != m_units.end();) {
+        auto& unit = it.value();
+        for (auto url = unit.urls.begin(); url != unit.urls.end();) {
+            // e.g. the context was deleted, or parsed again without keeping the AST
+            auto context = DUChainUtils::standardContextForUrl(url->toUrl());
+            if (context && context->ast().data() == unit.session) {
+                ++url;
+            } else {
+                url = unit.urls.erase(url);
+            }
+        }
+        if (unit.urls.isEmpty()) {
+            m_memoryUsage -= unit.memoryUsage;
+            m_usage.removeOne(it.key());
+            it = m_units.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2026 KDevelop Developers <kdevelop-devel@kde.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License or (at your option) version 3 or any later version
+ * accepted by the membership of KDE e.V. (or its successor approved
+ * by the membership of KDE e.V.), which shall act as a proxy
+ * defined in Section 14 of version 3 of the license.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRANSLATIONUNITPOOL_H
+#define TRANSLATIONUNITPOOL_H
+
+#include "clangprivateexport.h"
+
+#include <serialization/indexedstring.h>
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+class ParseSessionData;
+
+/**
+ * @short Limits the memory used by the translation units that are kept for open documents.
+ *
+ * The parse session of an open document is attached to its DUChain, so that reparsing and
+ * code-completion don't have to start from scratch. Once these sessions use more memory than
+ * the budget, the ones of the least recently focused translation units are detached. Their
+ * DUChain is kept, and the session is created again when one of their documents gets focused.
+ * Sessions are detached as well when their documents are closed, and units whose contexts
+ * dropped their session in another way are forgotten before the memory usage is checked.
+ *
+ * This class is thread safe.
+ */
+class KDEVCLANGPRIVATE_EXPORT TranslationUnitPool
+{
+public:
+    struct Statistics
+    {
+        /// The translation units that are kept
+        int units = 0;
+        /// The memory used by them, in bytes
+        quint64 memoryUsage = 0;
+        quint64 memoryBudget = 0;
+        /// How often a translation unit was detached to stay within the budget
+        int evictions = 0;
+    };
+
+    TranslationUnitPool();
+
+    /// Sets the memory that the translation units may use, in bytes
+    void setMemoryBudget(quint64 budget);
+
+    /**
+     * Registers @p session of the translation unit @p tuUrl, which was attached to the context of @p url.
+     *
+     * @p memoryUsage is the memory used by the session, in bytes.
+     * The DUChain must not be locked, as the least recently used sessions may be detached.
+     */
+    void insert(const KDevelop::IndexedString& tuUrl, const KDevelop::IndexedString& url,
+                const ParseSessionData* session, quint64 memoryUsage);
+
+    /// Marks the translation unit @p tuUrl as the most recently used one
+    void touch(const KDevelop::IndexedString& tuUrl);
+
+    /**
+     * Detaches the session from the context of @p url, e.g. because its document was closed.
+     *
+     * Translation units without any context that uses their session are removed.
+     * The DUChain must not be locked.
+     */
+    void remove(const KDevelop::IndexedString& url);
+
+    /// The DUChain must not be locked.
+    Statistics statistics();
+
+private:
+    struct Unit
+    {
+        // only used to check that a context still has this session attached
+        const ParseSessionData* session = nullptr;
+        quint64 memoryUsage = 0;
+        QList<KDevelop::IndexedString> urls;
+    };
+
+    void evict();
+    /// Forgets the contexts that dropped the session of their unit, the DUChain and m_mutex must be locked
+    void prune();
+
+    mutable QMutex m_mutex;
+    QHash<KDevelop::IndexedString, Unit> m_units;
+    /// The translation units, from the least to the most recently used one
+    QList<KDevelop::IndexedString> m_usage;
+    quint64 m_memoryUsage = 0;
+    quint64 m_memoryBudget;
+    int m_evictions = 0;
+};
+
+#endif // TRANSLATIONUNITPOOL_H
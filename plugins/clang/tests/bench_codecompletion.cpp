@@ -20,6 +20,7 @@
 
 #include "bench_codecompletion.h"
 
+#include <QElapsedTimer>
 #include <QTest>
 #include <QSignalSpy>
 
@@ -32,12 +33,25 @@
 #include "duchain/parsesession.h"
 #include "duchain/clangindex.h"
 
+#include "codecompletion/context.h"
 #include "codecompletion/model.h"
 
+#include <algorithm>
+
 QTEST_MAIN(BenchCodeCompletion);
 
 using namespace KDevelop;
 
+namespace {
+
+qint64 percentile(QVector<qint64> samples, int percent)
+{
+    std::sort(samples.begin(), samples.end());
+    return samples.at(std::min(samples.size() - 1, samples.size() * percent / 100));
+}
+
+}
+
 BenchCodeCompletion::BenchCodeCompletion()
     : m_index(new ClangIndex)
     , m_model(new ClangCodeCompletionModel(m_index.data(), this))
@@ -95,3 +109,51 @@ void BenchCodeCompletion::benchCodeCompletion()
         } while (!m_model->rowCount());
     }
 }
+
+void BenchCodeCompletion::benchCodeCompletionLatency_data()
+{
+    benchCodeCompletion_data();
+}
+
+void BenchCodeCompletion::benchCodeCompletionLatency()
+{
+    QFETCH(QString, code);
+    QFETCH(KTextEditor::Cursor, position);
+
+    TestFile file(code, "cpp");
+    QVERIFY(file.parseAndWait(TopDUContext::AllDeclarationsContextsUsesAndAST, 1, 5000));
+
+    DUChainReadLocker lock;
+    auto top = file.topContext();
+    QVERIFY(top);
+    const ParseSessionData::Ptr sessionData(dynamic_cast<ParseSessionData*>(top->ast().data()));
+    QVERIFY(sessionData);
+    const DUContextPointer topPtr(top);
+    lock.unlock();
+
+    const int runs = 20;
+    // the time until the best items are shown, and until all of them are
+    QVector<qint64> best;
+    QVector<qint64> all;
+    for (int i = 0; i < runs; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        // don't hold DUChain lock when constructing ClangCodeCompletionContext
+        QExplicitlySharedDataPointer<ClangCodeCompletionContext> context(
+            new ClangCodeCompletionContext(topPtr, sessionData, file.url().toUrl(), position, QString()));
+
+        bool abort = false;
+        lock.lock();
+        const auto bestItems = context->bestCompletionItems(50, abort);
+        const qint64 bestTime = timer.nsecsElapsed();
+        context->completionItems(abort);
+        all << timer.nsecsElapsed();
+        best << (bestItems.isEmpty() ? all.last() : bestTime);
+        lock.unlock();
+    }
+
+    for (int percent : {50, 90, 99}) {
+        qDebug("p%d: %.2f ms until the best items, %.2f ms until all items", percent,
+               percentile(best, percent) / 1e6, percentile(all, percent) / 1e6);
+    }
+}
@@ -37,6 +37,8 @@ public:
 private Q_SLOTS:
     void benchCodeCompletion_data();
     void benchCodeCompletion();
+    void benchCodeCompletionLatency_data();
+    void benchCodeCompletionLatency();
 
 private:
     QScopedPointer<ClangIndex> m_index;
@@ -51,6 +51,9 @@
 #include "duchain/clangparsingenvironmentfile.h"
 #include "duchain/clangparsingenvironment.h"
 #include "duchain/parsesession.h"
+#include "duchain/clangindex.h"
+#include "duchain/clangpch.h"
+#include "duchain/translationunitpool.h"
 
 #include <custom-definesandincludes/idefinesandincludesmanager.h>
 
@@ -58,7 +61,10 @@
 
 #include <QTest>
 #include <QSignalSpy>
+#include <QDateTime>
+#include <QFileInfo>
 #include <QLoggingCategory>
+#include <QStandardPaths>
 #include <QThread>
 
 QTEST_MAIN(TestDUChain);
@@ -97,6 +103,8 @@ TestDUChain::~TestDUChain() = default;
 
 void TestDUChain::initTestCase()
 {
+    // keep the shared preambles out of the user's cache
+    QStandardPaths::setTestModeEnabled(true);
     QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false\ndefault.debug=true\nkdevelop.plugins.clang.debug=true\n"));
     QVERIFY(qputenv("KDEV_CLANG_DISPLAY_DIAGS", "1"));
     AutoTestShell::init({QStringLiteral("kdevclangsupport")});
@@ -2069,3 +2077,206 @@ void TestDUChain::testHasInclude()
         }
     }
 }
+
+void TestDUChain::testTranslationUnitPool()
+{
+    const auto features = TopDUContext::Features(TopDUContext::AllDeclarationsContextsAndUses | TopDUContext::AST);
+    TestFile first(QStringLiteral("int first;"), QStringLiteral("cpp"));
+    TestFile second(QStringLiteral("int second;"), QStringLiteral("cpp"));
+    first.parse(features);
+    second.parse(features);
+    QVERIFY(first.waitForParsed(1000));
+    QVERIFY(second.waitForParsed(1000));
+
+    const ParseSessionData* firstSession;
+    const ParseSessionData* secondSession;
+    {
+        DUChainReadLocker lock;
+        firstSession = dynamic_cast<ParseSessionData*>(first.topContext()->ast().data());
+        secondSession = dynamic_cast<ParseSessionData*>(second.topContext()->ast().data());
+    }
+    QVERIFY(firstSession);
+    QVERIFY(secondSession);
+
+    TranslationUnitPool pool;
+    pool.insert(first.url(), first.url(), firstSession, 100);
+    pool.insert(second.url(), second.url(), secondSession, 100);
+    QCOMPARE(pool.statistics().units, 2);
+    QCOMPARE(pool.statistics().memoryUsage, quint64(200));
+
+    // focusing the first document makes the second one the least recently used
+    pool.touch(first.url());
+    pool.setMemoryBudget(150);
+
+    const auto statistics = pool.statistics();
+    QCOMPARE(statistics.units, 1);
+    QCOMPARE(statistics.memoryUsage, quint64(100));
+    QCOMPARE(statistics.evictions, 1);
+
+    DUChainReadLocker lock;
+    QVERIFY(first.topContext()->ast());
+    QVERIFY(!second.topContext()->ast());
+    // the DUChain is kept
+    QCOMPARE(second.topContext()->localDeclarations().size(), 1);
+    lock.unlock();
+
+    // closing a document detaches its session
+    pool.remove(first.url());
+    QCOMPARE(pool.statistics().units, 0);
+    QCOMPARE(pool.statistics().memoryUsage, quint64(0));
+    lock.lock();
+    QVERIFY(!first.topContext()->ast());
+    lock.unlock();
+
+    // a unit is forgotten once its context dropped the session
+    TestFile third(QStringLiteral("int third;"), QStringLiteral("cpp"));
+    third.parse(features);
+    QVERIFY(third.waitForParsed(1000));
+    lock.lock();
+    const auto thirdSession = dynamic_cast<ParseSessionData*>(third.topContext()->ast().data());
+    lock.unlock();
+    QVERIFY(thirdSession);
+    pool.insert(third.url(), third.url(), thirdSession, 100);
+    QCOMPARE(pool.statistics().units, 1);
+    {
+        DUChainWriteLocker writeLock;
+        third.topContext()->clearAst();
+    }
+    QCOMPARE(pool.statistics().units, 0);
+    QCOMPARE(pool.statistics().memoryUsage, quint64(0));
+}
+
+void TestDUChain::testTranslationUnitForUrl()
+{
+    const IndexedString tu(QStringLiteral("/tu-for-url/main.cpp"));
+    const IndexedString header(QStringLiteral("/tu-for-url/header.h"));
+    const IndexedString other(QStringLiteral("/tu-for-url/other.cpp"));
+
+    ClangIndex index;
+    QCOMPARE(index.translationUnitForUrl(header), header);
+
+    index.setIncludedFiles(tu, {tu, header});
+    QCOMPARE(index.translationUnitForUrl(header), tu);
+    QCOMPARE(index.translationUnitForUrl(tu), tu);
+
+    // the first translation unit is kept
+    index.setIncludedFiles(other, {other, header});
+    QCOMPARE(index.translationUnitForUrl(header), tu);
+
+    // pinning takes precedence
+    index.pinTranslationUnitForUrl(other, header);
+    QCOMPARE(index.translationUnitForUrl(header), other);
+    index.unpinTranslationUnitForUrl(header);
+    QCOMPARE(index.translationUnitForUrl(header), header);
+
+    index.setIncludedFiles(tu, {tu, header});
+    QCOMPARE(index.translationUnitForUrl(header), tu);
+    // the header is no longer included
+    index.setIncludedFiles(tu, {tu});
+    QCOMPARE(index.translationUnitForUrl(header), header);
+
+    index.setIncludedFiles(tu, {tu, header});
+    QCOMPARE(index.translationUnitForUrl(header), tu);
+    index.fileRemoved(tu);
+    QCOMPARE(index.translationUnitForUrl(header), header);
+}
+
+void TestDUChain::testPreambleHeader()
+{
+    const QString includes = QStringLiteral("#include <vector>\n// comment\n#include <string>\n#include <map>\n");
+    TestFile file(includes + QStringLiteral("int i;\n"), QStringLiteral("cpp"));
+    TestFile sameIncludes(includes + QStringLiteral("int j;\n"), QStringLiteral("cpp"));
+    TestFile localInclude(includes + QStringLiteral("#include \"config.h\"\n#include <set>\n"), QStringLiteral("cpp"));
+    TestFile fewIncludes(QStringLiteral("#include <vector>\n#include \"config.h\"\n#include <string>\n#include <map>\n"), QStringLiteral("cpp"));
+
+    ClangIndex index;
+    auto environment = [] (const TestFile& file) {
+        ClangParsingEnvironment environment;
+        environment.setTranslationUnitUrl(file.url());
+        return environment;
+    };
+
+    const auto header = index.preambleHeader(environment(file));
+    QVERIFY(header.isValid());
+    QFile headerFile(header.toLocalFile());
+    QVERIFY(headerFile.open(QIODevice::ReadOnly));
+    QCOMPARE(headerFile.readAll(), QByteArray("#include <vector>\n#include <string>\n#include <map>\n"));
+
+    // the key only depends on the includes and the environment
+    QCOMPARE(index.preambleHeader(environment(sameIncludes)), header);
+    // the system includes after a local one may depend on its macros
+    QCOMPARE(index.preambleHeader(environment(localInclude)), header);
+    QVERIFY(!index.preambleHeader(environment(fewIncludes)).isValid());
+
+    auto definesEnvironment = environment(sameIncludes);
+    definesEnvironment.addDefines({{QStringLiteral("FOO"), QStringLiteral("1")}});
+    const auto definesHeader = index.preambleHeader(definesEnvironment);
+    QVERIFY(definesHeader.isValid());
+    QVERIFY(definesHeader != header);
+}
+
+void TestDUChain::testPchCache()
+{
+    TestFile firstHeader(QStringLiteral("int first;\n"), QStringLiteral("h"));
+    TestFile secondHeader(QStringLiteral("int second;\n"), QStringLiteral("h"));
+    auto environment = [] (const TestFile& header) {
+        ClangParsingEnvironment environment;
+        environment.setPchInclude(Path(header.url().str()));
+        return environment;
+    };
+    const QString pchFile = firstHeader.url().str() + QLatin1String(".pch");
+
+    QDateTime savedAt;
+    {
+        ClangIndex index;
+        const auto first = index.pch(environment(firstHeader));
+        QVERIFY(first);
+        QVERIFY(first->context().data());
+        QVERIFY(QFile::exists(pchFile));
+        savedAt = QFileInfo(pchFile).lastModified();
+        QCOMPARE(index.pch(environment(firstHeader)), first);
+
+        // the most recently used PCH is kept even if it exceeds the budget
+        index.setPchMemoryBudget(1);
+        QCOMPARE(index.pch(environment(firstHeader)), first);
+        const auto second = index.pch(environment(secondHeader));
+        QVERIFY(second);
+        QCOMPARE(index.pch(environment(secondHeader)), second);
+        // the least recently used one got released
+        QVERIFY(index.pch(environment(firstHeader)) != first);
+    }
+
+    // a later session loads the saved PCH instead of saving it again
+    {
+        ClangIndex index;
+        QVERIFY(index.pch(environment(firstHeader)));
+        QCOMPARE(QFileInfo(pchFile).lastModified(), savedAt);
+    }
+
+    // but it is built again once its input changed
+    QTest::qSleep(1100);
+    firstHeader.setFileContents(QStringLiteral("int changed;\n"));
+    {
+        ClangIndex index;
+        QVERIFY(index.pch(environment(firstHeader)));
+        QVERIFY(QFileInfo(pchFile).lastModified() > savedAt);
+        savedAt = QFileInfo(pchFile).lastModified();
+    }
+
+    // or once it is used with other include paths
+    QTest::qSleep(1100);
+    {
+        ClangIndex index;
+        auto includesEnvironment = environment(firstHeader);
+        includesEnvironment.addIncludes(Path::List() << Path(QStringLiteral("/foo/bar/baz")));
+        QVERIFY(index.pch(includesEnvironment));
+        QVERIFY(QFileInfo(pchFile).lastModified() > savedAt);
+    }
+
+    // the defines are kept in the cache, not next to the header
+    QVERIFY(!QFile::exists(firstHeader.url().str() + QLatin1String(".defines")));
+
+    for (const TestFile* header : {&firstHeader, &secondHeader}) {
+        QFile::remove(header->url().str() + QLatin1String(".pch"));
+    }
+}
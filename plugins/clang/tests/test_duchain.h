@@ -101,6 +101,10 @@ private Q_SLOTS:
     void testGccCompatibility();
     void testQtIntegration();
     void testHasInclude();
+    void testTranslationUnitPool();
+    void testTranslationUnitForUrl();
+    void testPreambleHeader();
+    void testPchCache();
 
 private:
     QScopedPointer<TestEnvironmentProvider> m_provider;
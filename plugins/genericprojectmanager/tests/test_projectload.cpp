@@ -408,3 +408,63 @@ void TestProjectLoad::addDuringImport()
     //      esp. when adding a file at a point where the parent folder was already imported
     //      or removing a file that was already imported
 }
+
+IProject* openProject(const TestProject& p)
+{
+    QSignalSpy spy(ICore::self()->projectController(), SIGNAL(projectOpened(KDevelop::IProject*)));
+    ICore::self()->projectController()->openProject(p.file);
+    if (!spy.wait(2000)) {
+        return nullptr;
+    }
+    return spy.first().at(0).value<IProject*>();
+}
+
+void TestProjectLoad::batchedChanges()
+{
+    const TestProject p = makeProject();
+    IProject* project = openProject(p);
+    QVERIFY(project);
+
+    QSignalSpy insertSpy(ICore::self()->projectController()->projectModel(), SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy addSpy(project->managerPlugin(), SIGNAL(fileAdded(KDevelop::ProjectFileItem*)));
+
+    // files that show up at once are added to their folder with a single insertion
+    for (int i = 0; i < 50; ++i) {
+        QVERIFY(createFile(p.dir->path() + "/batch" + QString::number(i)));
+    }
+    for (int i = 0; i < 50 && addSpy.count() < 50; ++i) {
+        QTest::qWait(100);
+    }
+    QCOMPARE(addSpy.count(), 50);
+    QCOMPARE(insertSpy.count(), 1);
+    QCOMPARE(insertSpy.first().at(2).toInt() - insertSpy.first().at(1).toInt() + 1, 50);
+    QCOMPARE(project->projectItem()->fileList().count(), 51);
+}
+
+void TestProjectLoad::cancelledChanges()
+{
+    const TestProject p = makeProject();
+    const QString replaced = p.dir->path() + "/replaced";
+    QVERIFY(createFile(replaced));
+    IProject* project = openProject(p);
+    QVERIFY(project);
+
+    const QList<ProjectFileItem*> items = project->filesForPath(IndexedString(replaced));
+    QCOMPARE(items.size(), 1);
+    QSignalSpy addSpy(project->managerPlugin(), SIGNAL(fileAdded(KDevelop::ProjectFileItem*)));
+    QSignalSpy removeSpy(project->managerPlugin(), SIGNAL(fileRemoved(KDevelop::ProjectFileItem*)));
+
+    // a file that is removed again before the changes are applied never shows up
+    const QString transient = p.dir->path() + "/transient";
+    QVERIFY(createFile(transient));
+    QVERIFY(QFile::remove(transient));
+    // a file that is written again right after its removal keeps its item
+    QVERIFY(QFile::remove(replaced));
+    QVERIFY(createFile(replaced));
+
+    QTest::qWait(2000);
+    QCOMPARE(addSpy.count(), 0);
+    QCOMPARE(removeSpy.count(), 0);
+    QVERIFY(project->filesForPath(IndexedString(transient)).isEmpty());
+    QCOMPARE(project->filesForPath(IndexedString(replaced)), items);
+}
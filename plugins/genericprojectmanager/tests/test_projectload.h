@@ -44,6 +44,9 @@ private Q_SLOTS:
   void raceJob();
 
   void addDuringImport();
+
+  void batchedChanges();
+  void cancelledChanges();
 };
 
 #endif
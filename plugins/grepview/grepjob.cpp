@@ -20,69 +20,239 @@
 
 #include <QFile>
 #include <QList>
+#include <QMap>
+#include <QMutex>
 #include <QRegExp>
-#include <QTextStream>
+#include <QTextCodec>
+#include <QThread>
+#include <QtConcurrentRun>
 
 #include <KEncodingProber>
 #include <KLocalizedString>
 
 #include <serialization/indexedstring.h>
+#include <project/trigramindex.h>
 #include <interfaces/icore.h>
 #include <interfaces/iuicontroller.h>
 
 using namespace KDevelop;
 
 
-GrepOutputItem::List grepFile(const QString &filename, const QRegExp &re)
+namespace {
+
+// Size of the chunks fed to the encoding prober
+const int probeChunkSize = 0xFF;
+
+// Interval in which the matches found by the search threads are passed on to the output model
+const int deliveryInterval = 50;
+
+QString readFile(const QString &filename, bool *ok)
 {
-    GrepOutputItem::List res;
     QFile file(filename);
+    *ok = file.open(QIODevice::ReadOnly);
+    if (!*ok) {
+        return QString();
+    }
 
-    if(!file.open(QIODevice::ReadOnly))
-        return res;
-    int lineno = 0;
-
+    // Large files are mapped instead of copied
+    QByteArray data;
+    const qint64 size = file.size();
+    if (uchar* mapped = size > 0 ? file.map(0, size) : nullptr) {
+        data = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), size);
+    } else {
+        data = file.readAll();
+    }
 
     // detect encoding (unicode files can be feed forever, stops when confidence reachs 99%
     KEncodingProber prober;
-    while(!file.atEnd() && prober.state() == KEncodingProber::Probing && prober.confidence() < 0.99) {
-        prober.feed(file.read(0xFF));
+    for (int pos = 0; pos < data.size() && prober.state() == KEncodingProber::Probing && prober.confidence() < 0.99; pos += probeChunkSize) {
+        prober.feed(data.mid(pos, probeChunkSize));
     }
 
-    // reads file with detected encoding
-    file.seek(0);
-    QTextStream stream(&file);
-    if(prober.confidence()>0.7)
-        stream.setCodec(prober.encoding());
-    while( !stream.atEnd() )
-    {
-        QString data = stream.readLine();
+    QTextCodec* codec = nullptr;
+    if (prober.confidence() > 0.7) {
+        codec = QTextCodec::codecForName(prober.encoding());
+    }
+    if (!codec) {
+        codec = QTextCodec::codecForLocale();
+    }
+    // like QTextStream, a byte order mark overrides the detected encoding
+    codec = QTextCodec::codecForUtfText(data, codec);
 
-        // remove line terminators (in order to not match them)
-        for(int pos = data.length()-1; pos >= 0 && (data[pos] == '\r' || data[pos] == '\n'); pos--)
-        {
-            data.chop(1);
+    // decoded before the mapping is released together with the file
+    return codec->toUnicode(data);
+}
+
+/// @returns the end of the line starting at @p lineStart, without the line terminators
+int lineEnd(const QString &text, int lineStart, int *nextLineStart)
+{
+    int end = text.indexOf(QLatin1Char('\n'), lineStart);
+    *nextLineStart = end == -1 ? text.size() : end + 1;
+    if (end == -1) {
+        end = text.size();
+    }
+    // remove line terminators (in order to not match them)
+    while (end > lineStart && text[end - 1] == QLatin1Char('\r')) {
+        --end;
+    }
+    return end;
+}
+
+void addMatch(const QString &filename, const QString &line, int lineno, int start, int end, GrepOutputItem::List &res)
+{
+    DocumentChangePointer change = DocumentChangePointer(new DocumentChange(
+        IndexedString(filename),
+        KTextEditor::Range(lineno, start, lineno, end),
+        line.mid(start, end - start), QString()));
+
+    res << GrepOutputItem(change, line, false);
+}
+
+}
+
+GrepMatcher::GrepMatcher(const QRegExp &re)
+    : m_mode(MatchRegExp)
+    , m_regExp(re)
+{
+    QString literal;
+    if (literalPattern(re, &literal)) {
+        m_mode = MatchLiteral;
+        m_literal = QStringMatcher(literal, re.caseSensitivity());
+        return;
+    }
+
+    if (re.patternSyntax() == QRegExp::RegExp || re.patternSyntax() == QRegExp::RegExp2) {
+        // \w and friends match all letters in QRegExp, not only ASCII ones
+        QRegularExpression::PatternOptions options = QRegularExpression::UseUnicodePropertiesOption;
+        if (re.caseSensitivity() == Qt::CaseInsensitive) {
+            options |= QRegularExpression::CaseInsensitiveOption;
+        }
+        m_regularExpression = QRegularExpression(re.pattern(), options);
+        if (m_regularExpression.isValid()) {
+            m_regularExpression.optimize();
+            m_mode = MatchRegularExpression;
+        }
+    }
+}
+
+GrepOutputItem::List GrepMatcher::grep(const QString &filename) const
+{
+    GrepOutputItem::List res;
+    bool ok;
+    const QString text = readFile(filename, &ok);
+    if (!ok) {
+        return res;
+    }
+
+    if (m_mode == MatchLiteral) {
+        grepLiteral(filename, text, res);
+    } else {
+        grepLines(filename, text, res);
+    }
+    return res;
+}
+
+void GrepMatcher::grepLiteral(const QString &filename, const QString &text, GrepOutputItem::List &res) const
+{
+    // The literal can't contain line terminators, so the whole text is searched at once,
+    // and only the lines that contain matches are split off
+    int lineno = 0;
+    int lineStart = 0;
+    int nextLineStart = 0;
+    int end = lineEnd(text, lineStart, &nextLineStart);
+    QString line = text.mid(lineStart, end - lineStart);
+
+    const int length = m_literal.pattern().size();
+    for (int pos = m_literal.indexIn(text); pos != -1; pos = m_literal.indexIn(text, pos + length)) {
+        if (pos >= nextLineStart) {
+            lineno += text.midRef(nextLineStart, pos - nextLineStart).count(QLatin1Char('\n')) + 1;
+            lineStart = text.lastIndexOf(QLatin1Char('\n'), pos) + 1;
+            end = lineEnd(text, lineStart, &nextLineStart);
+            line = text.mid(lineStart, end - lineStart);
+        }
+        if (pos + length > end) {
+            // Only matches the line terminators
+            continue;
         }
+        addMatch(filename, line, lineno, pos - lineStart, pos - lineStart + length, res);
+    }
+}
+
+void GrepMatcher::grepLines(const QString &filename, const QString &text, GrepOutputItem::List &res) const
+{
+    // QRegExp is not thread-safe, every call works on its own copy
+    QRegExp re = m_regExp;
+
+    int lineno = 0;
+    for (int lineStart = 0, nextLineStart = 0; lineStart < text.size(); lineStart = nextLineStart, ++lineno) {
+        const QString line = text.mid(lineStart, lineEnd(text, lineStart, &nextLineStart) - lineStart);
 
         int offset = 0;
         // allow empty string matching result in an infinite loop !
-        while( re.indexIn(data, offset)!=-1 && re.cap(0).length() > 0 )
-        {
-            int start = re.pos(0);
-            int end = start + re.cap(0).length();
-
-            DocumentChangePointer change = DocumentChangePointer(new DocumentChange(
-                IndexedString(filename),
-                KTextEditor::Range(lineno, start, lineno, end),
-                re.cap(0), QString()));
-
-            res << GrepOutputItem(change, data, false);
-            offset = end;
+        if (m_mode == MatchRegularExpression) {
+            for (auto match = m_regularExpression.match(line, offset); match.hasMatch() && match.capturedLength() > 0;
+                 match = m_regularExpression.match(line, offset))
+            {
+                offset = match.capturedEnd();
+                addMatch(filename, line, lineno, match.capturedStart(), offset, res);
+            }
+        } else {
+            while (re.indexIn(line, offset) != -1 && re.cap(0).length() > 0) {
+                const int start = re.pos(0);
+                offset = start + re.cap(0).length();
+                addMatch(filename, line, lineno, start, offset, res);
+            }
+        }
+    }
+}
+
+GrepOutputItem::List grepFile(const QString &filename, const QRegExp &re)
+{
+    return GrepMatcher(re).grep(filename);
+}
+
+/// State shared between a GrepJob and its search threads
+struct GrepSearch
+{
+    GrepSearch(const QList<QUrl> &files, const QRegExp &re)
+        : files(files)
+        , matcher(re)
+        , finished(files.size(), false)
+    {
+    }
+
+    const QList<QUrl> files;
+    const GrepMatcher matcher;
+    QAtomicInt nextFile;
+    QAtomicInt cancelled;
+
+    QMutex mutex;
+    // Guarded by mutex
+    QVector<bool> finished;
+    int finishedCount = 0;
+    QMap<int, GrepOutputItem::List> results;
+
+    // Only used by the job
+    int nextDelivery = 0;
+};
+
+static void grepFiles(const QSharedPointer<GrepSearch> &search)
+{
+    while (!search->cancelled.load()) {
+        const int index = search->nextFile.fetchAndAddRelaxed(1);
+        if (index >= search->files.size()) {
+            return;
+        }
+
+        const GrepOutputItem::List items = search->matcher.grep(search->files[index].toLocalFile());
+
+        QMutexLocker lock(&search->mutex);
+        search->finished[index] = true;
+        ++search->finishedCount;
+        if (!items.isEmpty()) {
+            search->results.insert(index, items);
         }
-        lineno++;
     }
-    file.close();
-    return res;
 }
 
 GrepJob::GrepJob( QObject* parent )
@@ -97,6 +267,16 @@ GrepJob::GrepJob( QObject* parent )
     KDevelop::ICore::self()->uiController()->registerStatus(this);
 
     connect(this, &GrepJob::result, this, &GrepJob::testFinishState);
+
+    m_searchPool.setMaxThreadCount(QThread::idealThreadCount());
+    m_deliveryTimer.setInterval(deliveryInterval);
+    connect(&m_deliveryTimer, &QTimer::timeout, this, &GrepJob::slotWork);
+}
+
+GrepJob::~GrepJob()
+{
+    cancelSearch();
+    // the pool waits for the search threads, they stop after their current file
 }
 
 QString GrepJob::statusName() const
@@ -162,6 +342,12 @@ void GrepJob::slotFindFinished()
     m_outputModel->setRegExp(m_regExp);
     m_outputModel->setReplacementTemplate(m_settings.replacementTemplate);
 
+    const QStringList literals = requiredLiterals(m_regExp);
+    if (!literals.isEmpty()) {
+        // skips the files that can't match according to the trigram indexes of the projects
+        m_fileList = TrigramIndex::candidates(m_fileList, literals);
+    }
+
 
     emit showMessage(this, i18np("Searching for <b>%2</b> in one file",
                                  "Searching for <b>%2</b> in %1 files",
@@ -169,7 +355,58 @@ void GrepJob::slotFindFinished()
                                  m_regExp.pattern().toHtmlEscaped()));
 
     m_workState = WorkGrep;
-    QMetaObject::invokeMethod( this, "slotWork", Qt::QueuedConnection);
+    startSearch();
+}
+
+void GrepJob::startSearch()
+{
+    m_search.reset(new GrepSearch(m_fileList, m_regExp));
+    const int threads = qMin(m_searchPool.maxThreadCount(), m_fileList.size());
+    for (int i = 0; i < threads; ++i) {
+        QtConcurrent::run(&m_searchPool, grepFiles, m_search);
+    }
+    m_deliveryTimer.start();
+}
+
+bool GrepJob::deliverResults()
+{
+    QMap<int, GrepOutputItem::List> results;
+    int finishedCount;
+    {
+        QMutexLocker lock(&m_search->mutex);
+        finishedCount = m_search->finishedCount;
+        if (m_settings.orderedResults) {
+            // only the matches of files before the first unfinished one
+            while (m_search->nextDelivery < m_search->finished.size() && m_search->finished[m_search->nextDelivery]) {
+                const auto it = m_search->results.find(m_search->nextDelivery);
+                if (it != m_search->results.end()) {
+                    results.insert(it.key(), *it);
+                    m_search->results.erase(it);
+                }
+                ++m_search->nextDelivery;
+            }
+        } else {
+            results.swap(m_search->results);
+        }
+    }
+
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        m_findSomething = true;
+        emit foundMatches(m_search->files[it.key()].toLocalFile(), *it);
+    }
+
+    m_fileIndex = finishedCount;
+    emit showProgress(this, 0, m_fileList.length(), m_fileIndex);
+    return finishedCount == m_fileList.length();
+}
+
+void GrepJob::cancelSearch()
+{
+    m_deliveryTimer.stop();
+    if (m_search) {
+        m_search->cancelled.store(1);
+        m_search.reset();
+    }
 }
 
 void GrepJob::slotWork()
@@ -189,25 +426,10 @@ void GrepJob::slotWork()
             m_findThread->start();
             break;
         case WorkGrep:
-            if(m_fileIndex < m_fileList.length())
-            {
-                emit showProgress(this, 0, m_fileList.length(), m_fileIndex);
-                if(m_fileIndex < m_fileList.length()) {
-                    QString file = m_fileList[m_fileIndex].toLocalFile();
-                    GrepOutputItem::List items = grepFile(file, m_regExp);
-
-                    if(!items.isEmpty())
-                    {
-                        m_findSomething = true;
-                        emit foundMatches(file, items);
-                    }
-
-                    m_fileIndex++;
-                }
-                QMetaObject::invokeMethod(this, "slotWork", Qt::QueuedConnection);
-            }
-            else
+            // called by the delivery timer while the search threads are running
+            if(m_search && deliverResults())
             {
+                cancelSearch();
                 emit hideProgress(this);
                 emit clearMessage(this);
                 m_workState = WorkIdle;
@@ -216,6 +438,7 @@ void GrepJob::slotWork()
             }
             break;
         case WorkCancelled:
+            cancelSearch();
             emit hideProgress(this);
             emit clearMessage(this);
             emit showErrorMessage(i18n("Search aborted"), 5000);
@@ -252,6 +475,10 @@ bool GrepJob::doKill()
     }
     else
     {
+        if (m_search) {
+            // the search threads stop right away, the delivery timer finishes the job
+            m_search->cancelled.store(1);
+        }
         m_workState = WorkCancelled;
     }
     return true;
@@ -17,6 +17,12 @@
 #define KDEVPLATFORM_PLUGIN_GREPJOB_H
 
 #include <QPointer>
+#include <QRegExp>
+#include <QRegularExpression>
+#include <QSharedPointer>
+#include <QStringMatcher>
+#include <QThreadPool>
+#include <QTimer>
 #include <QUrl>
 
 #include <KJob>
@@ -31,9 +37,9 @@ namespace KDevelop
     class IProject;
 }
 
-class QRegExp;
 class GrepViewPlugin;
 class FindReplaceTest; //FIXME: this is useful only for tests
+struct GrepSearch;
 
 struct GrepJobSettings
 {
@@ -45,6 +51,9 @@ struct GrepJobSettings
 
     int depth = -1;
 
+    /// Whether matches are reported in the order of the files, instead of as soon as they are found
+    bool orderedResults = true;
+
     QString pattern;
     QString searchTemplate;
     QString replacementTemplate;
@@ -66,6 +75,8 @@ private:
     explicit GrepJob( QObject *parent = nullptr );
 
 public:
+    ~GrepJob() override;
+
     void setSettings(const GrepJobSettings& settings);
     GrepJobSettings settings() const;
 
@@ -94,6 +105,9 @@ Q_SIGNALS:
 
 private:
     Q_INVOKABLE void slotWork();
+    void startSearch();
+    bool deliverResults();
+    void cancelSearch();
 
     QList<QUrl> m_directoryChoice;
     QString m_errorMessage;
@@ -113,11 +127,44 @@ private:
     int m_fileIndex;
     QPointer<GrepFindFilesThread> m_findThread;
 
+    QSharedPointer<GrepSearch> m_search;
+    QThreadPool m_searchPool;
+    QTimer m_deliveryTimer;
+
     GrepJobSettings m_settings;
 
     bool m_findSomething;
 };
 
+/**
+ * Finds the matches of a regular expression in the lines of files.
+ *
+ * Patterns that match literal text are searched with a QStringMatcher over the whole file,
+ * other regular expressions are compiled once into a QRegularExpression.
+ * A const matcher can be used from multiple threads.
+ */
+class GrepMatcher
+{
+public:
+    explicit GrepMatcher(const QRegExp &re);
+
+    GrepOutputItem::List grep(const QString &filename) const;
+
+private:
+    void grepLiteral(const QString &filename, const QString &text, GrepOutputItem::List &res) const;
+    void grepLines(const QString &filename, const QString &text, GrepOutputItem::List &res) const;
+
+    enum {
+        MatchLiteral,
+        MatchRegularExpression,
+        MatchRegExp
+    } m_mode;
+
+    QStringMatcher m_literal;
+    QRegularExpression m_regularExpression;
+    QRegExp m_regExp;
+};
+
 //FIXME: this function is used externally only for tests, find a way to keep it
 //       static for a regular compilation
 GrepOutputItem::List grepFile(const QString &filename, const QRegExp &re);
@@ -13,6 +13,8 @@
 #include <algorithm>
 #include <QChar>
 #include <QComboBox>
+#include <QRegExp>
+#include <QStringList>
 
 static int const MAX_LAST_SEARCH_ITEMS_COUNT = 15;
 
@@ -63,3 +65,147 @@ QStringList qCombo2StringList( QComboBox* combo, bool allowEmpty )
     return list;
 }
 
+bool literalPattern(const QRegExp &re, QString *literal)
+{
+    const QString pattern = re.pattern();
+    if (pattern.isEmpty() || re.isMinimal()) {
+        return false;
+    }
+
+    switch (re.patternSyntax()) {
+    case QRegExp::FixedString:
+        *literal = pattern;
+        return true;
+    case QRegExp::Wildcard:
+    case QRegExp::WildcardUnix:
+        if (pattern != QRegExp::escape(pattern)) {
+            return false;
+        }
+        *literal = pattern;
+        return true;
+    case QRegExp::RegExp:
+    case QRegExp::RegExp2:
+        break;
+    default:
+        return false;
+    }
+
+    // Accepts the output of QRegExp::escape(), so searches for raw text take the fast path
+    static const QString specialCharacters = QStringLiteral("$()*+.?[]^{}|\\");
+    literal->clear();
+    for (int i = 0; i < pattern.size(); ++i) {
+        QChar c = pattern[i];
+        if (c == QLatin1Char('\\')) {
+            if (++i == pattern.size()) {
+                return false;
+            }
+            c = pattern[i];
+            if (c.isLetterOrNumber() || c == QLatin1Char('_')) {
+                return false;
+            }
+        } else if (specialCharacters.contains(c)) {
+            return false;
+        }
+        literal->append(c);
+    }
+    return true;
+}
+
+QStringList requiredLiterals(const QRegExp &re)
+{
+    QString literal;
+    if (literalPattern(re, &literal)) {
+        return {literal};
+    }
+    const QString pattern = re.pattern();
+    if ((re.patternSyntax() != QRegExp::RegExp && re.patternSyntax() != QRegExp::RegExp2)
+        || pattern.contains(QLatin1Char('|')))
+    {
+        return {};
+    }
+
+    // Collects the runs of literal characters outside of groups and character classes,
+    // characters that may be repeated or left out end a run
+    QStringList ret;
+    QString run;
+    auto endRun = [&ret, &run]() {
+        if (!run.isEmpty()) {
+            ret << run;
+            run.clear();
+        }
+    };
+    int depth = 0;
+    for (int i = 0; i < pattern.size(); ++i) {
+        QChar c = pattern[i];
+        switch (c.unicode()) {
+        case '\\':
+            if (++i == pattern.size()) {
+                return {};
+            }
+            c = pattern[i];
+            if (c.isLetterOrNumber() || c == QLatin1Char('_')) {
+                // character classes, assertions, back references and character codes,
+                // the digits of a code are part of the escape
+                endRun();
+                const bool hex = c == QLatin1Char('x') || c == QLatin1Char('u');
+                if (hex || c.isDigit()) {
+                    for (int digits = 0; digits < 4 && i + 1 < pattern.size(); ++digits) {
+                        const QChar next = pattern[i + 1];
+                        if (!next.isDigit() && !(hex && QStringLiteral("abcdefABCDEF").contains(next))) {
+                            break;
+                        }
+                        ++i;
+                    }
+                }
+                continue;
+            }
+            break;
+        case '[':
+            endRun();
+            if (i + 1 < pattern.size() && pattern[i + 1] == QLatin1Char('^')) {
+                ++i;
+            }
+            // a ']' right after the opening bracket or its negation is part of the class
+            if (i + 1 < pattern.size() && pattern[i + 1] == QLatin1Char(']')) {
+                ++i;
+            }
+            for (++i; i < pattern.size() && pattern[i] != QLatin1Char(']'); ++i) {
+                if (pattern[i] == QLatin1Char('\\')) {
+                    ++i;
+                }
+            }
+            continue;
+        case '(':
+            endRun();
+            ++depth;
+            continue;
+        case ')':
+            --depth;
+            continue;
+        case '?':
+        case '*':
+        case '{':
+            run.chop(1);
+            endRun();
+            if (c == QLatin1Char('{')) {
+                while (i < pattern.size() && pattern[i] != QLatin1Char('}')) {
+                    ++i;
+                }
+            }
+            continue;
+        case '+':
+        case '.':
+        case '^':
+        case '$':
+            endRun();
+            continue;
+        default:
+            break;
+        }
+        if (depth == 0) {
+            run += c;
+        }
+    }
+    endRun();
+    return ret;
+}
@@ -13,6 +13,7 @@
 #define KDEVPLATFORM_PLUGIN_GREPUTIL_H
 
 class QComboBox;
+class QRegExp;
 class QStringList;
 class QString;
 
@@ -22,4 +23,10 @@ QStringList qCombo2StringList( QComboBox* combo, bool allowEmpty = false );
 /// Replaces each occurrence of "%s" in pattern by searchString (and "%%" by "%")
 QString substitudePattern(const QString& pattern, const QString& searchString);
 
+/// @returns whether @p re only matches literal text, and stores that text in @p literal
+bool literalPattern(const QRegExp& re, QString* literal);
+
+/// @returns texts that every match of @p re contains, for narrowing down the files with a TrigramIndex
+QStringList requiredLiterals(const QRegExp& re);
+
 #endif
@@ -23,6 +23,7 @@
 #include "../grepjob.h"
 #include "../grepviewplugin.h"
 #include "../grepoutputmodel.h"
+#include "../greputil.h"
 
 void FindReplaceTest::initTestCase()
 {
@@ -64,6 +65,10 @@ void FindReplaceTest::testFind_data()
                            << (MatchList() << Match(0, 0, 6));
     QTest::newRow("Matching empty string anywhere") << "foobar\n" << QRegExp("")
                            << (MatchList());
+    QTest::newRow("Escaped raw text") << "axb\na.b a.b" << QRegExp(QRegExp::escape(QStringLiteral("a.b")))
+                           << (MatchList() << Match(1, 0, 3) << Match(1, 4, 7));
+    QTest::newRow("Case insensitive raw text") << "Foo\r\nbar fOO" << QRegExp(QStringLiteral("foo"), Qt::CaseInsensitive)
+                           << (MatchList() << Match(0, 0, 3) << Match(1, 4, 7));
 }
 
 void FindReplaceTest::testFind()
@@ -196,5 +201,31 @@ void FindReplaceTest::testReplace()
     tempDir.remove();
 }
 
+void FindReplaceTest::testRequiredLiterals_data()
+{
+    QTest::addColumn<QRegExp>("search");
+    QTest::addColumn<QStringList>("literals");
+
+    QTest::newRow("Fixed string") << QRegExp("a.b", Qt::CaseSensitive, QRegExp::FixedString)
+                                  << QStringList{"a.b"};
+    QTest::newRow("Escaped text") << QRegExp("foo\\.bar") << QStringList{"foo.bar"};
+    QTest::newRow("Optional character") << QRegExp("foob?ar") << QStringList{"foo", "ar"};
+    QTest::newRow("Character classes") << QRegExp("\\bfoo\\s+bar") << QStringList{"foo", "bar"};
+    QTest::newRow("Group") << QRegExp("(foo)bar") << QStringList{"bar"};
+    QTest::newRow("Alternatives") << QRegExp("foo|bar") << QStringList();
+    // the digits of character codes must not become literals
+    QTest::newRow("Hex escape") << QRegExp("foo\\x41bar") << QStringList{"foo", "bar"};
+    QTest::newRow("Hex escape with letters") << QRegExp("foo\\x4fbar") << QStringList{"foo", "r"};
+    QTest::newRow("Octal escape") << QRegExp("foo\\0101bar") << QStringList{"foo", "bar"};
+    QTest::newRow("Back reference") << QRegExp("(a)foo\\1bar") << QStringList{"foo", "bar"};
+}
+
+void FindReplaceTest::testRequiredLiterals()
+{
+    QFETCH(QRegExp, search);
+    QFETCH(QStringList, literals);
+
+    QCOMPARE(requiredLiterals(search), literals);
+}
 
 QTEST_MAIN(FindReplaceTest);
@@ -53,6 +53,9 @@ private Q_SLOTS:
 
     void testReplace();
     void testReplace_data();
+
+    void testRequiredLiterals();
+    void testRequiredLiterals_data();
 };
 
 Q_DECLARE_METATYPE(FindReplaceTest::MatchList)
@@ -25,14 +25,73 @@
 
 #include <QFile>
 
+#include <algorithm>
+
 using namespace KDevelop;
 
+namespace {
+
+// How long the existence of a .kdev_ignore file is cached, in ms
+const qint64 ignoreFileTimeout = 5000;
+
+bool isWildcard(QChar c)
+{
+    return c == QLatin1Char('*') || c == QLatin1Char('?');
+}
+
+bool hasWildcard(const QString& text)
+{
+    return std::any_of(text.begin(), text.end(), isWildcard);
+}
+
+/// Matches a pattern that only contains '*' and '?' wildcards, like QRegExp::WildcardUnix.
+bool matchesGlob(const QString& pattern, const QChar* text, int textSize)
+{
+    const QChar* p = pattern.constData();
+    const int patternSize = pattern.size();
+    int patternPos = 0;
+    int textPos = 0;
+    int starPatternPos = -1;
+    int starTextPos = 0;
+    while (textPos < textSize) {
+        if (patternPos < patternSize && p[patternPos] == QLatin1Char('*')) {
+            starPatternPos = patternPos++;
+            starTextPos = textPos;
+        } else if (patternPos < patternSize && (p[patternPos] == QLatin1Char('?') || p[patternPos] == text[textPos])) {
+            ++patternPos;
+            ++textPos;
+        } else if (starPatternPos != -1) {
+            // let the last star consume one more character
+            patternPos = starPatternPos + 1;
+            textPos = ++starTextPos;
+        } else {
+            return false;
+        }
+    }
+    while (patternPos < patternSize && p[patternPos] == QLatin1Char('*')) {
+        ++patternPos;
+    }
+    return patternPos == patternSize;
+}
+
+}
+
 ProjectFilter::ProjectFilter( const IProject* const project, const QVector<Filter>& filters )
     : m_filters( filters )
     , m_projectFile( project->projectFile() )
     , m_project( project->path() )
 {
-
+    // the lists are sorted by descending index
+    for (int i = m_filters.size() - 1; i >= 0; --i) {
+        const Filter& filter = m_filters.at(i);
+        if (filter.targets & Filter::Files) {
+            compile(&m_fileFilters, filter, i);
+        }
+        if (filter.targets & Filter::Folders) {
+            compile(&m_folderFilters, filter, i);
+        }
+    }
+    m_clock.start();
 }
 
 ProjectFilter::~ProjectFilter()
@@ -40,6 +99,53 @@ ProjectFilter::~ProjectFilter()
 
 }
 
+void ProjectFilter::compile(CompiledFilters* filters, const Filter& filter, int index)
+{
+    const QString pattern = filter.pattern.pattern();
+    const QLatin1String anyFolder("*/");
+
+    // The relative paths always start with a slash, so "*/*suffix" is the same as "*suffix".
+    // Only patterns without sets and escapes are compiled, the others use the QRegExp.
+    const bool simple = !pattern.contains(QLatin1Char('[')) && !pattern.contains(QLatin1Char('\\'));
+    if (simple && pattern.startsWith(anyFolder)) {
+        const QString name = pattern.mid(anyFolder.size());
+        if (!name.isEmpty() && !name.contains(QLatin1Char('/')) && !hasWildcard(name)) {
+            if (!filters->names.contains(name)) {
+                filters->names.insert(name, index);
+            }
+            return;
+        }
+    }
+
+    if (simple && pattern.startsWith(QLatin1Char('*'))) {
+        const QString suffix = pattern.mid(pattern.startsWith(QLatin1String("*/*")) ? 3 : 1);
+        if (suffix.isEmpty()) {
+            if (filters->all == -1) {
+                filters->all = index;
+            }
+            return;
+        } else if (!suffix.contains(QLatin1Char('/')) && !hasWildcard(suffix)) {
+            filters->suffixes[suffix.at(suffix.size() - 1)].append({index, suffix});
+            return;
+        }
+    }
+
+    CompiledFilters::Glob glob;
+    glob.index = index;
+    if (simple) {
+        glob.pattern = pattern;
+        int tailStart = pattern.size();
+        while (tailStart > 0 && !isWildcard(pattern.at(tailStart - 1))) {
+            --tailStart;
+        }
+        const QString tail = pattern.mid(tailStart);
+        if (tailStart > 0 && !tail.contains(QLatin1Char('/'))) {
+            glob.lastSegmentSuffix = tail;
+        }
+    }
+    filters->globs.append(glob);
+}
+
 bool ProjectFilter::isValid( const Path &path, const bool isFolder ) const
 {
     if (!isFolder && path == m_projectFile) {
@@ -51,45 +157,103 @@ bool ProjectFilter::isValid( const Path &path, const bool isFolder ) const
         return true;
     }
 
-    if (isFolder && path.isLocalFile() && QFile::exists(path.toLocalFile() + "/.kdev_ignore")) {
+    if (isFolder && path.isLocalFile() && hasIgnoreFile(path)) {
         return false;
     }
 
     // from here on the user can configure what he wants to see or not.
 
-    // we operate on the path relative to the project base
-    // by prepending a slash we can filter hidden files with the pattern "*/.*"
+    if (isFolder && path.lastPathSegment() == QLatin1String(".kdev4")) {
+        return false;
+    }
 
-    const QString relativePath = makeRelative(path);
+    const int match = lastMatch(isFolder ? m_folderFilters : m_fileFilters, path);
+    return match == -1 || m_filters.at(match).type == Filter::Inclusive;
+}
 
-    if (isFolder && relativePath.endsWith(QLatin1String("/.kdev4"))) {
-        return false;
+int ProjectFilter::lastMatch(const CompiledFilters& filters, const Path& path) const
+{
+    const QString name = path.lastPathSegment();
+
+    int match = qMax(filters.all, filters.names.value(name, -1));
+
+    if (!name.isEmpty()) {
+        const auto suffixes = filters.suffixes.constFind(name.at(name.size() - 1));
+        if (suffixes != filters.suffixes.constEnd()) {
+            for (const auto& suffix : *suffixes) {
+                if (suffix.index <= match) {
+                    break;
+                }
+                if (name.endsWith(suffix.suffix)) {
+                    match = suffix.index;
+                    break;
+                }
+            }
+        }
     }
 
-    bool isValid = true;
-    foreach( const Filter& filter, m_filters ) {
-        if (isFolder && !(filter.targets & Filter::Folders)) {
-            continue;
-        } else if (!isFolder && !(filter.targets & Filter::Files)) {
+    // the relative path is only built when a pattern needs it
+    PathBuffer relativePath;
+    for (const auto& glob : filters.globs) {
+        if (glob.index <= match) {
+            break;
+        }
+        if (!name.endsWith(glob.lastSegmentSuffix)) {
             continue;
         }
-        if ((!isValid && filter.type == Filter::Inclusive) || (isValid && filter.type == Filter::Exclusive)) {
-            const bool match = filter.pattern.exactMatch( relativePath );
-            if (filter.type == Filter::Inclusive) {
-                isValid = match;
-            } else {
-                isValid = !match;
-            }
+        if (relativePath.isEmpty()) {
+            makeRelative(path, &relativePath);
+        }
+        bool matches;
+        if (glob.pattern.isEmpty()) {
+            // QRegExp stores the captures of the last match, so concurrent callers match on a copy
+            QRegExp pattern = m_filters.at(glob.index).pattern;
+            matches = pattern.exactMatch(QString(relativePath.constData(), relativePath.size()));
+        } else {
+            matches = matchesGlob(glob.pattern, relativePath.constData(), relativePath.size());
+        }
+        if (matches) {
+            match = glob.index;
+            break;
         }
     }
-    return isValid;
+    return match;
 }
 
-QString ProjectFilter::makeRelative(const Path& path) const
+bool ProjectFilter::hasIgnoreFile(const Path& folder) const
 {
+    const qint64 now = m_clock.elapsed();
+    {
+        QMutexLocker lock(&m_ignoreFilesMutex);
+        const auto it = m_ignoreFiles.constFind(folder);
+        if (it != m_ignoreFiles.constEnd() && now - it->checked < ignoreFileTimeout) {
+            return it->exists;
+        }
+    }
+
+    const bool exists = QFile::exists(folder.toLocalFile() + QLatin1String("/.kdev_ignore"));
+    QMutexLocker lock(&m_ignoreFilesMutex);
+    m_ignoreFiles.insert(folder, {exists, now});
+    return exists;
+}
+
+void ProjectFilter::makeRelative(const Path& path, PathBuffer* buffer) const
+{
+    // we operate on the path relative to the project base
+    // by prepending a slash we can filter hidden files with the pattern "*/.*"
     if (!m_project.isParentOf(path)) {
-        return path.path();
+        const QString str = path.path();
+        buffer->append(str.constData(), str.size());
+        return;
     }
 
-    return '/' + m_project.relativePath(path);
+    // walking up the interned path doesn't allocate, unlike relativePath()
+    QVarLengthArray<QString, 32> segments;
+    for (Path it = path; it != m_project; it = it.parent()) {
+        segments.append(it.lastPathSegment());
+    }
+    for (int i = segments.size() - 1; i >= 0; --i) {
+        buffer->append(QLatin1Char('/'));
+        buffer->append(segments.at(i).constData(), segments.at(i).size());
+    }
 }
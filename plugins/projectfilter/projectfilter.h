@@ -25,6 +25,11 @@
 #include <project/interfaces/iprojectfilter.h>
 #include <util/path.h>
 
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QVarLengthArray>
+
 #include "filter.h"
 
 namespace KDevelop {
@@ -40,11 +45,61 @@ public:
     bool isValid(const Path& path, bool isFolder) const override;
 
 private:
-    QString makeRelative(const Path& path) const;
+    typedef QVarLengthArray<QChar, 256> PathBuffer;
+
+    /**
+     * The filters for files or folders, sorted into tables by the kind of their pattern.
+     *
+     * The last matching filter decides whether a path is valid, so all lists are sorted by
+     * descending filter index, and only filters with a higher index than the best match so far
+     * need to be checked.
+     */
+    struct CompiledFilters
+    {
+        struct Suffix
+        {
+            int index;
+            QString suffix;
+        };
+        struct Glob
+        {
+            int index;
+            // the pattern, if it only contains '*' and '?' wildcards
+            QString pattern;
+            // the literal text after the last wildcard, if the last path segment has to end with it
+            QString lastSegmentSuffix;
+        };
+
+        // "*/name": the last path segment equals the name
+        QHash<QString, int> names;
+        // "*suffix" and "*/*suffix": the last path segment ends with the suffix, keyed by its last character
+        QHash<QChar, QVector<Suffix>> suffixes;
+        // "*": all paths
+        int all = -1;
+        // patterns that are matched against the relative path
+        QVector<Glob> globs;
+    };
+
+    static void compile(CompiledFilters* filters, const Filter& filter, int index);
+    int lastMatch(const CompiledFilters& filters, const Path& path) const;
+    bool hasIgnoreFile(const Path& folder) const;
+    void makeRelative(const Path& path, PathBuffer* buffer) const;
 
     Filters m_filters;
     Path m_projectFile;
     Path m_project;
+
+    CompiledFilters m_fileFilters;
+    CompiledFilters m_folderFilters;
+
+    struct IgnoreFileEntry
+    {
+        bool exists;
+        qint64 checked;
+    };
+    mutable QMutex m_ignoreFilesMutex;
+    mutable QHash<Path, IgnoreFileEntry> m_ignoreFiles;
+    QElapsedTimer m_clock;
 };
 
 }
@@ -336,6 +336,37 @@ void TestProjectFilter::match_data()
         };
         ADD_TESTS("escaping", project, filter, tests);
     }
+    {
+        // wildcards in the middle of patterns
+        const TestProject project;
+        const Filters filters = Filters()
+            << Filter(SerializedFilter(QStringLiteral("?oo.txt"), Filter::Files))
+            << Filter(SerializedFilter(QStringLiteral("gen*/"), Filter::Folders))
+            << Filter(SerializedFilter(QStringLiteral("*/include/*.h"), Filter::Files))
+            << Filter(SerializedFilter(QStringLiteral("[ab]ar"), Filter::Files));
+        TestFilter filter(new ProjectFilter(&project, filters));
+
+        QTest::newRow("projectRoot") << filter << project.path() << Folder << Valid;
+        QTest::newRow("project.kdev4") << filter << project.projectFile() << File << Invalid;
+
+        MatchTest tests[] = {
+            //{path, isFolder, isValid}
+            {QStringLiteral("foo.txt"), File, Invalid},
+            {QStringLiteral("folder/boo.txt"), File, Invalid},
+            {QStringLiteral("oo.txt"), File, Valid},
+            {QStringLiteral("afoo.txt"), File, Valid},
+            {QStringLiteral("generated"), Folder, Invalid},
+            {QStringLiteral("folder/gen"), Folder, Invalid},
+            {QStringLiteral("generated"), File, Valid},
+            {QStringLiteral("include/foo.h"), File, Invalid},
+            {QStringLiteral("folder/include/sub/foo.h"), File, Invalid},
+            {QStringLiteral("include/foo.cpp"), File, Valid},
+            {QStringLiteral("foo.h"), File, Valid},
+            {QStringLiteral("bar"), File, Invalid},
+            {QStringLiteral("car"), File, Valid}
+        };
+        ADD_TESTS("wildcards", project, filter, tests);
+    }
 }
 
 static QVector<BenchData> createBenchData(const Path& base, int folderDepth, int foldersPerFolder, int filesPerFolder)
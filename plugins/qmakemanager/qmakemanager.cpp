@@ -101,12 +101,12 @@ IProjectFileManager::Features QMakeProjectManager::features() const
     return Features(Folders | Targets | Files);
 }
 
-bool QMakeProjectManager::isValid(const Path& path, const bool isFolder, IProject* project) const
+bool QMakeProjectManager::isValidIgnoringFilters(const Path& path, const bool isFolder, IProject* project) const
 {
     if (!isFolder && path.lastPathSegment().startsWith(QLatin1String("Makefile"))) {
         return false;
     }
-    return AbstractFileManagerPlugin::isValid(path, isFolder, project);
+    return AbstractFileManagerPlugin::isValidIgnoringFilters(path, isFolder, project);
 }
 
 Path QMakeProjectManager::buildDirectory(ProjectBaseItem* item) const
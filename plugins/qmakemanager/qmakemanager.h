@@ -47,7 +47,7 @@ public:
     KDevelop::ProjectFolderItem* createFolderItem( KDevelop::IProject* project, const KDevelop::Path& path,
                                                    KDevelop::ProjectBaseItem* parent = nullptr ) override;
     Features features() const override;
-    bool isValid( const KDevelop::Path& path, const bool isFolder, KDevelop::IProject* project ) const override;
+    bool isValidIgnoringFilters( const KDevelop::Path& path, const bool isFolder, KDevelop::IProject* project ) const override;
     //END AbstractFileManager
 
     //BEGIN IBuildSystemManager
@@ -159,3 +159,69 @@ void BenchQuickOpen::benchProjectFileFilter_providerDataIcon_data()
 {
     getData();
 }
+
+namespace {
+
+// Paths of a large code base, spread over a few projects with many directories each
+const QStringList& manyPaths()
+{
+    static QStringList paths;
+    if (paths.isEmpty()) {
+        const int count = 500000;
+        paths.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            paths << QStringLiteral("/home/user/projects/project%1/src/module%2/sub%3/File%4Impl.%5")
+                .arg(i % 10).arg((i / 10) % 500).arg(i % 7).arg(i).arg(i % 2 ? QStringLiteral("cpp") : QStringLiteral("h"));
+        }
+    }
+    return paths;
+}
+
+}
+
+void BenchQuickOpen::benchPathFilter_setItems()
+{
+    const QStringList& paths = manyPaths();
+    PathTestFilter filter;
+    QBENCHMARK {
+        filter.setItems(paths);
+    }
+}
+
+void BenchQuickOpen::benchPathFilter_setFilter()
+{
+    QFETCH(QStringList, filter);
+
+    PathTestFilter pathFilter;
+    pathFilter.setItems(manyPaths());
+
+    QBENCHMARK {
+        pathFilter.setFilter(filter);
+        pathFilter.clearFilter();
+    }
+}
+
+void BenchQuickOpen::benchPathFilter_setFilter_data()
+{
+    QTest::addColumn<QStringList>("filter");
+
+    QTest::newRow("500k-none") << QStringList{QStringLiteral("xyz")};
+    QTest::newRow("500k-file") << QStringList{QStringLiteral("file1234")};
+    QTest::newRow("500k-abbr") << QStringList{QStringLiteral("F12I")};
+    QTest::newRow("500k-dirs") << QStringList{QStringLiteral("module42"), QStringLiteral("file")};
+    QTest::newRow("500k-all_") << QStringList{QStringLiteral("src")};
+}
+
+void BenchQuickOpen::benchPathFilter_typing()
+{
+    PathTestFilter pathFilter;
+    pathFilter.setItems(manyPaths());
+
+    const QString typed = QStringLiteral("file4242impl");
+    QBENCHMARK {
+        for (int i = 1; i <= typed.size(); ++i) {
+            pathFilter.setFilter({typed.left(i)});
+        }
+        pathFilter.clearFilter();
+    }
+}
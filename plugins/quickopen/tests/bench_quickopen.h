@@ -42,6 +42,10 @@ private Q_SLOTS:
     void benchProjectFileFilter_providerData_data();
     void benchProjectFileFilter_providerDataIcon();
     void benchProjectFileFilter_providerDataIcon_data();
+    void benchPathFilter_setItems();
+    void benchPathFilter_setFilter();
+    void benchPathFilter_setFilter_data();
+    void benchPathFilter_typing();
 };
 
 #endif // KDEVPLATFORM_PLUGIN_BENCH_QUICKOPEN_H